@@ -81,7 +81,7 @@ DEFINE_string(linear_solver, "sparse_schur", "Options are: "
               "dense_qr, dense_normal_cholesky and cgnr.");
 DEFINE_string(preconditioner, "jacobi", "Options are: "
               "identity, jacobi, schur_jacobi, cluster_jacobi, "
-              "cluster_tridiagonal.");
+              "cluster_tridiagonal, additive_schwarz.");
 DEFINE_string(sparse_linear_algebra_library, "suite_sparse",
               "Options are: suite_sparse and cx_sparse.");
 DEFINE_string(ordering, "automatic", "Options are: automatic, user.");
@@ -98,6 +98,10 @@ DEFINE_double(eta, 1e-2, "Default value for eta. Eta determines the "
 
 DEFINE_bool(use_block_amd, true, "Use a block oriented fill reducing "
             "ordering.");
+DEFINE_bool(use_nested_dissection_ordering, false, "Use a nested dissection "
+            "ordering of the reduced camera matrix for SPARSE_SCHUR.");
+DEFINE_bool(use_single_precision_jacobian, false, "Use a single precision "
+            "copy of the Jacobian in ITERATIVE_SCHUR and CGNR.");
 
 DEFINE_int32(num_threads, 1, "Number of threads.");
 DEFINE_int32(num_iterations, 5, "Number of iterations.");
@@ -140,6 +144,9 @@ void SetOrdering(BALProblem* bal_problem, Solver::Options* options) {
   double* cameras = bal_problem->mutable_cameras();
 
   options->use_block_amd = FLAGS_use_block_amd;
+  options->use_nested_dissection_ordering =
+      FLAGS_use_nested_dissection_ordering;
+  options->use_single_precision_jacobian = FLAGS_use_single_precision_jacobian;
 
   if (options->use_inner_iterations) {
     if (FLAGS_blocks_for_inner_iterations == "cameras") {
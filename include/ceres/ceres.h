@@ -47,6 +47,7 @@
 #include "ceres/loss_function.h"
 #include "ceres/numeric_diff_cost_function.h"
 #include "ceres/numeric_diff_functor.h"
+#include "ceres/numeric_diff_options.h"
 #include "ceres/ordered_groups.h"
 #include "ceres/problem.h"
 #include "ceres/sized_cost_function.h"
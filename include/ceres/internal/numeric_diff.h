@@ -34,12 +34,17 @@
 #ifndef CERES_PUBLIC_INTERNAL_NUMERIC_DIFF_H_
 #define CERES_PUBLIC_INTERNAL_NUMERIC_DIFF_H_
 
+#include <algorithm>
+#include <cmath>
 #include <cstring>
+#include <limits>
 
 #include "Eigen/Dense"
 #include "ceres/cost_function.h"
+#include "ceres/internal/fixed_array.h"
 #include "ceres/internal/scoped_ptr.h"
 #include "ceres/internal/variadic_evaluate.h"
+#include "ceres/numeric_diff_options.h"
 #include "ceres/types.h"
 #include "glog/logging.h"
 
@@ -74,6 +79,50 @@ bool EvaluateImpl(const CostFunctor* functor,
   return functor->Evaluate(parameters, residuals, NULL);
 }
 
+// Computes the step sizes used to differentiate with respect to each
+// coordinate of the parameter block x, relative_step_size * |x[j]|.
+//
+// To handle cases where a parameter is exactly zero, instead use the
+// mean step_size for the other dimensions. If all the parameters are
+// zero, there's no good answer. Take relative_step_size as a guess and
+// hope for the best.
+inline void ComputeStepSizes(const double* x,
+                             int size,
+                             double relative_step_size,
+                             double* step_size) {
+  double sum = 0.0;
+  for (int j = 0; j < size; ++j) {
+    step_size[j] = std::abs(x[j]) * relative_step_size;
+    sum += step_size[j];
+  }
+
+  const double fallback_step_size =
+      (sum == 0.0) ? relative_step_size : sum / size;
+  for (int j = 0; j < size; ++j) {
+    if (step_size[j] == 0.0) {
+      step_size[j] = fallback_step_size;
+    }
+  }
+}
+
+// Computes the jacobians of cost_function at parameters with FORWARD
+// or CENTRAL differences, evaluating the jacobian columns in parallel
+// using num_threads threads. residuals must contain the residuals at
+// parameters. cost_function->Evaluate is called with NULL jacobians,
+// concurrently if num_threads > 1, on per thread copies of the
+// parameters, which are not modified.
+//
+// This is not a template so that the OpenMP code lives in the Ceres
+// library, and code including this header need not use OpenMP. If
+// Ceres was built without OpenMP, a single thread is used.
+bool EvaluateJacobianColumnsInParallel(const CostFunction* cost_function,
+                                       NumericDiffMethod method,
+                                       double relative_step_size,
+                                       int num_threads,
+                                       double const* const* parameters,
+                                       double const* residuals,
+                                       double** jacobians);
+
 // This is split from the main class because C++ doesn't allow partial template
 // specializations for member functions. The alternative is to repeat the main
 // class for differing numbers of parameters, which is also unfortunate.
@@ -85,11 +134,15 @@ template <typename CostFunctor,
           int kParameterBlock,
           int kParameterBlockSize>
 struct NumericDiff {
+  typedef Eigen::Matrix<double, kNumResiduals, 1> ResidualVector;
+  typedef Eigen::Matrix<double, kNumResiduals, Eigen::Dynamic>
+      ExtrapolationTableau;
+
   // Mutates parameters but must restore them before return.
   static bool EvaluateJacobianForParameterBlock(
       const CostFunctor* functor,
       double const* residuals_at_eval_point,
-      const double relative_step_size,
+      const NumericDiffOptions& options,
       double **parameters,
       double *jacobian) {
     using Eigen::Map;
@@ -97,7 +150,6 @@ struct NumericDiff {
     using Eigen::RowMajor;
     using Eigen::ColMajor;
 
-    typedef Matrix<double, kNumResiduals, 1> ResidualVector;
     typedef Matrix<double, kParameterBlockSize, 1> ParameterVector;
     typedef Matrix<double, kNumResiduals, kParameterBlockSize,
                    (kParameterBlockSize == 1 &&
@@ -112,22 +164,41 @@ struct NumericDiff {
     Map<ParameterVector> x_plus_delta(parameters[kParameterBlock],
                                       kParameterBlockSize);
     ParameterVector x(x_plus_delta);
-    ParameterVector step_size = x.array().abs() * relative_step_size;
+    ParameterVector step_size;
+    ComputeStepSizes(x.data(),
+                     kParameterBlockSize,
+                     (kMethod == ceres::RIDDERS)
+                     ? options.ridders_relative_initial_step_size
+                     : options.relative_step_size,
+                     step_size.data());
 
-    // To handle cases where a parameter is exactly zero, instead use
-    // the mean step_size for the other dimensions. If all the
-    // parameters are zero, there's no good answer. Take
-    // relative_step_size as a guess and hope for the best.
-    const double fallback_step_size =
-        (step_size.sum() == 0)
-        ? relative_step_size
-        : step_size.sum() / step_size.rows();
+    if (kMethod == ceres::RIDDERS) {
+      ExtrapolationTableau current(kNumResiduals,
+                                   options.max_num_ridders_extrapolations);
+      ExtrapolationTableau previous(kNumResiduals,
+                                    options.max_num_ridders_extrapolations);
+      ResidualVector derivative;
+      for (int j = 0; j < kParameterBlockSize; ++j) {
+        if (!EvaluateRiddersJacobianColumn(functor,
+                                           x(j),
+                                           step_size(j),
+                                           options,
+                                           parameters,
+                                           &x_plus_delta(j),
+                                           &current,
+                                           &previous,
+                                           &derivative)) {
+          return false;
+        }
+        parameter_jacobian.col(j) = derivative;
+      }
+      return true;
+    }
 
     // For each parameter in the parameter block, use finite differences to
     // compute the derivative for that parameter.
     for (int j = 0; j < kParameterBlockSize; ++j) {
-      const double delta =
-          (step_size(j) == 0.0) ? fallback_step_size : step_size(j);
+      const double delta = step_size(j);
 
       x_plus_delta(j) = x(j) + delta;
 
@@ -146,7 +217,7 @@ struct NumericDiff {
           Map<const ResidualVector>(residuals, kNumResiduals);
 
       double one_over_delta = 1.0 / delta;
-      if (kMethod == CENTRAL) {
+      if (kMethod == ceres::CENTRAL) {
         // Compute the function on the other side of x(j).
         x_plus_delta(j) = x(j) - delta;
 
@@ -170,6 +241,116 @@ struct NumericDiff {
     }
     return true;
   }
+
+  // Computes the central difference (f(x + delta) - f(x - delta)) / 2
+  // delta with respect to the coordinate x_j of the parameters, whose
+  // unperturbed value is x.
+  static bool EvaluateCentralDifference(const CostFunctor* functor,
+                                        const double x,
+                                        const double delta,
+                                        double** parameters,
+                                        double* x_j,
+                                        double* central_difference) {
+    using Eigen::Map;
+    double residuals[kNumResiduals];  // NOLINT
+    Map<ResidualVector> difference(central_difference, kNumResiduals);
+
+    *x_j = x + delta;
+    if (!EvaluateImpl<CostFunctor, N0, N1, N2, N3, N4, N5, N6, N7, N8, N9>(
+            functor, parameters, central_difference, functor)) {
+      *x_j = x;
+      return false;
+    }
+
+    *x_j = x - delta;
+    if (!EvaluateImpl<CostFunctor, N0, N1, N2, N3, N4, N5, N6, N7, N8, N9>(
+            functor, parameters, residuals, functor)) {
+      *x_j = x;
+      return false;
+    }
+    *x_j = x;
+
+    difference -= Map<const ResidualVector>(residuals, kNumResiduals);
+    difference /= 2.0 * delta;
+    return true;
+  }
+
+  // Differentiates with respect to the coordinate x_j using Ridders'
+  // method, i.e., Richardson extrapolation of central differences
+  // with geometrically decreasing step sizes, see "Numerical Recipes
+  // in C", Section 5.7.
+  //
+  // The i-th column of current and previous is the i-th order
+  // extrapolation in the current and previous rows of the tableau.
+  static bool EvaluateRiddersJacobianColumn(
+      const CostFunctor* functor,
+      const double x,
+      const double initial_delta,
+      const NumericDiffOptions& options,
+      double** parameters,
+      double* x_j,
+      ExtrapolationTableau* current,
+      ExtrapolationTableau* previous,
+      ResidualVector* derivative) {
+    const double shrink_factor2 =
+        options.ridders_step_shrink_factor * options.ridders_step_shrink_factor;
+    double delta = initial_delta;
+    if (!EvaluateCentralDifference(functor,
+                                   x,
+                                   delta,
+                                   parameters,
+                                   x_j,
+                                   previous->col(0).data())) {
+      return false;
+    }
+    *derivative = previous->col(0);
+
+    double error = std::numeric_limits<double>::max();
+    for (int i = 1; i < options.max_num_ridders_extrapolations; ++i) {
+      delta /= options.ridders_step_shrink_factor;
+      if (!EvaluateCentralDifference(functor,
+                                     x,
+                                     delta,
+                                     parameters,
+                                     x_j,
+                                     current->col(0).data())) {
+        return false;
+      }
+
+      double factor = shrink_factor2;
+      for (int k = 1; k <= i; ++k) {
+        current->col(k) = (factor * current->col(k - 1) -
+                           previous->col(k - 1)) / (factor - 1.0);
+        factor *= shrink_factor2;
+
+        // The error estimate is the difference with the lower order
+        // extrapolations it was computed from.
+        const double candidate_error = std::max(
+            (current->col(k) - current->col(k - 1))
+            .template lpNorm<Eigen::Infinity>(),
+            (current->col(k) - previous->col(k - 1))
+            .template lpNorm<Eigen::Infinity>());
+        if (candidate_error <= error) {
+          error = candidate_error;
+          *derivative = current->col(k);
+        }
+      }
+
+      // Stop once round off makes the highest order extrapolation
+      // worse than the best estimate so far by a significant factor.
+      if ((current->col(i) - previous->col(i - 1))
+          .template lpNorm<Eigen::Infinity>() >= 2.0 * error) {
+        break;
+      }
+
+      if (error < options.ridders_epsilon) {
+        break;
+      }
+
+      current->swap(*previous);
+    }
+    return true;
+  }
 };
 
 template <typename CostFunctor,
@@ -185,7 +366,7 @@ struct NumericDiff<CostFunctor, kMethod, kNumResiduals,
   static bool EvaluateJacobianForParameterBlock(
       const CostFunctor* functor,
       double const* residuals_at_eval_point,
-      const double relative_step_size,
+      const NumericDiffOptions& options,
       double **parameters,
       double *jacobian) {
     LOG(FATAL) << "Control should never reach here.";
@@ -193,6 +374,157 @@ struct NumericDiff<CostFunctor, kMethod, kNumResiduals,
   }
 };
 
+// HasEvaluateBatch<CostFunctor>::value is true if CostFunctor has a
+// member function
+//
+//   bool EvaluateBatch(int num_evaluations,
+//                      double const* const* parameters,
+//                      double* residuals) const;
+//
+// see NumericDiffCostFunction.
+template <typename CostFunctor>
+class HasEvaluateBatch {
+  typedef char Yes;
+  struct No { char unused[2]; };
+
+  template <typename U,
+            bool (U::*)(int, double const* const*, double*) const>
+  struct Signature {};
+
+  template <typename U>
+  static Yes Test(Signature<U, &U::EvaluateBatch>*);
+
+  template <typename U>
+  static No Test(...);
+
+ public:
+  enum { value = (sizeof(Test<CostFunctor>(0)) == sizeof(Yes)) };
+};
+
+template <typename CostFunctor,
+          bool kHasEvaluateBatch = HasEvaluateBatch<CostFunctor>::value>
+struct EvaluateBatchImpl {
+  static bool Call(const CostFunctor* functor,
+                   int num_evaluations,
+                   double const* const* parameters,
+                   double* residuals) {
+    LOG(FATAL) << "Control should never reach here.";
+    return false;
+  }
+};
+
+template <typename CostFunctor>
+struct EvaluateBatchImpl<CostFunctor, true> {
+  static bool Call(const CostFunctor* functor,
+                   int num_evaluations,
+                   double const* const* parameters,
+                   double* residuals) {
+    return functor->EvaluateBatch(num_evaluations, parameters, residuals);
+  }
+};
+
+// Computes the jacobians with forward or central differences using a
+// single call to CostFunctor::EvaluateBatch for all the perturbed
+// parameter vectors.
+//
+// The k-th of the num_evaluations parameter vectors passed to
+// EvaluateBatch is stored block by block: its i-th parameter block is
+// at parameters[i] + k * Ni, and its residuals are stored at
+// residuals + k * kNumResiduals. Each parameter vector differs from
+// the evaluation point in exactly one coordinate.
+template <typename CostFunctor,
+          NumericDiffMethod kMethod,
+          int kNumResiduals,
+          int N0, int N1, int N2, int N3, int N4,
+          int N5, int N6, int N7, int N8, int N9>
+struct BatchedNumericDiff {
+  static bool EvaluateJacobians(const CostFunctor* functor,
+                                double const* residuals_at_eval_point,
+                                const double relative_step_size,
+                                double const* const* parameters,
+                                double** jacobians) {
+    const int kBlockSizes[] = { N0, N1, N2, N3, N4, N5, N6, N7, N8, N9 };
+    const int kNumParameters = N0 + N1 + N2 + N3 + N4 + N5 + N6 + N7 + N8 + N9;
+    const int kNumParameterBlocks =
+        (N0 > 0) + (N1 > 0) + (N2 > 0) + (N3 > 0) + (N4 > 0) +
+        (N5 > 0) + (N6 > 0) + (N7 > 0) + (N8 > 0) + (N9 > 0);
+    const int kNumEvaluationsPerColumn = (kMethod == ceres::CENTRAL) ? 2 : 1;
+
+    int num_columns = 0;
+    for (int i = 0; i < kNumParameterBlocks; ++i) {
+      if (jacobians[i] != NULL) {
+        num_columns += kBlockSizes[i];
+      }
+    }
+    if (num_columns == 0) {
+      return true;
+    }
+    const int num_evaluations = kNumEvaluationsPerColumn * num_columns;
+
+    // Replicate the evaluation point num_evaluations times.
+    FixedArray<double> batch_parameter_values(num_evaluations * kNumParameters);
+    FixedArray<double*> batch_parameters(kNumParameterBlocks);
+    double* cursor = batch_parameter_values.get();
+    for (int i = 0; i < kNumParameterBlocks; ++i) {
+      batch_parameters[i] = cursor;
+      for (int k = 0; k < num_evaluations; ++k) {
+        memcpy(cursor, parameters[i], sizeof(double) * kBlockSizes[i]);
+        cursor += kBlockSizes[i];
+      }
+    }
+
+    // Perturb one coordinate of each copy.
+    FixedArray<double> step_sizes(num_columns);
+    for (int i = 0, column = 0; i < kNumParameterBlocks; ++i) {
+      if (jacobians[i] == NULL) {
+        continue;
+      }
+      const int block_size = kBlockSizes[i];
+      ComputeStepSizes(parameters[i],
+                       block_size,
+                       relative_step_size,
+                       &step_sizes[column]);
+      for (int j = 0; j < block_size; ++j, ++column) {
+        double* x = batch_parameters[i] +
+            kNumEvaluationsPerColumn * column * block_size + j;
+        x[0] += step_sizes[column];
+        if (kMethod == ceres::CENTRAL) {
+          x[block_size] -= step_sizes[column];
+        }
+      }
+    }
+
+    FixedArray<double> batch_residuals(num_evaluations * kNumResiduals);
+    if (!EvaluateBatchImpl<CostFunctor>::Call(functor,
+                                              num_evaluations,
+                                              batch_parameters.get(),
+                                              batch_residuals.get())) {
+      return false;
+    }
+
+    for (int i = 0, column = 0; i < kNumParameterBlocks; ++i) {
+      if (jacobians[i] == NULL) {
+        continue;
+      }
+      const int block_size = kBlockSizes[i];
+      for (int j = 0; j < block_size; ++j, ++column) {
+        const double* forward_residuals = batch_residuals.get() +
+            kNumEvaluationsPerColumn * column * kNumResiduals;
+        const double* backward_residuals = (kMethod == ceres::CENTRAL)
+            ? forward_residuals + kNumResiduals
+            : residuals_at_eval_point;
+        const double one_over_delta =
+            1.0 / (kNumEvaluationsPerColumn * step_sizes[column]);
+        for (int r = 0; r < kNumResiduals; ++r) {
+          jacobians[i][r * block_size + j] =
+              (forward_residuals[r] - backward_residuals[r]) * one_over_delta;
+        }
+      }
+    }
+    return true;
+  }
+};
+
 }  // namespace internal
 }  // namespace ceres
 
@@ -35,6 +35,8 @@
 #ifndef CERES_PUBLIC_ITERATION_CALLBACK_H_
 #define CERES_PUBLIC_ITERATION_CALLBACK_H_
 
+#include <vector>
+#include "ceres/internal/port.h"
 #include "ceres/types.h"
 
 namespace ceres {
@@ -201,6 +203,26 @@ class IterationCallback {
  public:
   virtual ~IterationCallback() {}
   virtual CallbackReturnType operator()(const IterationSummary& summary) = 0;
+
+  // When Solver::Options::update_state_every_iteration is true, the
+  // solver copies the current parameter values into the user's
+  // parameter blocks before calling the callbacks. For large problems
+  // this copy can cost as much as an iteration of the solver.
+  //
+  // A callback that only reads some of the parameter blocks can
+  // override this method to store pointers to them in
+  // parameter_blocks and return true. If all the callbacks do so,
+  // only the union of these parameter blocks is updated every
+  // iteration. The other parameter blocks are updated when the solver
+  // terminates, as they would be without update_state_every_iteration
+  // (so they are not updated if a callback returns SOLVER_ABORT).
+  //
+  // The default implementation returns false, i.e., the callback may
+  // read any parameter block.
+  virtual bool ObservedParameterBlocks(
+      vector<double*>* parameter_blocks) const {
+    return false;
+  }
 };
 
 }  // namespace ceres
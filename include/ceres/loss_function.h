@@ -111,6 +111,23 @@ class LossFunction {
   //
   // so that they mimic the least squares cost for small residuals.
   virtual void Evaluate(double sq_norm, double out[3]) const = 0;
+
+  // Evaluates the loss function for num_sq_norms squared norms at
+  // once, i.e. for each i in [0, num_sq_norms)
+  //
+  //   rho0[i] = rho(sq_norms[i]),
+  //   rho1[i] = rho'(sq_norms[i]),
+  //   rho2[i] = rho''(sq_norms[i]).
+  //
+  // When evaluating the cost of a problem, the loss functions of many
+  // residual blocks are evaluated in batches with this method. The
+  // default implementation calls Evaluate() once per squared norm;
+  // the loss functions below override it with vectorized loops.
+  virtual void EvaluateBatch(int num_sq_norms,
+                             const double* sq_norms,
+                             double* rho0,
+                             double* rho1,
+                             double* rho2) const;
 };
 
 // Some common implementations follow below.
@@ -131,6 +148,8 @@ class LossFunction {
 class TrivialLoss : public LossFunction {
  public:
   virtual void Evaluate(double, double*) const;
+  virtual void EvaluateBatch(int, const double*,
+                             double*, double*, double*) const;
 };
 
 // Scaling
@@ -175,6 +194,8 @@ class HuberLoss : public LossFunction {
  public:
   explicit HuberLoss(double a) : a_(a), b_(a * a) { }
   virtual void Evaluate(double, double*) const;
+  virtual void EvaluateBatch(int, const double*,
+                             double*, double*, double*) const;
 
  private:
   const double a_;
@@ -191,6 +212,8 @@ class SoftLOneLoss : public LossFunction {
  public:
   explicit SoftLOneLoss(double a) : b_(a * a), c_(1 / b_) { }
   virtual void Evaluate(double, double*) const;
+  virtual void EvaluateBatch(int, const double*,
+                             double*, double*, double*) const;
 
  private:
   // b = a^2.
@@ -208,6 +231,8 @@ class CauchyLoss : public LossFunction {
  public:
   explicit CauchyLoss(double a) : b_(a * a), c_(1 / b_) { }
   virtual void Evaluate(double, double*) const;
+  virtual void EvaluateBatch(int, const double*,
+                             double*, double*, double*) const;
 
  private:
   // b = a^2.
@@ -229,6 +254,8 @@ class ArctanLoss : public LossFunction {
  public:
   explicit ArctanLoss(double a) : a_(a), b_(1 / (a * a)) { }
   virtual void Evaluate(double, double*) const;
+  virtual void EvaluateBatch(int, const double*,
+                             double*, double*, double*) const;
 
  private:
   const double a_;
@@ -319,6 +346,8 @@ class ScaledLoss : public LossFunction {
     }
   }
   virtual void Evaluate(double, double*) const;
+  virtual void EvaluateBatch(int, const double*,
+                             double*, double*, double*) const;
 
  private:
   internal::scoped_ptr<const LossFunction> rho_;
@@ -378,6 +407,15 @@ class LossFunctionWrapper : public LossFunction {
     rho_->Evaluate(sq_norm, out);
   }
 
+  virtual void EvaluateBatch(int num_sq_norms,
+                             const double* sq_norms,
+                             double* rho0,
+                             double* rho1,
+                             double* rho2) const {
+    CHECK_NOTNULL(rho_.get());
+    rho_->EvaluateBatch(num_sq_norms, sq_norms, rho0, rho1, rho2);
+  }
+
   void Reset(LossFunction* rho, Ownership ownership) {
     if (ownership_ == DO_NOT_TAKE_OWNERSHIP) {
       rho_.release();
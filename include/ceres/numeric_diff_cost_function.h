@@ -102,6 +102,19 @@
 // central differences begin with, and only after that works, trying forward
 // difference to improve performance.
 //
+// If the derivatives need to be more accurate than central differences
+// allow, use RIDDERS, which extrapolates central differences computed
+// with a sequence of decreasing step sizes. It is much more accurate
+// and much less sensitive to the choice of the step size, but also
+// much more expensive. The step sizes and the stopping criteria are
+// controlled by NumericDiffOptions, which can be passed to the
+// constructor.
+//
+// For expensive functors or large parameter blocks, the jacobian
+// columns computed with CENTRAL or FORWARD differences can be
+// evaluated in parallel by setting NumericDiffOptions::num_threads.
+// The functor must then be thread safe.
+//
 // TODO(sameeragarwal): Add support for dynamic number of residuals.
 //
 // WARNING #1: A common beginner's error when first using
@@ -141,6 +154,27 @@
 // where MyCostFunction has 1 residual and 2 parameter blocks with sizes 4 and 8
 // respectively. Look at the tests for a more detailed example.
 //
+////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////
+//
+// BATCHED EVALUATION
+//
+// Computing the jacobians with FORWARD or CENTRAL differences requires
+// one or two evaluations of the functor per parameter. If, in addition
+// to operator() (or Evaluate() for the alternate interface), the
+// functor has a member function
+//
+//   bool EvaluateBatch(int num_evaluations,
+//                      double const* const* parameters,
+//                      double* residuals) const;
+//
+// then all the perturbed parameter vectors are passed to a single call
+// of EvaluateBatch, which allows the functor to vectorize across them
+// or share work between them. The k-th parameter vector has its i-th
+// parameter block at parameters[i] + k * Ni, where Ni is the size of
+// that block, and its residuals must be written to
+// residuals + k * kNumResiduals. RIDDERS does not use EvaluateBatch.
+//
 // TODO(keir): Characterize accuracy; mention pitfalls; provide alternatives.
 
 #ifndef CERES_PUBLIC_NUMERIC_DIFF_COST_FUNCTION_H_
@@ -151,6 +185,7 @@
 #include "ceres/cost_function.h"
 #include "ceres/internal/numeric_diff.h"
 #include "ceres/internal/scoped_ptr.h"
+#include "ceres/numeric_diff_options.h"
 #include "ceres/sized_cost_function.h"
 #include "ceres/types.h"
 
@@ -178,14 +213,25 @@ class NumericDiffCostFunction
                           const double relative_step_size = 1e-6)
       :functor_(functor),
        ownership_(TAKE_OWNERSHIP),
-       relative_step_size_(relative_step_size) {}
+       options_(OptionsWithRelativeStepSize(relative_step_size)) {}
 
   NumericDiffCostFunction(CostFunctor* functor,
                           Ownership ownership,
                           const double relative_step_size = 1e-6)
       : functor_(functor),
         ownership_(ownership),
-        relative_step_size_(relative_step_size) {}
+        options_(OptionsWithRelativeStepSize(relative_step_size)) {}
+
+  NumericDiffCostFunction(CostFunctor* functor,
+                          Ownership ownership,
+                          const NumericDiffOptions& options)
+      : functor_(functor),
+        ownership_(ownership),
+        options_(options) {
+    CHECK_GT(options.max_num_ridders_extrapolations, 0);
+    CHECK_GT(options.ridders_step_shrink_factor, 1.0);
+    CHECK_GE(options.num_threads, 1);
+  }
 
   ~NumericDiffCostFunction() {
     if (ownership_ != TAKE_OWNERSHIP) {
@@ -218,6 +264,32 @@ class NumericDiffCostFunction
       return true;
     }
 
+    if (method != RIDDERS && internal::HasEvaluateBatch<CostFunctor>::value) {
+      return internal::BatchedNumericDiff<CostFunctor,
+                                          method,
+                                          kNumResiduals,
+                                          N0, N1, N2, N3, N4,
+                                          N5, N6, N7, N8, N9>::
+          EvaluateJacobians(functor_.get(),
+                            residuals,
+                            options_.relative_step_size,
+                            parameters,
+                            jacobians);
+    }
+
+    // The columns are evaluated by calling Evaluate with NULL
+    // jacobians, which only evaluates the functor.
+    if (method != RIDDERS && options_.num_threads > 1) {
+      return internal::EvaluateJacobianColumnsInParallel(
+          this,
+          method,
+          options_.relative_step_size,
+          options_.num_threads,
+          parameters,
+          residuals,
+          jacobians);
+    }
+
     // Create a copy of the parameters which will get mutated.
     FixedArray<double> parameters_copy(kNumParameters);
     FixedArray<double*> parameters_reference_copy(kNumParameterBlocks);
@@ -230,8 +302,8 @@ class NumericDiffCostFunction
     if (N5) parameters_reference_copy[5] = parameters_reference_copy[4] + N4;
     if (N6) parameters_reference_copy[6] = parameters_reference_copy[5] + N5;
     if (N7) parameters_reference_copy[7] = parameters_reference_copy[6] + N6;
-    if (N7) parameters_reference_copy[8] = parameters_reference_copy[7] + N7;
-    if (N8) parameters_reference_copy[9] = parameters_reference_copy[8] + N8;
+    if (N8) parameters_reference_copy[8] = parameters_reference_copy[7] + N7;
+    if (N9) parameters_reference_copy[9] = parameters_reference_copy[8] + N8;
 
 #define COPY_PARAMETER_BLOCK(block)                                     \
   if (N ## block) memcpy(parameters_reference_copy[block],              \
@@ -261,7 +333,7 @@ class NumericDiffCostFunction
                        N ## block >::EvaluateJacobianForParameterBlock( \
                            functor_.get(),                              \
                            residuals,                                   \
-                           relative_step_size_,                         \
+                           options_,                                    \
                            parameters_reference_copy.get(),             \
                            jacobians[block])) {                         \
         return false;                                                   \
@@ -285,9 +357,16 @@ class NumericDiffCostFunction
   }
 
  private:
+  static NumericDiffOptions OptionsWithRelativeStepSize(
+      const double relative_step_size) {
+    NumericDiffOptions options;
+    options.relative_step_size = relative_step_size;
+    return options;
+  }
+
   internal::scoped_ptr<CostFunctor> functor_;
   Ownership ownership_;
-  const double relative_step_size_;
+  const NumericDiffOptions options_;
 };
 
 }  // namespace ceres
@@ -0,0 +1,88 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Options controlling the numeric differentiation performed by
+// NumericDiffCostFunction.
+
+#ifndef CERES_PUBLIC_NUMERIC_DIFF_OPTIONS_H_
+#define CERES_PUBLIC_NUMERIC_DIFF_OPTIONS_H_
+
+namespace ceres {
+
+struct NumericDiffOptions {
+  NumericDiffOptions() {
+    relative_step_size = 1e-6;
+    ridders_relative_initial_step_size = 1e-2;
+    max_num_ridders_extrapolations = 10;
+    ridders_epsilon = 1e-12;
+    ridders_step_shrink_factor = 2.0;
+    num_threads = 1;
+  }
+
+  // Step size used by the CENTRAL and FORWARD methods, relative to the
+  // magnitude of the parameter being perturbed. Parameters which are
+  // exactly zero use the mean step size of the other parameters in
+  // their parameter block.
+  double relative_step_size;
+
+  // The RIDDERS method evaluates central differences with step sizes
+  // decreasing geometrically, starting from
+  // ridders_relative_initial_step_size (relative to the magnitude of
+  // the parameter, as above) and shrinking by a factor of
+  // ridders_step_shrink_factor each time, and extrapolates them to a
+  // step size of zero.
+  //
+  // The extrapolation stops after max_num_ridders_extrapolations
+  // steps, once the estimated error of the derivative is below
+  // ridders_epsilon, or once the error starts increasing, which
+  // happens when the step size becomes small enough for round off to
+  // dominate.
+  //
+  // Ridders' method is much more accurate than central differences
+  // and much less sensitive to the choice of the step size, at the
+  // cost of many more evaluations of the functor.
+  double ridders_relative_initial_step_size;
+  int max_num_ridders_extrapolations;
+  double ridders_epsilon;
+  double ridders_step_shrink_factor;
+
+  // Number of threads used to evaluate the columns of the jacobians
+  // with the CENTRAL and FORWARD methods. Each column requires one or
+  // two evaluations of the functor, so this is only worth it for
+  // expensive functors or large parameter blocks. If num_threads > 1,
+  // the functor must be safe to call from several threads at once.
+  //
+  // Threads are only used if Ceres was built with OpenMP. This option
+  // is ignored by the RIDDERS method, and for functors with an
+  // EvaluateBatch method, see NumericDiffCostFunction.
+  int num_threads;
+};
+
+}  // namespace ceres
+
+#endif  // CERES_PUBLIC_NUMERIC_DIFF_OPTIONS_H_
@@ -408,6 +408,61 @@ class Problem {
                 vector<double>* gradient,
                 CRSMatrix* jacobian);
 
+  // Every call to Evaluate sets up the evaluation from scratch. When
+  // the same set of residual and parameter blocks is evaluated over
+  // and over again, e.g., in a robust reweighting loop, the cost of
+  // this setup can exceed the cost of the evaluation itself. An
+  // EvaluationContext does this setup once, and can then be used to
+  // evaluate the problem any number of times.
+  //
+  //   Problem::EvaluateOptions options;
+  //   options.residual_blocks = ...;
+  //   scoped_ptr<Problem::EvaluationContext> context(
+  //       problem.CreateEvaluationContext(options));
+  //
+  //   vector<double> residuals(context->NumResiduals());
+  //   CRSMatrix jacobian;
+  //   while (...) {
+  //     // Update the parameter blocks.
+  //     ...
+  //     context->Evaluate(&cost, &residuals[0], NULL, &jacobian);
+  //   }
+  //
+  // The context is only valid as long as the residual and parameter
+  // blocks it was created with are not removed from the problem, and
+  // the parameter blocks in options.parameter_blocks are not made
+  // constant or variable, and do not get a local parameterization
+  // with a different local size, e.g., through SetParameterization.
+  // Evaluate returns false if the constancy or the local size of one
+  // of them changed. Evaluations using different contexts, or
+  // using a context and Problem::Evaluate, must not run concurrently.
+  class EvaluationContext {
+   public:
+    virtual ~EvaluationContext() {}
+
+    // Same as Problem::Evaluate with the options the context was
+    // created with, except that the outputs are not resized. If not
+    // NULL, residuals must point to an array of size NumResiduals()
+    // and gradient to an array of size NumEffectiveParameters(). The
+    // structure of the jacobian is only computed once. If jacobian
+    // already holds it, e.g. because it was filled in by a previous
+    // call, only its values are updated.
+    virtual bool Evaluate(double* cost,
+                          double* residuals,
+                          double* gradient,
+                          CRSMatrix* jacobian) = 0;
+
+    // The size of the residual vector and the number of columns of
+    // the jacobian respectively.
+    virtual int NumResiduals() const = 0;
+    virtual int NumEffectiveParameters() const = 0;
+  };
+
+  // Create an EvaluationContext for the residual and parameter blocks
+  // in options. The caller owns the result. Returns NULL if the
+  // context cannot be created.
+  EvaluationContext* CreateEvaluationContext(const EvaluateOptions& options);
+
  private:
   friend class Solver;
   internal::scoped_ptr<internal::ProblemImpl> problem_impl_;
@@ -51,6 +51,8 @@
 
 namespace ceres {
 
+template <typename T, int N> struct Jet;
+
 // Trivial wrapper to index linear arrays as matrices, given a fixed
 // column and row stride. When an array "T* array" is wrapped by a
 //
@@ -195,6 +197,58 @@ T DotProduct(const T x[3], const T y[3]);
 template<typename T> inline
 void AngleAxisRotatePoint(const T angle_axis[3], const T pt[3], T result[3]);
 
+// Same as AngleAxisRotatePoint, UnitQuaternionRotatePoint and
+// QuaternionRotatePoint, but also compute the closed form jacobians of
+// result with respect to the rotation and the point, in row-major
+// order. jacobian_angle_axis and jacobian_pt are 3x3 matrices and
+// jacobian_quaternion is a 3x4 matrix. Either jacobian may be NULL, in
+// which case it is not computed.
+//
+// These are meant for cost functions which compute their own
+// derivatives, e.g. subclasses of SizedCostFunction. Automatically
+// differentiated functors get the same derivatives through the
+// overloads for Jets below.
+template<typename T> inline
+void AngleAxisRotatePointWithJacobians(const T angle_axis[3],
+                                       const T pt[3],
+                                       T result[3],
+                                       T jacobian_angle_axis[3 * 3],
+                                       T jacobian_pt[3 * 3]);
+
+template<typename T> inline
+void UnitQuaternionRotatePointWithJacobians(const T q[4],
+                                            const T pt[3],
+                                            T result[3],
+                                            T jacobian_quaternion[3 * 4],
+                                            T jacobian_pt[3 * 3]);
+
+template<typename T> inline
+void QuaternionRotatePointWithJacobians(const T q[4],
+                                        const T pt[3],
+                                        T result[3],
+                                        T jacobian_quaternion[3 * 4],
+                                        T jacobian_pt[3 * 3]);
+
+// Overloads of AngleAxisRotatePoint, UnitQuaternionRotatePoint and
+// QuaternionRotatePoint for Jets. Instead of carrying the derivatives
+// through every arithmetic operation of the rotation, they rotate the
+// scalar parts and apply the closed form jacobians above to the
+// derivative parts.
+template<typename T, int N> inline
+void AngleAxisRotatePoint(const Jet<T, N> angle_axis[3],
+                          const Jet<T, N> pt[3],
+                          Jet<T, N> result[3]);
+
+template<typename T, int N> inline
+void UnitQuaternionRotatePoint(const Jet<T, N> q[4],
+                               const Jet<T, N> pt[3],
+                               Jet<T, N> result[3]);
+
+template<typename T, int N> inline
+void QuaternionRotatePoint(const Jet<T, N> q[4],
+                           const Jet<T, N> pt[3],
+                           Jet<T, N> result[3]);
+
 // --- IMPLEMENTATION
 
 template<typename T, int row_stride, int col_stride>
@@ -633,6 +687,292 @@ void AngleAxisRotatePoint(const T angle_axis[3], const T pt[3], T result[3]) {
   }
 }
 
+template<typename T> inline
+void AngleAxisRotatePointWithJacobians(const T angle_axis[3],
+                                       const T pt[3],
+                                       T result[3],
+                                       T jacobian_angle_axis[3 * 3],
+                                       T jacobian_pt[3 * 3]) {
+  const T& w0 = angle_axis[0];
+  const T& w1 = angle_axis[1];
+  const T& w2 = angle_axis[2];
+  const T theta2 = DotProduct(angle_axis, angle_axis);
+
+  // With theta = |angle_axis| and W the cross product matrix of
+  // angle_axis, the rotation matrix is
+  //
+  //   R = I + sin(theta) / theta * W + (1 - cos(theta)) / theta^2 * W^2
+  //
+  // Near zero the three coefficients below are evaluated using their
+  // Taylor series, since the closed form expressions lose all their
+  // precision to cancellation.
+  T sin_by_theta;
+  T one_minus_cos_by_theta2;
+  T theta_minus_sin_by_theta3;
+  if (theta2 > T(1e-4)) {
+    const T theta = sqrt(theta2);
+    const T sintheta = sin(theta);
+    sin_by_theta = sintheta / theta;
+    one_minus_cos_by_theta2 = (T(1.0) - cos(theta)) / theta2;
+    theta_minus_sin_by_theta3 = (theta - sintheta) / (theta * theta2);
+  } else {
+    sin_by_theta =
+        T(1.0) - theta2 * (T(1.0 / 6.0) - theta2 * T(1.0 / 120.0));
+    one_minus_cos_by_theta2 =
+        T(0.5) - theta2 * (T(1.0 / 24.0) - theta2 * T(1.0 / 720.0));
+    theta_minus_sin_by_theta3 =
+        T(1.0 / 6.0) - theta2 * (T(1.0 / 120.0) - theta2 * T(1.0 / 5040.0));
+  }
+
+  // R = cos(theta) * I + sin(theta) / theta * W
+  //     + (1 - cos(theta)) / theta^2 * angle_axis * angle_axis',
+  // using W^2 = angle_axis * angle_axis' - theta^2 * I.
+  const T costheta = T(1.0) - theta2 * one_minus_cos_by_theta2;
+  const T a = sin_by_theta;
+  const T b = one_minus_cos_by_theta2;
+  const T R[9] = {
+    costheta + b * w0 * w0, b * w0 * w1 - a * w2,   b * w0 * w2 + a * w1,
+    b * w1 * w0 + a * w2,   costheta + b * w1 * w1, b * w1 * w2 - a * w0,
+    b * w2 * w0 - a * w1,   b * w2 * w1 + a * w0,   costheta + b * w2 * w2
+  };
+
+  const T r[3] = {
+    R[0] * pt[0] + R[1] * pt[1] + R[2] * pt[2],
+    R[3] * pt[0] + R[4] * pt[1] + R[5] * pt[2],
+    R[6] * pt[0] + R[7] * pt[1] + R[8] * pt[2]
+  };
+
+  if (jacobian_pt != NULL) {
+    std::copy(R, R + 9, jacobian_pt);
+  }
+
+  if (jacobian_angle_axis != NULL) {
+    // Perturbing angle_axis by delta rotates R * pt by J * delta, where
+    // J is the left jacobian of SO(3),
+    //
+    //   J = I + (1 - cos(theta)) / theta^2 * W
+    //         + (theta - sin(theta)) / theta^3 * W^2,
+    //
+    // so that the derivative of R * pt is -[R * pt]_x * J.
+    const T c = one_minus_cos_by_theta2;
+    const T d = theta_minus_sin_by_theta3;
+    const T e = T(1.0) - d * theta2;
+    const T J[9] = {
+      e + d * w0 * w0,      d * w0 * w1 - c * w2, d * w0 * w2 + c * w1,
+      d * w1 * w0 + c * w2, e + d * w1 * w1,      d * w1 * w2 - c * w0,
+      d * w2 * w0 - c * w1, d * w2 * w1 + c * w0, e + d * w2 * w2
+    };
+    for (int j = 0; j < 3; ++j) {
+      jacobian_angle_axis[j]     = r[2] * J[3 + j] - r[1] * J[6 + j];
+      jacobian_angle_axis[3 + j] = r[0] * J[6 + j] - r[2] * J[j];
+      jacobian_angle_axis[6 + j] = r[1] * J[j] - r[0] * J[3 + j];
+    }
+  }
+
+  result[0] = r[0];
+  result[1] = r[1];
+  result[2] = r[2];
+}
+
+template<typename T> inline
+void UnitQuaternionRotatePointWithJacobians(const T q[4],
+                                            const T pt[3],
+                                            T result[3],
+                                            T jacobian_quaternion[3 * 4],
+                                            T jacobian_pt[3 * 3]) {
+  // The rotation matrix used by UnitQuaternionRotatePoint, i.e.
+  // result = (I + 2 * A) * pt.
+  const T A[9] = {
+    -q[2] * q[2] - q[3] * q[3], q[1] * q[2] - q[0] * q[3], q[0] * q[2] + q[1] * q[3],  // NOLINT
+    q[0] * q[3] + q[1] * q[2], -q[1] * q[1] - q[3] * q[3], q[2] * q[3] - q[0] * q[1],  // NOLINT
+    q[1] * q[3] - q[0] * q[2], q[0] * q[1] + q[2] * q[3], -q[1] * q[1] - q[2] * q[2]   // NOLINT
+  };
+
+  if (jacobian_quaternion != NULL) {
+    const T& p0 = pt[0];
+    const T& p1 = pt[1];
+    const T& p2 = pt[2];
+    const T two_q0[3] = { T(2.0) * q[0] * p0, T(2.0) * q[0] * p1, T(2.0) * q[0] * p2 };  // NOLINT
+    const T two_q1[3] = { T(2.0) * q[1] * p0, T(2.0) * q[1] * p1, T(2.0) * q[1] * p2 };  // NOLINT
+    const T two_q2[3] = { T(2.0) * q[2] * p0, T(2.0) * q[2] * p1, T(2.0) * q[2] * p2 };  // NOLINT
+    const T two_q3[3] = { T(2.0) * q[3] * p0, T(2.0) * q[3] * p1, T(2.0) * q[3] * p2 };  // NOLINT
+    T* J = jacobian_quaternion;
+    J[0]  = two_q2[2] - two_q3[1];
+    J[1]  = two_q2[1] + two_q3[2];
+    J[2]  = two_q1[1] + two_q0[2] - T(2.0) * two_q2[0];
+    J[3]  = two_q1[2] - two_q0[1] - T(2.0) * two_q3[0];
+    J[4]  = two_q3[0] - two_q1[2];
+    J[5]  = two_q2[0] - two_q0[2] - T(2.0) * two_q1[1];
+    J[6]  = two_q1[0] + two_q3[2];
+    J[7]  = two_q0[0] + two_q2[2] - T(2.0) * two_q3[1];
+    J[8]  = two_q1[1] - two_q2[0];
+    J[9]  = two_q3[0] + two_q0[1] - T(2.0) * two_q1[2];
+    J[10] = two_q3[1] - two_q0[0] - T(2.0) * two_q2[2];
+    J[11] = two_q1[0] + two_q2[1];
+  }
+
+  if (jacobian_pt != NULL) {
+    for (int i = 0; i < 9; ++i) {
+      jacobian_pt[i] = T(2.0) * A[i];
+    }
+    jacobian_pt[0] += T(1.0);
+    jacobian_pt[4] += T(1.0);
+    jacobian_pt[8] += T(1.0);
+  }
+
+  const T r[3] = {
+    T(2.0) * (A[0] * pt[0] + A[1] * pt[1] + A[2] * pt[2]) + pt[0],
+    T(2.0) * (A[3] * pt[0] + A[4] * pt[1] + A[5] * pt[2]) + pt[1],
+    T(2.0) * (A[6] * pt[0] + A[7] * pt[1] + A[8] * pt[2]) + pt[2]
+  };
+  result[0] = r[0];
+  result[1] = r[1];
+  result[2] = r[2];
+}
+
+template<typename T> inline
+void QuaternionRotatePointWithJacobians(const T q[4],
+                                        const T pt[3],
+                                        T result[3],
+                                        T jacobian_quaternion[3 * 4],
+                                        T jacobian_pt[3 * 3]) {
+  // 'scale' is 1 / norm(q).
+  const T scale = T(1) / sqrt(q[0] * q[0] +
+                              q[1] * q[1] +
+                              q[2] * q[2] +
+                              q[3] * q[3]);
+
+  // Make unit-norm version of q.
+  const T unit[4] = {
+    scale * q[0],
+    scale * q[1],
+    scale * q[2],
+    scale * q[3],
+  };
+
+  UnitQuaternionRotatePointWithJacobians(unit,
+                                         pt,
+                                         result,
+                                         jacobian_quaternion,
+                                         jacobian_pt);
+  if (jacobian_quaternion == NULL) {
+    return;
+  }
+
+  // Chain rule through the normalization, whose jacobian is
+  // (I - unit * unit') * scale.
+  for (int i = 0; i < 3; ++i) {
+    T* J = jacobian_quaternion + 4 * i;
+    const T J_unit = J[0] * unit[0] + J[1] * unit[1] +
+                     J[2] * unit[2] + J[3] * unit[3];
+    for (int j = 0; j < 4; ++j) {
+      J[j] = scale * (J[j] - J_unit * unit[j]);
+    }
+  }
+}
+
+namespace internal {
+
+// Sets result to the rotated point with value value and derivative
+//
+//   jacobian_rotation * rotation.v + jacobian_pt * pt.v,
+//
+// where the jacobians are row-major. result is only written once all
+// of its entries have been computed, so it may alias pt.
+template<int kRotationSize, typename T, int N> inline
+void SetRotatedPointJets(const T value[3],
+                         const T* jacobian_rotation,
+                         const Jet<T, N>* rotation,
+                         const T jacobian_pt[3 * 3],
+                         const Jet<T, N> pt[3],
+                         Jet<T, N> result[3]) {
+  Jet<T, N> r[3];
+  for (int i = 0; i < 3; ++i) {
+    const T* jacobian_rotation_row = jacobian_rotation + kRotationSize * i;
+    const T* jacobian_pt_row = jacobian_pt + 3 * i;
+    r[i].a = value[i];
+    r[i].v = jacobian_pt_row[0] * pt[0].v +
+             jacobian_pt_row[1] * pt[1].v +
+             jacobian_pt_row[2] * pt[2].v;
+    for (int j = 0; j < kRotationSize; ++j) {
+      r[i].v += jacobian_rotation_row[j] * rotation[j].v;
+    }
+  }
+  result[0] = r[0];
+  result[1] = r[1];
+  result[2] = r[2];
+}
+
+}  // namespace internal
+
+template<typename T, int N> inline
+void AngleAxisRotatePoint(const Jet<T, N> angle_axis[3],
+                          const Jet<T, N> pt[3],
+                          Jet<T, N> result[3]) {
+  const T angle_axis_value[3] = { angle_axis[0].a,
+                                  angle_axis[1].a,
+                                  angle_axis[2].a };
+  const T pt_value[3] = { pt[0].a, pt[1].a, pt[2].a };
+  T value[3];
+  T jacobian_angle_axis[3 * 3];
+  T jacobian_pt[3 * 3];
+  AngleAxisRotatePointWithJacobians(angle_axis_value,
+                                    pt_value,
+                                    value,
+                                    jacobian_angle_axis,
+                                    jacobian_pt);
+  internal::SetRotatedPointJets<3>(value,
+                                   jacobian_angle_axis,
+                                   angle_axis,
+                                   jacobian_pt,
+                                   pt,
+                                   result);
+}
+
+template<typename T, int N> inline
+void UnitQuaternionRotatePoint(const Jet<T, N> q[4],
+                               const Jet<T, N> pt[3],
+                               Jet<T, N> result[3]) {
+  const T q_value[4] = { q[0].a, q[1].a, q[2].a, q[3].a };
+  const T pt_value[3] = { pt[0].a, pt[1].a, pt[2].a };
+  T value[3];
+  T jacobian_quaternion[3 * 4];
+  T jacobian_pt[3 * 3];
+  UnitQuaternionRotatePointWithJacobians(q_value,
+                                         pt_value,
+                                         value,
+                                         jacobian_quaternion,
+                                         jacobian_pt);
+  internal::SetRotatedPointJets<4>(value,
+                                   jacobian_quaternion,
+                                   q,
+                                   jacobian_pt,
+                                   pt,
+                                   result);
+}
+
+template<typename T, int N> inline
+void QuaternionRotatePoint(const Jet<T, N> q[4],
+                           const Jet<T, N> pt[3],
+                           Jet<T, N> result[3]) {
+  const T q_value[4] = { q[0].a, q[1].a, q[2].a, q[3].a };
+  const T pt_value[3] = { pt[0].a, pt[1].a, pt[2].a };
+  T value[3];
+  T jacobian_quaternion[3 * 4];
+  T jacobian_pt[3 * 3];
+  QuaternionRotatePointWithJacobians(q_value,
+                                     pt_value,
+                                     value,
+                                     jacobian_quaternion,
+                                     jacobian_pt);
+  internal::SetRotatedPointJets<4>(value,
+                                   jacobian_quaternion,
+                                   q,
+                                   jacobian_pt,
+                                   pt,
+                                   result);
+}
+
 }  // namespace ceres
 
 #endif  // CERES_PUBLIC_ROTATION_H_
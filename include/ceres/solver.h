@@ -67,6 +67,7 @@ class Solver {
       dogleg_type = TRADITIONAL_DOGLEG;
       use_nonmonotonic_steps = false;
       max_consecutive_nonmonotonic_steps = 5;
+      use_speculative_jacobian_evaluation = false;
       max_num_iterations = 50;
       max_solver_time_in_seconds = 1e9;
       num_threads = 1;
@@ -101,6 +102,11 @@ class Solver {
 #else
       use_block_amd = true;
 #endif
+      use_nested_dissection_ordering = false;
+      use_mixed_precision_solves = false;
+      max_num_refinement_iterations = 10;
+      max_schur_products_memory_in_mb = 1024;
+      use_single_precision_jacobian = false;
       linear_solver_ordering = NULL;
       use_inner_iterations = false;
       inner_iteration_ordering = NULL;
@@ -114,6 +120,7 @@ class Solver {
       lsqp_dump_format_type = TEXTFILE;
       check_gradients = false;
       gradient_check_relative_precision = 1e-8;
+      gradient_check_num_samples_per_type = 0;
       numeric_derivative_relative_step_size = 1e-6;
       update_state_every_iteration = false;
     }
@@ -209,6 +216,25 @@ class Solver {
     bool use_nonmonotonic_steps;
     int max_consecutive_nonmonotonic_steps;
 
+    // By default the trust region minimizer evaluates only the cost
+    // at the candidate point, and if the step is accepted, evaluates
+    // the residuals and the Jacobian at the new point in a second
+    // pass over the residual blocks.
+    //
+    // If use_speculative_jacobian_evaluation is true, the residuals
+    // and the Jacobian are evaluated along with the cost at every
+    // candidate point into a second Jacobian buffer, which is swapped
+    // in if the step is accepted. This saves a pass over the
+    // residual blocks per successful step, at the cost of storing a
+    // second Jacobian and of wasted Jacobian evaluations on
+    // unsuccessful steps. It pays off for problems where most steps
+    // are accepted and the per residual block evaluation overhead is
+    // significant.
+    //
+    // Candidate points modified by inner iterations are re-evaluated
+    // as usual.
+    bool use_speculative_jacobian_evaluation;
+
     // Maximum number of iterations for the minimizer to run for.
     int max_num_iterations;
 
@@ -370,6 +396,51 @@ class Solver {
     // sparse_linear_algebra_library = SUITE_SPARSE.
     bool use_block_amd;
 
+    // For SPARSE_SCHUR, compute the fill-reducing ordering of the
+    // reduced camera matrix using nested dissection on the graph of
+    // its blocks, instead of (block) AMD. Nested dissection produces
+    // much less fill than AMD for reduced camera matrices whose
+    // camera graphs are nearly planar, e.g., those of large outdoor
+    // reconstructions. The ordering is computed by Ceres and does not
+    // depend on METIS. Works with both SUITE_SPARSE and CX_SPARSE,
+    // and overrides use_block_amd.
+    bool use_nested_dissection_ordering;
+
+    // For DENSE_NORMAL_CHOLESKY and DENSE_SCHUR, factorize the dense
+    // linear system in single precision and recover double precision
+    // accuracy using iterative refinement with residuals computed in
+    // double precision. This is about twice as fast for large dense
+    // systems. If the system is too ill-conditioned for this to
+    // converge in max_num_refinement_iterations iterations, Ceres
+    // falls back to a double precision factorization.
+    bool use_mixed_precision_solves;
+    int max_num_refinement_iterations;
+
+    // For DENSE_SCHUR and SPARSE_SCHUR, the products E_k'E_k, E_k'F_k
+    // and E'b computed while eliminating the e_blocks, along with the
+    // inverses of the diagonal blocks E_k'E_k + D_k'D_k, are stored
+    // if their total size is at most this many megabytes. They are
+    // used to solve for the e_blocks without touching the Jacobian
+    // again, and to re-eliminate when only the LM diagonal changes
+    // after a rejected step. Set it to zero to never store them.
+    int max_schur_products_memory_in_mb;
+
+    // For ITERATIVE_SCHUR and CGNR, perform the products of the
+    // Jacobian with vectors in the conjugate gradients iterations
+    // using a copy of the Jacobian stored in single precision, made
+    // once per linear solve. The products are accumulated in double
+    // precision. This halves the memory traffic of the iterations,
+    // which are usually bandwidth bound, at the cost of rounding the
+    // Jacobian to single precision. The preconditioners are computed
+    // in double precision.
+    //
+    // The single precision copy is stored in addition to the double
+    // precision Jacobian, so this option increases the memory used by
+    // about half the size of the values of the Jacobian. It only
+    // reduces memory bandwidth, and does not help fitting larger
+    // problems in memory.
+    bool use_single_precision_jacobian;
+
     // Some non-linear least squares problems have additional
     // structure in the way the parameter blocks interact that it is
     // beneficial to modify the way the trust region step is computed.
@@ -477,9 +548,12 @@ class Solver {
 
     // List of iterations at which the optimizer should dump the
     // linear least squares problem to disk. Useful for testing and
-    // benchmarking. If empty (default), no problems are dumped.
+    // benchmarking. If empty (default), no problems are dumped. Only
+    // the trust region minimizer dumps its linear least squares
+    // problems.
     //
-    // This is ignored if protocol buffers are disabled.
+    // The PROTOBUF format requires protocol buffers, see
+    // DumpFormatType for the formats available without them.
     vector<int> lsqp_iterations_to_dump;
     string lsqp_dump_directory;
     DumpFormatType lsqp_dump_format_type;
@@ -499,6 +573,22 @@ class Solver {
     // this number, then the jacobian for that cost term is dumped.
     double gradient_check_relative_precision;
 
+    // If check_gradients is true and gradient_check_num_samples_per_type
+    // is positive, the jacobians are not checked every time a residual
+    // block is evaluated. Instead, the residual blocks are grouped by
+    // their shape, i.e., the number of residuals and parameter block
+    // sizes of their cost function, and the jacobians of at most
+    // gradient_check_num_samples_per_type randomly chosen residual
+    // blocks of each shape are checked once, at the initial point,
+    // before the minimizer runs. The checks run in parallel using
+    // num_threads threads.
+    //
+    // The results for each shape are reported in
+    // Summary::gradient_check_report, and the bad jacobians are logged
+    // as above. Unlike checking every evaluation, this is cheap enough
+    // to leave enabled on large problems.
+    int gradient_check_num_samples_per_type;
+
     // Relative shift used for taking numeric derivatives. For finite
     // differencing, each dimension is evaluated at slightly shifted
     // values; for the case of central difference, this is what gets
@@ -572,6 +662,11 @@ class Solver {
     // description of the error.
     string error;
 
+    // If the gradients of a sample of the residual blocks were checked
+    // (see Solver::Options::gradient_check_num_samples_per_type), a
+    // table of the results for each residual block shape.
+    string gradient_check_report;
+
     // Cost of the problem before and after the optimization. See
     // problem.h for definition of the cost of a problem.
     double initial_cost;
@@ -112,7 +112,15 @@ enum PreconditionerType {
   // of the scene to determine the sparsity structure of the
   // preconditioner. Requires SuiteSparse/CHOLMOD.
   CLUSTER_JACOBI,
-  CLUSTER_TRIDIAGONAL
+  CLUSTER_TRIDIAGONAL,
+
+  // Additive Schwarz preconditioner for the Schur complement. The
+  // cameras are clustered using their visibility structure, and the
+  // clusters, extended by their most strongly connected neighbours,
+  // are used as overlapping subdomains whose diagonal blocks of the
+  // Schur complement are factorized independently. This
+  // preconditioner may only be used with the ITERATIVE_SCHUR solver.
+  ADDITIVE_SCHWARZ
 };
 
 enum SparseLinearAlgebraLibraryType {
@@ -198,6 +206,15 @@ enum LineSearchType {
   // Backtracking line search with polynomial interpolation or
   // bisection.
   ARMIJO,
+
+  // Line search that finds a step satisfying the strong Wolfe
+  // conditions, using bracketing and cubic interpolation. The
+  // curvature condition makes it a better match for LBFGS, whose
+  // updates need the gradient at the new point to have changed
+  // enough along the search direction. For more details see
+  // Algorithms 3.5 and 3.6 of "Numerical Optimization" by Nocedal &
+  // Wright.
+  WOLFE,
 };
 
 // Ceres supports different strategies for computing the trust region
@@ -324,7 +341,16 @@ enum DumpFormatType {
   //
   // A MATLAB/octave script called lm_iteration_???.m is also output,
   // which can be used to parse and load the problem into memory.
-  TEXTFILE
+  TEXTFILE,
+
+  // Write out the linear least squares problem to the directory
+  // pointed to by Solver::Options::lsqp_dump_directory in a compact,
+  // chunked binary format that is streamed to disk and does not
+  // depend on any external libraries. For details on the on disk
+  // format, see lsqp_binary_file.h. The files are named
+  // lm_iteration_???.lsqp.bin, and can be replayed with the
+  // lsqp_replay tool.
+  BINARY
 };
 
 // For SizedCostFunction and AutoDiffCostFunction, DYNAMIC can be specified for
@@ -336,7 +362,12 @@ enum DimensionType {
 
 enum NumericDiffMethod {
   CENTRAL,
-  FORWARD
+  FORWARD,
+
+  // Central differences with Richardson extrapolation over a sequence
+  // of decreasing step sizes (Ridders' method). See
+  // NumericDiffOptions.
+  RIDDERS
 };
 
 const char* LinearSolverTypeToString(LinearSolverType type);
@@ -30,31 +30,29 @@
 
 #include "ceres/block_evaluate_preparer.h"
 
-#include <vector>
 #include "ceres/block_sparse_matrix.h"
 #include "ceres/casts.h"
-#include "ceres/parameter_block.h"
-#include "ceres/residual_block.h"
+#include "ceres/evaluation_plan.h"
 #include "ceres/sparse_matrix.h"
 
 namespace ceres {
 namespace internal {
 
-void BlockEvaluatePreparer::Init(int const* const* jacobian_layout,
+void BlockEvaluatePreparer::Init(const EvaluationPlan* plan,
+                                 const int* jacobian_offsets,
                                  int max_derivatives_per_residual_block) {
-  jacobian_layout_ = jacobian_layout;
-  scratch_evaluate_preparer_.Init(max_derivatives_per_residual_block);
+  plan_ = plan;
+  jacobian_offsets_ = jacobian_offsets;
+  scratch_evaluate_preparer_.Init(plan, max_derivatives_per_residual_block);
 }
 
 // Point the jacobian blocks directly into the block sparse matrix.
-void BlockEvaluatePreparer::Prepare(const ResidualBlock* residual_block,
-                                    int residual_block_index,
+void BlockEvaluatePreparer::Prepare(int residual_block_index,
                                     SparseMatrix* jacobian,
                                     double** jacobians) {
   // If the overall jacobian is not available, use the scratch space.
   if (jacobian == NULL) {
-    scratch_evaluate_preparer_.Prepare(residual_block,
-                                       residual_block_index,
+    scratch_evaluate_preparer_.Prepare(residual_block_index,
                                        jacobian,
                                        jacobians);
     return;
@@ -63,19 +61,13 @@ void BlockEvaluatePreparer::Prepare(const ResidualBlock* residual_block,
   double* jacobian_values =
       down_cast<BlockSparseMatrix*>(jacobian)->mutable_values();
 
-  const int* jacobian_block_offset = jacobian_layout_[residual_block_index];
-  const int num_parameter_blocks = residual_block->NumParameterBlocks();
-  for (int j = 0; j < num_parameter_blocks; ++j) {
-    if (!residual_block->parameter_blocks()[j]->IsConstant()) {
-      jacobians[j] = jacobian_values + *jacobian_block_offset;
-
-      // The jacobian_block_offset can't be indexed with 'j' since the code
-      // that creates the layout strips out any blocks for inactive
-      // parameters. Instead, bump the pointer for active parameters only.
-      jacobian_block_offset++;
-    } else {
-      jacobians[j] = NULL;
-    }
+  const EvaluationPlan::ResidualBlockEntry& entry =
+      plan_->residual_block(residual_block_index);
+  const int* jacobian_offsets = jacobian_offsets_ + entry.arguments_begin;
+  for (int j = 0; j < entry.num_arguments; ++j) {
+    jacobians[j] = (jacobian_offsets[j] >= 0)
+        ? jacobian_values + jacobian_offsets[j]
+        : NULL;
   }
 }
 
@@ -41,7 +41,7 @@
 namespace ceres {
 namespace internal {
 
-class ResidualBlock;
+class EvaluationPlan;
 class SparseMatrix;
 
 class BlockEvaluatePreparer {
@@ -49,7 +49,8 @@ class BlockEvaluatePreparer {
   // Using Init() instead of a constructor allows for allocating this structure
   // with new[]. This is because C++ doesn't allow passing arguments to objects
   // constructed with new[] (as opposed to plain 'new').
-  void Init(int const* const* jacobian_layout,
+  void Init(const EvaluationPlan* plan,
+            const int* jacobian_offsets,
             int max_derivatives_per_residual_block);
 
   // EvaluatePreparer interface
@@ -57,13 +58,17 @@ class BlockEvaluatePreparer {
   // Point the jacobian blocks directly into the block sparse matrix, if
   // jacobian is non-null. Otherwise, uses an internal per-thread buffer to
   // store the jacobians temporarily.
-  void Prepare(const ResidualBlock* residual_block,
-               int residual_block_index,
+  void Prepare(int residual_block_index,
                SparseMatrix* jacobian,
                double** jacobians);
 
  private:
-  int const* const* jacobian_layout_;
+  const EvaluationPlan* plan_;
+
+  // Offsets of the jacobian blocks in the values array of the block
+  // sparse jacobian, one per argument in the evaluation plan; see
+  // BlockJacobianWriter.
+  const int* jacobian_offsets_;
 
   // For the case that the overall jacobian is not available, but the
   // individual jacobians are requested, use a pass-through scratch evaluate
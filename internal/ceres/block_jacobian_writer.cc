@@ -32,9 +32,9 @@
 
 #include "ceres/block_evaluate_preparer.h"
 #include "ceres/block_sparse_matrix.h"
+#include "ceres/evaluation_plan.h"
 #include "ceres/parameter_block.h"
 #include "ceres/program.h"
-#include "ceres/residual_block.h"
 #include "ceres/internal/eigen.h"
 #include "ceres/internal/port.h"
 #include "ceres/internal/scoped_ptr.h"
@@ -51,69 +51,58 @@ namespace {
 // the first num_eliminate_blocks parameter blocks as indicated by the parameter
 // block ordering. The remaining parameter blocks are the F blocks.
 //
+// The E blocks are laid out in residual block order. Since the Schur ordering
+// places the residual blocks of each E block next to each other, the E blocks
+// of each chunk form a single row major matrix, which the SchurEliminator
+// multiplies in one go, and the F blocks of each chunk are contiguous as well.
+//
 // TODO(keir): Consider if we should use a boolean for each parameter block
 // instead of num_eliminate_blocks.
-void BuildJacobianLayout(const Program& program,
+void BuildJacobianLayout(const EvaluationPlan& plan,
                          int num_eliminate_blocks,
-                         vector<int*>* jacobian_layout,
-                         vector<int>* jacobian_layout_storage) {
-  const vector<ResidualBlock*>& residual_blocks = program.residual_blocks();
-
-  // Iterate over all the active residual blocks and determine how many E blocks
-  // are there. This will determine where the F blocks start in the jacobian
-  // matrix. Also compute the number of jacobian blocks.
+                         vector<int>* jacobian_offsets) {
+  // Iterate over all the arguments and determine the size of the E
+  // blocks. This will determine where the F blocks start in the
+  // jacobian matrix.
   int f_block_pos = 0;
-  int num_jacobian_blocks = 0;
-  for (int i = 0; i < residual_blocks.size(); ++i) {
-    ResidualBlock* residual_block = residual_blocks[i];
-    const int num_residuals = residual_block->NumResiduals();
-    const int num_parameter_blocks = residual_block->NumParameterBlocks();
-
-    // Advance f_block_pos over each E block for this residual.
-    for (int j = 0; j < num_parameter_blocks; ++j) {
-      ParameterBlock* parameter_block = residual_block->parameter_blocks()[j];
-      if (!parameter_block->IsConstant()) {
-        // Only count blocks for active parameters.
-        num_jacobian_blocks++;
-        if (parameter_block->index() < num_eliminate_blocks) {
-          f_block_pos += num_residuals * parameter_block->LocalSize();
-        }
+  for (int i = 0; i < plan.num_residual_blocks(); ++i) {
+    const EvaluationPlan::ResidualBlockEntry& entry = plan.residual_block(i);
+    const EvaluationPlan::Argument* arguments = plan.arguments(i);
+    for (int j = 0; j < entry.num_arguments; ++j) {
+      const int parameter_block_index = arguments[j].parameter_block_index;
+      if (parameter_block_index >= 0 &&
+          parameter_block_index < num_eliminate_blocks) {
+        f_block_pos += entry.num_residuals * arguments[j].local_size;
       }
     }
   }
 
   // We now know that the E blocks are laid out starting at zero, and the F
-  // blocks are laid out starting at f_block_pos. Iterate over the residual
-  // blocks again, and this time fill the jacobian_layout array with the
-  // position information.
-
-  jacobian_layout->resize(program.NumResidualBlocks());
-  jacobian_layout_storage->resize(num_jacobian_blocks);
-
+  // blocks are laid out starting at f_block_pos. Iterate over the arguments
+  // again, and this time fill the jacobian_offsets array with the position
+  // information.
+  jacobian_offsets->resize(plan.num_arguments());
   int e_block_pos = 0;
-  int* jacobian_pos = &(*jacobian_layout_storage)[0];
-  for (int i = 0; i < residual_blocks.size(); ++i) {
-    const ResidualBlock* residual_block = residual_blocks[i];
-    const int num_residuals = residual_block->NumResiduals();
-    const int num_parameter_blocks = residual_block->NumParameterBlocks();
-
-    (*jacobian_layout)[i] = jacobian_pos;
-    for (int j = 0; j < num_parameter_blocks; ++j) {
-      ParameterBlock* parameter_block = residual_block->parameter_blocks()[j];
-      const int parameter_block_index = parameter_block->index();
-      if (parameter_block->IsConstant()) {
+  for (int i = 0; i < plan.num_residual_blocks(); ++i) {
+    const EvaluationPlan::ResidualBlockEntry& entry = plan.residual_block(i);
+    const EvaluationPlan::Argument* arguments = plan.arguments(i);
+    for (int j = 0; j < entry.num_arguments; ++j) {
+      int* jacobian_offset =
+          &(*jacobian_offsets)[entry.arguments_begin + j];
+      const int parameter_block_index = arguments[j].parameter_block_index;
+      if (parameter_block_index < 0) {
+        *jacobian_offset = -1;
         continue;
       }
       const int jacobian_block_size =
-          num_residuals * parameter_block->LocalSize();
+          entry.num_residuals * arguments[j].local_size;
       if (parameter_block_index < num_eliminate_blocks) {
-        *jacobian_pos = e_block_pos;
+        *jacobian_offset = e_block_pos;
         e_block_pos += jacobian_block_size;
       } else {
-        *jacobian_pos = f_block_pos;
+        *jacobian_offset = f_block_pos;
         f_block_pos += jacobian_block_size;
       }
-      jacobian_pos++;
     }
   }
 }
@@ -121,15 +110,14 @@ void BuildJacobianLayout(const Program& program,
 }  // namespace
 
 BlockJacobianWriter::BlockJacobianWriter(const Evaluator::Options& options,
-                                         Program* program)
-    : program_(program) {
+                                         Program* program,
+                                         const EvaluationPlan* plan)
+    : program_(program),
+      plan_(plan) {
   CHECK_GE(options.num_eliminate_blocks, 0)
       << "num_eliminate_blocks must be greater than 0.";
 
-  BuildJacobianLayout(*program,
-                      options.num_eliminate_blocks,
-                      &jacobian_layout_,
-                      &jacobian_layout_storage_);
+  BuildJacobianLayout(*plan, options.num_eliminate_blocks, &jacobian_offsets_);
 }
 
 // Create evaluate prepareres that point directly into the final jacobian. This
@@ -141,7 +129,9 @@ BlockEvaluatePreparer* BlockJacobianWriter::CreateEvaluatePreparers(
 
   BlockEvaluatePreparer* preparers = new BlockEvaluatePreparer[num_threads];
   for (int i = 0; i < num_threads; i++) {
-    preparers[i].Init(&jacobian_layout_[0], max_derivatives_per_residual_block);
+    preparers[i].Init(plan_,
+                      jacobian_offsets_.empty() ? NULL : &jacobian_offsets_[0],
+                      max_derivatives_per_residual_block);
   }
   return preparers;
 }
@@ -163,40 +153,24 @@ SparseMatrix* BlockJacobianWriter::CreateJacobian() const {
   }
 
   // Construct the cells in each row.
-  const vector<ResidualBlock*>& residual_blocks =
-      program_->residual_blocks();
   int row_block_position = 0;
-  bs->rows.resize(residual_blocks.size());
-  for (int i = 0; i < residual_blocks.size(); ++i) {
-    const ResidualBlock* residual_block = residual_blocks[i];
+  bs->rows.resize(plan_->num_residual_blocks());
+  for (int i = 0; i < plan_->num_residual_blocks(); ++i) {
+    const EvaluationPlan::ResidualBlockEntry& entry = plan_->residual_block(i);
+    const EvaluationPlan::Argument* arguments = plan_->arguments(i);
     CompressedRow* row = &bs->rows[i];
 
-    row->block.size = residual_block->NumResiduals();
+    row->block.size = entry.num_residuals;
     row->block.position = row_block_position;
     row_block_position += row->block.size;
 
-    // Size the row by the number of active parameters in this residual.
-    const int num_parameter_blocks = residual_block->NumParameterBlocks();
-    int num_active_parameter_blocks = 0;
-    for (int j = 0; j < num_parameter_blocks; ++j) {
-      if (residual_block->parameter_blocks()[j]->index() != -1) {
-        num_active_parameter_blocks++;
-      }
-    }
-    row->cells.resize(num_active_parameter_blocks);
-
     // Add layout information for the active parameters in this row.
-    for (int j = 0, k = 0; j < num_parameter_blocks; ++j) {
-      const ParameterBlock* parameter_block =
-          residual_block->parameter_blocks()[j];
-      if (!parameter_block->IsConstant()) {
-        Cell& cell = row->cells[k];
-        cell.block_id = parameter_block->index();
-        cell.position = jacobian_layout_[i][k];
-
-        // Only increment k for active parameters, since there is only layout
-        // information for active parameters.
-        k++;
+    row->cells.reserve(entry.num_arguments);
+    for (int j = 0; j < entry.num_arguments; ++j) {
+      if (arguments[j].parameter_block_index >= 0) {
+        const int position = jacobian_offsets_[entry.arguments_begin + j];
+        row->cells.push_back(Cell(arguments[j].parameter_block_index,
+                                  position));
       }
     }
 
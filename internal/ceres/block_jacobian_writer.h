@@ -46,13 +46,15 @@ namespace ceres {
 namespace internal {
 
 class BlockEvaluatePreparer;
+class EvaluationPlan;
 class Program;
 class SparseMatrix;
 
 class BlockJacobianWriter {
  public:
   BlockJacobianWriter(const Evaluator::Options& options,
-                      Program* program);
+                      Program* program,
+                      const EvaluationPlan* plan);
 
   // JacobianWriter interface.
 
@@ -73,6 +75,7 @@ class BlockJacobianWriter {
 
  private:
   Program* program_;
+  const EvaluationPlan* plan_;
 
   // Stores the position of each residual / parameter jacobian.
   //
@@ -86,15 +89,15 @@ class BlockJacobianWriter {
   // find the offset in the values_ array of each residual/parameter jacobian
   // block.
   //
-  // That is the purpose of jacobian_layout_.
+  // That is the purpose of jacobian_offsets_. It has one entry per argument
+  // of the evaluation plan, i.e.,
   //
-  // In particular, jacobian_layout_[i][j] is the offset in the values_ array of
-  // the derivative of residual block i with respect to the parameter block at
-  // active argument position j.
+  //   jacobian_offsets_[plan_->residual_block(i).arguments_begin + j]
   //
-  // The active qualifier means that non-active parameters do not count. Care
-  // must be taken when indexing into jacobian_layout_ to account for this.
-  // Consider a single residual example:
+  // is the offset in the values_ array of the derivative of residual block i
+  // with respect to its j^th parameter block, or -1 if that parameter block
+  // is constant and there is no jacobian block for it. Consider a single
+  // residual example:
   //
   //   r(x, y, z)
   //
@@ -102,23 +105,14 @@ class BlockJacobianWriter {
   // Take y as a constant (non-active) parameter.
   // Take r as residual number 0.
   //
-  // In this case, the active arguments are only (x, z), so the active argument
-  // position for x is 0, and the active argument position for z is 1. This is
-  // similar to thinking of r as taking only 2 parameters:
+  // There are only 2 jacobian blocks: dr/dx and dr/dz. jacobian_offsets_
+  // would have the following contents:
   //
-  //   r(x, z)
-  //
-  // There are only 2 jacobian blocks: dr/dx and dr/dz. jacobian_layout_ would
-  // have the following contents:
-  //
-  //   jacobian_layout_[0] = { 0, 12 }
+  //   jacobian_offsets_ = { 0, -1, 12 }
   //
   // which indicates that dr/dx is located at values_[0], and dr/dz is at
-  // values_[12]. See BlockEvaluatePreparer::Prepare()'s comments about 'j'.
-  vector<int*> jacobian_layout_;
-
-  // The pointers in jacobian_layout_ point directly into this vector.
-  vector<int> jacobian_layout_storage_;
+  // values_[12].
+  vector<int> jacobian_offsets_;
 };
 
 }  // namespace internal
@@ -83,6 +83,9 @@ class BlockRandomAccessDenseMatrix : public BlockRandomAccessMatrix {
   const double* values() const { return values_.get(); }
   double* mutable_values() { return values_.get(); }
 
+  // The row/column offset of each block in the underlying matrix.
+  const vector<int>& block_layout() const { return block_layout_; }
+
  private:
   int num_rows_;
   vector<int> block_layout_;
@@ -37,6 +37,7 @@
 #include "ceres/internal/port.h"
 #include "ceres/internal/scoped_ptr.h"
 #include "ceres/mutex.h"
+#include "ceres/schur_complement_pattern.h"
 #include "ceres/triplet_sparse_matrix.h"
 #include "ceres/types.h"
 #include "glog/logging.h"
@@ -51,6 +52,39 @@ BlockRandomAccessSparseMatrix::BlockRandomAccessSparseMatrix(
       blocks_(blocks) {
   CHECK_LT(blocks.size(), kMaxRowBlocks);
 
+  // The pairs in block_pairs are sorted by row block and then by
+  // column block, so they can be converted to compressed row form
+  // directly.
+  vector<int> rows(blocks_.size() + 1, 0);
+  vector<int> cols;
+  cols.reserve(block_pairs.size());
+  for (set<pair<int, int> >::const_iterator it = block_pairs.begin();
+       it != block_pairs.end();
+       ++it) {
+    ++rows[it->first + 1];
+    cols.push_back(it->second);
+  }
+  for (int i = 0; i < blocks_.size(); ++i) {
+    rows[i + 1] += rows[i];
+  }
+
+  Init(rows, cols);
+}
+
+BlockRandomAccessSparseMatrix::BlockRandomAccessSparseMatrix(
+    const vector<int>& blocks,
+    const BlockSparsityPattern& pattern)
+    : kMaxRowBlocks(10 * 1000 * 1000),
+      blocks_(blocks) {
+  CHECK_LT(blocks.size(), kMaxRowBlocks);
+  CHECK_EQ(pattern.num_row_blocks(), blocks.size());
+  Init(pattern.rows, pattern.cols);
+}
+
+void BlockRandomAccessSparseMatrix::Init(const vector<int>& block_rows,
+                                         const vector<int>& block_cols) {
+  const int num_row_blocks = blocks_.size();
+
   // Build the row/column layout vector and count the number of scalar
   // rows/columns.
   int num_cols = 0;
@@ -64,12 +98,10 @@ BlockRandomAccessSparseMatrix::BlockRandomAccessSparseMatrix(
   // object for looking into the values array of the
   // TripletSparseMatrix.
   int num_nonzeros = 0;
-  for (set<pair<int, int> >::const_iterator it = block_pairs.begin();
-       it != block_pairs.end();
-       ++it) {
-    const int row_block_size = blocks_[it->first];
-    const int col_block_size = blocks_[it->second];
-    num_nonzeros += row_block_size * col_block_size;
+  for (int i = 0; i < num_row_blocks; ++i) {
+    for (int j = block_rows[i]; j < block_rows[i + 1]; ++j) {
+      num_nonzeros += blocks_[i] * blocks_[block_cols[j]];
+    }
   }
 
   VLOG(1) << "Matrix Size [" << num_cols
@@ -82,34 +114,26 @@ BlockRandomAccessSparseMatrix::BlockRandomAccessSparseMatrix(
   int* cols = tsm_->mutable_cols();
   double* values = tsm_->mutable_values();
 
+  // Fill the layout and the sparsity pattern of the underlying
+  // matrix.
   int pos = 0;
-  for (set<pair<int, int> >::const_iterator it = block_pairs.begin();
-       it != block_pairs.end();
-       ++it) {
-    const int row_block_size = blocks_[it->first];
-    const int col_block_size = blocks_[it->second];
-    layout_[IntPairToLong(it->first, it->second)] =
-        new CellInfo(values + pos);
-    pos += row_block_size * col_block_size;
-  }
-
-  // Fill the sparsity pattern of the underlying matrix.
-  for (set<pair<int, int> >::const_iterator it = block_pairs.begin();
-       it != block_pairs.end();
-       ++it) {
-    const int row_block_id = it->first;
-    const int col_block_id = it->second;
+  for (int row_block_id = 0; row_block_id < num_row_blocks; ++row_block_id) {
     const int row_block_size = blocks_[row_block_id];
-    const int col_block_size = blocks_[col_block_id];
-    int pos =
-        layout_[IntPairToLong(row_block_id, col_block_id)]->values - values;
-    for (int r = 0; r < row_block_size; ++r) {
-      for (int c = 0; c < col_block_size; ++c, ++pos) {
+    for (int j = block_rows[row_block_id];
+         j < block_rows[row_block_id + 1];
+         ++j) {
+      const int col_block_id = block_cols[j];
+      const int col_block_size = blocks_[col_block_id];
+      layout_[IntPairToLong(row_block_id, col_block_id)] =
+          new CellInfo(values + pos);
+      for (int r = 0; r < row_block_size; ++r) {
+        for (int c = 0; c < col_block_size; ++c, ++pos) {
           rows[pos] = col_layout[row_block_id] + r;
           cols[pos] = col_layout[col_block_id] + c;
           values[pos] = 1.0;
           DCHECK_LT(rows[pos], tsm_->num_rows());
           DCHECK_LT(cols[pos], tsm_->num_rows());
+        }
       }
     }
   }
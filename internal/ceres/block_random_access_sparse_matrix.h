@@ -47,6 +47,8 @@
 namespace ceres {
 namespace internal {
 
+struct BlockSparsityPattern;
+
 // A threaf safe square block sparse implementation of
 // BlockRandomAccessMatrix. Internally a TripletSparseMatrix is used
 // for doing the actual storage. This class augments this matrix with
@@ -59,6 +61,13 @@ class BlockRandomAccessSparseMatrix : public BlockRandomAccessMatrix {
   BlockRandomAccessSparseMatrix(const vector<int>& blocks,
                                 const set<pair<int, int> >& block_pairs);
 
+  // Same as above, but with the non-zero cells given by the upper
+  // triangular block sparsity pattern in compressed row form. This
+  // avoids building a set of block pairs when the pattern is already
+  // available, e.g., from a SchurStructureCache.
+  BlockRandomAccessSparseMatrix(const vector<int>& blocks,
+                                const BlockSparsityPattern& pattern);
+
   // The destructor is not thread safe. It assumes that no one is
   // modifying any cells when the matrix is being destroyed.
   virtual ~BlockRandomAccessSparseMatrix();
@@ -85,6 +94,10 @@ class BlockRandomAccessSparseMatrix : public BlockRandomAccessMatrix {
   TripletSparseMatrix* mutable_matrix() { return tsm_.get(); }
 
  private:
+  // Build the layout and the underlying matrix given the column
+  // blocks of each row block in compressed row form.
+  void Init(const vector<int>& block_rows, const vector<int>& block_cols);
+
   int64 IntPairToLong(int a, int b) {
     return a * kMaxRowBlocks + b;
   }
@@ -32,6 +32,7 @@
 #include <vector>
 #include "ceres/block_random_access_sparse_matrix.h"
 #include "ceres/internal/eigen.h"
+#include "ceres/schur_complement_pattern.h"
 #include "glog/logging.h"
 #include "gtest/gtest.h"
 
@@ -119,6 +120,58 @@ TEST(BlockRandomAccessSparseMatrix, GetCell) {
               kTolerance);
 }
 
+TEST(BlockRandomAccessSparseMatrix, PatternMatchesBlockPairs) {
+  vector<int> blocks;
+  blocks.push_back(2);
+  blocks.push_back(3);
+  blocks.push_back(1);
+
+  set<pair<int, int> > block_pairs;
+  block_pairs.insert(make_pair(0, 0));
+  block_pairs.insert(make_pair(0, 2));
+  block_pairs.insert(make_pair(1, 1));
+  block_pairs.insert(make_pair(1, 2));
+  block_pairs.insert(make_pair(2, 2));
+
+  BlockSparsityPattern pattern;
+  const int kRows[] = {0, 2, 4, 5};
+  const int kCols[] = {0, 2, 1, 2, 2};
+  pattern.rows.assign(kRows, kRows + 4);
+  pattern.cols.assign(kCols, kCols + 5);
+
+  BlockRandomAccessSparseMatrix expected(blocks, block_pairs);
+  BlockRandomAccessSparseMatrix actual(blocks, pattern);
+
+  // Both matrices have the same layout.
+  const TripletSparseMatrix* expected_tsm = expected.matrix();
+  const TripletSparseMatrix* actual_tsm = actual.matrix();
+  ASSERT_EQ(actual_tsm->num_rows(), expected_tsm->num_rows());
+  ASSERT_EQ(actual_tsm->num_nonzeros(), expected_tsm->num_nonzeros());
+  for (int i = 0; i < expected_tsm->num_nonzeros(); ++i) {
+    EXPECT_EQ(actual_tsm->rows()[i], expected_tsm->rows()[i]);
+    EXPECT_EQ(actual_tsm->cols()[i], expected_tsm->cols()[i]);
+  }
+
+  for (set<pair<int, int> >::const_iterator it = block_pairs.begin();
+       it != block_pairs.end();
+       ++it) {
+    int row, col, row_stride, col_stride;
+    CellInfo* expected_cell = expected.GetCell(it->first, it->second,
+                                               &row, &col,
+                                               &row_stride, &col_stride);
+    CellInfo* actual_cell = actual.GetCell(it->first, it->second,
+                                           &row, &col,
+                                           &row_stride, &col_stride);
+    ASSERT_TRUE(actual_cell != NULL);
+    EXPECT_EQ(actual_cell->values - actual_tsm->values(),
+              expected_cell->values - expected_tsm->values());
+  }
+
+  int row, col, row_stride, col_stride;
+  EXPECT_TRUE(actual.GetCell(2, 0, &row, &col, &row_stride, &col_stride)
+              == NULL);
+}
+
 // IntPairToLong is private, thus this fixture is needed to access and
 // test it.
 class BlockRandomAccessSparseMatrixTest : public ::testing::Test {
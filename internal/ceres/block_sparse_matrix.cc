@@ -36,6 +36,7 @@
 #include "ceres/blas.h"
 #include "ceres/block_structure.h"
 #include "ceres/internal/eigen.h"
+#include "ceres/lsqp_binary_file.h"
 #include "ceres/matrix_proto.h"
 #include "ceres/triplet_sparse_matrix.h"
 #include "glog/logging.h"
@@ -282,5 +283,46 @@ void BlockSparseMatrix::ToTextFile(FILE* file) const {
   }
 }
 
+void BlockSparseMatrix::ToBinaryFile(FILE* file) const {
+  CHECK_NOTNULL(file);
+  const vector<Block>& cols = block_structure_->cols;
+  const vector<CompressedRow>& rows = block_structure_->rows;
+
+  int64 num_ints = 3 + 1 + 2 * cols.size() + 1 + 3 * rows.size();
+  for (int i = 0; i < rows.size(); ++i) {
+    num_ints += 2 * rows[i].cells.size();
+  }
+  WriteLsqpChunkHeader(file,
+                       LSQP_BLOCK_SPARSE_MATRIX,
+                       num_ints * sizeof(int));
+
+  const int header[4] = {
+    num_rows_, num_cols_, num_nonzeros_, static_cast<int>(cols.size())
+  };
+  WriteLsqpInts(file, header, 4);
+  for (int i = 0; i < cols.size(); ++i) {
+    const int block[2] = { cols[i].size, cols[i].position };
+    WriteLsqpInts(file, block, 2);
+  }
+
+  const int num_row_blocks = rows.size();
+  WriteLsqpInts(file, &num_row_blocks, 1);
+  for (int i = 0; i < rows.size(); ++i) {
+    const vector<Cell>& cells = rows[i].cells;
+    const int row[3] = {
+      rows[i].block.size,
+      rows[i].block.position,
+      static_cast<int>(cells.size())
+    };
+    WriteLsqpInts(file, row, 3);
+    for (int j = 0; j < cells.size(); ++j) {
+      const int cell[2] = { cells[j].block_id, cells[j].position };
+      WriteLsqpInts(file, cell, 2);
+    }
+  }
+
+  WriteLsqpDoubleChunks(file, LSQP_A_VALUES, values_.get(), num_nonzeros_);
+}
+
 }  // namespace internal
 }  // namespace ceres
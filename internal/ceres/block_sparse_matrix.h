@@ -114,6 +114,7 @@ class BlockSparseMatrix : public BlockSparseMatrixBase {
   virtual void ToProto(SparseMatrixProto* proto) const;
 #endif
   virtual void ToTextFile(FILE* file) const;
+  virtual void ToBinaryFile(FILE* file) const;
 
   virtual int num_rows()         const { return num_rows_;     }
   virtual int num_cols()         const { return num_cols_;     }
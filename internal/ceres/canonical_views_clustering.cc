@@ -29,12 +29,15 @@
 // Author: David Gallup (dgallup@google.com)
 //         Sameer Agarwal (sameeragarwal@google.com)
 
-#ifndef CERES_NO_SUITESPARSE
-
 #include "ceres/canonical_views_clustering.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <vector>
 #include "ceres/collections_port.h"
-#include "ceres/graph.h"
+#include "ceres/compressed_graph.h"
 #include "ceres/internal/macros.h"
 #include "ceres/map_util.h"
 #include "glog/logging.h"
@@ -43,7 +46,28 @@ namespace ceres {
 namespace internal {
 
 typedef HashMap<int, int> IntMap;
-typedef HashSet<int> IntSet;
+
+static const int kInvalidView = -1;
+
+// A candidate canonical view, along with its quality difference as
+// computed when the clustering had num_centers canonical views.
+struct Candidate {
+  Candidate(double difference, int view, int num_centers)
+      : difference(difference), view(view), num_centers(num_centers) {}
+
+  // Larger differences first, ties broken in favour of the smaller
+  // view id.
+  bool operator<(const Candidate& other) const {
+    if (difference != other.difference) {
+      return difference < other.difference;
+    }
+    return view > other.view;
+  }
+
+  double difference;
+  int view;
+  int num_centers;
+};
 
 class CanonicalViewsClustering {
  public:
@@ -57,13 +81,13 @@ class CanonicalViewsClustering {
   // configuration of the clustering algorithm that some of the
   // vertices may not be assigned to any cluster. In this case they
   // are assigned to a cluster with id = kInvalidClusterId.
-  void ComputeClustering(const Graph<int>& graph,
+  void ComputeClustering(const CompressedGraph& graph,
                          const CanonicalViewsClusteringOptions& options,
                          vector<int>* centers,
                          IntMap* membership);
 
  private:
-  void FindValidViews(IntSet* valid_views) const;
+  void FindValidViews(vector<int>* valid_views) const;
   double ComputeClusteringQualityDifference(const int candidate,
                                             const vector<int>& centers) const;
   void UpdateCanonicalViewAssignments(const int canonical_view);
@@ -71,17 +95,17 @@ class CanonicalViewsClustering {
                                 IntMap* membership) const;
 
   CanonicalViewsClusteringOptions options_;
-  const Graph<int>* graph_;
-  // Maps a view to its representative canonical view (its cluster
-  // center).
-  IntMap view_to_canonical_view_;
-  // Maps a view to its similarity to its current cluster center.
-  HashMap<int, double> view_to_canonical_view_similarity_;
+  const CompressedGraph* graph_;
+  // The representative canonical view (cluster center) of each view,
+  // or kInvalidView if the view has not been assigned to a cluster.
+  vector<int> view_to_canonical_view_;
+  // The similarity of each view to its current cluster center.
+  vector<double> view_to_canonical_view_similarity_;
   CERES_DISALLOW_COPY_AND_ASSIGN(CanonicalViewsClustering);
 };
 
 void ComputeCanonicalViewsClustering(
-    const Graph<int>& graph,
+    const CompressedGraph& graph,
     const CanonicalViewsClusteringOptions& options,
     vector<int>* centers,
     IntMap* membership) {
@@ -94,7 +118,7 @@ void ComputeCanonicalViewsClustering(
 
 // Implementation of CanonicalViewsClustering
 void CanonicalViewsClustering::ComputeClustering(
-    const Graph<int>& graph,
+    const CompressedGraph& graph,
     const CanonicalViewsClusteringOptions& options,
     vector<int>* centers,
     IntMap* membership) {
@@ -102,53 +126,71 @@ void CanonicalViewsClustering::ComputeClustering(
   CHECK_NOTNULL(centers)->clear();
   CHECK_NOTNULL(membership)->clear();
   graph_ = &graph;
+  view_to_canonical_view_.assign(graph.num_vertices(), kInvalidView);
+  view_to_canonical_view_similarity_.assign(graph.num_vertices(), 0.0);
 
-  IntSet valid_views;
-  FindValidViews(&valid_views);
-  while (valid_views.size() > 0) {
-    // Find the next best canonical view.
-    double best_difference = -std::numeric_limits<double>::max();
-    int best_view = 0;
-
-    // TODO(sameeragarwal): Make this loop multi-threaded.
-    for (IntSet::const_iterator view = valid_views.begin();
-         view != valid_views.end();
-         ++view) {
-      const double difference =
-          ComputeClusteringQualityDifference(*view, *centers);
-      if (difference > best_difference) {
-        best_difference = difference;
-        best_view = *view;
-      }
+  // The valid views are in increasing order, which makes ties between
+  // views with the same quality difference resolve in favour of the
+  // smaller view id.
+  vector<int> views;
+  FindValidViews(&views);
+
+  // The quality difference of each candidate with respect to an empty
+  // set of canonical views. This is the most expensive pass over the
+  // graph, and the candidates are independent of each other.
+  vector<double> differences(views.size());
+#pragma omp parallel for num_threads(options_.num_threads) schedule(dynamic, 64)
+  for (int i = 0; i < views.size(); ++i) {
+    differences[i] = ComputeClusteringQualityDifference(views[i], *centers);
+  }
+
+  // Adding a canonical view can only decrease the quality difference
+  // of the remaining candidates; the coverage term only shrinks as
+  // the similarity of each view to its center grows, and the
+  // orthogonality penalty only grows. So a stale difference is an
+  // upper bound on the current one, and the candidates can be kept in
+  // a max-heap which is lazily updated. Only the candidate at the top
+  // of the heap is re-evaluated, and if its current difference still
+  // beats every other upper bound, it is the best view.
+  priority_queue<Candidate> candidates;
+  for (int i = 0; i < views.size(); ++i) {
+    candidates.push(Candidate(differences[i], views[i], 0));
+  }
+
+  while (!candidates.empty()) {
+    Candidate best = candidates.top();
+    candidates.pop();
+    if (best.num_centers != centers->size()) {
+      best.difference = ComputeClusteringQualityDifference(best.view,
+                                                           *centers);
+      best.num_centers = centers->size();
+      candidates.push(best);
+      continue;
     }
 
-    CHECK_GT(best_difference, -std::numeric_limits<double>::max());
+    CHECK_GT(best.difference, -std::numeric_limits<double>::max());
 
     // Add canonical view if quality improves, or if minimum is not
     // yet met, otherwise break.
-    if ((best_difference <= 0) &&
+    if ((best.difference <= 0) &&
         (centers->size() >= options_.min_views)) {
       break;
     }
 
-    centers->push_back(best_view);
-    valid_views.erase(best_view);
-    UpdateCanonicalViewAssignments(best_view);
+    centers->push_back(best.view);
+    UpdateCanonicalViewAssignments(best.view);
   }
 
   ComputeClusterMembership(*centers, membership);
 }
 
-// Return the set of vertices of the graph which have valid vertex
-// weights.
+// Return the vertices of the graph which have valid vertex weights,
+// in increasing order.
 void CanonicalViewsClustering::FindValidViews(
-    IntSet* valid_views) const {
-  const IntSet& views = graph_->vertices();
-  for (IntSet::const_iterator view = views.begin();
-       view != views.end();
-       ++view) {
-    if (graph_->VertexWeight(*view) != Graph<int>::InvalidWeight()) {
-      valid_views->insert(*view);
+    vector<int>* valid_views) const {
+  for (int view = 0; view < graph_->num_vertices(); ++view) {
+    if (!std::isnan(graph_->VertexWeight(view))) {
+      valid_views->push_back(view);
     }
   }
 }
@@ -165,13 +207,11 @@ double CanonicalViewsClustering::ComputeClusteringQualityDifference(
   // Compute how much the quality score changes if the candidate view
   // was added to the list of canonical views and its nearest
   // neighbors became members of its cluster.
-  const IntSet& neighbors = graph_->Neighbors(candidate);
-  for (IntSet::const_iterator neighbor = neighbors.begin();
-       neighbor != neighbors.end();
-       ++neighbor) {
+  const int* neighbors = graph_->Neighbors(candidate);
+  for (int i = 0; i < graph_->Degree(candidate); ++i) {
     const double old_similarity =
-        FindWithDefault(view_to_canonical_view_similarity_, *neighbor, 0.0);
-    const double new_similarity = graph_->EdgeWeight(*neighbor, candidate);
+        view_to_canonical_view_similarity_[neighbors[i]];
+    const double new_similarity = graph_->NeighborWeight(candidate, i);
     if (new_similarity > old_similarity) {
       difference += new_similarity - old_similarity;
     }
@@ -192,17 +232,14 @@ double CanonicalViewsClustering::ComputeClusteringQualityDifference(
 // Reassign views if they're more similar to the new canonical view.
 void CanonicalViewsClustering::UpdateCanonicalViewAssignments(
     const int canonical_view) {
-  const IntSet& neighbors = graph_->Neighbors(canonical_view);
-  for (IntSet::const_iterator neighbor = neighbors.begin();
-       neighbor != neighbors.end();
-       ++neighbor) {
-    const double old_similarity =
-        FindWithDefault(view_to_canonical_view_similarity_, *neighbor, 0.0);
-    const double new_similarity =
-        graph_->EdgeWeight(*neighbor, canonical_view);
+  const int* neighbors = graph_->Neighbors(canonical_view);
+  for (int i = 0; i < graph_->Degree(canonical_view); ++i) {
+    const int neighbor = neighbors[i];
+    const double old_similarity = view_to_canonical_view_similarity_[neighbor];
+    const double new_similarity = graph_->NeighborWeight(canonical_view, i);
     if (new_similarity > old_similarity) {
-      view_to_canonical_view_[*neighbor] = canonical_view;
-      view_to_canonical_view_similarity_[*neighbor] = new_similarity;
+      view_to_canonical_view_[neighbor] = canonical_view;
+      view_to_canonical_view_similarity_[neighbor] = new_similarity;
     }
   }
 }
@@ -221,22 +258,16 @@ void CanonicalViewsClustering::ComputeClusterMembership(
 
   static const int kInvalidClusterId = -1;
 
-  const IntSet& views = graph_->vertices();
-  for (IntSet::const_iterator view = views.begin();
-       view != views.end();
-       ++view) {
-    IntMap::const_iterator it =
-        view_to_canonical_view_.find(*view);
+  for (int view = 0; view < graph_->num_vertices(); ++view) {
+    const int canonical_view = view_to_canonical_view_[view];
     int cluster_id = kInvalidClusterId;
-    if (it != view_to_canonical_view_.end()) {
-      cluster_id = FindOrDie(center_to_cluster_id, it->second);
+    if (canonical_view != kInvalidView) {
+      cluster_id = FindOrDie(center_to_cluster_id, canonical_view);
     }
 
-    InsertOrDie(membership, *view, cluster_id);
+    InsertOrDie(membership, view, cluster_id);
   }
 }
 
 }  // namespace internal
 }  // namespace ceres
-
-#endif  // CERES_NO_SUITESPARSE
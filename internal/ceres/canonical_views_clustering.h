@@ -41,12 +41,10 @@
 #ifndef CERES_INTERNAL_CANONICAL_VIEWS_CLUSTERING_H_
 #define CERES_INTERNAL_CANONICAL_VIEWS_CLUSTERING_H_
 
-#ifndef CERES_NO_SUITESPARSE
-
 #include <vector>
 
 #include "ceres/collections_port.h"
-#include "ceres/graph.h"
+#include "ceres/compressed_graph.h"
 #include "ceres/internal/macros.h"
 #include "ceres/map_util.h"
 #include "glog/logging.h"
@@ -91,6 +89,8 @@ struct CanonicalViewsClusteringOptions;
 //          - similarity_penalty_weight * sum_[i in C, j in C, j > i] w_ij
 //          + view_score_weight * sum_[i in C] w_i
 //
+// Vertices whose weight is NaN are never chosen as canonical views.
+//
 // centers will contain the vertices that are the identified
 // as the canonical views/cluster centers, and membership is a map
 // from vertices to cluster_ids. The i^th cluster center corresponds
@@ -100,7 +100,7 @@ struct CanonicalViewsClusteringOptions;
 // algorithm that some of the vertices may not be assigned to any
 // cluster. In this case they are assigned to a cluster with id = -1;
 void ComputeCanonicalViewsClustering(
-    const Graph<int>& graph,
+    const CompressedGraph& graph,
     const CanonicalViewsClusteringOptions& options,
     vector<int>* centers,
     HashMap<int, int>* membership);
@@ -110,7 +110,8 @@ struct CanonicalViewsClusteringOptions {
       : min_views(3),
         size_penalty_weight(5.75),
         similarity_penalty_weight(100.0),
-        view_score_weight(0.0) {
+        view_score_weight(0.0),
+        num_threads(1) {
   }
   // The minimum number of canonical views to compute.
   int min_views;
@@ -127,10 +128,12 @@ struct CanonicalViewsClusteringOptions {
   // Weight for per-view scores.  Lower weight places less
   // confidence in the view scores.
   double view_score_weight;
+
+  // Number of threads used to score the candidate views.
+  int num_threads;
 };
 
 }  // namespace internal
 }  // namespace ceres
 
-#endif  // CERES_NO_SUITESPARSE
 #endif  // CERES_INTERNAL_CANONICAL_VIEWS_CLUSTERING_H_
@@ -29,12 +29,11 @@
 // Author: Sameer Agarwal (sameeragarwal@google.com)
 //         David Gallup (dgallup@google.com)
 
-#ifndef CERES_NO_SUITESPARSE
-
 #include "ceres/canonical_views_clustering.h"
 
 #include "ceres/collections_port.h"
-#include "ceres/graph.h"
+#include "ceres/compressed_graph.h"
+#include "ceres/internal/scoped_ptr.h"
 #include "gtest/gtest.h"
 
 namespace ceres {
@@ -50,29 +49,32 @@ class CanonicalViewsTest : public ::testing::Test {
     //                   V0-----V1-----V2-----V3
     // Edge weights:        0.8    0.9    0.3
     const double kVertexWeights[] = {0.0, 2.0, 2.0, -1.0};
-    for (int i = 0; i < 4; ++i) {
-      graph_.AddVertex(i, kVertexWeights[i]);
-    }
+    const vector<double> vertex_weights(kVertexWeights, kVertexWeights + 4);
+    vector<pair<int, int> > edges;
+    vector<double> edge_weights;
+
     // Create self edges.
     // CanonicalViews requires that every view "sees" itself.
     for (int i = 0; i < 4; ++i) {
-      graph_.AddEdge(i, i, 1.0);
+      edges.push_back(make_pair(i, i));
+      edge_weights.push_back(1.0);
     }
 
     // Create three edges.
     const double kEdgeWeights[] = {0.8, 0.9, 0.3};
     for (int i = 0; i < 3; ++i) {
-      // The graph interface is directed, so remember to create both
-      // edges.
-      graph_.AddEdge(kVertexIds[i], kVertexIds[i + 1], kEdgeWeights[i]);
+      edges.push_back(make_pair(kVertexIds[i], kVertexIds[i + 1]));
+      edge_weights.push_back(kEdgeWeights[i]);
     }
+
+    graph_.reset(new CompressedGraph(vertex_weights, edges, edge_weights, 1));
   }
 
   void ComputeClustering() {
-    ComputeCanonicalViewsClustering(graph_, options_, &centers_, &membership_);
+    ComputeCanonicalViewsClustering(*graph_, options_, &centers_, &membership_);
   }
 
-  Graph<int> graph_;
+  scoped_ptr<CompressedGraph> graph_;
 
   CanonicalViewsClusteringOptions options_;
   vector<int> centers_;
@@ -98,6 +100,47 @@ TEST_F(CanonicalViewsTest, ComputeCanonicalViewsTest) {
   EXPECT_EQ(FindOrDie(membership_, kVertexIds[3]), 1);
 }
 
+TEST_F(CanonicalViewsTest, MultithreadedClusteringMatchesSerial) {
+  options_.min_views = 0;
+  options_.size_penalty_weight = 0.5;
+  options_.similarity_penalty_weight = 0.0;
+  options_.view_score_weight = 0.0;
+  options_.num_threads = 4;
+  ComputeClustering();
+
+  EXPECT_EQ(centers_.size(), 2);
+  EXPECT_EQ(centers_[0], kVertexIds[1]);
+  EXPECT_EQ(centers_[1], kVertexIds[3]);
+}
+
+// Views 0 and 2 are symmetric, so they have the same quality
+// difference. The tie is broken in favour of the smaller view id.
+TEST(CanonicalViewsClustering, TiesAreBrokenByViewId) {
+  vector<pair<int, int> > edges;
+  vector<double> edge_weights;
+  for (int i = 0; i < 3; ++i) {
+    edges.push_back(make_pair(i, i));
+    edge_weights.push_back(1.0);
+  }
+  edges.push_back(make_pair(0, 1));
+  edge_weights.push_back(0.5);
+  edges.push_back(make_pair(1, 2));
+  edge_weights.push_back(0.5);
+  CompressedGraph graph(vector<double>(3, 1.0), edges, edge_weights, 1);
+
+  CanonicalViewsClusteringOptions options;
+  options.min_views = 2;
+  options.size_penalty_weight = 0.0;
+  options.similarity_penalty_weight = 0.0;
+
+  vector<int> centers;
+  HashMap<int, int> membership;
+  ComputeCanonicalViewsClustering(graph, options, &centers, &membership);
+  ASSERT_GE(centers.size(), 2);
+  EXPECT_EQ(centers[0], 1);
+  EXPECT_EQ(centers[1], 0);
+}
+
 // Increases size penalty so the second canonical view won't be
 // chosen.
 TEST_F(CanonicalViewsTest, SizePenaltyTest) {
@@ -143,5 +186,3 @@ TEST_F(CanonicalViewsTest, SimilarityPenaltyTest) {
 
 }  // namespace internal
 }  // namespace ceres
-
-#endif  // CERES_NO_SUITESPARSE
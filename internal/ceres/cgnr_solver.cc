@@ -34,6 +34,7 @@
 #include "ceres/cgnr_linear_operator.h"
 #include "ceres/conjugate_gradients_solver.h"
 #include "ceres/linear_solver.h"
+#include "ceres/single_precision_block_sparse_matrix.h"
 #include "ceres/wall_time.h"
 #include "glog/logging.h"
 
@@ -69,9 +70,20 @@ LinearSolver::Summary CgnrSolver::SolveImpl(
     LOG(FATAL) << "CGNR only supports IDENTITY and JACOBI preconditioners.";
   }
 
+  // The products with A in the conjugate gradients iterations use a
+  // single precision copy of its values if requested.
+  const LinearOperator* lhs_A = A;
+  if (options_.use_single_precision_jacobian) {
+    if (single_precision_A_.get() == NULL) {
+      single_precision_A_.reset(new SinglePrecisionBlockSparseMatrix(*A));
+    }
+    single_precision_A_->UpdateValues(*A, options_.num_threads);
+    lhs_A = single_precision_A_.get();
+  }
+
   // Solve (AtA + DtD)x = z (= Atb).
   std::fill(x, x + A->num_cols(), 0.0);
-  CgnrLinearOperator lhs(*A, per_solve_options.D);
+  CgnrLinearOperator lhs(*lhs_A, per_solve_options.D);
   event_logger.AddEvent("Setup");
 
   ConjugateGradientsSolver conjugate_gradient_solver(options_);
@@ -38,6 +38,7 @@ namespace ceres {
 namespace internal {
 
 class Preconditioner;
+class SinglePrecisionBlockSparseMatrix;
 
 class BlockJacobiPreconditioner;
 
@@ -60,6 +61,7 @@ class CgnrSolver : public BlockSparseMatrixBaseSolver {
  private:
   const LinearSolver::Options options_;
   scoped_ptr<Preconditioner> preconditioner_;
+  scoped_ptr<SinglePrecisionBlockSparseMatrix> single_precision_A_;
   CERES_DISALLOW_COPY_AND_ASSIGN(CgnrSolver);
 };
 
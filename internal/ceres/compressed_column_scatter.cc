@@ -0,0 +1,103 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "ceres/compressed_column_scatter.h"
+
+#include <vector>
+#include "ceres/internal/port.h"
+#include "ceres/triplet_sparse_matrix.h"
+#include "glog/logging.h"
+
+namespace ceres {
+namespace internal {
+
+CompressedColumnScatter::CompressedColumnScatter(const TripletSparseMatrix& A)
+    : num_rows_(A.num_rows()),
+      num_cols_(A.num_cols()) {
+  const int num_nonzeros = A.num_nonzeros();
+  const int* rows = A.rows();
+  const int* cols = A.cols();
+
+  // Counting sort the triplets by row, and then stably by column, so
+  // that the rows in each column end up sorted.
+  vector<int> row_starts(num_rows_ + 1, 0);
+  for (int i = 0; i < num_nonzeros; ++i) {
+    ++row_starts[rows[i] + 1];
+  }
+  for (int i = 0; i < num_rows_; ++i) {
+    row_starts[i + 1] += row_starts[i];
+  }
+
+  vector<int> by_row(num_nonzeros);
+  for (int i = 0; i < num_nonzeros; ++i) {
+    by_row[row_starts[rows[i]]++] = i;
+  }
+
+  col_starts_.resize(num_cols_ + 1, 0);
+  for (int i = 0; i < num_nonzeros; ++i) {
+    ++col_starts_[cols[i] + 1];
+  }
+  for (int i = 0; i < num_cols_; ++i) {
+    col_starts_[i + 1] += col_starts_[i];
+  }
+
+  rows_.resize(num_nonzeros);
+  values_.resize(num_nonzeros, 0.0);
+  permutation_.resize(num_nonzeros);
+  vector<int> positions(col_starts_.begin(), col_starts_.end() - 1);
+  for (int i = 0; i < num_nonzeros; ++i) {
+    const int triplet = by_row[i];
+    const int position = positions[cols[triplet]]++;
+    rows_[position] = rows[triplet];
+    permutation_[triplet] = position;
+  }
+
+  for (int c = 0; c < num_cols_; ++c) {
+    for (int i = col_starts_[c] + 1; i < col_starts_[c + 1]; ++i) {
+      CHECK_LT(rows_[i - 1], rows_[i])
+          << "Duplicate entry (" << rows_[i] << ", " << c << ")";
+    }
+  }
+}
+
+void CompressedColumnScatter::Scatter(const TripletSparseMatrix& A,
+                                      const int num_threads) {
+  CHECK_EQ(A.num_rows(), num_rows_);
+  CHECK_EQ(A.num_cols(), num_cols_);
+  CHECK_EQ(A.num_nonzeros(), permutation_.size());
+
+  const int num_nonzeros = permutation_.size();
+  const double* values = A.values();
+#pragma omp parallel for num_threads(num_threads) schedule(static)
+  for (int i = 0; i < num_nonzeros; ++i) {
+    values_[permutation_[i]] = values[i];
+  }
+}
+
+}  // namespace internal
+}  // namespace ceres
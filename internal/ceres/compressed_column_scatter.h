@@ -0,0 +1,105 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Compressed column storage for a TripletSparseMatrix whose sparsity
+// pattern does not change between updates of its values.
+
+#ifndef CERES_INTERNAL_COMPRESSED_COLUMN_SCATTER_H_
+#define CERES_INTERNAL_COMPRESSED_COLUMN_SCATTER_H_
+
+#include <vector>
+#include "ceres/internal/macros.h"
+#include "ceres/internal/port.h"
+
+namespace ceres {
+namespace internal {
+
+class TripletSparseMatrix;
+
+// Converting a TripletSparseMatrix to compressed column form involves
+// sorting its entries by column. When the same matrix is converted
+// over and over again with different values, e.g., the reduced
+// camera matrix in every iteration of a sparse Schur solver, this
+// work only needs to be done once.
+//
+// This class computes the compressed column structure of a
+// TripletSparseMatrix together with the position of each triplet in
+// it once, after which Scatter copies the values of a matrix with the
+// same sparsity pattern into the compressed column storage without
+// any sorting or allocation. The row indices in each column are
+// sorted.
+//
+// The arrays are exposed through mutable accessors so that they can
+// be wrapped without copying by the C interfaces of CHOLMOD and
+// CXSparse, see SuiteSparse::CreateSparseMatrixView and
+// CXSparse::CreateSparseMatrixView. The structure must not be
+// modified through them.
+class CompressedColumnScatter {
+ public:
+  // The matrix A must not contain duplicate entries.
+  explicit CompressedColumnScatter(const TripletSparseMatrix& A);
+
+  // Copy the values of A into the compressed column storage using
+  // num_threads threads. A must have the same sparsity pattern, i.e.,
+  // the same rows and cols arrays, as the matrix this object was
+  // constructed with.
+  void Scatter(const TripletSparseMatrix& A, int num_threads);
+
+  int num_rows() const { return num_rows_; }
+  int num_cols() const { return num_cols_; }
+  int num_nonzeros() const { return rows_.size(); }
+
+  // Column j consists of the entries col_starts[j], ...,
+  // col_starts[j + 1] - 1 of the rows and values arrays.
+  const int* col_starts() const { return &col_starts_[0]; }
+  int* mutable_col_starts() { return &col_starts_[0]; }
+  const int* rows() const { return rows_.empty() ? NULL : &rows_[0]; }
+  int* mutable_rows() { return rows_.empty() ? NULL : &rows_[0]; }
+  const double* values() const {
+    return values_.empty() ? NULL : &values_[0];
+  }
+  double* mutable_values() { return values_.empty() ? NULL : &values_[0]; }
+
+ private:
+  int num_rows_;
+  int num_cols_;
+  vector<int> col_starts_;
+  vector<int> rows_;
+  vector<double> values_;
+
+  // The i^th triplet of the matrix is stored at position
+  // permutation_[i] of rows_ and values_.
+  vector<int> permutation_;
+
+  CERES_DISALLOW_COPY_AND_ASSIGN(CompressedColumnScatter);
+};
+
+}  // namespace internal
+}  // namespace ceres
+
+#endif  // CERES_INTERNAL_COMPRESSED_COLUMN_SCATTER_H_
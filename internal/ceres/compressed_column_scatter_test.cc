@@ -0,0 +1,118 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "ceres/compressed_column_scatter.h"
+
+#include <algorithm>
+#include <vector>
+#include "ceres/internal/eigen.h"
+#include "ceres/internal/port.h"
+#include "ceres/internal/scoped_ptr.h"
+#include "ceres/random.h"
+#include "ceres/triplet_sparse_matrix.h"
+#include "gtest/gtest.h"
+
+namespace ceres {
+namespace internal {
+
+// A random sparse matrix whose triplets are in random order.
+TripletSparseMatrix* CreateRandomMatrix(const int num_rows,
+                                        const int num_cols) {
+  vector<int> entries;
+  for (int i = 0; i < num_rows * num_cols; ++i) {
+    if (Uniform(3) == 0) {
+      entries.push_back(i);
+    }
+  }
+  for (int i = entries.size() - 1; i > 0; --i) {
+    std::swap(entries[i], entries[Uniform(i + 1)]);
+  }
+
+  TripletSparseMatrix* A =
+      new TripletSparseMatrix(num_rows, num_cols, entries.size());
+  for (int i = 0; i < entries.size(); ++i) {
+    A->mutable_rows()[i] = entries[i] / num_cols;
+    A->mutable_cols()[i] = entries[i] % num_cols;
+    A->mutable_values()[i] = RandDouble();
+  }
+  A->set_num_nonzeros(entries.size());
+  return A;
+}
+
+// Expand the compressed column storage into a dense matrix, checking
+// that the rows in each column are sorted.
+Matrix ToDense(const CompressedColumnScatter& m) {
+  Matrix dense = Matrix::Zero(m.num_rows(), m.num_cols());
+  for (int c = 0; c < m.num_cols(); ++c) {
+    for (int i = m.col_starts()[c]; i < m.col_starts()[c + 1]; ++i) {
+      if (i > m.col_starts()[c]) {
+        EXPECT_LT(m.rows()[i - 1], m.rows()[i]);
+      }
+      dense(m.rows()[i], c) = m.values()[i];
+    }
+  }
+  return dense;
+}
+
+TEST(CompressedColumnScatter, MatchesTripletMatrix) {
+  SetRandomState(3);
+  for (int num_threads = 1; num_threads <= 4; num_threads *= 2) {
+    scoped_ptr<TripletSparseMatrix> A(CreateRandomMatrix(13, 7));
+    CompressedColumnScatter m(*A);
+    EXPECT_EQ(m.num_rows(), 13);
+    EXPECT_EQ(m.num_cols(), 7);
+    EXPECT_EQ(m.num_nonzeros(), A->num_nonzeros());
+    EXPECT_EQ(m.col_starts()[7], A->num_nonzeros());
+
+    Matrix expected;
+    m.Scatter(*A, num_threads);
+    A->ToDenseMatrix(&expected);
+    EXPECT_EQ((ToDense(m) - expected).norm(), 0.0);
+
+    // Updating the values only requires another scatter.
+    for (int i = 0; i < A->num_nonzeros(); ++i) {
+      A->mutable_values()[i] = RandDouble();
+    }
+    m.Scatter(*A, num_threads);
+    A->ToDenseMatrix(&expected);
+    EXPECT_EQ((ToDense(m) - expected).norm(), 0.0);
+  }
+}
+
+TEST(CompressedColumnScatter, EmptyMatrix) {
+  TripletSparseMatrix A(3, 2, 0);
+  CompressedColumnScatter m(A);
+  m.Scatter(A, 1);
+  EXPECT_EQ(m.num_nonzeros(), 0);
+  for (int c = 0; c <= 2; ++c) {
+    EXPECT_EQ(m.col_starts()[c], 0);
+  }
+}
+
+}  // namespace internal
+}  // namespace ceres
@@ -0,0 +1,187 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "ceres/compressed_graph.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include "glog/logging.h"
+
+namespace ceres {
+namespace internal {
+namespace {
+
+bool NeighborLessThan(const pair<int, double>& lhs,
+                      const pair<int, double>& rhs) {
+  return lhs.first < rhs.first;
+}
+
+}  // namespace
+
+CompressedGraph::CompressedGraph(int num_vertices,
+                                 const vector<pair<int, int> >& edges,
+                                 int num_threads) {
+  Init(num_vertices, edges, NULL, num_threads);
+}
+
+CompressedGraph::CompressedGraph(const vector<double>& vertex_weights,
+                                 const vector<pair<int, int> >& edges,
+                                 const vector<double>& edge_weights,
+                                 int num_threads)
+    : vertex_weights_(vertex_weights) {
+  CHECK_EQ(edges.size(), edge_weights.size());
+  Init(vertex_weights.size(), edges, &edge_weights, num_threads);
+}
+
+void CompressedGraph::Init(int num_vertices,
+                           const vector<pair<int, int> >& edges,
+                           const vector<double>* edge_weights,
+                           int num_threads) {
+  CHECK_GE(num_vertices, 0);
+
+  // Count the entries in each row, and scatter the edges into the
+  // rows in the order in which they occur in edges.
+  vector<int> rows(num_vertices + 1, 0);
+  for (int i = 0; i < edges.size(); ++i) {
+    const int vertex1 = edges[i].first;
+    const int vertex2 = edges[i].second;
+    CHECK(vertex1 >= 0 && vertex1 < num_vertices &&
+          vertex2 >= 0 && vertex2 < num_vertices)
+        << "Invalid edge (" << vertex1 << ", " << vertex2 << ") "
+        << "in a graph with " << num_vertices << " vertices.";
+    ++rows[vertex1 + 1];
+    if (vertex1 != vertex2) {
+      ++rows[vertex2 + 1];
+    }
+  }
+
+  for (int i = 0; i < num_vertices; ++i) {
+    rows[i + 1] += rows[i];
+  }
+
+  vector<int> cols(rows.back());
+  vector<double> weights(edge_weights != NULL ? rows.back() : 0);
+  {
+    vector<int> cursor(rows.begin(), rows.end() - 1);
+    for (int i = 0; i < edges.size(); ++i) {
+      const int vertex1 = edges[i].first;
+      const int vertex2 = edges[i].second;
+      if (edge_weights != NULL) {
+        weights[cursor[vertex1]] = (*edge_weights)[i];
+      }
+      cols[cursor[vertex1]++] = vertex2;
+      if (vertex1 != vertex2) {
+        if (edge_weights != NULL) {
+          weights[cursor[vertex2]] = (*edge_weights)[i];
+        }
+        cols[cursor[vertex2]++] = vertex1;
+      }
+    }
+  }
+
+  if (cols.empty()) {
+    rows_.swap(rows);
+    return;
+  }
+
+  // Sort and deduplicate each row in place. The rows are independent
+  // of each other. When there are weights, a stable sort leaves the
+  // last occurrence of each edge at the end of its run of duplicates.
+  vector<int> row_sizes(num_vertices, 0);
+#pragma omp parallel num_threads(num_threads)
+  {
+    vector<pair<int, double> > row;
+
+#pragma omp for schedule(dynamic, 64)
+    for (int i = 0; i < num_vertices; ++i) {
+      int* row_begin = &cols[0] + rows[i];
+      int* row_end = &cols[0] + rows[i + 1];
+      if (edge_weights == NULL) {
+        sort(row_begin, row_end);
+        row_sizes[i] = unique(row_begin, row_end) - row_begin;
+        continue;
+      }
+
+      double* weights_begin = &weights[0] + rows[i];
+      row.clear();
+      for (int j = 0; j < row_end - row_begin; ++j) {
+        row.push_back(make_pair(row_begin[j], weights_begin[j]));
+      }
+      stable_sort(row.begin(), row.end(), NeighborLessThan);
+
+      int row_size = 0;
+      for (int j = 0; j < row.size(); ++j) {
+        if (j + 1 < row.size() && row[j + 1].first == row[j].first) {
+          continue;
+        }
+        row_begin[row_size] = row[j].first;
+        weights_begin[row_size] = row[j].second;
+        ++row_size;
+      }
+      row_sizes[i] = row_size;
+    }
+  }
+
+  // Compact the rows.
+  rows_.resize(num_vertices + 1);
+  rows_[0] = 0;
+  for (int i = 0; i < num_vertices; ++i) {
+    rows_[i + 1] = rows_[i] + row_sizes[i];
+  }
+
+  cols_.resize(rows_.back());
+  if (edge_weights != NULL) {
+    edge_weights_.resize(rows_.back());
+  }
+
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic, 64)
+  for (int i = 0; i < num_vertices; ++i) {
+    copy(cols.begin() + rows[i],
+         cols.begin() + rows[i] + row_sizes[i],
+         cols_.begin() + rows_[i]);
+    if (edge_weights != NULL) {
+      copy(weights.begin() + rows[i],
+           weights.begin() + rows[i] + row_sizes[i],
+           edge_weights_.begin() + rows_[i]);
+    }
+  }
+}
+
+double CompressedGraph::EdgeWeight(int vertex1, int vertex2) const {
+  const int* row_begin = Neighbors(vertex1);
+  const int* row_end = row_begin + Degree(vertex1);
+  const int* it = lower_bound(row_begin, row_end, vertex2);
+  if (it == row_end || *it != vertex2) {
+    return 0.0;
+  }
+  return NeighborWeight(vertex1, it - row_begin);
+}
+
+}  // namespace internal
+}  // namespace ceres
@@ -0,0 +1,129 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// An immutable weighted undirected graph over the integer vertices
+// 0, ..., num_vertices - 1, stored in compressed row form.
+
+#ifndef CERES_INTERNAL_COMPRESSED_GRAPH_H_
+#define CERES_INTERNAL_COMPRESSED_GRAPH_H_
+
+#include <utility>
+#include <vector>
+#include "ceres/internal/macros.h"
+#include "ceres/internal/port.h"
+#include "glog/logging.h"
+
+namespace ceres {
+namespace internal {
+
+// Graph<Vertex> (see graph.h) is convenient for incrementally
+// building and modifying small graphs, but its hash table based
+// storage uses a lot of memory and is slow to traverse for graphs
+// with millions of vertices. CompressedGraph is built once from a
+// list of edges, after which the neighbors of each vertex are stored
+// as a sorted contiguous array, with the edge weights (if any) in a
+// parallel array.
+//
+// Edges are undirected, so an edge (i, j) is stored in the rows of
+// both i and j. Self edges (i, i) are allowed and are stored once in
+// the row of i.
+class CompressedGraph {
+ public:
+  // Construct a graph with unit vertex and edge weights. The edges
+  // may contain duplicates, and each edge may be given in either or
+  // both directions. num_threads threads are used to sort and
+  // deduplicate the rows.
+  CompressedGraph(int num_vertices,
+                  const vector<pair<int, int> >& edges,
+                  int num_threads);
+
+  // Same as above, but with vertex and edge weights. If an edge
+  // occurs more than once in edges, the weight of its last
+  // occurrence is used.
+  CompressedGraph(const vector<double>& vertex_weights,
+                  const vector<pair<int, int> >& edges,
+                  const vector<double>& edge_weights,
+                  int num_threads);
+
+  int num_vertices() const { return rows_.size() - 1; }
+
+  // Number of entries in the rows of the graph, i.e., twice the
+  // number of edges which are not self edges plus the number of self
+  // edges.
+  int num_nonzeros() const { return cols_.size(); }
+
+  int Degree(int vertex) const {
+    DCHECK_GE(vertex, 0);
+    DCHECK_LT(vertex, num_vertices());
+    return rows_[vertex + 1] - rows_[vertex];
+  }
+
+  // The neighbors of vertex in increasing order. The array has
+  // Degree(vertex) entries.
+  const int* Neighbors(int vertex) const {
+    DCHECK_GE(vertex, 0);
+    DCHECK_LT(vertex, num_vertices());
+    return cols_.empty() ? NULL : &cols_[0] + rows_[vertex];
+  }
+
+  // Weight of the edge between vertex and Neighbors(vertex)[i].
+  double NeighborWeight(int vertex, int i) const {
+    DCHECK_GE(i, 0);
+    DCHECK_LT(i, Degree(vertex));
+    return edge_weights_.empty() ? 1.0 : edge_weights_[rows_[vertex] + i];
+  }
+
+  double VertexWeight(int vertex) const {
+    DCHECK_GE(vertex, 0);
+    DCHECK_LT(vertex, num_vertices());
+    return vertex_weights_.empty() ? 1.0 : vertex_weights_[vertex];
+  }
+
+  // The weight of the edge between vertex1 and vertex2, or zero if
+  // they are not connected. The cost is logarithmic in the degree of
+  // vertex1.
+  double EdgeWeight(int vertex1, int vertex2) const;
+
+ private:
+  void Init(int num_vertices,
+            const vector<pair<int, int> >& edges,
+            const vector<double>* edge_weights,
+            int num_threads);
+
+  vector<int> rows_;
+  vector<int> cols_;
+  vector<double> vertex_weights_;
+  vector<double> edge_weights_;
+
+  CERES_DISALLOW_COPY_AND_ASSIGN(CompressedGraph);
+};
+
+}  // namespace internal
+}  // namespace ceres
+
+#endif  // CERES_INTERNAL_COMPRESSED_GRAPH_H_
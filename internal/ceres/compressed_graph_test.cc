@@ -0,0 +1,137 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "ceres/compressed_graph.h"
+
+#include <utility>
+#include <vector>
+#include "gtest/gtest.h"
+#include "ceres/internal/port.h"
+
+namespace ceres {
+namespace internal {
+
+TEST(CompressedGraph, EmptyGraph) {
+  CompressedGraph graph(0, vector<pair<int, int> >(), 1);
+  EXPECT_EQ(graph.num_vertices(), 0);
+  EXPECT_EQ(graph.num_nonzeros(), 0);
+}
+
+TEST(CompressedGraph, NoEdges) {
+  CompressedGraph graph(3, vector<pair<int, int> >(), 1);
+  EXPECT_EQ(graph.num_vertices(), 3);
+  EXPECT_EQ(graph.num_nonzeros(), 0);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(graph.Degree(i), 0);
+    EXPECT_EQ(graph.VertexWeight(i), 1.0);
+  }
+  EXPECT_EQ(graph.EdgeWeight(0, 1), 0.0);
+}
+
+TEST(CompressedGraph, EdgesAreUndirectedAndUnique) {
+  // 0-1, 1-2 given in both directions and repeated, and a self edge
+  // on 3.
+  vector<pair<int, int> > edges;
+  edges.push_back(make_pair(1, 0));
+  edges.push_back(make_pair(0, 1));
+  edges.push_back(make_pair(1, 2));
+  edges.push_back(make_pair(1, 2));
+  edges.push_back(make_pair(3, 3));
+  edges.push_back(make_pair(3, 3));
+
+  for (int num_threads = 1; num_threads <= 4; num_threads += 3) {
+    CompressedGraph graph(4, edges, num_threads);
+    EXPECT_EQ(graph.num_vertices(), 4);
+    EXPECT_EQ(graph.num_nonzeros(), 5);
+
+    ASSERT_EQ(graph.Degree(0), 1);
+    EXPECT_EQ(graph.Neighbors(0)[0], 1);
+
+    ASSERT_EQ(graph.Degree(1), 2);
+    EXPECT_EQ(graph.Neighbors(1)[0], 0);
+    EXPECT_EQ(graph.Neighbors(1)[1], 2);
+
+    ASSERT_EQ(graph.Degree(2), 1);
+    EXPECT_EQ(graph.Neighbors(2)[0], 1);
+
+    ASSERT_EQ(graph.Degree(3), 1);
+    EXPECT_EQ(graph.Neighbors(3)[0], 3);
+
+    EXPECT_EQ(graph.EdgeWeight(0, 1), 1.0);
+    EXPECT_EQ(graph.EdgeWeight(2, 1), 1.0);
+    EXPECT_EQ(graph.EdgeWeight(3, 3), 1.0);
+    EXPECT_EQ(graph.EdgeWeight(0, 2), 0.0);
+    EXPECT_EQ(graph.NeighborWeight(1, 1), 1.0);
+  }
+}
+
+TEST(CompressedGraph, Weights) {
+  vector<double> vertex_weights;
+  vertex_weights.push_back(1.0);
+  vertex_weights.push_back(2.0);
+  vertex_weights.push_back(3.0);
+
+  vector<pair<int, int> > edges;
+  vector<double> edge_weights;
+  edges.push_back(make_pair(0, 2));
+  edge_weights.push_back(0.5);
+  edges.push_back(make_pair(1, 0));
+  edge_weights.push_back(0.25);
+  edges.push_back(make_pair(1, 1));
+  edge_weights.push_back(4.0);
+  // The last occurrence of an edge determines its weight.
+  edges.push_back(make_pair(2, 0));
+  edge_weights.push_back(0.75);
+
+  for (int num_threads = 1; num_threads <= 4; num_threads += 3) {
+    CompressedGraph graph(vertex_weights, edges, edge_weights, num_threads);
+    EXPECT_EQ(graph.num_vertices(), 3);
+    EXPECT_EQ(graph.num_nonzeros(), 5);
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_EQ(graph.VertexWeight(i), vertex_weights[i]);
+    }
+
+    EXPECT_EQ(graph.EdgeWeight(0, 2), 0.75);
+    EXPECT_EQ(graph.EdgeWeight(2, 0), 0.75);
+    EXPECT_EQ(graph.EdgeWeight(0, 1), 0.25);
+    EXPECT_EQ(graph.EdgeWeight(1, 0), 0.25);
+    EXPECT_EQ(graph.EdgeWeight(1, 1), 4.0);
+    EXPECT_EQ(graph.EdgeWeight(1, 2), 0.0);
+
+    // The weights of the neighbors are stored in the same order as
+    // the neighbors.
+    ASSERT_EQ(graph.Degree(0), 2);
+    EXPECT_EQ(graph.Neighbors(0)[0], 1);
+    EXPECT_EQ(graph.NeighborWeight(0, 0), 0.25);
+    EXPECT_EQ(graph.Neighbors(0)[1], 2);
+    EXPECT_EQ(graph.NeighborWeight(0, 1), 0.75);
+  }
+}
+
+}  // namespace internal
+}  // namespace ceres
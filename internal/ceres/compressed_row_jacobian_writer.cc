@@ -32,6 +32,7 @@
 
 #include "ceres/casts.h"
 #include "ceres/compressed_row_sparse_matrix.h"
+#include "ceres/evaluation_plan.h"
 #include "ceres/parameter_block.h"
 #include "ceres/program.h"
 #include "ceres/residual_block.h"
@@ -40,6 +41,45 @@
 namespace ceres {
 namespace internal {
 
+CompressedRowJacobianWriter::CompressedRowJacobianWriter(
+    Evaluator::Options /* ignored */,
+    Program* program,
+    const EvaluationPlan* plan)
+    : program_(program),
+      plan_(plan) {
+  column_offsets_.resize(plan_->num_arguments(), -1);
+  vector<pair<int, int> > active_arguments;
+  for (int i = 0; i < plan_->num_residual_blocks(); ++i) {
+    const EvaluationPlan::ResidualBlockEntry& entry = plan_->residual_block(i);
+    const EvaluationPlan::Argument* arguments = plan_->arguments(i);
+
+    // Sort the active arguments by the position of their parameter
+    // blocks in the state vector.
+    active_arguments.clear();
+    for (int j = 0; j < entry.num_arguments; ++j) {
+      if (arguments[j].parameter_block_index >= 0) {
+        active_arguments.push_back(
+            make_pair(arguments[j].parameter_block_index, j));
+      }
+    }
+    sort(active_arguments.begin(), active_arguments.end());
+    for (int k = 1; k < active_arguments.size(); ++k) {
+      CHECK_NE(active_arguments[k - 1].first, active_arguments[k].first)
+          << "Ceres internal error:  "
+          << "Duplicate parameter blocks detected in a cost function. "
+          << "This should never happen. Please report this to "
+          << "the Ceres developers.";
+    }
+
+    int col_pos = 0;
+    for (int k = 0; k < active_arguments.size(); ++k) {
+      const int j = active_arguments[k].second;
+      column_offsets_[entry.arguments_begin + j] = col_pos;
+      col_pos += arguments[j].local_size;
+    }
+  }
+}
+
 SparseMatrix* CompressedRowJacobianWriter::CreateJacobian() const {
   const vector<ResidualBlock*>& residual_blocks =
       program_->residual_blocks();
@@ -49,14 +89,12 @@ SparseMatrix* CompressedRowJacobianWriter::CreateJacobian() const {
 
   // Count the number of jacobian nonzeros.
   int num_jacobian_nonzeros = 0;
-  for (int i = 0; i < residual_blocks.size(); ++i) {
-    ResidualBlock* residual_block = residual_blocks[i];
-    const int num_residuals = residual_block->NumResiduals();
-    const int num_parameter_blocks = residual_block->NumParameterBlocks();
-    for (int j = 0; j < num_parameter_blocks; ++j) {
-      ParameterBlock* parameter_block = residual_block->parameter_blocks()[j];
-      if (!parameter_block->IsConstant()) {
-        num_jacobian_nonzeros += num_residuals * parameter_block->LocalSize();
+  for (int i = 0; i < plan_->num_residual_blocks(); ++i) {
+    const EvaluationPlan::ResidualBlockEntry& entry = plan_->residual_block(i);
+    const EvaluationPlan::Argument* arguments = plan_->arguments(i);
+    for (int j = 0; j < entry.num_arguments; ++j) {
+      if (arguments[j].delta_offset >= 0) {
+        num_jacobian_nonzeros += entry.num_residuals * arguments[j].local_size;
       }
     }
   }
@@ -75,60 +113,41 @@ SparseMatrix* CompressedRowJacobianWriter::CreateJacobian() const {
   // seems to be the only way to construct it without doing a memory copy.
   int* rows = jacobian->mutable_rows();
   int* cols = jacobian->mutable_cols();
-  int row_pos = 0;
   rows[0] = 0;
-  for (int i = 0; i < residual_blocks.size(); ++i) {
-    const ResidualBlock* residual_block = residual_blocks[i];
-    const int num_parameter_blocks = residual_block->NumParameterBlocks();
+  for (int i = 0; i < plan_->num_residual_blocks(); ++i) {
+    const EvaluationPlan::ResidualBlockEntry& entry = plan_->residual_block(i);
+    const EvaluationPlan::Argument* arguments = plan_->arguments(i);
+    const int* column_offsets = &column_offsets_[0] + entry.arguments_begin;
+    const int row_pos = entry.residual_offset;
 
-    // Count the number of derivatives for a row of this residual block and
-    // build a list of active parameter block indices.
+    // Count the number of derivatives for a row of this residual block.
     int num_derivatives = 0;
-    vector<int> parameter_indices;
-    for (int j = 0; j < num_parameter_blocks; ++j) {
-      ParameterBlock* parameter_block = residual_block->parameter_blocks()[j];
-      if (!parameter_block->IsConstant()) {
-        parameter_indices.push_back(parameter_block->index());
-        num_derivatives += parameter_block->LocalSize();
+    for (int j = 0; j < entry.num_arguments; ++j) {
+      if (column_offsets[j] >= 0) {
+        num_derivatives += arguments[j].local_size;
       }
     }
 
-    // Sort the parameters by their position in the state vector.
-    sort(parameter_indices.begin(), parameter_indices.end());
-    CHECK(unique(parameter_indices.begin(), parameter_indices.end()) ==
-          parameter_indices.end())
-          << "Ceres internal error:  "
-          << "Duplicate parameter blocks detected in a cost function. "
-          << "This should never happen. Please report this to "
-          << "the Ceres developers.";
-
     // Update the row indices.
-    const int num_residuals = residual_block->NumResiduals();
-    for (int j = 0; j < num_residuals; ++j) {
-      rows[row_pos + j + 1] = rows[row_pos + j] + num_derivatives;
+    for (int r = 0; r < entry.num_residuals; ++r) {
+      rows[row_pos + r + 1] = rows[row_pos + r] + num_derivatives;
     }
 
-    // Iterate over parameter blocks in the order which they occur in the
-    // parameter vector. This code mirrors that in Write(), where jacobian
-    // values are updated.
-    int col_pos = 0;
-    for (int j = 0; j < parameter_indices.size(); ++j) {
-      ParameterBlock* parameter_block =
-          program_->parameter_blocks()[parameter_indices[j]];
-      const int parameter_block_size = parameter_block->LocalSize();
-
-      for (int r = 0; r < num_residuals; ++r) {
+    // Fill in the column indices of each jacobian block. This code
+    // mirrors that in Write(), where jacobian values are updated.
+    for (int j = 0; j < entry.num_arguments; ++j) {
+      if (column_offsets[j] < 0) {
+        continue;
+      }
+      for (int r = 0; r < entry.num_residuals; ++r) {
         // This is the position in the values array of the jacobian where this
         // row of the jacobian block should go.
-        const int column_block_begin = rows[row_pos + r] + col_pos;
-
-        for (int c = 0; c < parameter_block_size; ++c) {
-          cols[column_block_begin + c] = parameter_block->delta_offset() + c;
+        const int column_block_begin = rows[row_pos + r] + column_offsets[j];
+        for (int c = 0; c < arguments[j].local_size; ++c) {
+          cols[column_block_begin + c] = arguments[j].delta_offset + c;
         }
       }
-      col_pos += parameter_block_size;
     }
-    row_pos += num_residuals;
   }
   CHECK_EQ(num_jacobian_nonzeros, rows[total_num_residuals]);
 
@@ -162,55 +181,32 @@ void CompressedRowJacobianWriter::Write(int residual_id,
   double* jacobian_values = jacobian->mutable_values();
   const int* jacobian_rows = jacobian->rows();
 
-  const ResidualBlock* residual_block =
-      program_->residual_blocks()[residual_id];
-  const int num_parameter_blocks = residual_block->NumParameterBlocks();
-  const int num_residuals = residual_block->NumResiduals();
-
-  // It is necessary to determine the order of the jacobian blocks before
-  // copying them into the CompressedRowSparseMatrix. Just because a cost
-  // function uses parameter blocks 1 after 2 in its arguments does not mean
-  // that the block 1 occurs before block 2 in the column layout of the
-  // jacobian. Thus, determine the order by sorting the jacobian blocks by their
-  // position in the state vector.
-  vector<pair<int, int> > evaluated_jacobian_blocks;
-  for (int j = 0; j < num_parameter_blocks; ++j) {
-    const ParameterBlock* parameter_block =
-        residual_block->parameter_blocks()[j];
-    if (!parameter_block->IsConstant()) {
-      evaluated_jacobian_blocks.push_back(
-          make_pair(parameter_block->index(), j));
-    }
-  }
-  sort(evaluated_jacobian_blocks.begin(), evaluated_jacobian_blocks.end());
-
-  // Where in the current row does the jacobian for a parameter block begin.
-  int col_pos = 0;
+  const EvaluationPlan::ResidualBlockEntry& entry =
+      plan_->residual_block(residual_id);
+  const EvaluationPlan::Argument* arguments = plan_->arguments(residual_id);
+  const int* column_offsets = &column_offsets_[0] + entry.arguments_begin;
 
-  // Iterate over the jacobian blocks in increasing order of their
-  // positions in the reduced parameter vector.
-  for (int i = 0; i < evaluated_jacobian_blocks.size(); ++i) {
-    const ParameterBlock* parameter_block =
-        program_->parameter_blocks()[evaluated_jacobian_blocks[i].first];
-    const int argument = evaluated_jacobian_blocks[i].second;
-    const int parameter_block_size = parameter_block->LocalSize();
+  for (int j = 0; j < entry.num_arguments; ++j) {
+    if (column_offsets[j] < 0) {
+      continue;
+    }
+    const int parameter_block_size = arguments[j].local_size;
 
     // Copy one row of the jacobian block at a time.
-    for (int r = 0; r < num_residuals; ++r) {
+    for (int r = 0; r < entry.num_residuals; ++r) {
       // Position of the r^th row of the current jacobian block.
       const double* block_row_begin =
-          jacobians[argument] + r * parameter_block_size;
+          jacobians[j] + r * parameter_block_size;
 
       // Position in the values array of the jacobian where this
       // row of the jacobian block should go.
-      double* column_block_begin =
-          jacobian_values + jacobian_rows[residual_offset + r] + col_pos;
+      double* column_block_begin = jacobian_values +
+          jacobian_rows[residual_offset + r] + column_offsets[j];
 
       copy(block_row_begin,
            block_row_begin + parameter_block_size,
            column_block_begin);
     }
-    col_pos += parameter_block_size;
   }
 }
 
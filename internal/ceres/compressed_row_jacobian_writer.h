@@ -33,21 +33,23 @@
 #ifndef CERES_INTERNAL_COMPRESSED_ROW_JACOBIAN_WRITER_H_
 #define CERES_INTERNAL_COMPRESSED_ROW_JACOBIAN_WRITER_H_
 
+#include <vector>
 #include "ceres/evaluator.h"
+#include "ceres/internal/port.h"
 #include "ceres/scratch_evaluate_preparer.h"
 
 namespace ceres {
 namespace internal {
 
+class EvaluationPlan;
 class Program;
 class SparseMatrix;
 
 class CompressedRowJacobianWriter {
  public:
   CompressedRowJacobianWriter(Evaluator::Options /* ignored */,
-                              Program* program)
-    : program_(program) {
-  }
+                              Program* program,
+                              const EvaluationPlan* plan);
 
   // JacobianWriter interface.
 
@@ -55,7 +57,7 @@ class CompressedRowJacobianWriter {
   // the cost functions, use scratch space to store the jacobians temporarily
   // then copy them over to the larger jacobian in the Write() function.
   ScratchEvaluatePreparer* CreateEvaluatePreparers(int num_threads) {
-    return ScratchEvaluatePreparer::Create(*program_, num_threads);
+    return ScratchEvaluatePreparer::Create(*program_, plan_, num_threads);
   }
 
   SparseMatrix* CreateJacobian() const;
@@ -67,6 +69,17 @@ class CompressedRowJacobianWriter {
 
  private:
   Program* program_;
+  const EvaluationPlan* plan_;
+
+  // The columns of a row of a CompressedRowSparseMatrix are sorted, so
+  // the jacobian blocks of a residual block are stored in the order of
+  // the positions of their parameter blocks in the state vector, which
+  // need not be the order in which the cost function takes them.
+  //
+  // column_offsets_ has one entry per argument of the evaluation plan,
+  // the position of the jacobian block of that argument within each row
+  // of its residual block, or -1 if the parameter block is constant.
+  vector<int> column_offsets_;
 };
 
 }  // namespace internal
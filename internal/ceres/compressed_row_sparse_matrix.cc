@@ -34,6 +34,7 @@
 #include <vector>
 #include "ceres/crs_matrix.h"
 #include "ceres/internal/port.h"
+#include "ceres/lsqp_binary_file.h"
 #include "ceres/matrix_proto.h"
 
 namespace ceres {
@@ -337,6 +338,33 @@ void CompressedRowSparseMatrix::ToTextFile(FILE* file) const {
   }
 }
 
+void CompressedRowSparseMatrix::ToBinaryFile(FILE* file) const {
+  CHECK_NOTNULL(file);
+  const int num_row_blocks = row_blocks_.size();
+  const int num_col_blocks = col_blocks_.size();
+  const int64 num_ints =
+      3 + static_cast<int64>(num_rows_ + 1) + num_nonzeros() +
+      1 + num_row_blocks + 1 + num_col_blocks;
+  WriteLsqpChunkHeader(file,
+                       LSQP_COMPRESSED_ROW_SPARSE_MATRIX,
+                       num_ints * sizeof(int));
+
+  const int header[3] = { num_rows_, num_cols_, num_nonzeros() };
+  WriteLsqpInts(file, header, 3);
+  WriteLsqpInts(file, rows_.get(), num_rows_ + 1);
+  WriteLsqpInts(file, cols_.get(), num_nonzeros());
+  WriteLsqpInts(file, &num_row_blocks, 1);
+  if (num_row_blocks > 0) {
+    WriteLsqpInts(file, &row_blocks_[0], num_row_blocks);
+  }
+  WriteLsqpInts(file, &num_col_blocks, 1);
+  if (num_col_blocks > 0) {
+    WriteLsqpInts(file, &col_blocks_[0], num_col_blocks);
+  }
+
+  WriteLsqpDoubleChunks(file, LSQP_A_VALUES, values_.get(), num_nonzeros());
+}
+
 void CompressedRowSparseMatrix::ToCRSMatrix(CRSMatrix* matrix) const {
   matrix->num_rows = num_rows();
   matrix->num_cols = num_cols();
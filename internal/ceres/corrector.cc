@@ -114,10 +114,14 @@ void Corrector::CorrectJacobian(int nrow, int ncol,
   DCHECK(residuals != NULL);
   DCHECK(jacobian != NULL);
 
-  if (nrow == 1) {
+  if (alpha_sq_norm_ == 0.0) {
+    // The rank-1 term vanishes, so only the scaling remains.
+    VectorRef(jacobian, nrow * ncol) *= sqrt_rho1_;
+  } else if (nrow == 1) {
     // Specialization for the case where the residual is a scalar.
     VectorRef j_ref(jacobian, ncol);
-    j_ref *= sqrt_rho1_ * (1.0 - alpha_sq_norm_ * pow(*residuals, 2));
+    j_ref *= sqrt_rho1_ *
+        (1.0 - alpha_sq_norm_ * (residuals[0] * residuals[0]));
   } else {
     ConstVectorRef r_ref(residuals, nrow);
     MatrixRef j_ref(jacobian, nrow, ncol);
@@ -74,6 +74,11 @@ class Corrector {
   // The method assumes that the jacobian has row-major storage. It is
   // the caller's responsibility to ensure that the pointer to
   // jacobian is not null.
+  //
+  // When alpha = 0, which is always the case for loss functions with
+  // rho'' <= 0 (e.g. CauchyLoss, ArctanLoss and SoftLOneLoss), the
+  // correction reduces to scaling the jacobian by sqrt(rho[1]), and
+  // the rank-1 update is skipped.
   void CorrectJacobian(int nrow, int ncol,
                        double* residuals, double* jacobian);
 
@@ -32,6 +32,7 @@
 
 #include "ceres/cxsparse.h"
 
+#include "ceres/compressed_column_scatter.h"
 #include "ceres/compressed_row_sparse_matrix.h"
 #include "ceres/triplet_sparse_matrix.h"
 #include "glog/logging.h"
@@ -92,6 +93,37 @@ cs_dis* CXSparse::AnalyzeCholesky(cs_di* A) {
   return cs_schol(1, A);
 }
 
+cs_dis* CXSparse::AnalyzeCholeskyWithUserOrdering(
+    cs_di* A,
+    const vector<int>& ordering) {
+  CHECK_EQ(ordering.size(), A->n);
+
+  // cs_schol only computes AMD or natural orderings. So compute the
+  // symbolic factorization of the permuted matrix in its natural
+  // ordering, and make the ordering its permutation, which
+  // cs_chol and SolveCholesky apply to A.
+  int* pinv = cs_pinv(&ordering[0], A->n);
+  if (pinv == NULL) {
+    return NULL;
+  }
+
+  cs_di* permuted_A = cs_symperm(A, pinv, 0);
+  if (permuted_A == NULL) {
+    cs_free(pinv);
+    return NULL;
+  }
+
+  cs_dis* symbolic_factorization = cs_schol(0, permuted_A);
+  cs_spfree(permuted_A);
+  if (symbolic_factorization == NULL) {
+    cs_free(pinv);
+    return NULL;
+  }
+
+  symbolic_factorization->pinv = pinv;
+  return symbolic_factorization;
+}
+
 cs_di CXSparse::CreateSparseMatrixTransposeView(CompressedRowSparseMatrix* A) {
   cs_di At;
   At.m = A->num_cols();
@@ -104,6 +136,18 @@ cs_di CXSparse::CreateSparseMatrixTransposeView(CompressedRowSparseMatrix* A) {
   return At;
 }
 
+cs_di CXSparse::CreateSparseMatrixView(CompressedColumnScatter* A) {
+  cs_di view;
+  view.m = A->num_rows();
+  view.n = A->num_cols();
+  view.nz = -1;
+  view.nzmax = A->num_nonzeros();
+  view.p = A->mutable_col_starts();
+  view.i = A->mutable_rows();
+  view.x = A->mutable_values();
+  return view;
+}
+
 cs_di* CXSparse::CreateSparseMatrix(TripletSparseMatrix* tsm) {
   cs_di_sparse tsm_wrapper;
   tsm_wrapper.nzmax = tsm->num_nonzeros();;
@@ -33,11 +33,14 @@
 
 #ifndef CERES_NO_CXSPARSE
 
+#include <vector>
+#include "ceres/internal/port.h"
 #include "cs.h"
 
 namespace ceres {
 namespace internal {
 
+class CompressedColumnScatter;
 class CompressedRowSparseMatrix;
 class TripletSparseMatrix;
 
@@ -64,6 +67,10 @@ class CXSparse {
   // argument.
   cs_di CreateSparseMatrixTransposeView(CompressedRowSparseMatrix* A);
 
+  // Same as above, but for a matrix stored in compressed column
+  // form.
+  cs_di CreateSparseMatrixView(CompressedColumnScatter* A);
+
   // Creates a new matrix from a triplet form. Deallocate the returned matrix
   // with Free. May return NULL if the compression or allocation fails.
   cs_di* CreateSparseMatrix(TripletSparseMatrix* A);
@@ -72,6 +79,12 @@ class CXSparse {
   // The returned matrix should be deallocated with Free when not used anymore.
   cs_dis* AnalyzeCholesky(cs_di* A);
 
+  // Same as AnalyzeCholesky, but using the given fill-reducing
+  // ordering instead of AMD, i.e., row/column ordering[i] of A is
+  // the i^th one to be eliminated.
+  cs_dis* AnalyzeCholeskyWithUserOrdering(cs_di* A,
+                                          const vector<int>& ordering);
+
   void Free(cs_di* sparse_matrix);
   void Free(cs_dis* symbolic_factorization);
 
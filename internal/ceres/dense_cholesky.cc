@@ -0,0 +1,285 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "ceres/dense_cholesky.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "Eigen/Dense"
+#include "ceres/fpclassify.h"
+#include "ceres/internal/eigen.h"
+#include "glog/logging.h"
+
+namespace ceres {
+namespace internal {
+namespace {
+
+typedef Eigen::Matrix<float,
+                      Eigen::Dynamic,
+                      Eigen::Dynamic,
+                      Eigen::RowMajor> FloatMatrix;
+typedef Eigen::Matrix<float, Eigen::Dynamic, 1> FloatVector;
+
+// Tiles smaller than this do not have enough work to amortize the
+// cost of the GEMM calls and the thread synchronization.
+const int kMinTileSize = 128;
+
+// Divide [0, num_rows) into tiles of at least kMinTileSize rows,
+// whose boundaries are block boundaries. tiles contains the
+// boundaries, starting with 0 and ending with num_rows.
+void ComputeTiles(const vector<int>& block_layout,
+                  const int num_rows,
+                  vector<int>* tiles) {
+  tiles->clear();
+  tiles->push_back(0);
+  for (int i = 0; i < block_layout.size(); ++i) {
+    if (block_layout[i] - tiles->back() >= kMinTileSize) {
+      tiles->push_back(block_layout[i]);
+    }
+  }
+
+  // Without a block structure, use uniform tiles.
+  if (block_layout.empty()) {
+    for (int i = kMinTileSize; i < num_rows; i += kMinTileSize) {
+      tiles->push_back(i);
+    }
+  }
+
+  // Merge a small last tile into the previous one.
+  if (tiles->size() > 1 && num_rows - tiles->back() < kMinTileSize / 2) {
+    tiles->pop_back();
+  }
+  tiles->push_back(num_rows);
+}
+
+template <typename T>
+bool BlockedCholeskyFactorizeImpl(const DenseCholeskyOptions& options,
+                                  const int num_rows,
+                                  T* values) {
+  typedef Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+      TileMatrix;
+  Eigen::Map<TileMatrix> lhs(values, num_rows, num_rows);
+
+  vector<int> tiles;
+  ComputeTiles(options.block_layout, num_rows, &tiles);
+  const int num_tiles = tiles.size() - 1;
+
+  for (int k = 0; k < num_tiles; ++k) {
+    const int k_begin = tiles[k];
+    const int k_size = tiles[k + 1] - k_begin;
+
+    // Factorize the diagonal tile.
+    Eigen::LLT<TileMatrix, Eigen::Upper> llt(
+        lhs.block(k_begin, k_begin, k_size, k_size));
+    if (llt.info() != Eigen::Success) {
+      return false;
+    }
+    lhs.block(k_begin, k_begin, k_size, k_size)
+        .template triangularView<Eigen::Upper>() = llt.matrixU();
+
+    // Solve for the tiles to the right of the diagonal tile, i.e.,
+    // U_kj = U_kk^-T A_kj.
+#pragma omp parallel for num_threads(options.num_threads) schedule(dynamic)
+    for (int j = k + 1; j < num_tiles; ++j) {
+      llt.matrixL().solveInPlace(
+          lhs.block(k_begin, tiles[j], k_size, tiles[j + 1] - tiles[j]));
+    }
+
+    // Update the upper triangular part of the trailing submatrix,
+    // A_ij -= U_ki' U_kj, one tile at a time. The tiles are
+    // independent of each other, so they are distributed over the
+    // threads as a flat list of (i, j) pairs.
+    const int num_trailing_tiles = num_tiles - k - 1;
+    const int num_updates =
+        num_trailing_tiles * (num_trailing_tiles + 1) / 2;
+#pragma omp parallel for num_threads(options.num_threads) schedule(dynamic)
+    for (int u = 0; u < num_updates; ++u) {
+      // Map u to the pair (i, j), with k < i <= j, enumerating the
+      // tiles row by row.
+      int i = k + 1;
+      int row_length = num_trailing_tiles;
+      int offset = u;
+      while (offset >= row_length) {
+        offset -= row_length;
+        --row_length;
+        ++i;
+      }
+      const int j = i + offset;
+
+      const int i_begin = tiles[i];
+      const int i_size = tiles[i + 1] - i_begin;
+      const int j_begin = tiles[j];
+      const int j_size = tiles[j + 1] - j_begin;
+      if (i == j) {
+        lhs.block(i_begin, i_begin, i_size, i_size)
+            .template selfadjointView<Eigen::Upper>()
+            .rankUpdate(lhs.block(k_begin, i_begin, k_size, i_size)
+                        .transpose(),
+                        T(-1.0));
+      } else {
+        lhs.block(i_begin, j_begin, i_size, j_size).noalias() -=
+            lhs.block(k_begin, i_begin, k_size, i_size).transpose() *
+            lhs.block(k_begin, j_begin, k_size, j_size);
+      }
+    }
+  }
+
+  return true;
+}
+
+// Solve U'U x = rhs, where U is stored in the upper triangular part
+// of the row major matrix factor.
+template <typename FactorMatrix, typename VectorType>
+void SolveUsingFactor(const FactorMatrix& factor, VectorType* rhs) {
+  factor.template triangularView<Eigen::Upper>()
+      .transpose().solveInPlace(*rhs);
+  factor.template triangularView<Eigen::Upper>().solveInPlace(*rhs);
+}
+
+// Infinity norm of the symmetric matrix whose upper triangular part
+// is stored in lhs.
+double SymmetricInfinityNorm(const ConstMatrixRef& lhs) {
+  const int num_rows = lhs.rows();
+  Vector row_sums = Vector::Zero(num_rows);
+  for (int i = 0; i < num_rows; ++i) {
+    row_sums[i] += std::abs(lhs(i, i));
+    for (int j = i + 1; j < num_rows; ++j) {
+      const double a = std::abs(lhs(i, j));
+      row_sums[i] += a;
+      row_sums[j] += a;
+    }
+  }
+  return row_sums.maxCoeff();
+}
+
+// Mixed precision iterative refinement, along the lines of LAPACK's
+// dsposv. Returns the number of iterations used, or zero if the
+// single precision factorization failed or the refinement did not
+// converge.
+int SolveUsingIterativeRefinement(const DenseCholeskyOptions& options,
+                                  const ConstMatrixRef& lhs,
+                                  const ConstVectorRef& rhs,
+                                  VectorRef* solution) {
+  const int num_rows = lhs.rows();
+  FloatMatrix factor = lhs.cast<float>();
+  if (!BlockedCholeskyFactorize(options, num_rows, factor.data())) {
+    VLOG(2) << "Single precision Cholesky factorization failed.";
+    return 0;
+  }
+
+  // The refinement has converged when the residual is as small as a
+  // backward stable double precision solve would make it.
+  const double tolerance = std::sqrt(static_cast<double>(num_rows)) *
+      std::numeric_limits<double>::epsilon() *
+      SymmetricInfinityNorm(lhs);
+
+  solution->setZero();
+  Vector residual = rhs;
+  FloatVector correction(num_rows);
+  for (int i = 1; i <= options.max_num_refinement_iterations; ++i) {
+    correction = residual.cast<float>();
+    SolveUsingFactor(factor, &correction);
+    *solution += correction.cast<double>();
+    residual = rhs;
+    residual.noalias() -= lhs.selfadjointView<Eigen::Upper>() * (*solution);
+
+    const double residual_norm = residual.lpNorm<Eigen::Infinity>();
+    const double solution_norm = solution->lpNorm<Eigen::Infinity>();
+    if (!IsFinite(residual_norm)) {
+      break;
+    }
+    if (residual_norm <= tolerance * solution_norm) {
+      return i;
+    }
+  }
+
+  VLOG(2) << "Iterative refinement did not converge in "
+          << options.max_num_refinement_iterations << " iterations.";
+  return 0;
+}
+
+}  // namespace
+
+bool BlockedCholeskyFactorize(const DenseCholeskyOptions& options,
+                              const int num_rows,
+                              double* lhs) {
+  return BlockedCholeskyFactorizeImpl(options, num_rows, lhs);
+}
+
+bool BlockedCholeskyFactorize(const DenseCholeskyOptions& options,
+                              const int num_rows,
+                              float* lhs) {
+  return BlockedCholeskyFactorizeImpl(options, num_rows, lhs);
+}
+
+void SolveUsingCholeskyFactor(const double* factor,
+                              const int num_rows,
+                              double* rhs) {
+  VectorRef rhs_ref(rhs, num_rows);
+  SolveUsingFactor(ConstMatrixRef(factor, num_rows, num_rows), &rhs_ref);
+}
+
+int SolveDenseSymmetricSystem(const DenseCholeskyOptions& options,
+                              const double* lhs,
+                              const double* rhs,
+                              const int num_rows,
+                              double* solution) {
+  ConstMatrixRef lhs_ref(lhs, num_rows, num_rows);
+  ConstVectorRef rhs_ref(rhs, num_rows);
+  VectorRef solution_ref(solution, num_rows);
+
+  if (options.use_mixed_precision) {
+    const int num_iterations =
+        SolveUsingIterativeRefinement(options, lhs_ref, rhs_ref,
+                                      &solution_ref);
+    if (num_iterations > 0) {
+      return num_iterations;
+    }
+    VLOG(2) << "Falling back to double precision factorization.";
+  }
+
+  Matrix factor = lhs_ref;
+  if (BlockedCholeskyFactorize(options, num_rows, factor.data())) {
+    solution_ref = rhs_ref;
+    SolveUsingFactor(factor, &solution_ref);
+    return 0;
+  }
+
+  // The matrix is only positive semidefinite.
+  //
+  // TODO(sameeragarwal): Add proper error handling; this completely ignores
+  // the quality of the solution to the solve.
+  solution_ref =
+      lhs_ref.selfadjointView<Eigen::Upper>().ldlt().solve(rhs_ref);
+  return 0;
+}
+
+}  // namespace internal
+}  // namespace ceres
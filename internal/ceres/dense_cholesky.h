@@ -0,0 +1,109 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Dense Cholesky factorization based solvers for symmetric positive
+// definite linear systems.
+
+#ifndef CERES_INTERNAL_DENSE_CHOLESKY_H_
+#define CERES_INTERNAL_DENSE_CHOLESKY_H_
+
+#include <vector>
+#include "ceres/internal/port.h"
+
+namespace ceres {
+namespace internal {
+
+struct DenseCholeskyOptions {
+  DenseCholeskyOptions()
+      : use_mixed_precision(false),
+        max_num_refinement_iterations(10),
+        num_threads(1) {
+  }
+
+  // If true, the matrix is factorized in single precision, and the
+  // solution is refined to double precision accuracy using residuals
+  // computed in double precision. This roughly halves the cost of the
+  // factorization, which dominates for large systems. If the matrix
+  // is too ill-conditioned for the single precision factorization,
+  // or the refinement does not converge in
+  // max_num_refinement_iterations, the system is solved using a
+  // double precision factorization instead.
+  bool use_mixed_precision;
+  int max_num_refinement_iterations;
+
+  // Number of threads used by the blocked factorization.
+  int num_threads;
+
+  // Row/column offsets of the diagonal blocks of the matrix, as in
+  // BlockRandomAccessDenseMatrix. If not empty, the tiles of the
+  // blocked factorization are aligned with these blocks.
+  vector<int> block_layout;
+};
+
+// Solve the linear system lhs * solution = rhs, where lhs is a
+// num_rows x num_rows symmetric positive (semi)definite matrix stored
+// in row major order. Only the upper triangular part of lhs is
+// referenced.
+//
+// Returns the number of refinement iterations performed, or zero if
+// the double precision factorization was used.
+int SolveDenseSymmetricSystem(const DenseCholeskyOptions& options,
+                              const double* lhs,
+                              const double* rhs,
+                              int num_rows,
+                              double* solution);
+
+// Compute the Cholesky factorization lhs = U'U of a symmetric
+// positive definite num_rows x num_rows matrix stored in row major
+// order, and overwrite the upper triangular part of lhs with U. The
+// strictly lower triangular part of lhs is not referenced.
+//
+// This is a right looking blocked factorization. The matrix is
+// divided into square tiles whose boundaries are taken from
+// options.block_layout, and at each step the diagonal tile is
+// factorized, the tiles to its right are solved for, and the
+// trailing submatrix is updated tile by tile using
+// options.num_threads threads.
+//
+// Returns false if lhs is not numerically positive definite.
+bool BlockedCholeskyFactorize(const DenseCholeskyOptions& options,
+                              int num_rows,
+                              double* lhs);
+bool BlockedCholeskyFactorize(const DenseCholeskyOptions& options,
+                              int num_rows,
+                              float* lhs);
+
+// Solve U'U x = rhs in place, where U is the Cholesky factor computed
+// by BlockedCholeskyFactorize, i.e., the upper triangular part of the
+// num_rows x num_rows row major matrix factor.
+void SolveUsingCholeskyFactor(const double* factor, int num_rows, double* rhs);
+
+}  // namespace internal
+}  // namespace ceres
+
+#endif  // CERES_INTERNAL_DENSE_CHOLESKY_H_
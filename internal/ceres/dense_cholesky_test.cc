@@ -0,0 +1,167 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "ceres/dense_cholesky.h"
+
+#include <cmath>
+#include "Eigen/Dense"
+#include "ceres/internal/eigen.h"
+#include "gtest/gtest.h"
+
+namespace ceres {
+namespace internal {
+
+// Create a random symmetric positive definite matrix with the given
+// condition number and a random right hand side.
+void CreateRandomSystem(const int num_rows,
+                        const double condition_number,
+                        Matrix* lhs,
+                        Vector* rhs) {
+  srand(5);
+  const Matrix random = Matrix::Random(num_rows, num_rows);
+  Eigen::HouseholderQR<Matrix> qr(random);
+  const Matrix q = qr.householderQ();
+  Vector eigenvalues(num_rows);
+  for (int i = 0; i < num_rows; ++i) {
+    eigenvalues[i] = std::pow(condition_number,
+                              -static_cast<double>(i) / (num_rows - 1));
+  }
+  *lhs = q * eigenvalues.asDiagonal() * q.transpose();
+  *rhs = Vector::Random(num_rows);
+}
+
+void ExpectSolutionIsAccurate(const Matrix& lhs,
+                              const Vector& rhs,
+                              const Vector& solution) {
+  const Vector expected = lhs.ldlt().solve(rhs);
+  EXPECT_LT((solution - expected).norm() / expected.norm(), 1e-10);
+}
+
+TEST(DenseCholesky, DoublePrecision) {
+  Matrix lhs;
+  Vector rhs;
+  CreateRandomSystem(50, 1e3, &lhs, &rhs);
+  Vector solution(50);
+  DenseCholeskyOptions options;
+  EXPECT_EQ(SolveDenseSymmetricSystem(options, lhs.data(), rhs.data(), 50,
+                                      solution.data()), 0);
+  ExpectSolutionIsAccurate(lhs, rhs, solution);
+}
+
+void ExpectBlockedFactorizationIsCorrect(const DenseCholeskyOptions& options,
+                                         const int num_rows) {
+  Matrix lhs;
+  Vector rhs;
+  CreateRandomSystem(num_rows, 1e3, &lhs, &rhs);
+  Matrix factor = lhs;
+  ASSERT_TRUE(BlockedCholeskyFactorize(options, num_rows, factor.data()));
+
+  const Matrix expected = lhs.llt().matrixU();
+  const Matrix actual = factor.triangularView<Eigen::Upper>();
+  EXPECT_LT((actual - expected).norm() / expected.norm(), 1e-12);
+}
+
+TEST(DenseCholesky, BlockedFactorizationWithUniformTiles) {
+  DenseCholeskyOptions options;
+  ExpectBlockedFactorizationIsCorrect(options, 50);
+  ExpectBlockedFactorizationIsCorrect(options, 300);
+  ExpectBlockedFactorizationIsCorrect(options, 512);
+}
+
+TEST(DenseCholesky, BlockedFactorizationWithBlockLayout) {
+  // 9x9 camera blocks, as in a bundle adjustment problem.
+  const int kNumBlocks = 50;
+  DenseCholeskyOptions options;
+  for (int i = 0; i < kNumBlocks; ++i) {
+    options.block_layout.push_back(9 * i);
+  }
+  ExpectBlockedFactorizationIsCorrect(options, 9 * kNumBlocks);
+}
+
+TEST(DenseCholesky, MultithreadedBlockedFactorization) {
+  DenseCholeskyOptions options;
+  options.num_threads = 4;
+  ExpectBlockedFactorizationIsCorrect(options, 700);
+}
+
+TEST(DenseCholesky, BlockedFactorizationDetectsIndefiniteMatrix) {
+  Matrix lhs;
+  Vector rhs;
+  CreateRandomSystem(300, 1e3, &lhs, &rhs);
+  lhs(250, 250) = -1.0;
+  DenseCholeskyOptions options;
+  EXPECT_FALSE(BlockedCholeskyFactorize(options, 300, lhs.data()));
+}
+
+TEST(DenseCholesky, MixedPrecisionRecoversDoubleAccuracy) {
+  Matrix lhs;
+  Vector rhs;
+  CreateRandomSystem(50, 1e3, &lhs, &rhs);
+  Vector solution(50);
+  DenseCholeskyOptions options;
+  options.use_mixed_precision = true;
+  const int num_iterations =
+      SolveDenseSymmetricSystem(options, lhs.data(), rhs.data(), 50,
+                                solution.data());
+  EXPECT_GT(num_iterations, 1);
+  EXPECT_LE(num_iterations, 10);
+  ExpectSolutionIsAccurate(lhs, rhs, solution);
+}
+
+TEST(DenseCholesky, MixedPrecisionOnlyUsesUpperTriangle) {
+  Matrix lhs;
+  Vector rhs;
+  CreateRandomSystem(20, 10.0, &lhs, &rhs);
+  Matrix upper = lhs.triangularView<Eigen::Upper>();
+  Vector solution(20);
+  DenseCholeskyOptions options;
+  options.use_mixed_precision = true;
+  EXPECT_GT(SolveDenseSymmetricSystem(options, upper.data(), rhs.data(), 20,
+                                      solution.data()), 0);
+  ExpectSolutionIsAccurate(lhs, rhs, solution);
+}
+
+// The matrix is too ill-conditioned for a single precision
+// factorization, so the solver falls back to double precision.
+TEST(DenseCholesky, MixedPrecisionFallsBackToDouble) {
+  Matrix lhs;
+  Vector rhs;
+  CreateRandomSystem(50, 1e10, &lhs, &rhs);
+  Vector solution(50);
+  DenseCholeskyOptions options;
+  options.use_mixed_precision = true;
+  EXPECT_EQ(SolveDenseSymmetricSystem(options, lhs.data(), rhs.data(), 50,
+                                      solution.data()), 0);
+  // The solution is only as accurate as the conditioning of the
+  // matrix allows, so check the backward error instead.
+  EXPECT_LT((lhs * solution - rhs).norm() / (lhs.norm() * solution.norm()),
+            1e-14);
+}
+
+}  // namespace internal
+}  // namespace ceres
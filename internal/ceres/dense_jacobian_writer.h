@@ -35,9 +35,8 @@
 
 #include "ceres/casts.h"
 #include "ceres/dense_sparse_matrix.h"
-#include "ceres/parameter_block.h"
+#include "ceres/evaluation_plan.h"
 #include "ceres/program.h"
-#include "ceres/residual_block.h"
 #include "ceres/scratch_evaluate_preparer.h"
 #include "ceres/internal/eigen.h"
 
@@ -47,8 +46,10 @@ namespace internal {
 class DenseJacobianWriter {
  public:
   DenseJacobianWriter(Evaluator::Options /* ignored */,
-                      Program* program)
-    : program_(program) {
+                      Program* program,
+                      const EvaluationPlan* plan)
+    : program_(program),
+      plan_(plan) {
   }
 
   // JacobianWriter interface.
@@ -57,7 +58,7 @@ class DenseJacobianWriter {
   // functions, use scratch space to store the jacobians temporarily then copy
   // them over to the larger jacobian later.
   ScratchEvaluatePreparer* CreateEvaluatePreparers(int num_threads) {
-    return ScratchEvaluatePreparer::Create(*program_, num_threads);
+    return ScratchEvaluatePreparer::Create(*program_, plan_, num_threads);
   }
 
   SparseMatrix* CreateJacobian() const {
@@ -74,35 +75,33 @@ class DenseJacobianWriter {
     if (jacobian != NULL) {
       dense_jacobian = down_cast<DenseSparseMatrix*>(jacobian);
     }
-    const ResidualBlock* residual_block =
-        program_->residual_blocks()[residual_id];
-    int num_parameter_blocks = residual_block->NumParameterBlocks();
-    int num_residuals = residual_block->NumResiduals();
+    const EvaluationPlan::ResidualBlockEntry& entry =
+        plan_->residual_block(residual_id);
+    const EvaluationPlan::Argument* arguments = plan_->arguments(residual_id);
 
     // Now copy the jacobians for each parameter into the dense jacobian matrix.
-    for (int j = 0; j < num_parameter_blocks; ++j) {
-      ParameterBlock* parameter_block = residual_block->parameter_blocks()[j];
-
+    for (int j = 0; j < entry.num_arguments; ++j) {
       // If the parameter block is fixed, then there is nothing to do.
-      if (parameter_block->IsConstant()) {
+      if (arguments[j].delta_offset < 0) {
         continue;
       }
 
-      const int parameter_block_size = parameter_block->LocalSize();
+      const int parameter_block_size = arguments[j].local_size;
       ConstMatrixRef parameter_jacobian(jacobians[j],
-                                        num_residuals,
+                                        entry.num_residuals,
                                         parameter_block_size);
 
       dense_jacobian->mutable_matrix().block(
           residual_offset,
-          parameter_block->delta_offset(),
-          num_residuals,
+          arguments[j].delta_offset,
+          entry.num_residuals,
           parameter_block_size) = parameter_jacobian;
     }
   }
 
  private:
   Program* program_;
+  const EvaluationPlan* plan_;
 };
 
 }  // namespace internal
@@ -33,6 +33,7 @@
 #include <cstddef>
 
 #include "Eigen/Dense"
+#include "ceres/dense_cholesky.h"
 #include "ceres/dense_sparse_matrix.h"
 #include "ceres/internal/eigen.h"
 #include "ceres/internal/scoped_ptr.h"
@@ -45,7 +46,8 @@ namespace internal {
 
 DenseNormalCholeskySolver::DenseNormalCholeskySolver(
     const LinearSolver::Options& options)
-    : options_(options) {}
+    : options_(options),
+      products_are_valid_(false) {}
 
 LinearSolver::Summary DenseNormalCholeskySolver::SolveImpl(
     DenseSparseMatrix* A,
@@ -57,20 +59,26 @@ LinearSolver::Summary DenseNormalCholeskySolver::SolveImpl(
   const int num_rows = A->num_rows();
   const int num_cols = A->num_cols();
 
-  ConstColMajorMatrixRef Aref = A->matrix();
-  Matrix lhs(num_cols, num_cols);
-  lhs.setZero();
-
   event_logger.AddEvent("Setup");
-  //   lhs += A'A
-  //
-  // Using rankUpdate instead of GEMM, exposes the fact that its the
-  // same matrix being multiplied with itself and that the product is
-  // symmetric.
-  lhs.selfadjointView<Eigen::Upper>().rankUpdate(Aref.transpose());
+  if (!(per_solve_options.A_and_b_are_unchanged && products_are_valid_)) {
+    ConstColMajorMatrixRef Aref = A->matrix();
+    ata_.resize(num_cols, num_cols);
+    ata_.setZero();
+
+    //   ata_ = A'A
+    //
+    // Using rankUpdate instead of GEMM, exposes the fact that its the
+    // same matrix being multiplied with itself and that the product is
+    // symmetric.
+    ata_.selfadjointView<Eigen::Upper>().rankUpdate(Aref.transpose());
+
+    //   atb_ = A'b
+    atb_ = Aref.transpose() * ConstVectorRef(b, num_rows);
+    products_are_valid_ = true;
+    event_logger.AddEvent("Product");
+  }
 
-  //   rhs = A'b
-  Vector rhs = Aref.transpose() * ConstVectorRef(b, num_rows);
+  Matrix lhs = ata_;
 
   if (per_solve_options.D != NULL) {
     ConstVectorRef D(per_solve_options.D, num_cols);
@@ -80,8 +88,16 @@ LinearSolver::Summary DenseNormalCholeskySolver::SolveImpl(
   LinearSolver::Summary summary;
   summary.num_iterations = 1;
   summary.termination_type = TOLERANCE;
-  VectorRef(x, num_cols) =
-      lhs.selfadjointView<Eigen::Upper>().ldlt().solve(rhs);
+  DenseCholeskyOptions cholesky_options;
+  cholesky_options.use_mixed_precision = options_.use_mixed_precision_solves;
+  cholesky_options.max_num_refinement_iterations =
+      options_.max_num_refinement_iterations;
+  cholesky_options.num_threads = options_.num_threads;
+  SolveDenseSymmetricSystem(cholesky_options,
+                            lhs.data(),
+                            atb_.data(),
+                            num_cols,
+                            x);
   event_logger.AddEvent("Solve");
 
   return summary;
@@ -70,10 +70,12 @@ class DenseSparseMatrix;
 //
 // is solved.
 //
-// This class uses the LDLT factorization routines from the Eigen
-// library. This solver always returns a solution, it is the user's
-// responsibility to judge if the solution is good enough for their
-// purposes.
+// The normal equations are solved using SolveDenseSymmetricSystem
+// (see dense_cholesky.h), i.e., a blocked LLT factorization,
+// optionally in mixed precision, which falls back to Eigen's LDLT
+// factorization if A'A is not numerically positive definite. This
+// solver always returns a solution, it is the user's responsibility
+// to judge if the solution is good enough for their purposes.
 class DenseNormalCholeskySolver: public DenseSparseMatrixSolver {
  public:
   explicit DenseNormalCholeskySolver(const LinearSolver::Options& options);
@@ -86,6 +88,13 @@ class DenseNormalCholeskySolver: public DenseSparseMatrixSolver {
       double* x);
 
   const LinearSolver::Options options_;
+
+  // A'A (upper triangular part) and A'b from the last call to
+  // SolveImpl, reused if PerSolveOptions::A_and_b_are_unchanged.
+  Matrix ata_;
+  Vector atb_;
+  bool products_are_valid_;
+
   CERES_DISALLOW_COPY_AND_ASSIGN(DenseNormalCholeskySolver);
 };
 
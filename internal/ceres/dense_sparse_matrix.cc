@@ -31,6 +31,7 @@
 #include "ceres/dense_sparse_matrix.h"
 
 #include <algorithm>
+#include "ceres/lsqp_binary_file.h"
 #include "ceres/matrix_proto.h"
 #include "ceres/triplet_sparse_matrix.h"
 #include "ceres/internal/eigen.h"
@@ -211,5 +212,26 @@ void DenseSparseMatrix::ToTextFile(FILE* file) const {
   }
 }
 
+void DenseSparseMatrix::ToBinaryFile(FILE* file) const {
+  CHECK_NOTNULL(file);
+  const int active_rows = num_rows();
+  const int header[3] = { active_rows, num_cols(), num_nonzeros() };
+  WriteLsqpChunkHeader(file, LSQP_DENSE_SPARSE_MATRIX, sizeof(header));
+  WriteLsqpInts(file, header, 3);
+
+  // If a diagonal is reserved but not appended, the columns of m_
+  // are longer than the columns of the matrix.
+  if (active_rows == m_.rows()) {
+    WriteLsqpDoubleChunks(file, LSQP_A_VALUES, m_.data(), m_.size());
+  } else {
+    for (int c = 0; c < m_.cols(); ++c) {
+      WriteLsqpDoubleChunks(file,
+                            LSQP_A_VALUES,
+                            m_.data() + c * m_.rows(),
+                            active_rows);
+    }
+  }
+}
+
 }  // namespace internal
 }  // namespace ceres
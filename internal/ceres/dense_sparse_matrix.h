@@ -72,6 +72,7 @@ class DenseSparseMatrix : public SparseMatrix {
   virtual void ToProto(SparseMatrixProto* proto) const;
 #endif
   virtual void ToTextFile(FILE* file) const;
+  virtual void ToBinaryFile(FILE* file) const;
   virtual int num_rows() const;
   virtual int num_cols() const;
   virtual int num_nonzeros() const;
@@ -34,6 +34,7 @@
 #include "Eigen/Dense"
 #include "ceres/array_utils.h"
 #include "ceres/internal/eigen.h"
+#include "ceres/linear_least_squares_problems.h"
 #include "ceres/linear_solver.h"
 #include "ceres/polynomial.h"
 #include "ceres/sparse_matrix.h"
@@ -62,7 +63,8 @@ DoglegStrategy::DoglegStrategy(const TrustRegionStrategy::Options& options)
       decrease_threshold_(0.25),
       dogleg_step_norm_(0.0),
       reuse_(false),
-      dogleg_type_(options.dogleg_type) {
+      dogleg_type_(options.dogleg_type),
+      num_eliminate_blocks_(options.num_eliminate_blocks) {
   CHECK_NOTNULL(linear_solver_);
   CHECK_GT(min_diagonal_, 0.0);
   CHECK_LE(min_diagonal_, max_diagonal_);
@@ -84,6 +86,19 @@ TrustRegionStrategy::Summary DoglegStrategy::ComputeStep(
 
   const int n = jacobian->num_cols();
   if (reuse_) {
+    // The linear least squares problem is the one solved by the
+    // last call to ComputeGaussNewtonStep. Its solution is recovered
+    // from the scaled Gauss-Newton step, so that dumps are not
+    // silently skipped for iterations which follow a rejected step.
+    if (!per_solve_options.dump_directory.empty()) {
+      const Vector solution =
+          -gauss_newton_step_.array() / diagonal_.array();
+      DumpGaussNewtonProblem(per_solve_options,
+                             jacobian,
+                             residuals,
+                             solution.data());
+    }
+
     // Gauss-Newton and gradient vectors are always available, only a
     // new interpolant need to be computed. For the subspace case,
     // the subspace and the two-dimensional model are also still valid.
@@ -127,7 +142,7 @@ TrustRegionStrategy::Summary DoglegStrategy::ComputeStep(
   ComputeCauchyPoint(jacobian);
 
   LinearSolver::Summary linear_solver_summary =
-      ComputeGaussNewtonStep(jacobian, residuals);
+      ComputeGaussNewtonStep(per_solve_options, jacobian, residuals);
 
   TrustRegionStrategy::Summary summary;
   summary.residual_norm = linear_solver_summary.residual_norm;
@@ -507,6 +522,7 @@ bool DoglegStrategy::FindMinimumOnTrustRegionBoundary(Vector2d* minimum) const {
 }
 
 LinearSolver::Summary DoglegStrategy::ComputeGaussNewtonStep(
+    const PerSolveOptions& per_solve_options,
     SparseMatrix* jacobian,
     const double* residuals) {
   const int n = jacobian->num_cols();
@@ -572,6 +588,13 @@ LinearSolver::Summary DoglegStrategy::ComputeGaussNewtonStep(
   }
 
   if (linear_solver_summary.termination_type != FAILURE) {
+    if (!per_solve_options.dump_directory.empty()) {
+      DumpGaussNewtonProblem(per_solve_options,
+                             jacobian,
+                             residuals,
+                             gauss_newton_step_.data());
+    }
+
     // The scaled Gauss-Newton step is D * GN:
     //
     //     - (D^-1 J^T J D^-1)^-1 (D^-1 g)
@@ -584,6 +607,24 @@ LinearSolver::Summary DoglegStrategy::ComputeGaussNewtonStep(
   return linear_solver_summary;
 }
 
+void DoglegStrategy::DumpGaussNewtonProblem(
+    const PerSolveOptions& per_solve_options,
+    SparseMatrix* jacobian,
+    const double* residuals,
+    const double* solution) const {
+  if (!DumpLinearLeastSquaresProblem(per_solve_options.dump_directory,
+                                     per_solve_options.dump_iteration,
+                                     per_solve_options.dump_format_type,
+                                     jacobian,
+                                     lm_diagonal_.data(),
+                                     residuals,
+                                     solution,
+                                     num_eliminate_blocks_)) {
+    LOG(FATAL) << "Tried writing linear least squares problem: "
+               << per_solve_options.dump_directory << " but failed.";
+  }
+}
+
 void DoglegStrategy::StepAccepted(double step_quality) {
   CHECK_GT(step_quality, 0.0);
 
@@ -79,8 +79,17 @@ class DoglegStrategy : public TrustRegionStrategy {
   typedef Eigen::Matrix<double, 2, 1, Eigen::DontAlign> Vector2d;
   typedef Eigen::Matrix<double, 2, 2, Eigen::DontAlign> Matrix2d;
 
-  LinearSolver::Summary ComputeGaussNewtonStep(SparseMatrix* jacobian,
-                                               const double* residuals);
+  LinearSolver::Summary ComputeGaussNewtonStep(
+      const PerSolveOptions& per_solve_options,
+      SparseMatrix* jacobian,
+      const double* residuals);
+  // Dump the linear least squares problem solved by
+  // ComputeGaussNewtonStep, whose solution is the unscaled
+  // Gauss-Newton step.
+  void DumpGaussNewtonProblem(const PerSolveOptions& per_solve_options,
+                              SparseMatrix* jacobian,
+                              const double* residuals,
+                              const double* solution) const;
   void ComputeCauchyPoint(SparseMatrix* jacobian);
   void ComputeGradient(SparseMatrix* jacobian, const double* residuals);
   void ComputeTraditionalDoglegStep(double* step);
@@ -149,6 +158,8 @@ class DoglegStrategy : public TrustRegionStrategy {
   // quadratic model is found.
   DoglegType dogleg_type_;
 
+  const int num_eliminate_blocks_;
+
   // If the type is SUBSPACE_DOGLEG, the two-dimensional
   // model 1/2 x^T B x + g^T x has to be computed and stored.
   bool subspace_is_one_dimensional_;
@@ -0,0 +1,153 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "ceres/evaluation_plan.h"
+
+#include <algorithm>
+#include <map>
+#include <vector>
+#include "ceres/parameter_block.h"
+#include "ceres/program.h"
+#include "ceres/residual_block.h"
+#include "glog/logging.h"
+
+namespace ceres {
+namespace internal {
+
+const int EvaluationPlan::kMaxLossFunctionBatchSize;
+
+EvaluationPlan::EvaluationPlan(const Program& program) {
+  // The state vector is the concatenation of the parameter blocks of
+  // the program (see Program::StateVectorToParameterBlocks), which is
+  // not necessarily consistent with ParameterBlock::state_offset(),
+  // e.g., for the single parameter block programs built by the
+  // CoordinateDescentMinimizer.
+  const vector<ParameterBlock*>& parameter_blocks = program.parameter_blocks();
+  vector<int> state_offsets(parameter_blocks.size());
+  int state_offset = 0;
+  for (int i = 0; i < parameter_blocks.size(); ++i) {
+    state_offsets[i] = state_offset;
+    state_offset += parameter_blocks[i]->Size();
+  }
+
+  const vector<ResidualBlock*>& residual_blocks = program.residual_blocks();
+  int num_arguments = 0;
+  for (int i = 0; i < residual_blocks.size(); ++i) {
+    num_arguments += residual_blocks[i]->NumParameterBlocks();
+  }
+
+  residual_blocks_.resize(residual_blocks.size());
+  arguments_.resize(num_arguments);
+
+  int residual_offset = 0;
+  int argument = 0;
+  for (int i = 0; i < residual_blocks.size(); ++i) {
+    const ResidualBlock* residual_block = residual_blocks[i];
+    ResidualBlockEntry& entry = residual_blocks_[i];
+    entry.residual_block = residual_block;
+    entry.num_residuals = residual_block->NumResiduals();
+    entry.residual_offset = residual_offset;
+    entry.num_arguments = residual_block->NumParameterBlocks();
+    entry.arguments_begin = argument;
+    residual_offset += entry.num_residuals;
+
+    for (int j = 0; j < entry.num_arguments; ++j, ++argument) {
+      const ParameterBlock* parameter_block =
+          residual_block->parameter_blocks()[j];
+      Argument& a = arguments_[argument];
+      a.parameter_block = parameter_block;
+      a.local_size = parameter_block->LocalSize();
+      if (parameter_block->IsConstant()) {
+        a.state_offset = -1;
+        a.delta_offset = -1;
+        a.parameter_block_index = -1;
+      } else {
+        const int index = parameter_block->index();
+        CHECK(index >= 0 &&
+              index < parameter_blocks.size() &&
+              parameter_blocks[index] == parameter_block)
+            << "Parameter block offsets and indices are not set.";
+        a.state_offset = state_offsets[index];
+        a.delta_offset = parameter_block->delta_offset();
+        a.parameter_block_index = index;
+      }
+    }
+  }
+
+  // Group the residual blocks by loss function, keeping the groups in
+  // order of first appearance so that the order in which the costs
+  // are summed does not depend on the addresses of the loss functions.
+  map<const LossFunction*, int> group_ids;
+  vector<vector<int> > groups;
+  for (int i = 0; i < residual_blocks.size(); ++i) {
+    const LossFunction* loss_function = residual_blocks[i]->loss_function();
+    if (loss_function == NULL) {
+      continue;
+    }
+    map<const LossFunction*, int>::const_iterator it =
+        group_ids.find(loss_function);
+    if (it == group_ids.end()) {
+      it = group_ids.insert(make_pair(loss_function,
+                                      static_cast<int>(groups.size()))).first;
+      groups.push_back(vector<int>());
+    }
+    groups[it->second].push_back(i);
+  }
+
+  for (int g = 0; g < groups.size(); ++g) {
+    const LossFunction* loss_function =
+        residual_blocks[groups[g][0]]->loss_function();
+    for (int begin = 0; begin < groups[g].size();
+         begin += kMaxLossFunctionBatchSize) {
+      LossFunctionBatch batch;
+      batch.loss_function = loss_function;
+      batch.begin = robustified_residual_blocks_.size() + begin;
+      batch.size = std::min(static_cast<int>(groups[g].size()) - begin,
+                            kMaxLossFunctionBatchSize);
+      loss_function_batches_.push_back(batch);
+    }
+    robustified_residual_blocks_.insert(robustified_residual_blocks_.end(),
+                                        groups[g].begin(),
+                                        groups[g].end());
+  }
+}
+
+void EvaluationPlan::GetParameters(const int i,
+                                   const double* state,
+                                   const double** parameters) const {
+  const ResidualBlockEntry& entry = residual_blocks_[i];
+  const Argument* arguments = &arguments_[entry.arguments_begin];
+  for (int j = 0; j < entry.num_arguments; ++j) {
+    parameters[j] = (arguments[j].state_offset >= 0)
+        ? state + arguments[j].state_offset
+        : arguments[j].parameter_block->state();
+  }
+}
+
+}  // namespace internal
+}  // namespace ceres
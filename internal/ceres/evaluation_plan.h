@@ -0,0 +1,166 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// A flattened description of the residual blocks of a Program, used by
+// the ProgramEvaluator and the jacobian writers.
+
+#ifndef CERES_INTERNAL_EVALUATION_PLAN_H_
+#define CERES_INTERNAL_EVALUATION_PLAN_H_
+
+#include <vector>
+#include "ceres/internal/macros.h"
+#include "ceres/internal/port.h"
+
+namespace ceres {
+
+class LossFunction;
+
+namespace internal {
+
+class ParameterBlock;
+class Program;
+class ResidualBlock;
+
+// Evaluating a Program by walking its residual blocks involves several
+// levels of indirection per parameter block (Program -> ResidualBlock
+// -> ParameterBlock -> state, constancy, sizes and offsets). The
+// evaluation plan gathers everything the evaluation loop needs into
+// two contiguous arrays, built once when the evaluator is created, so
+// that each evaluation is a linear scan over them.
+//
+// The arguments of all the residual blocks are stored one after the
+// other, in residual block order. Jacobian writers use the position of
+// an argument in this array (ResidualBlockEntry::arguments_begin + j)
+// to index their own per argument tables.
+//
+// The residual blocks with a loss function are also grouped by loss
+// function into batches, so that cost only evaluations can apply the
+// loss functions to many residual blocks at once (see
+// LossFunction::EvaluateBatch).
+//
+// The plan captures the constancy of the parameter blocks and their
+// offsets in the state vector at the time it is built, so it has to be
+// rebuilt if either of them changes.
+class EvaluationPlan {
+ public:
+  // A parameter block argument of a residual block.
+  struct Argument {
+    // Offsets of the parameter block in the state vector and in the
+    // tangent space (i.e. the gradient and the columns of the
+    // jacobian), or -1 if the parameter block is constant.
+    int state_offset;
+    int delta_offset;
+
+    // Position of the parameter block in Program::parameter_blocks(),
+    // or -1 if the parameter block is constant.
+    int parameter_block_index;
+
+    int local_size;
+
+    // Only used to find the values of constant parameter blocks,
+    // which are not part of the state vector.
+    const ParameterBlock* parameter_block;
+  };
+
+  struct ResidualBlockEntry {
+    const ResidualBlock* residual_block;
+    int num_residuals;
+
+    // Offset of the residuals of the residual block in the residual
+    // vector, i.e. the row of the jacobian where they start.
+    int residual_offset;
+
+    int num_arguments;
+    int arguments_begin;
+  };
+
+  // Residual blocks sharing the same loss function. They are stored at
+  // robustified_residual_blocks()[begin, begin + size).
+  struct LossFunctionBatch {
+    const LossFunction* loss_function;
+    int begin;
+    int size;
+  };
+
+  // Upper bound on LossFunctionBatch::size, which keeps the buffers
+  // used to evaluate a batch small enough to stay in cache.
+  static const int kMaxLossFunctionBatchSize = 256;
+
+  explicit EvaluationPlan(const Program& program);
+
+  int num_residual_blocks() const { return residual_blocks_.size(); }
+  const ResidualBlockEntry& residual_block(int i) const {
+    return residual_blocks_[i];
+  }
+
+  // The arguments of the i^th residual block.
+  const Argument* arguments(int i) const {
+    return arguments_.empty()
+        ? NULL
+        : &arguments_[0] + residual_blocks_[i].arguments_begin;
+  }
+
+  // Total number of arguments of all the residual blocks.
+  int num_arguments() const { return arguments_.size(); }
+
+  // Stores pointers to the values of the arguments of the i^th
+  // residual block in parameters, reading the values of the variable
+  // parameter blocks from state.
+  void GetParameters(int i,
+                     const double* state,
+                     const double** parameters) const;
+
+  int num_loss_function_batches() const {
+    return loss_function_batches_.size();
+  }
+  const LossFunctionBatch& loss_function_batch(int i) const {
+    return loss_function_batches_[i];
+  }
+
+  // Indices of the residual blocks which have a loss function, grouped
+  // by loss function in the order in which the loss functions first
+  // appear in the program.
+  const int* robustified_residual_blocks() const {
+    return robustified_residual_blocks_.empty()
+        ? NULL
+        : &robustified_residual_blocks_[0];
+  }
+
+ private:
+  vector<ResidualBlockEntry> residual_blocks_;
+  vector<Argument> arguments_;
+  vector<LossFunctionBatch> loss_function_batches_;
+  vector<int> robustified_residual_blocks_;
+
+  CERES_DISALLOW_COPY_AND_ASSIGN(EvaluationPlan);
+};
+
+}  // namespace internal
+}  // namespace ceres
+
+#endif  // CERES_INTERNAL_EVALUATION_PLAN_H_
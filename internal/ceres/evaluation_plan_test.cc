@@ -0,0 +1,214 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "ceres/evaluation_plan.h"
+
+#include <vector>
+#include "ceres/loss_function.h"
+#include "ceres/parameter_block.h"
+#include "ceres/problem_impl.h"
+#include "ceres/program.h"
+#include "ceres/residual_block.h"
+#include "ceres/sized_cost_function.h"
+#include "gtest/gtest.h"
+
+namespace ceres {
+namespace internal {
+
+template <int M, int N1 = 0, int N2 = 0, int N3 = 0>
+class DummyCostFunction: public SizedCostFunction<M, N1, N2, N3> {
+  virtual bool Evaluate(double const* const* parameters,
+                        double* residuals,
+                        double** jacobians) const {
+    return true;
+  }
+};
+
+class EvaluationPlanTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    problem_.AddParameterBlock(x_, 2);
+    problem_.AddParameterBlock(y_, 3);
+    problem_.AddParameterBlock(z_, 4);
+
+    problem_.AddResidualBlock(new DummyCostFunction<1, 2, 3>, NULL, x_, y_);
+    problem_.AddResidualBlock(new DummyCostFunction<2, 4, 2>, NULL, z_, x_);
+    problem_.AddResidualBlock(new DummyCostFunction<3, 3>, NULL, y_);
+  }
+
+  ProblemImpl problem_;
+  double x_[2], y_[3], z_[4];
+};
+
+TEST_F(EvaluationPlanTest, Layout) {
+  problem_.SetParameterBlockConstant(y_);
+  Program* program = problem_.mutable_program();
+  program->SetParameterOffsetsAndIndex();
+  EvaluationPlan plan(*program);
+
+  ASSERT_EQ(plan.num_residual_blocks(), 3);
+  EXPECT_EQ(plan.num_arguments(), 5);
+
+  const int expected_num_residuals[] = { 1, 2, 3 };
+  const int expected_residual_offsets[] = { 0, 1, 3 };
+  const int expected_num_arguments[] = { 2, 2, 1 };
+  const int expected_arguments_begin[] = { 0, 2, 4 };
+  for (int i = 0; i < 3; ++i) {
+    const EvaluationPlan::ResidualBlockEntry& entry = plan.residual_block(i);
+    EXPECT_EQ(entry.residual_block, program->residual_blocks()[i]);
+    EXPECT_EQ(entry.num_residuals, expected_num_residuals[i]);
+    EXPECT_EQ(entry.residual_offset, expected_residual_offsets[i]);
+    EXPECT_EQ(entry.num_arguments, expected_num_arguments[i]);
+    EXPECT_EQ(entry.arguments_begin, expected_arguments_begin[i]);
+  }
+
+  // Arguments, in residual block order: x, y, z, x, y. y is constant.
+  const int expected_state_offsets[] = { 0, -1, 5, 0, -1 };
+  const int expected_delta_offsets[] = { 0, -1, 5, 0, -1 };
+  const int expected_indices[] = { 0, -1, 2, 0, -1 };
+  const int expected_local_sizes[] = { 2, 3, 4, 2, 3 };
+  const EvaluationPlan::Argument* arguments = plan.arguments(0);
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(arguments[i].state_offset, expected_state_offsets[i]);
+    EXPECT_EQ(arguments[i].delta_offset, expected_delta_offsets[i]);
+    EXPECT_EQ(arguments[i].parameter_block_index, expected_indices[i]);
+    EXPECT_EQ(arguments[i].local_size, expected_local_sizes[i]);
+  }
+  EXPECT_EQ(plan.arguments(1), arguments + 2);
+  EXPECT_EQ(plan.arguments(2), arguments + 4);
+}
+
+TEST_F(EvaluationPlanTest, GetParameters) {
+  problem_.SetParameterBlockConstant(y_);
+  Program* program = problem_.mutable_program();
+  program->SetParameterOffsetsAndIndex();
+  EvaluationPlan plan(*program);
+
+  double state[9];
+  const double* parameters[2];
+
+  // Variable parameter blocks are read from the state vector, constant
+  // ones from their own state.
+  plan.GetParameters(0, state, parameters);
+  EXPECT_EQ(parameters[0], state);
+  EXPECT_EQ(parameters[1], y_);
+
+  plan.GetParameters(1, state, parameters);
+  EXPECT_EQ(parameters[0], state + 5);
+  EXPECT_EQ(parameters[1], state);
+
+  plan.GetParameters(2, state, parameters);
+  EXPECT_EQ(parameters[0], y_);
+}
+
+// The state vector of a program is the concatenation of its parameter
+// blocks, regardless of their state offsets in a larger program.
+TEST_F(EvaluationPlanTest, SubsetProgram) {
+  Program* program = problem_.mutable_program();
+  program->SetParameterOffsetsAndIndex();
+
+  ParameterBlock* z = program->parameter_blocks()[2];
+  EXPECT_EQ(z->state_offset(), 5);
+  program->parameter_blocks()[0]->SetConstant();
+  program->parameter_blocks()[1]->SetConstant();
+  z->set_index(0);
+  z->set_delta_offset(0);
+
+  Program inner_program;
+  inner_program.mutable_parameter_blocks()->push_back(z);
+  inner_program.mutable_residual_blocks()->push_back(
+      program->residual_blocks()[1]);
+  EvaluationPlan plan(inner_program);
+
+  ASSERT_EQ(plan.num_residual_blocks(), 1);
+  const EvaluationPlan::Argument* arguments = plan.arguments(0);
+  EXPECT_EQ(arguments[0].state_offset, 0);
+  EXPECT_EQ(arguments[0].delta_offset, 0);
+  EXPECT_EQ(arguments[0].parameter_block_index, 0);
+  EXPECT_EQ(arguments[1].state_offset, -1);
+
+  double state[4];
+  const double* parameters[2];
+  plan.GetParameters(0, state, parameters);
+  EXPECT_EQ(parameters[0], state);
+  EXPECT_EQ(parameters[1], x_);
+}
+
+TEST(EvaluationPlan, LossFunctionBatches) {
+  Problem::Options options;
+  options.loss_function_ownership = DO_NOT_TAKE_OWNERSHIP;
+  ProblemImpl problem(options);
+  CauchyLoss cauchy(1.0);
+  HuberLoss huber(1.0);
+
+  // Interleave residual blocks without a loss function, with a
+  // CauchyLoss and with a HuberLoss. There are just enough residual
+  // blocks with each loss function to need two batches.
+  const int kBatchSize = EvaluationPlan::kMaxLossFunctionBatchSize;
+  const int kNumResidualBlocks = 3 * (kBatchSize + 1);
+  double x[1];
+  for (int i = 0; i < kNumResidualBlocks; ++i) {
+    LossFunction* loss_function = NULL;
+    if (i % 3 == 1) {
+      loss_function = &cauchy;
+    } else if (i % 3 == 2) {
+      loss_function = &huber;
+    }
+    problem.AddResidualBlock(new DummyCostFunction<1, 1>, loss_function, x);
+  }
+
+  Program* program = problem.mutable_program();
+  program->SetParameterOffsetsAndIndex();
+  EvaluationPlan plan(*program);
+
+  const LossFunction* expected_loss_functions[] = {
+    &cauchy, &cauchy, &huber, &huber
+  };
+  const int expected_sizes[] = { kBatchSize, 1, kBatchSize, 1 };
+  const int expected_first_residual_blocks[] = {
+    1, 1 + 3 * kBatchSize, 2, 2 + 3 * kBatchSize
+  };
+
+  ASSERT_EQ(plan.num_loss_function_batches(), 4);
+  int expected_begin = 0;
+  for (int b = 0; b < plan.num_loss_function_batches(); ++b) {
+    const EvaluationPlan::LossFunctionBatch& batch =
+        plan.loss_function_batch(b);
+    EXPECT_EQ(batch.loss_function, expected_loss_functions[b]);
+    EXPECT_EQ(batch.begin, expected_begin);
+    ASSERT_EQ(batch.size, expected_sizes[b]);
+    for (int k = 0; k < batch.size; ++k) {
+      EXPECT_EQ(plan.robustified_residual_blocks()[batch.begin + k],
+                expected_first_residual_blocks[b] + 3 * k);
+    }
+    expected_begin += batch.size;
+  }
+}
+
+}  // namespace internal
+}  // namespace ceres
@@ -40,6 +40,7 @@
 #include "ceres/internal/eigen.h"
 #include "ceres/internal/scoped_ptr.h"
 #include "ceres/local_parameterization.h"
+#include "ceres/loss_function.h"
 #include "ceres/problem_impl.h"
 #include "ceres/program.h"
 #include "ceres/sized_cost_function.h"
@@ -634,5 +635,72 @@ TEST(Evaluator, EvaluatorRespectsParameterChanges) {
   }
 }
 
+// Without jacobians, the loss functions are applied in batches after
+// the cost functions are evaluated. Check that this gives the same
+// cost and residuals as applying them one residual block at a time,
+// which is what happens when the jacobian is evaluated.
+TEST(Evaluator, BatchedLossFunctionsMatchPerResidualBlockEvaluation) {
+  Problem::Options problem_options;
+  problem_options.loss_function_ownership = DO_NOT_TAKE_OWNERSHIP;
+  ProblemImpl problem(problem_options);
+  CauchyLoss cauchy(0.5);
+  HuberLoss huber(2.0);
+  ScaledLoss scaled_tolerant(new TolerantLoss(1.0, 0.5), 3.0, TAKE_OWNERSHIP);
+  LossFunction* loss_functions[] = { NULL, &cauchy, &huber, &scaled_tolerant };
+
+  const int kNumResidualBlocks = 1000;
+  vector<double> x(2 * kNumResidualBlocks);
+  for (int i = 0; i < kNumResidualBlocks; ++i) {
+    x[2 * i] = 0.01 * i;
+    x[2 * i + 1] = 1.0 - 0.002 * i;
+    problem.AddResidualBlock(new ParameterSensitiveCostFunction(),
+                             loss_functions[i % 4],
+                             &x[2 * i]);
+  }
+  Program* program = problem.mutable_program();
+  program->SetParameterOffsetsAndIndex();
+
+  for (int num_threads = 1; num_threads <= 4; num_threads += 3) {
+#ifndef CERES_USE_OPENMP
+    if (num_threads > 1) {
+      continue;
+    }
+#endif
+    Evaluator::Options options;
+    options.linear_solver_type = DENSE_QR;
+    options.num_eliminate_blocks = 0;
+    options.num_threads = num_threads;
+    string error;
+    scoped_ptr<Evaluator> evaluator(
+        Evaluator::Create(options, program, &error));
+    scoped_ptr<SparseMatrix> jacobian(evaluator->CreateJacobian());
+
+    const int num_residuals = evaluator->NumResiduals();
+    Vector expected_residuals(num_residuals);
+    double expected_cost = -1;
+    ASSERT_TRUE(evaluator->Evaluate(&x[0],
+                                    &expected_cost,
+                                    expected_residuals.data(),
+                                    NULL,
+                                    jacobian.get()));
+
+    double cost_only = -1;
+    ASSERT_TRUE(evaluator->Evaluate(&x[0], &cost_only, NULL, NULL, NULL));
+    EXPECT_NEAR(cost_only, expected_cost, 1e-12 * expected_cost);
+
+    Vector residuals(num_residuals);
+    double cost = -1;
+    ASSERT_TRUE(evaluator->Evaluate(&x[0],
+                                    &cost,
+                                    residuals.data(),
+                                    NULL,
+                                    NULL));
+    EXPECT_NEAR(cost, expected_cost, 1e-12 * expected_cost);
+    for (int i = 0; i < num_residuals; ++i) {
+      EXPECT_NEAR(residuals[i], expected_residuals[i], 1e-14);
+    }
+  }
+}
+
 }  // namespace internal
 }  // namespace ceres
@@ -32,6 +32,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <map>
 #include <numeric>
 #include <string>
 #include <vector>
@@ -43,6 +44,7 @@
 #include "ceres/problem.h"
 #include "ceres/problem_impl.h"
 #include "ceres/program.h"
+#include "ceres/random.h"
 #include "ceres/residual_block.h"
 #include "ceres/runtime_numeric_diff_cost_function.h"
 #include "ceres/stringprintf.h"
@@ -77,6 +79,104 @@ bool IsClose(double x, double y, double relative_precision,
   return fabs(*relative_error) < fabs(relative_precision);
 }
 
+// Evaluates the jacobians of function using the user supplied code
+// and using finite_diff_function, which numerically differentiates
+// function. Returns false if function fails to evaluate.
+bool EvaluateJacobians(const CostFunction& function,
+                       const CostFunction& finite_diff_function,
+                       double const* const* parameters,
+                       double* residuals,
+                       vector<Matrix>* term_jacobians,
+                       vector<Matrix>* finite_difference_jacobians) {
+  const int num_residuals = function.num_residuals();
+
+  // Make space for the jacobians of the two methods.
+  const vector<int16>& block_sizes = function.parameter_block_sizes();
+  term_jacobians->resize(block_sizes.size());
+  finite_difference_jacobians->resize(block_sizes.size());
+  vector<double*> term_jacobian_pointers(block_sizes.size());
+  vector<double*> finite_difference_jacobian_pointers(block_sizes.size());
+  for (int i = 0; i < block_sizes.size(); i++) {
+    (*term_jacobians)[i].resize(num_residuals, block_sizes[i]);
+    term_jacobian_pointers[i] = (*term_jacobians)[i].data();
+    (*finite_difference_jacobians)[i].resize(num_residuals, block_sizes[i]);
+    finite_difference_jacobian_pointers[i] =
+        (*finite_difference_jacobians)[i].data();
+  }
+
+  // Evaluate the derivative using the user supplied code.
+  if (!function.Evaluate(parameters, residuals, &term_jacobian_pointers[0])) {
+    return false;
+  }
+
+  // Evaluate the derivative using numeric derivatives.
+  finite_diff_function.Evaluate(parameters,
+                                residuals,
+                                &finite_difference_jacobian_pointers[0]);
+  return true;
+}
+
+// Compares the jacobians computed by a cost function with the ones
+// computed by numeric differentiation, and returns the number of
+// entries whose relative error is larger than relative_precision.
+//
+// The largest relative error is stored in worst_relative_error, and a
+// table of all the entries, which is only worth logging when some of
+// them are bad, is appended to m.
+int CompareJacobians(const vector<Matrix>& term_jacobians,
+                     const vector<Matrix>& finite_difference_jacobians,
+                     double const* const* parameters,
+                     const double* residuals,
+                     double relative_precision,
+                     double* worst_relative_error,
+                     string* m) {
+  int num_bad_jacobian_components = 0;
+  for (int k = 0; k < term_jacobians.size(); k++) {
+    StringAppendF(m,
+                  "========== "
+                  "Jacobian for " "block %d: (%ld by %ld)) "
+                  "==========\n",
+                  k,
+                  static_cast<long>(term_jacobians[k].rows()),
+                  static_cast<long>(term_jacobians[k].cols()));
+    // The funny spacing creates appropriately aligned column headers.
+    *m += " block  row  col        user dx/dy    num diff dx/dy         "
+          "abs error    relative error         parameter          residual\n";
+
+    for (int i = 0; i < term_jacobians[k].rows(); i++) {
+      for (int j = 0; j < term_jacobians[k].cols(); j++) {
+        double term_jacobian = term_jacobians[k](i, j);
+        double finite_jacobian = finite_difference_jacobians[k](i, j);
+        double relative_error, absolute_error;
+        bool bad_jacobian_entry =
+            !IsClose(term_jacobian,
+                     finite_jacobian,
+                     relative_precision,
+                     &relative_error,
+                     &absolute_error);
+        *worst_relative_error = std::max(*worst_relative_error,
+                                         relative_error);
+
+        StringAppendF(m, "%6d %4d %4d %17g %17g %17g %17g %17g %17g",
+                      k, i, j,
+                      term_jacobian, finite_jacobian,
+                      absolute_error, relative_error,
+                      parameters[k][j],
+                      residuals[i]);
+
+        if (bad_jacobian_entry) {
+          num_bad_jacobian_components++;
+          StringAppendF(
+              m, " ------ (%d,%d,%d) Relative error worse than %g",
+              k, i, j, relative_precision);
+        }
+        *m += "\n";
+      }
+    }
+  }
+  return num_bad_jacobian_components;
+}
+
 class GradientCheckingCostFunction : public CostFunction {
  public:
   GradientCheckingCostFunction(const CostFunction* function,
@@ -87,7 +187,8 @@ class GradientCheckingCostFunction : public CostFunction {
         finite_diff_cost_function_(
             CreateRuntimeNumericDiffCostFunction(function,
                                                  CENTRAL,
-                                                 relative_step_size)),
+                                                 relative_step_size,
+                                                 1)),
         relative_precision_(relative_precision),
         extra_info_(extra_info) {
     *mutable_parameter_block_sizes() = function->parameter_block_sizes();
@@ -104,94 +205,40 @@ class GradientCheckingCostFunction : public CostFunction {
       return function_->Evaluate(parameters, residuals, NULL);
     }
 
-    int num_residuals = function_->num_residuals();
-
-    // Make space for the jacobians of the two methods.
     const vector<int16>& block_sizes = function_->parameter_block_sizes();
-    vector<Matrix> term_jacobians(block_sizes.size());
-    vector<Matrix> finite_difference_jacobians(block_sizes.size());
-    vector<double*> term_jacobian_pointers(block_sizes.size());
-    vector<double*> finite_difference_jacobian_pointers(block_sizes.size());
-    for (int i = 0; i < block_sizes.size(); i++) {
-      term_jacobians[i].resize(num_residuals, block_sizes[i]);
-      term_jacobian_pointers[i] = term_jacobians[i].data();
-      finite_difference_jacobians[i].resize(num_residuals, block_sizes[i]);
-      finite_difference_jacobian_pointers[i] =
-          finite_difference_jacobians[i].data();
-    }
-
-    // Evaluate the derivative using the user supplied code.
-    if (!function_->Evaluate(parameters,
-                             residuals,
-                             &term_jacobian_pointers[0])) {
+    vector<Matrix> term_jacobians;
+    vector<Matrix> finite_difference_jacobians;
+    if (!EvaluateJacobians(*function_,
+                           *finite_diff_cost_function_,
+                           parameters,
+                           residuals,
+                           &term_jacobians,
+                           &finite_difference_jacobians)) {
       LOG(WARNING) << "Function evaluation failed.";
       return false;
     }
 
-    // Evaluate the derivative using numeric derivatives.
-    finite_diff_cost_function_->Evaluate(
-        parameters,
-        residuals,
-        &finite_difference_jacobian_pointers[0]);
-
-    // See if any elements have relative error larger than the threshold.
-    int num_bad_jacobian_components = 0;
-    double worst_relative_error = 0;
-
-    // Accumulate the error message for all the jacobians, since it won't get
-    // output if there are no bad jacobian components.
-    string m;
+    // Copy the original jacobian blocks into the jacobians array.
     for (int k = 0; k < block_sizes.size(); k++) {
-      // Copy the original jacobian blocks into the jacobians array.
       if (jacobians[k] != NULL) {
         MatrixRef(jacobians[k],
                   term_jacobians[k].rows(),
                   term_jacobians[k].cols()) = term_jacobians[k];
       }
-
-      StringAppendF(&m,
-                    "========== "
-                    "Jacobian for " "block %d: (%ld by %ld)) "
-                    "==========\n",
-                    k,
-                    static_cast<long>(term_jacobians[k].rows()),
-                    static_cast<long>(term_jacobians[k].cols()));
-      // The funny spacing creates appropriately aligned column headers.
-      m += " block  row  col        user dx/dy    num diff dx/dy         "
-           "abs error    relative error         parameter          residual\n";
-
-      for (int i = 0; i < term_jacobians[k].rows(); i++) {
-        for (int j = 0; j < term_jacobians[k].cols(); j++) {
-          double term_jacobian = term_jacobians[k](i, j);
-          double finite_jacobian = finite_difference_jacobians[k](i, j);
-          double relative_error, absolute_error;
-          bool bad_jacobian_entry =
-              !IsClose(term_jacobian,
-                       finite_jacobian,
-                       relative_precision_,
-                       &relative_error,
-                       &absolute_error);
-          worst_relative_error = std::max(worst_relative_error,
-                                          relative_error);
-
-          StringAppendF(&m, "%6d %4d %4d %17g %17g %17g %17g %17g %17g",
-                        k, i, j,
-                        term_jacobian, finite_jacobian,
-                        absolute_error, relative_error,
-                        parameters[k][j],
-                        residuals[i]);
-
-          if (bad_jacobian_entry) {
-            num_bad_jacobian_components++;
-            StringAppendF(
-                &m, " ------ (%d,%d,%d) Relative error worse than %g",
-                k, i, j, relative_precision_);
-          }
-          m += "\n";
-        }
-      }
     }
 
+    // See if any elements have relative error larger than the threshold.
+    double worst_relative_error = 0;
+    string m;
+    const int num_bad_jacobian_components =
+        CompareJacobians(term_jacobians,
+                         finite_difference_jacobians,
+                         parameters,
+                         residuals,
+                         relative_precision_,
+                         &worst_relative_error,
+                         &m);
+
     // Since there were some bad errors, dump comprehensive debug info.
     if (num_bad_jacobian_components) {
       string header = StringPrintf("Detected %d bad jacobian component(s). "
@@ -213,6 +260,76 @@ class GradientCheckingCostFunction : public CostFunction {
   string extra_info_;
 };
 
+// Describes the shape of the residual blocks using cost_function,
+// i.e., their number of residuals and parameter block sizes, e.g.
+// "2 x [9, 3]". Different cost functions can have the same shape.
+string ResidualBlockShape(const CostFunction& cost_function) {
+  string shape = StringPrintf("%d x [", cost_function.num_residuals());
+  const vector<int16>& block_sizes = cost_function.parameter_block_sizes();
+  for (int i = 0; i < block_sizes.size(); ++i) {
+    StringAppendF(&shape, "%s%d", (i > 0) ? ", " : "", block_sizes[i]);
+  }
+  return shape + "]";
+}
+
+// The result of checking the jacobians of a residual block.
+struct GradientCheckResult {
+  GradientCheckResult()
+      : evaluation_failed(false),
+        num_bad_jacobian_components(0),
+        worst_relative_error(0.0) {}
+
+  bool evaluation_failed;
+  int num_bad_jacobian_components;
+  double worst_relative_error;
+  // Table of the jacobian entries, only if some of them are bad.
+  string details;
+};
+
+void CheckResidualBlock(const ResidualBlock& residual_block,
+                        double relative_step_size,
+                        double relative_precision,
+                        GradientCheckResult* result) {
+  const CostFunction* cost_function = residual_block.cost_function();
+  scoped_ptr<CostFunction> finite_diff_cost_function(
+      CreateRuntimeNumericDiffCostFunction(cost_function,
+                                           CENTRAL,
+                                           relative_step_size,
+                                           1));
+
+  const int num_parameter_blocks = residual_block.NumParameterBlocks();
+  vector<const double*> parameters(num_parameter_blocks);
+  for (int i = 0; i < num_parameter_blocks; ++i) {
+    parameters[i] = residual_block.parameter_blocks()[i]->state();
+  }
+  vector<double> residuals(cost_function->num_residuals());
+
+  vector<Matrix> term_jacobians;
+  vector<Matrix> finite_difference_jacobians;
+  if (!EvaluateJacobians(*cost_function,
+                         *finite_diff_cost_function,
+                         &parameters[0],
+                         &residuals[0],
+                         &term_jacobians,
+                         &finite_difference_jacobians)) {
+    result->evaluation_failed = true;
+    return;
+  }
+
+  string m;
+  result->num_bad_jacobian_components =
+      CompareJacobians(term_jacobians,
+                       finite_difference_jacobians,
+                       &parameters[0],
+                       &residuals[0],
+                       relative_precision,
+                       &result->worst_relative_error,
+                       &m);
+  if (result->num_bad_jacobian_components > 0) {
+    result->details.swap(m);
+  }
+}
+
 }  // namespace
 
 CostFunction *CreateGradientCheckingCostFunction(
@@ -303,6 +420,112 @@ ProblemImpl* CreateGradientCheckingProblemImpl(ProblemImpl* problem_impl,
   return gradient_checking_problem_impl;
 }
 
+bool CheckGradientsOfSampledResidualBlocks(const Program& program,
+                                           int num_samples_per_type,
+                                           double relative_step_size,
+                                           double relative_precision,
+                                           int num_threads,
+                                           string* report) {
+  CHECK_GT(num_samples_per_type, 0);
+  CHECK_NOTNULL(report);
+  const vector<ResidualBlock*>& residual_blocks = program.residual_blocks();
+
+  // Group the residual blocks by their shape, in the order in which
+  // the shapes first appear.
+  map<string, int> shape_ids;
+  vector<string> shapes;
+  vector<vector<int> > residual_blocks_by_shape;
+  for (int i = 0; i < residual_blocks.size(); ++i) {
+    const string shape =
+        ResidualBlockShape(*residual_blocks[i]->cost_function());
+    map<string, int>::const_iterator it = shape_ids.find(shape);
+    if (it == shape_ids.end()) {
+      it = shape_ids.insert(make_pair(shape,
+                                      static_cast<int>(shapes.size()))).first;
+      shapes.push_back(shape);
+      residual_blocks_by_shape.push_back(vector<int>());
+    }
+    residual_blocks_by_shape[it->second].push_back(i);
+  }
+
+  // Sample the residual blocks of each shape without replacement,
+  // using a partial Fisher-Yates shuffle.
+  vector<int> samples;
+  vector<int> sample_shapes;
+  for (int t = 0; t < shapes.size(); ++t) {
+    vector<int>& candidates = residual_blocks_by_shape[t];
+    const int num_candidates = candidates.size();
+    const int num_samples = std::min(num_samples_per_type, num_candidates);
+    for (int k = 0; k < num_samples; ++k) {
+      std::swap(candidates[k], candidates[k + Uniform(num_candidates - k)]);
+      samples.push_back(candidates[k]);
+      sample_shapes.push_back(t);
+    }
+  }
+
+  const int num_samples = samples.size();
+  vector<GradientCheckResult> results(num_samples);
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic)
+  for (int i = 0; i < num_samples; ++i) {
+    CheckResidualBlock(*residual_blocks[samples[i]],
+                       relative_step_size,
+                       relative_precision,
+                       &results[i]);
+  }
+
+  // Summarize the results by shape, and log the bad jacobians.
+  vector<int> num_checked(shapes.size(), 0);
+  vector<int> num_bad(shapes.size(), 0);
+  vector<int> num_failed(shapes.size(), 0);
+  vector<double> worst_relative_error(shapes.size(), 0.0);
+  for (int i = 0; i < num_samples; ++i) {
+    const int t = sample_shapes[i];
+    const GradientCheckResult& result = results[i];
+    if (result.evaluation_failed) {
+      ++num_failed[t];
+      LOG(WARNING) << "Residual block " << samples[i]
+                   << " with shape " << shapes[t]
+                   << " failed to evaluate.";
+      continue;
+    }
+
+    ++num_checked[t];
+    worst_relative_error[t] = std::max(worst_relative_error[t],
+                                       result.worst_relative_error);
+    if (result.num_bad_jacobian_components > 0) {
+      ++num_bad[t];
+      LOG(WARNING) << "\n"
+                   << StringPrintf("Detected %d bad jacobian component(s) "
+                                   "in residual block %d with shape %s. "
+                                   "Worst relative error was %g.\n",
+                                   result.num_bad_jacobian_components,
+                                   samples[i],
+                                   shapes[t].c_str(),
+                                   result.worst_relative_error)
+                   << result.details;
+    }
+  }
+
+  bool gradients_are_correct = true;
+  *report = StringPrintf("%-24s %15s %10s %10s %10s %20s\n",
+                         "Residual block shape",
+                         "Residual blocks",
+                         "Checked",
+                         "Bad",
+                         "Failed",
+                         "Worst rel. error");
+  for (int t = 0; t < shapes.size(); ++t) {
+    StringAppendF(report, "%-24s % 15d % 10d % 10d % 10d % 20e\n",
+                  shapes[t].c_str(),
+                  static_cast<int>(residual_blocks_by_shape[t].size()),
+                  num_checked[t],
+                  num_bad[t],
+                  num_failed[t],
+                  worst_relative_error[t]);
+    gradients_are_correct = gradients_are_correct && (num_bad[t] == 0);
+  }
+  return gradients_are_correct;
+}
 
 }  // namespace internal
 }  // namespace ceres
@@ -39,6 +39,7 @@ namespace ceres {
 namespace internal {
 
 class ProblemImpl;
+class Program;
 
 // Creates a CostFunction that checks the jacobians that cost_function computes
 // with finite differences. Bad results are logged; required precision is
@@ -79,6 +80,28 @@ ProblemImpl* CreateGradientCheckingProblemImpl(ProblemImpl* problem_impl,
                                                double relative_step_size,
                                                double relative_precision);
 
+// Checks the jacobians of a random sample of the residual blocks of
+// program once, at the current values of their parameter blocks,
+// instead of every time they are evaluated.
+//
+// The residual blocks are grouped by their shape, i.e. by the number
+// of residuals and parameter block sizes of their cost function, and
+// at most num_samples_per_type residual blocks of each shape are
+// checked. The checks run in parallel using num_threads threads, so
+// the cost functions must be thread safe, as they must be to be
+// evaluated with Solver::Options::num_threads > 1.
+//
+// The jacobians are compared as in CreateGradientCheckingCostFunction,
+// and the details of the bad ones are logged. A table of the results
+// for each shape is stored in report. Returns false if some jacobian
+// entry has a relative error larger than relative_precision.
+bool CheckGradientsOfSampledResidualBlocks(const Program& program,
+                                           int num_samples_per_type,
+                                           double relative_step_size,
+                                           double relative_precision,
+                                           int num_threads,
+                                           string* report);
+
 }  // namespace internal
 }  // namespace ceres
 
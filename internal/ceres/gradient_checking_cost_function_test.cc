@@ -31,6 +31,8 @@
 #include "ceres/gradient_checking_cost_function.h"
 
 #include <cmath>
+#include <cstdio>
+#include <string>
 #include <vector>
 #include "ceres/cost_function.h"
 #include "ceres/internal/scoped_ptr.h"
@@ -413,5 +415,107 @@ TEST(GradientCheckingProblemImpl, ProblemDimensionsMatch) {
   }
 }
 
+// Finds the row of the gradient check report for the residual block
+// shape and parses its counts.
+void ParseGradientCheckReport(const string& report,
+                              const string& shape,
+                              int* num_residual_blocks,
+                              int* num_checked,
+                              int* num_bad,
+                              int* num_failed) {
+  const size_t row = report.find(shape);
+  ASSERT_NE(row, string::npos) << report;
+  ASSERT_EQ(4, sscanf(report.c_str() + row + shape.size(),
+                      "%d %d %d %d",
+                      num_residual_blocks,
+                      num_checked,
+                      num_bad,
+                      num_failed)) << report;
+}
+
+TEST(GradientCheckingProblemImpl, CheckGradientsOfSampledResidualBlocks) {
+  srand(5);
+
+  // Residual blocks of two shapes, with the jacobians of one of them
+  // being wrong.
+  const int kNumGoodResidualBlocks = 20;
+  const int kNumBadResidualBlocks = 5;
+  int const good_dim[] = { 2, 3, 4 };
+  int const bad_dim[] = { 2, 3 };
+
+  vector<double> values(kNumGoodResidualBlocks * 9 + kNumBadResidualBlocks * 5);
+  for (int i = 0; i < values.size(); ++i) {
+    values[i] = 2.0 * RandDouble() - 1.0;
+  }
+
+  ProblemImpl problem_impl;
+  double* cursor = &values[0];
+  for (int i = 0; i < kNumGoodResidualBlocks; ++i) {
+    problem_impl.AddResidualBlock(new TestTerm<-1, -1>(3, good_dim),
+                                  NULL,
+                                  cursor, cursor + 2, cursor + 5);
+    cursor += 9;
+  }
+
+  const double kRelativeStepSize = 1e-6;
+  const double kRelativePrecision = 1e-4;
+  const int kNumThreads = 2;
+  int num_residual_blocks, num_checked, num_bad, num_failed;
+
+  // All the jacobians are correct.
+  string report;
+  EXPECT_TRUE(CheckGradientsOfSampledResidualBlocks(problem_impl.program(),
+                                                    3,
+                                                    kRelativeStepSize,
+                                                    kRelativePrecision,
+                                                    kNumThreads,
+                                                    &report));
+  ParseGradientCheckReport(report, "1 x [2, 3, 4]",
+                           &num_residual_blocks,
+                           &num_checked,
+                           &num_bad,
+                           &num_failed);
+  EXPECT_EQ(num_residual_blocks, kNumGoodResidualBlocks);
+  EXPECT_EQ(num_checked, 3);
+  EXPECT_EQ(num_bad, 0);
+  EXPECT_EQ(num_failed, 0);
+
+  for (int i = 0; i < kNumBadResidualBlocks; ++i) {
+    problem_impl.AddResidualBlock(new TestTerm<1, 2>(2, bad_dim),
+                                  NULL,
+                                  cursor, cursor + 2);
+    cursor += 5;
+  }
+
+  // Every sampled residual block of the second shape is bad. Asking
+  // for more samples than there are residual blocks checks all of
+  // them.
+  EXPECT_FALSE(CheckGradientsOfSampledResidualBlocks(problem_impl.program(),
+                                                     10,
+                                                     kRelativeStepSize,
+                                                     kRelativePrecision,
+                                                     kNumThreads,
+                                                     &report));
+  ParseGradientCheckReport(report, "1 x [2, 3, 4]",
+                           &num_residual_blocks,
+                           &num_checked,
+                           &num_bad,
+                           &num_failed);
+  EXPECT_EQ(num_residual_blocks, kNumGoodResidualBlocks);
+  EXPECT_EQ(num_checked, 10);
+  EXPECT_EQ(num_bad, 0);
+  EXPECT_EQ(num_failed, 0);
+
+  ParseGradientCheckReport(report, "1 x [2, 3]",
+                           &num_residual_blocks,
+                           &num_checked,
+                           &num_bad,
+                           &num_failed);
+  EXPECT_EQ(num_residual_blocks, kNumBadResidualBlocks);
+  EXPECT_EQ(num_checked, kNumBadResidualBlocks);
+  EXPECT_EQ(num_bad, kNumBadResidualBlocks);
+  EXPECT_EQ(num_failed, 0);
+}
+
 }  // namespace internal
 }  // namespace ceres
@@ -0,0 +1,642 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "ceres/graph_algorithms.h"
+
+#include <algorithm>
+#include <set>
+#include <utility>
+#include <vector>
+#include "ceres/compressed_graph.h"
+#include "glog/logging.h"
+
+namespace ceres {
+namespace internal {
+namespace {
+
+// Same as FindConnectedComponent in graph_algorithms.h, with the
+// disjoint-set stored as an array.
+int FindConnectedComponent(int vertex, vector<int>* union_find) {
+  int root = vertex;
+  while ((*union_find)[root] != root) {
+    root = (*union_find)[root];
+  }
+
+  while ((*union_find)[vertex] != root) {
+    const int next = (*union_find)[vertex];
+    (*union_find)[vertex] = root;
+    vertex = next;
+  }
+  return root;
+}
+
+// A set of vertices of the graph which is to be ordered. The
+// vertices v in the set have subset_ids[v] == id, and they are
+// assigned the positions begin, ..., begin + vertices.size() - 1 in
+// the ordering.
+struct VertexSubset {
+  VertexSubset() : id(-1), begin(0) {}
+
+  void Swap(VertexSubset* other) {
+    std::swap(id, other->id);
+    std::swap(begin, other->begin);
+    vertices.swap(other->vertices);
+  }
+
+  int id;
+  int begin;
+  vector<int> vertices;
+};
+
+// Breadth first search of the subgraph induced by subset, starting
+// at root. On input, levels must be -1 for all the vertices of the
+// subset. On return, levels contains the level of each visited
+// vertex, visited contains the visited vertices in the order of
+// their levels, and the vertices in the i^th level are visited[j],
+// level_offsets[i] <= j < level_offsets[i + 1].
+void BreadthFirstSearch(const CompressedGraph& graph,
+                        const vector<int>& subset_ids,
+                        const int id,
+                        const int root,
+                        vector<int>* levels,
+                        vector<int>* visited,
+                        vector<int>* level_offsets) {
+  visited->clear();
+  level_offsets->clear();
+  visited->push_back(root);
+  (*levels)[root] = 0;
+  for (int i = 0; i < visited->size(); ++i) {
+    const int vertex = (*visited)[i];
+    const int level = (*levels)[vertex];
+    if (level == level_offsets->size()) {
+      level_offsets->push_back(i);
+    }
+
+    const int* neighbors = graph.Neighbors(vertex);
+    for (int j = 0; j < graph.Degree(vertex); ++j) {
+      const int neighbor = neighbors[j];
+      if (subset_ids[neighbor] == id && (*levels)[neighbor] == -1) {
+        (*levels)[neighbor] = level + 1;
+        visited->push_back(neighbor);
+      }
+    }
+  }
+  level_offsets->push_back(visited->size());
+}
+
+void ResetLevels(const vector<int>& visited, vector<int>* levels) {
+  for (int i = 0; i < visited.size(); ++i) {
+    (*levels)[visited[i]] = -1;
+  }
+}
+
+// Order the vertices of subset using the minimum degree algorithm on
+// the subgraph induced by subset. Ties are broken in favour of the
+// vertex which occurs first in subset.vertices. scratch must be -1
+// for all the vertices of the subset, and is restored on return.
+//
+// The pivot search is linear and the elimination graph is stored
+// using sets, so on a dense subgraph this is O(n^3 log n). It is only
+// used for subsets of at most kNestedDissectionLeafSize vertices.
+void MinimumDegreeOrdering(const CompressedGraph& graph,
+                           const VertexSubset& subset,
+                           const vector<int>& subset_ids,
+                           vector<int>* scratch,
+                           vector<int>* ordering) {
+  const int num_vertices = subset.vertices.size();
+  for (int i = 0; i < num_vertices; ++i) {
+    (*scratch)[subset.vertices[i]] = i;
+  }
+
+  // The elimination graph.
+  vector<set<int> > adjacency(num_vertices);
+  for (int i = 0; i < num_vertices; ++i) {
+    const int vertex = subset.vertices[i];
+    const int* neighbors = graph.Neighbors(vertex);
+    for (int j = 0; j < graph.Degree(vertex); ++j) {
+      const int neighbor = neighbors[j];
+      if (neighbor != vertex && subset_ids[neighbor] == subset.id) {
+        adjacency[i].insert((*scratch)[neighbor]);
+      }
+    }
+  }
+
+  vector<bool> is_eliminated(num_vertices, false);
+  for (int k = 0; k < num_vertices; ++k) {
+    int pivot = -1;
+    for (int i = 0; i < num_vertices; ++i) {
+      if (!is_eliminated[i] &&
+          (pivot == -1 || adjacency[i].size() < adjacency[pivot].size())) {
+        pivot = i;
+      }
+    }
+
+    // Eliminating the pivot turns its neighbors into a clique.
+    const set<int>& pivot_neighbors = adjacency[pivot];
+    for (set<int>::const_iterator it1 = pivot_neighbors.begin();
+         it1 != pivot_neighbors.end();
+         ++it1) {
+      set<int>& neighbors = adjacency[*it1];
+      neighbors.erase(pivot);
+      for (set<int>::const_iterator it2 = pivot_neighbors.begin();
+           it2 != pivot_neighbors.end();
+           ++it2) {
+        if (*it1 != *it2) {
+          neighbors.insert(*it2);
+        }
+      }
+    }
+
+    adjacency[pivot].clear();
+    is_eliminated[pivot] = true;
+    (*ordering)[subset.begin + k] = subset.vertices[pivot];
+  }
+
+  for (int i = 0; i < num_vertices; ++i) {
+    (*scratch)[subset.vertices[i]] = -1;
+  }
+}
+
+}  // namespace
+
+int IndependentSetOrdering(const CompressedGraph& graph,
+                           int num_threads,
+                           vector<int>* ordering) {
+  return IndependentSetOrdering(graph,
+                                vector<bool>(graph.num_vertices(), true),
+                                num_threads,
+                                ordering);
+}
+
+int IndependentSetOrdering(const CompressedGraph& graph,
+                           const vector<bool>& is_active,
+                           int num_threads,
+                           vector<int>* ordering) {
+  const int num_vertices = graph.num_vertices();
+  CHECK_EQ(is_active.size(), num_vertices);
+  CHECK_NOTNULL(ordering)->clear();
+
+  // Degree of each vertex in the active subgraph, ignoring self
+  // edges.
+  vector<int> degrees(num_vertices, 0);
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic, 1024)
+  for (int i = 0; i < num_vertices; ++i) {
+    if (!is_active[i]) {
+      continue;
+    }
+
+    const int* neighbors = graph.Neighbors(i);
+    for (int j = 0; j < graph.Degree(i); ++j) {
+      if (neighbors[j] != i && is_active[neighbors[j]]) {
+        ++degrees[i];
+      }
+    }
+  }
+
+  int max_degree = 0;
+  int num_active_vertices = 0;
+  for (int i = 0; i < num_vertices; ++i) {
+    if (is_active[i]) {
+      ++num_active_vertices;
+      max_degree = max(max_degree, degrees[i]);
+    }
+  }
+
+  // Sort the active vertices by increasing degree, and by increasing
+  // id for vertices with the same degree. Since the vertices are
+  // visited in increasing order, a counting sort on the degrees
+  // gives this order in linear time.
+  vector<int> degree_offsets(max_degree + 2, 0);
+  for (int i = 0; i < num_vertices; ++i) {
+    if (is_active[i]) {
+      ++degree_offsets[degrees[i] + 1];
+    }
+  }
+  for (int i = 0; i <= max_degree; ++i) {
+    degree_offsets[i + 1] += degree_offsets[i];
+  }
+  vector<int> vertex_queue(num_active_vertices);
+  for (int i = 0; i < num_vertices; ++i) {
+    if (is_active[i]) {
+      vertex_queue[degree_offsets[degrees[i]]++] = i;
+    }
+  }
+
+  // Colors for labeling the graph. White vertices are undecided,
+  // black vertices are in the independent set and grey vertices are
+  // adjacent to a black vertex.
+  const char kWhite = 0;
+  const char kGrey = 1;
+  const char kBlack = 2;
+  vector<char> vertex_color(num_vertices, kWhite);
+
+  // The white vertices, in the order in which they occur in
+  // vertex_queue.
+  vector<int> undecided(vertex_queue);
+
+  if (num_threads > 1) {
+    // Position of each vertex in vertex_queue.
+    vector<int> rank(num_vertices, -1);
+#pragma omp parallel for num_threads(num_threads) schedule(static)
+    for (int i = 0; i < num_active_vertices; ++i) {
+      rank[vertex_queue[i]] = i;
+    }
+
+    vector<char> is_joining(num_vertices, 0);
+    while (!undecided.empty()) {
+      const int num_undecided = undecided.size();
+
+      // A white vertex joins the independent set if all of its
+      // active neighbors which precede it in vertex_queue have been
+      // decided. Since the vertex is white, they must all be grey.
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic, 256)
+      for (int i = 0; i < num_undecided; ++i) {
+        const int vertex = undecided[i];
+        const int* neighbors = graph.Neighbors(vertex);
+        bool is_first = true;
+        for (int j = 0; j < graph.Degree(vertex); ++j) {
+          const int neighbor = neighbors[j];
+          if (neighbor != vertex &&
+              is_active[neighbor] &&
+              rank[neighbor] < rank[vertex] &&
+              vertex_color[neighbor] == kWhite) {
+            is_first = false;
+            break;
+          }
+        }
+        is_joining[vertex] = is_first;
+      }
+
+      // Color the joining vertices black and their neighbors grey.
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic, 256)
+      for (int i = 0; i < num_undecided; ++i) {
+        const int vertex = undecided[i];
+        if (is_joining[vertex]) {
+          vertex_color[vertex] = kBlack;
+          continue;
+        }
+
+        const int* neighbors = graph.Neighbors(vertex);
+        for (int j = 0; j < graph.Degree(vertex); ++j) {
+          if (is_joining[neighbors[j]]) {
+            vertex_color[vertex] = kGrey;
+            break;
+          }
+        }
+      }
+
+      int num_remaining = 0;
+      for (int i = 0; i < num_undecided; ++i) {
+        if (vertex_color[undecided[i]] == kWhite) {
+          undecided[num_remaining++] = undecided[i];
+        }
+      }
+      undecided.resize(num_remaining);
+
+      if (2 * num_remaining > num_undecided) {
+        break;
+      }
+    }
+  }
+
+  // Iterate over the undecided vertices. Pick the first white
+  // vertex, add it to the independent set. Mark it black and its
+  // neighbors grey.
+  for (int i = 0; i < undecided.size(); ++i) {
+    const int vertex = undecided[i];
+    if (vertex_color[vertex] != kWhite) {
+      continue;
+    }
+
+    vertex_color[vertex] = kBlack;
+    const int* neighbors = graph.Neighbors(vertex);
+    for (int j = 0; j < graph.Degree(vertex); ++j) {
+      if (neighbors[j] != vertex) {
+        vertex_color[neighbors[j]] = kGrey;
+      }
+    }
+  }
+
+  // The independent set followed by the grey vertices, both in the
+  // order in which they occur in vertex_queue. At this stage there
+  // should only be black or grey active vertices.
+  ordering->reserve(num_active_vertices);
+  for (int i = 0; i < num_active_vertices; ++i) {
+    const int vertex = vertex_queue[i];
+    if (vertex_color[vertex] == kBlack) {
+      ordering->push_back(vertex);
+    }
+  }
+
+  const int independent_set_size = ordering->size();
+  for (int i = 0; i < num_active_vertices; ++i) {
+    const int vertex = vertex_queue[i];
+    DCHECK_NE(vertex_color[vertex], kWhite);
+    if (vertex_color[vertex] != kBlack) {
+      ordering->push_back(vertex);
+    }
+  }
+
+  CHECK_EQ(ordering->size(), num_active_vertices);
+  return independent_set_size;
+}
+
+CompressedGraph* Degree2MaximumSpanningForest(const CompressedGraph& graph) {
+  const int num_vertices = graph.num_vertices();
+
+  // The edges of the graph, sorted in decreasing order of their
+  // weights. Ties are broken the same way as in the templated
+  // version.
+  vector<pair<double, pair<int, int> > > weighted_edges;
+  weighted_edges.reserve(graph.num_nonzeros() / 2);
+  vector<double> vertex_weights(num_vertices);
+  for (int i = 0; i < num_vertices; ++i) {
+    vertex_weights[i] = graph.VertexWeight(i);
+    const int* neighbors = graph.Neighbors(i);
+    for (int j = 0; j < graph.Degree(i); ++j) {
+      if (i < neighbors[j]) {
+        weighted_edges.push_back(
+            make_pair(graph.NeighborWeight(i, j),
+                      make_pair(i, neighbors[j])));
+      }
+    }
+  }
+  sort(weighted_edges.rbegin(), weighted_edges.rend());
+
+  // Disjoint-set to keep track of the connected components in the
+  // forest, and the degree of each vertex in the forest.
+  vector<int> disjoint_set(num_vertices);
+  for (int i = 0; i < num_vertices; ++i) {
+    disjoint_set[i] = i;
+  }
+  vector<int> degrees(num_vertices, 0);
+
+  vector<pair<int, int> > forest_edges;
+  vector<double> forest_edge_weights;
+
+  // Greedily add edges to the forest as long as they do not violate
+  // the degree/cycle constraint.
+  for (int i = 0; i < weighted_edges.size(); ++i) {
+    const int vertex1 = weighted_edges[i].second.first;
+    const int vertex2 = weighted_edges[i].second.second;
+    if (degrees[vertex1] == 2 || degrees[vertex2] == 2) {
+      continue;
+    }
+
+    int root1 = FindConnectedComponent(vertex1, &disjoint_set);
+    int root2 = FindConnectedComponent(vertex2, &disjoint_set);
+    if (root1 == root2) {
+      continue;
+    }
+
+    forest_edges.push_back(make_pair(vertex1, vertex2));
+    forest_edge_weights.push_back(weighted_edges[i].first);
+    ++degrees[vertex1];
+    ++degrees[vertex2];
+
+    // Connect the connected component with the greater index to the
+    // one with the smaller index.
+    if (root2 < root1) {
+      std::swap(root1, root2);
+    }
+    disjoint_set[root2] = root1;
+  }
+
+  return new CompressedGraph(vertex_weights,
+                             forest_edges,
+                             forest_edge_weights,
+                             1);
+}
+
+void NestedDissectionOrdering(const CompressedGraph& graph,
+                              vector<int>* ordering) {
+  const int num_vertices = graph.num_vertices();
+  CHECK_NOTNULL(ordering)->resize(num_vertices);
+
+  // The id of the subset containing each vertex which has not been
+  // ordered yet. Ordered vertices have id -1.
+  vector<int> subset_ids(num_vertices, 0);
+  vector<int> levels(num_vertices, -1);
+  vector<int> visited;
+  vector<int> level_offsets;
+  int num_subsets = 1;
+
+  vector<VertexSubset> subsets(1);
+  subsets[0].id = 0;
+  subsets[0].begin = 0;
+  subsets[0].vertices.resize(num_vertices);
+  for (int i = 0; i < num_vertices; ++i) {
+    subsets[0].vertices[i] = i;
+  }
+
+  while (!subsets.empty()) {
+    VertexSubset subset;
+    subset.Swap(&subsets.back());
+    subsets.pop_back();
+    const int subset_size = subset.vertices.size();
+
+    if (subset_size <= kNestedDissectionLeafSize) {
+      MinimumDegreeOrdering(graph, subset, subset_ids, &levels, ordering);
+      for (int i = 0; i < subset_size; ++i) {
+        subset_ids[subset.vertices[i]] = -1;
+      }
+      continue;
+    }
+
+    // Start the search for a pseudo-peripheral vertex at the vertex
+    // with the smallest degree.
+    int root = subset.vertices[0];
+    for (int i = 1; i < subset_size; ++i) {
+      if (graph.Degree(subset.vertices[i]) < graph.Degree(root)) {
+        root = subset.vertices[i];
+      }
+    }
+    BreadthFirstSearch(graph, subset_ids, subset.id, root,
+                       &levels, &visited, &level_offsets);
+
+    // If the subset is not connected, its connected components can be
+    // ordered independently. Since there are no edges between them,
+    // relabeling a component does not affect the search for the
+    // others.
+    if (visited.size() < subset_size) {
+      ResetLevels(visited, &levels);
+      int begin = subset.begin;
+      for (int i = 0; i < subset_size; ++i) {
+        const int vertex = subset.vertices[i];
+        if (subset_ids[vertex] != subset.id) {
+          continue;
+        }
+
+        BreadthFirstSearch(graph, subset_ids, subset.id, vertex,
+                           &levels, &visited, &level_offsets);
+        ResetLevels(visited, &levels);
+        subsets.push_back(VertexSubset());
+        VertexSubset& component = subsets.back();
+        component.id = num_subsets++;
+        component.begin = begin;
+        component.vertices = visited;
+        for (int j = 0; j < visited.size(); ++j) {
+          subset_ids[visited[j]] = component.id;
+        }
+        begin += visited.size();
+      }
+      continue;
+    }
+
+    // Find a pseudo-peripheral vertex, by repeatedly restarting the
+    // search from a vertex of smallest degree in the last level, for
+    // as long as the number of levels increases.
+    for (int i = 0; i < 8; ++i) {
+      const int num_levels = level_offsets.size() - 1;
+      int candidate = visited[level_offsets[num_levels - 1]];
+      for (int j = level_offsets[num_levels - 1] + 1;
+           j < level_offsets[num_levels];
+           ++j) {
+        if (graph.Degree(visited[j]) < graph.Degree(candidate)) {
+          candidate = visited[j];
+        }
+      }
+
+      ResetLevels(visited, &levels);
+      BreadthFirstSearch(graph, subset_ids, subset.id, candidate,
+                         &levels, &visited, &level_offsets);
+      if (level_offsets.size() - 1 <= num_levels) {
+        if (level_offsets.size() - 1 < num_levels) {
+          ResetLevels(visited, &levels);
+          BreadthFirstSearch(graph, subset_ids, subset.id, root,
+                             &levels, &visited, &level_offsets);
+        }
+        break;
+      }
+      root = candidate;
+    }
+
+    // A level structure with fewer than three levels has no level
+    // which separates the subset, e.g., a large, almost fully
+    // co-visible cluster of cameras. The subset is too large for
+    // MinimumDegreeOrdering, and any elimination order of a near
+    // clique gives essentially the same fill, so its vertices are
+    // kept in their current order.
+    const int num_levels = level_offsets.size() - 1;
+    if (num_levels < 3) {
+      ResetLevels(visited, &levels);
+      for (int i = 0; i < subset_size; ++i) {
+        (*ordering)[subset.begin + i] = subset.vertices[i];
+        subset_ids[subset.vertices[i]] = -1;
+      }
+      continue;
+    }
+
+    // The smallest level which leaves at least a quarter of the
+    // vertices on either side. If there is no such level, the most
+    // balanced one.
+    int separator_level = -1;
+    int fallback_level = -1;
+    for (int l = 1; l < num_levels - 1; ++l) {
+      const int num_below = level_offsets[l];
+      const int num_above = subset_size - level_offsets[l + 1];
+      const int separator_size = level_offsets[l + 1] - level_offsets[l];
+      if (4 * min(num_below, num_above) >= subset_size) {
+        if (separator_level == -1 ||
+            separator_size < (level_offsets[separator_level + 1] -
+                              level_offsets[separator_level])) {
+          separator_level = l;
+        }
+      }
+
+      if (fallback_level == -1 ||
+          max(num_below, num_above) <
+          max(level_offsets[fallback_level],
+              subset_size - level_offsets[fallback_level + 1])) {
+        fallback_level = l;
+      }
+    }
+    if (separator_level == -1) {
+      separator_level = fallback_level;
+    }
+
+    // Split the subset into the vertices below the separator level,
+    // the separator and the vertices above it. Vertices of the
+    // separator level with no neighbors above it do not need to be in
+    // the separator.
+    VertexSubset below;
+    below.id = num_subsets++;
+    below.begin = subset.begin;
+    VertexSubset above;
+    above.id = num_subsets++;
+    vector<int> separator;
+    for (int i = 0; i < subset_size; ++i) {
+      const int vertex = visited[i];
+      const int level = levels[vertex];
+      if (level < separator_level) {
+        below.vertices.push_back(vertex);
+      } else if (level > separator_level) {
+        above.vertices.push_back(vertex);
+      } else {
+        bool is_separator = false;
+        const int* neighbors = graph.Neighbors(vertex);
+        for (int j = 0; j < graph.Degree(vertex); ++j) {
+          const int neighbor = neighbors[j];
+          if (subset_ids[neighbor] == subset.id &&
+              levels[neighbor] == separator_level + 1) {
+            is_separator = true;
+            break;
+          }
+        }
+
+        if (is_separator) {
+          separator.push_back(vertex);
+        } else {
+          below.vertices.push_back(vertex);
+        }
+      }
+    }
+    ResetLevels(visited, &levels);
+
+    above.begin = below.begin + below.vertices.size();
+    const int separator_begin = above.begin + above.vertices.size();
+    for (int i = 0; i < separator.size(); ++i) {
+      subset_ids[separator[i]] = -1;
+      (*ordering)[separator_begin + i] = separator[i];
+    }
+    for (int i = 0; i < below.vertices.size(); ++i) {
+      subset_ids[below.vertices[i]] = below.id;
+    }
+    for (int i = 0; i < above.vertices.size(); ++i) {
+      subset_ids[above.vertices[i]] = above.id;
+    }
+
+    subsets.push_back(VertexSubset());
+    subsets.back().Swap(&above);
+    subsets.push_back(VertexSubset());
+    subsets.back().Swap(&below);
+  }
+}
+
+}  // namespace internal
+}  // namespace ceres
@@ -37,6 +37,7 @@
 #include <vector>
 #include <utility>
 #include "ceres/collections_port.h"
+#include "ceres/compressed_graph.h"
 #include "ceres/graph.h"
 #include "glog/logging.h"
 
@@ -266,6 +267,60 @@ Degree2MaximumSpanningForest(const Graph<Vertex>& graph) {
   return forest;
 }
 
+// Versions of IndependentSetOrdering and
+// Degree2MaximumSpanningForest for CompressedGraph. On graphs without
+// self edges, they return the same results as the templated versions
+// on the equivalent Graph<int>, using arrays indexed by vertex
+// instead of hash tables.
+//
+// The greedy algorithm above computes the lexicographically first
+// maximal independent set with respect to the (degree, id) order of
+// the vertices. This is the unique independent set in which a vertex
+// is a member if and only if none of its neighbors which precede it
+// in that order are members. With num_threads > 1, it is computed in
+// rounds; in each round, all the vertices whose preceding neighbors
+// have been decided are decided in parallel. The result does not
+// depend on num_threads. If a round decides less than half of the
+// remaining vertices, i.e., the graph has long chains of dependent
+// decisions, the rest are decided serially.
+int IndependentSetOrdering(const CompressedGraph& graph,
+                           int num_threads,
+                           vector<int>* ordering);
+
+// Same as above, but restricted to the subgraph induced by the
+// vertices for which is_active is true. The ordering only contains
+// the active vertices. This is equivalent to removing the inactive
+// vertices from the graph, without having to rebuild it.
+int IndependentSetOrdering(const CompressedGraph& graph,
+                           const vector<bool>& is_active,
+                           int num_threads,
+                           vector<int>* ordering);
+
+// Caller owns the result.
+CompressedGraph* Degree2MaximumSpanningForest(const CompressedGraph& graph);
+
+// Compute a fill reducing elimination ordering of the vertices of
+// graph using nested dissection, i.e., ordering[i] is the i^th vertex
+// to be eliminated. Self edges are ignored.
+//
+// The graph is recursively split into two parts by a vertex
+// separator, and the separator is ordered after both the parts. The
+// separators are found using breadth first search level structures
+// rooted at pseudo-peripheral vertices (George & Liu); among the
+// levels which leave at least a quarter of the vertices on either
+// side, the smallest one is the separator. Parts with at most
+// kNestedDissectionLeafSize vertices are ordered using the minimum
+// degree algorithm. Larger parts which cannot be separated, i.e.,
+// near cliques, are kept in their current order.
+//
+// For nearly planar graphs, e.g., the camera graphs of large
+// outdoor reconstructions, nested dissection orderings result in
+// much less fill in the Cholesky factorization than minimum degree
+// orderings.
+static const int kNestedDissectionLeafSize = 64;
+void NestedDissectionOrdering(const CompressedGraph& graph,
+                              vector<int>* ordering);
+
 }  // namespace internal
 }  // namespace ceres
 
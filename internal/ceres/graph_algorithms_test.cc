@@ -31,8 +31,11 @@
 #include "ceres/graph_algorithms.h"
 
 #include <algorithm>
+#include <set>
+#include <vector>
 #include "gtest/gtest.h"
 #include "ceres/collections_port.h"
+#include "ceres/compressed_graph.h"
 #include "ceres/graph.h"
 #include "ceres/internal/port.h"
 #include "ceres/internal/scoped_ptr.h"
@@ -165,6 +168,260 @@ TEST(Degree2MaximumSpanningForest, StarGraph) {
   }
 }
 
+// Builds the same graph as a Graph<int> and as a CompressedGraph. The
+// edges and weights are chosen so that there are plenty of vertices
+// with the same degree and edges with the same weight.
+void BuildTestGraphs(Graph<int>* graph,
+                     scoped_ptr<CompressedGraph>* compressed_graph) {
+  const int kNumVertices = 40;
+  vector<pair<int, int> > edges;
+  vector<double> edge_weights;
+  for (int i = 0; i < kNumVertices; ++i) {
+    graph->AddVertex(i, i % 3);
+  }
+
+  for (int i = 0; i < kNumVertices; ++i) {
+    for (int j = i + 1; j < kNumVertices; ++j) {
+      if ((i * 7 + j * 13) % 11 == 0) {
+        const double weight = (i + j) % 5;
+        graph->AddEdge(i, j, weight);
+        edges.push_back(make_pair(i, j));
+        edge_weights.push_back(weight);
+      }
+    }
+  }
+
+  vector<double> vertex_weights(kNumVertices);
+  for (int i = 0; i < kNumVertices; ++i) {
+    vertex_weights[i] = i % 3;
+  }
+  compressed_graph->reset(
+      new CompressedGraph(vertex_weights, edges, edge_weights, 1));
+}
+
+TEST(IndependentSetOrdering, CompressedGraphMatchesGraph) {
+  Graph<int> graph;
+  scoped_ptr<CompressedGraph> compressed_graph;
+  BuildTestGraphs(&graph, &compressed_graph);
+
+  vector<int> expected_ordering;
+  const int expected_independent_set_size =
+      IndependentSetOrdering(graph, &expected_ordering);
+  for (int num_threads = 1; num_threads <= 4; num_threads += 3) {
+    vector<int> ordering;
+    const int independent_set_size =
+        IndependentSetOrdering(*compressed_graph, num_threads, &ordering);
+
+    EXPECT_EQ(independent_set_size, expected_independent_set_size);
+    EXPECT_EQ(ordering, expected_ordering);
+  }
+}
+
+TEST(IndependentSetOrdering, CompressedGraphWithInactiveVertices) {
+  Graph<int> graph;
+  scoped_ptr<CompressedGraph> compressed_graph;
+  BuildTestGraphs(&graph, &compressed_graph);
+
+  // Removing vertices from the Graph is equivalent to marking them
+  // inactive in the CompressedGraph.
+  vector<bool> is_active(compressed_graph->num_vertices(), true);
+  for (int i = 0; i < compressed_graph->num_vertices(); i += 4) {
+    graph.RemoveVertex(i);
+    is_active[i] = false;
+  }
+
+  vector<int> expected_ordering;
+  const int expected_independent_set_size =
+      IndependentSetOrdering(graph, &expected_ordering);
+  for (int num_threads = 1; num_threads <= 4; num_threads += 3) {
+    vector<int> ordering;
+    const int independent_set_size = IndependentSetOrdering(*compressed_graph,
+                                                            is_active,
+                                                            num_threads,
+                                                            &ordering);
+
+    EXPECT_EQ(independent_set_size, expected_independent_set_size);
+    EXPECT_EQ(ordering, expected_ordering);
+  }
+}
+
+// On a chain, every decision depends on the previous one, so the
+// parallel rounds make little progress and the rest of the ordering
+// is computed serially.
+TEST(IndependentSetOrdering, CompressedGraphChain) {
+  const int kNumVertices = 101;
+  Graph<int> graph;
+  vector<pair<int, int> > edges;
+  for (int i = 0; i < kNumVertices; ++i) {
+    graph.AddVertex(i);
+  }
+  for (int i = 0; i + 1 < kNumVertices; ++i) {
+    graph.AddEdge(i, i + 1);
+    edges.push_back(make_pair(i, i + 1));
+  }
+  CompressedGraph compressed_graph(kNumVertices, edges, 1);
+
+  vector<int> expected_ordering;
+  const int expected_independent_set_size =
+      IndependentSetOrdering(graph, &expected_ordering);
+
+  vector<int> ordering;
+  const int independent_set_size =
+      IndependentSetOrdering(compressed_graph, 4, &ordering);
+  EXPECT_EQ(independent_set_size, expected_independent_set_size);
+  EXPECT_EQ(ordering, expected_ordering);
+}
+
+TEST(Degree2MaximumSpanningForest, CompressedGraphMatchesGraph) {
+  Graph<int> graph;
+  scoped_ptr<CompressedGraph> compressed_graph;
+  BuildTestGraphs(&graph, &compressed_graph);
+
+  scoped_ptr<Graph<int> > expected_forest(
+      Degree2MaximumSpanningForest(graph));
+  scoped_ptr<CompressedGraph> forest(
+      Degree2MaximumSpanningForest(*compressed_graph));
+
+  ASSERT_EQ(forest->num_vertices(), expected_forest->vertices().size());
+  for (int i = 0; i < forest->num_vertices(); ++i) {
+    EXPECT_EQ(forest->VertexWeight(i), expected_forest->VertexWeight(i));
+    const HashSet<int>& expected_neighbors = expected_forest->Neighbors(i);
+    ASSERT_EQ(forest->Degree(i), expected_neighbors.size());
+    for (int j = 0; j < forest->Degree(i); ++j) {
+      const int neighbor = forest->Neighbors(i)[j];
+      EXPECT_TRUE(expected_neighbors.count(neighbor) > 0);
+      EXPECT_EQ(forest->NeighborWeight(i, j),
+                expected_forest->EdgeWeight(i, neighbor));
+    }
+  }
+}
+
+// Number of non-zeros in the Cholesky factor of a matrix with the
+// sparsity structure of graph, when it is eliminated in the given
+// ordering.
+int CholeskyFactorSize(const CompressedGraph& graph,
+                       const vector<int>& ordering) {
+  const int num_vertices = graph.num_vertices();
+  vector<int> position(num_vertices);
+  for (int i = 0; i < num_vertices; ++i) {
+    position[ordering[i]] = i;
+  }
+
+  vector<set<int> > adjacency(num_vertices);
+  for (int i = 0; i < num_vertices; ++i) {
+    for (int j = 0; j < graph.Degree(i); ++j) {
+      const int neighbor = graph.Neighbors(i)[j];
+      if (neighbor != i) {
+        adjacency[position[i]].insert(position[neighbor]);
+      }
+    }
+  }
+
+  int factor_size = num_vertices;
+  for (int i = 0; i < num_vertices; ++i) {
+    const vector<int> later(adjacency[i].upper_bound(i), adjacency[i].end());
+    factor_size += later.size();
+    for (int j = 0; j < later.size(); ++j) {
+      adjacency[later[j]].insert(later.begin(), later.end());
+    }
+  }
+  return factor_size;
+}
+
+void ExpectIsPermutation(const vector<int>& ordering, int num_vertices) {
+  ASSERT_EQ(ordering.size(), num_vertices);
+  vector<int> sorted_ordering(ordering);
+  sort(sorted_ordering.begin(), sorted_ordering.end());
+  for (int i = 0; i < num_vertices; ++i) {
+    EXPECT_EQ(sorted_ordering[i], i);
+  }
+}
+
+TEST(NestedDissectionOrdering, GridGraph) {
+  // A kSize x kSize grid, which is planar and has O(n log n) fill
+  // with nested dissection and O(n^1.5) fill in the natural ordering.
+  const int kSize = 40;
+  vector<pair<int, int> > edges;
+  for (int i = 0; i < kSize; ++i) {
+    for (int j = 0; j < kSize; ++j) {
+      if (i + 1 < kSize) {
+        edges.push_back(make_pair(i * kSize + j, (i + 1) * kSize + j));
+      }
+      if (j + 1 < kSize) {
+        edges.push_back(make_pair(i * kSize + j, i * kSize + j + 1));
+      }
+    }
+  }
+  CompressedGraph graph(kSize * kSize, edges, 1);
+
+  vector<int> ordering;
+  NestedDissectionOrdering(graph, &ordering);
+  ExpectIsPermutation(ordering, kSize * kSize);
+
+  vector<int> natural_ordering(kSize * kSize);
+  for (int i = 0; i < natural_ordering.size(); ++i) {
+    natural_ordering[i] = i;
+  }
+  EXPECT_LT(CholeskyFactorSize(graph, ordering),
+            CholeskyFactorSize(graph, natural_ordering) / 2);
+}
+
+TEST(NestedDissectionOrdering, DisconnectedGraph) {
+  // Two interleaved chains, a clique and isolated vertices.
+  const int kNumVertices = 300;
+  vector<pair<int, int> > edges;
+  for (int i = 0; i + 1 < 50; ++i) {
+    edges.push_back(make_pair(2 * i, 2 * i + 2));
+    edges.push_back(make_pair(2 * i + 1, 2 * i + 3));
+  }
+  for (int i = 100; i < 120; ++i) {
+    for (int j = i; j < 120; ++j) {
+      edges.push_back(make_pair(i, j));
+    }
+  }
+  CompressedGraph graph(kNumVertices, edges, 1);
+
+  vector<int> ordering;
+  NestedDissectionOrdering(graph, &ordering);
+  ExpectIsPermutation(ordering, kNumVertices);
+
+  // Chains and cliques have no fill in a good ordering.
+  int num_edges = 0;
+  for (int i = 0; i < kNumVertices; ++i) {
+    for (int j = 0; j < graph.Degree(i); ++j) {
+      num_edges += (graph.Neighbors(i)[j] > i) ? 1 : 0;
+    }
+  }
+  EXPECT_EQ(CholeskyFactorSize(graph, ordering), kNumVertices + num_edges);
+}
+
+TEST(NestedDissectionOrdering, LargeClique) {
+  // A clique larger than the leaf size has a level structure with two
+  // levels, and cannot be separated. Its vertices are kept in their
+  // order, which has no fill.
+  const int kNumVertices = 8 * kNestedDissectionLeafSize;
+  vector<pair<int, int> > edges;
+  for (int i = 0; i < kNumVertices; ++i) {
+    for (int j = i + 1; j < kNumVertices; ++j) {
+      edges.push_back(make_pair(i, j));
+    }
+  }
+  CompressedGraph graph(kNumVertices, edges, 1);
+
+  vector<int> ordering;
+  NestedDissectionOrdering(graph, &ordering);
+  for (int i = 0; i < kNumVertices; ++i) {
+    EXPECT_EQ(ordering[i], i);
+  }
+}
+
+TEST(NestedDissectionOrdering, EmptyGraph) {
+  CompressedGraph graph(0, vector<pair<int, int> >(), 1);
+  vector<int> ordering;
+  NestedDissectionOrdering(graph, &ordering);
+  EXPECT_EQ(ordering.size(), 0);
+}
+
 TEST(VertexDegreeLessThan, TotalOrdering) {
   Graph<int> graph;
   graph.AddVertex(0);
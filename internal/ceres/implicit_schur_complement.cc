@@ -46,6 +46,7 @@ ImplicitSchurComplement::ImplicitSchurComplement(int num_eliminate_blocks,
     : num_eliminate_blocks_(num_eliminate_blocks),
       preconditioner_(preconditioner),
       A_(NULL),
+      single_precision_A_(NULL),
       D_(NULL),
       b_(NULL),
       block_diagonal_EtE_inverse_(NULL),
@@ -59,10 +60,14 @@ void ImplicitSchurComplement::Init(const BlockSparseMatrixBase& A,
                                    const double* D,
                                    const double* b) {
   // Since initialization is reasonably heavy, perhaps we can save on
-  // constructing a new object everytime.
-  if (A_ == NULL) {
+  // constructing a new object everytime. The view refers to A, so it
+  // is rebuilt if a different matrix with the same structure is
+  // passed in, e.g., when the trust region minimizer swaps in a
+  // speculatively evaluated Jacobian.
+  if (A_ == NULL || &A_->matrix() != &A) {
     A_.reset(new PartitionedMatrixView(A, num_eliminate_blocks_));
   }
+  A_->set_single_precision_matrix(single_precision_A_);
 
   D_ = D;
   b_ = b;
@@ -112,6 +112,15 @@ class ImplicitSchurComplement : public LinearOperator {
   // with the SchurComplement solver.
   void Init(const BlockSparseMatrixBase& A, const double* D, const double* b);
 
+  // Use single_precision_A, a single precision copy of the values of
+  // the matrix A passed to Init, for the products with E and F. See
+  // PartitionedMatrixView::set_single_precision_matrix. Takes effect
+  // at the next call to Init. Does not take ownership.
+  void set_single_precision_matrix(
+      const SinglePrecisionBlockSparseMatrix* single_precision_A) {
+    single_precision_A_ = single_precision_A;
+  }
+
   // y += Sx, where S is the Schur complement.
   virtual void RightMultiply(const double* x, double* y) const;
 
@@ -147,6 +156,7 @@ class ImplicitSchurComplement : public LinearOperator {
   bool preconditioner_;
 
   scoped_ptr<PartitionedMatrixView> A_;
+  const SinglePrecisionBlockSparseMatrix* single_precision_A_;
   const double* D_;
   const double* b_;
 
@@ -44,6 +44,8 @@
 #include "ceres/linear_solver.h"
 #include "ceres/preconditioner.h"
 #include "ceres/schur_jacobi_preconditioner.h"
+#include "ceres/schwarz_preconditioner.h"
+#include "ceres/single_precision_block_sparse_matrix.h"
 #include "ceres/triplet_sparse_matrix.h"
 #include "ceres/types.h"
 #include "ceres/visibility_based_preconditioner.h"
@@ -76,6 +78,14 @@ LinearSolver::Summary IterativeSchurComplementSolver::SolveImpl(
         new ImplicitSchurComplement(options_.elimination_groups[0],
                                     options_.preconditioner_type == JACOBI));
   }
+  if (options_.use_single_precision_jacobian) {
+    if (single_precision_A_ == NULL) {
+      single_precision_A_.reset(new SinglePrecisionBlockSparseMatrix(*A));
+      schur_complement_->set_single_precision_matrix(
+          single_precision_A_.get());
+    }
+    single_precision_A_->UpdateValues(*A, options_.num_threads);
+  }
   schur_complement_->Init(*A, per_solve_options.D, b);
 
   // Initialize the solution to the Schur complement system to zero.
@@ -105,6 +115,8 @@ LinearSolver::Summary IterativeSchurComplementSolver::SolveImpl(
   preconditioner_options.e_block_size = options_.e_block_size;
   preconditioner_options.f_block_size = options_.f_block_size;
   preconditioner_options.elimination_groups = options_.elimination_groups;
+  preconditioner_options.schur_structure_cache =
+      options_.schur_structure_cache;
 
   switch (options_.preconditioner_type) {
     case IDENTITY:
@@ -121,6 +133,13 @@ LinearSolver::Summary IterativeSchurComplementSolver::SolveImpl(
                 *A->block_structure(), preconditioner_options));
       }
       break;
+    case ADDITIVE_SCHWARZ:
+      if (preconditioner_.get() == NULL) {
+        preconditioner_.reset(
+            new SchwarzPreconditioner(
+                *A->block_structure(), preconditioner_options));
+      }
+      break;
     case CLUSTER_JACOBI:
     case CLUSTER_TRIDIAGONAL:
       if (preconditioner_.get() == NULL) {
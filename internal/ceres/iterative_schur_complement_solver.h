@@ -42,6 +42,7 @@ namespace internal {
 class BlockSparseMatrixBase;
 class ImplicitSchurComplement;
 class Preconditioner;
+class SinglePrecisionBlockSparseMatrix;
 
 // This class implements an iterative solver for the linear least
 // squares problems that have a bi-partite sparsity structure common
@@ -81,6 +82,7 @@ class IterativeSchurComplementSolver : public BlockSparseMatrixBaseSolver {
 
   LinearSolver::Options options_;
   scoped_ptr<internal::ImplicitSchurComplement> schur_complement_;
+  scoped_ptr<SinglePrecisionBlockSparseMatrix> single_precision_A_;
   scoped_ptr<Preconditioner> preconditioner_;
   Vector reduced_linear_system_solution_;
   CERES_DISALLOW_COPY_AND_ASSIGN(IterativeSchurComplementSolver);
@@ -70,9 +70,11 @@ class IterativeSchurComplementSolverTest : public ::testing::Test {
     num_cols_ = A_->num_cols();
     num_rows_ = A_->num_rows();
     num_eliminate_blocks_ = problem->num_eliminate_blocks;
+    use_single_precision_jacobian_ = false;
   }
 
-  AssertionResult TestSolver(double* D) {
+  AssertionResult TestSolver(double* D,
+                             PreconditionerType preconditioner_type) {
     TripletSparseMatrix triplet_A(A_->num_rows(),
                                   A_->num_cols(),
                                   A_->num_nonzeros());
@@ -90,7 +92,11 @@ class IterativeSchurComplementSolverTest : public ::testing::Test {
     qr->Solve(&dense_A, b_.get(), per_solve_options, reference_solution.data());
 
     options.elimination_groups.push_back(num_eliminate_blocks_);
+    options.elimination_groups.push_back(
+        A_->block_structure()->cols.size() - num_eliminate_blocks_);
     options.max_num_iterations = num_cols_;
+    options.preconditioner_type = preconditioner_type;
+    options.use_single_precision_jacobian = use_single_precision_jacobian_;
     IterativeSchurComplementSolver isc(options);
 
     Vector isc_sol(num_cols_);
@@ -109,14 +115,29 @@ class IterativeSchurComplementSolverTest : public ::testing::Test {
   int num_rows_;
   int num_cols_;
   int num_eliminate_blocks_;
+  bool use_single_precision_jacobian_;
   scoped_ptr<BlockSparseMatrix> A_;
   scoped_array<double> b_;
   scoped_array<double> D_;
 };
 
 TEST_F(IterativeSchurComplementSolverTest, SolverTest) {
-  EXPECT_TRUE(TestSolver(NULL));
-  EXPECT_TRUE(TestSolver(D_.get()));
+  EXPECT_TRUE(TestSolver(NULL, JACOBI));
+  EXPECT_TRUE(TestSolver(D_.get(), JACOBI));
+}
+
+TEST_F(IterativeSchurComplementSolverTest, AdditiveSchwarzPreconditioner) {
+  EXPECT_TRUE(TestSolver(NULL, ADDITIVE_SCHWARZ));
+  EXPECT_TRUE(TestSolver(D_.get(), ADDITIVE_SCHWARZ));
+}
+
+// The entries of the test matrix are exactly representable in single
+// precision, so the solution should not change.
+TEST_F(IterativeSchurComplementSolverTest, SinglePrecisionJacobian) {
+  use_single_precision_jacobian_ = true;
+  EXPECT_TRUE(TestSolver(NULL, JACOBI));
+  EXPECT_TRUE(TestSolver(D_.get(), JACOBI));
+  EXPECT_TRUE(TestSolver(D_.get(), SCHUR_JACOBI));
 }
 
 }  // namespace internal
@@ -34,6 +34,7 @@
 #include "Eigen/Core"
 #include "ceres/array_utils.h"
 #include "ceres/internal/eigen.h"
+#include "ceres/linear_least_squares_problems.h"
 #include "ceres/linear_solver.h"
 #include "ceres/sparse_matrix.h"
 #include "ceres/trust_region_strategy.h"
@@ -51,7 +52,8 @@ LevenbergMarquardtStrategy::LevenbergMarquardtStrategy(
       min_diagonal_(options.lm_min_diagonal),
       max_diagonal_(options.lm_max_diagonal),
       decrease_factor_(2.0),
-      reuse_diagonal_(false) {
+      reuse_diagonal_(false),
+      num_eliminate_blocks_(options.num_eliminate_blocks) {
   CHECK_NOTNULL(linear_solver_);
   CHECK_GT(min_diagonal_, 0.0);
   CHECK_LE(min_diagonal_, max_diagonal_);
@@ -86,6 +88,9 @@ TrustRegionStrategy::Summary LevenbergMarquardtStrategy::ComputeStep(
 
   LinearSolver::PerSolveOptions solve_options;
   solve_options.D = lm_diagonal_.data();
+  // The Jacobian and the residuals only change when a step is
+  // accepted, which is also when the diagonal is recomputed.
+  solve_options.A_and_b_are_unchanged = reuse_diagonal_;
   solve_options.q_tolerance = per_solve_options.eta;
   // Disable r_tolerance checking. Since we only care about
   // termination via the q_tolerance. As Nash and Sofer show,
@@ -109,6 +114,18 @@ TrustRegionStrategy::Summary LevenbergMarquardtStrategy::ComputeStep(
     LOG(WARNING) << "Linear solver failure. Failed to compute a finite step.";
     linear_solver_summary.termination_type = FAILURE;
   } else {
+    if (!per_solve_options.dump_directory.empty() &&
+        !DumpLinearLeastSquaresProblem(per_solve_options.dump_directory,
+                                       per_solve_options.dump_iteration,
+                                       per_solve_options.dump_format_type,
+                                       jacobian,
+                                       solve_options.D,
+                                       residuals,
+                                       step,
+                                       num_eliminate_blocks_)) {
+      LOG(FATAL) << "Tried writing linear least squares problem: "
+                 << per_solve_options.dump_directory << " but failed.";
+    }
     VectorRef(step, num_parameters) *= -1.0;
   }
 
@@ -79,6 +79,7 @@ class LevenbergMarquardtStrategy : public TrustRegionStrategy {
   // allocations in every iteration and reuse when a step fails and
   // ComputeStep is called again.
   Vector lm_diagonal_;  // lm_diagonal_ = diagonal_ / radius_;
+  const int num_eliminate_blocks_;
 };
 
 }  // namespace internal
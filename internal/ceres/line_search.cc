@@ -35,6 +35,7 @@
 #include "ceres/fpclassify.h"
 #include "ceres/evaluator.h"
 #include "ceres/internal/eigen.h"
+#include "ceres/parallel_vector_ops.h"
 #include "ceres/polynomial.h"
 
 
@@ -62,26 +63,144 @@ FunctionSample ValueAndGradientSample(const double x,
   return sample;
 };
 
+// Evaluates the value and the gradient of function at x. Returns
+// false if the evaluation failed, in which case only sample->x is
+// valid.
+bool EvaluateSample(LineSearch::Function* function,
+                    const double x,
+                    FunctionSample* sample) {
+  *sample = FunctionSample();
+  sample->x = x;
+  if (!function->Evaluate(x, &sample->value, &sample->gradient)) {
+    return false;
+  }
+  sample->value_is_valid = true;
+  sample->gradient_is_valid = true;
+  return true;
+}
+
+// Zoom phase of the Wolfe line search (Algorithm 3.6 in Nocedal &
+// Wright). lo is a step size satisfying the sufficient decrease
+// condition, with the smallest value of all the step sizes evaluated
+// so far which do. The interval between lo and hi contains step sizes
+// satisfying the strong Wolfe conditions.
+void Zoom(const LineSearch::Options& options,
+          const FunctionSample& initial,
+          FunctionSample lo,
+          FunctionSample hi,
+          LineSearch::Summary* summary) {
+  LineSearch::Function* function = options.function;
+  const double max_abs_gradient =
+      options.sufficient_curvature_decrease * fabs(initial.gradient);
+
+  while (summary->num_evaluations < options.max_num_iterations) {
+    const double lower = min(lo.x, hi.x);
+    const double upper = max(lo.x, hi.x);
+    const double width = upper - lower;
+    if (fabs(initial.gradient) * width < options.step_size_threshold) {
+      break;
+    }
+
+    double step_size = lower + 0.5 * width;
+    if (hi.value_is_valid) {
+      // Minimize the cubic interpolating the values and gradients at
+      // the ends of the interval, staying away from the ends so that
+      // the interval keeps shrinking.
+      vector<FunctionSample> samples;
+      samples.push_back(lo);
+      samples.push_back(hi);
+      double min_value;
+      MinimizeInterpolatingPolynomial(samples, lower, upper,
+                                      &step_size, &min_value);
+      step_size = min(max(step_size, lower + 0.1 * width),
+                      upper - 0.1 * width);
+    }
+
+    ++summary->num_evaluations;
+    FunctionSample current;
+    if (!EvaluateSample(function, step_size, &current)) {
+      hi = current;
+      continue;
+    }
+
+    if (current.value > (initial.value
+                         + options.sufficient_decrease
+                         * initial.gradient
+                         * step_size) ||
+        current.value >= lo.value) {
+      hi = current;
+      continue;
+    }
+
+    if (fabs(current.gradient) <= max_abs_gradient) {
+      summary->optimal_step_size = step_size;
+      summary->success = true;
+      return;
+    }
+
+    if (current.gradient * (hi.x - lo.x) >= 0.0) {
+      hi = lo;
+    }
+    lo = current;
+  }
+
+  // The curvature condition could not be satisfied. lo still
+  // satisfies the sufficient decrease condition.
+  if (lo.x > 0.0) {
+    VLOG(2) << "Wolfe line search: curvature condition not satisfied, "
+            << "using step_size: " << lo.x;
+    summary->optimal_step_size = lo.x;
+    summary->success = true;
+    return;
+  }
+
+  LOG(WARNING) << "Line search failed: Unable to find a step size "
+               << "satisfying the sufficient decrease condition.";
+}
+
 }  // namespace
 
-LineSearchFunction::LineSearchFunction(Evaluator* evaluator)
+LineSearch* LineSearch::Create(const LineSearchType line_search_type) {
+  switch (line_search_type) {
+    case ARMIJO:
+      return new ArmijoLineSearch;
+    case WOLFE:
+      return new WolfeLineSearch;
+    default:
+      LOG(ERROR) << "Unknown line search type: " << line_search_type;
+  }
+  return NULL;
+}
+
+LineSearchFunction::LineSearchFunction(Evaluator* evaluator,
+                                       const int num_threads)
     : evaluator_(evaluator),
-      position_(evaluator->NumParameters()),
-      direction_(evaluator->NumEffectiveParameters()),
+      num_threads_(num_threads),
+      position_(NULL),
+      direction_(NULL),
+      step_size_(0.0),
+      cost_(0.0),
+      has_gradient_(false),
       evaluation_point_(evaluator->NumParameters()),
       scaled_direction_(evaluator->NumEffectiveParameters()),
       gradient_(evaluator->NumEffectiveParameters()) {
 }
 
-void LineSearchFunction::Init(const Vector& position,
-                              const Vector& direction) {
-  position_ = position;
-  direction_ = direction;
+void LineSearchFunction::Init(const double* position,
+                              const double* direction) {
+  position_ = CHECK_NOTNULL(position);
+  direction_ = CHECK_NOTNULL(direction);
 }
 
 bool LineSearchFunction::Evaluate(const double x, double* f, double* g) {
-  scaled_direction_ = x * direction_;
-  if (!evaluator_->Plus(position_.data(),
+  step_size_ = x;
+  has_gradient_ = false;
+  ParallelLinearCombination(scaled_direction_.rows(),
+                            x, direction_,
+                            0.0, direction_,
+                            scaled_direction_.data(),
+                            num_threads_);
+  if (!evaluator_->Plus(position_,
                         scaled_direction_.data(),
                         evaluation_point_.data())) {
     return false;
@@ -100,8 +219,21 @@ bool LineSearchFunction::Evaluate(const double x, double* f, double* g) {
     return false;
   }
 
-  *g = direction_.dot(gradient_);
-  return IsFinite(*f) && IsFinite(*g);
+  *g = ParallelDot(gradient_.rows(),
+                   direction_,
+                   gradient_.data(),
+                   num_threads_);
+  if (!IsFinite(*f) || !IsFinite(*g)) {
+    return false;
+  }
+
+  cost_ = *f;
+  has_gradient_ = true;
+  return true;
+}
+
+bool LineSearchFunction::HasGradientAt(const double x) const {
+  return has_gradient_ && step_size_ == x;
 }
 
 void ArmijoLineSearch::Search(const LineSearch::Options& options,
@@ -208,6 +340,86 @@ void ArmijoLineSearch::Search(const LineSearch::Options& options,
   summary->success = true;
 }
 
+void WolfeLineSearch::Search(const LineSearch::Options& options,
+                             const double initial_step_size,
+                             const double initial_cost,
+                             const double initial_gradient,
+                             Summary* summary) {
+  *CHECK_NOTNULL(summary) = LineSearch::Summary();
+  Function* function = options.function;
+  const FunctionSample initial =
+      ValueAndGradientSample(0.0, initial_cost, initial_gradient);
+  const double max_abs_gradient =
+      options.sufficient_curvature_decrease * fabs(initial_gradient);
+
+  // Bracketing phase (Algorithm 3.5 in Nocedal & Wright). All the
+  // step sizes before current satisfy the sufficient decrease
+  // condition and have decreasing values.
+  FunctionSample previous = initial;
+  double step_size = initial_step_size;
+  while (summary->num_evaluations < options.max_num_iterations) {
+    ++summary->num_evaluations;
+    FunctionSample current;
+    if (!EvaluateSample(function, step_size, &current)) {
+      // If the evaluation failed, we treat it as if the step was too
+      // large and backtrack towards the previous step size.
+      step_size = previous.x + 0.5 * (step_size - previous.x);
+      if (fabs(initial_gradient) * (step_size - previous.x) <
+          options.step_size_threshold) {
+        break;
+      }
+      continue;
+    }
+
+    if (current.value > (initial_cost
+                         + options.sufficient_decrease
+                         * initial_gradient
+                         * step_size) ||
+        (previous.x > 0.0 && current.value >= previous.value)) {
+      Zoom(options, initial, previous, current, summary);
+      return;
+    }
+
+    if (fabs(current.gradient) <= max_abs_gradient) {
+      summary->optimal_step_size = step_size;
+      summary->success = true;
+      return;
+    }
+
+    if (current.gradient >= 0.0) {
+      Zoom(options, initial, current, previous, summary);
+      return;
+    }
+
+    // The function is still decreasing at current, extrapolate using
+    // the cubic interpolating previous and current.
+    vector<FunctionSample> samples;
+    samples.push_back(previous);
+    samples.push_back(current);
+    double min_value;
+    MinimizeInterpolatingPolynomial(
+        samples,
+        current.x + 0.01 * (current.x - previous.x),
+        options.max_step_expansion * current.x,
+        &step_size,
+        &min_value);
+    previous = current;
+  }
+
+  // Ran out of evaluations. previous satisfies the sufficient
+  // decrease condition.
+  if (previous.x > 0.0) {
+    VLOG(2) << "Wolfe line search: curvature condition not satisfied, "
+            << "using step_size: " << previous.x;
+    summary->optimal_step_size = previous.x;
+    summary->success = true;
+    return;
+  }
+
+  LOG(WARNING) << "Line search failed: Unable to find a step size "
+               << "satisfying the sufficient decrease condition.";
+}
+
 }  // namespace internal
 }  // namespace ceres
 
@@ -39,6 +39,7 @@
 #include <vector>
 #include "ceres/internal/eigen.h"
 #include "ceres/internal/port.h"
+#include "ceres/types.h"
 
 namespace ceres {
 namespace internal {
@@ -67,6 +68,9 @@ class LineSearch {
           min_relative_step_size_change(1e-3),
           max_relative_step_size_change(0.6),
           step_size_threshold(1e-9),
+          sufficient_curvature_decrease(0.9),
+          max_step_expansion(10.0),
+          max_num_iterations(20),
           function(NULL) {}
 
     // TODO(sameeragarwal): Replace this with enums which are common
@@ -113,6 +117,25 @@ class LineSearch {
     // value, it is truncated to zero.
     double step_size_threshold;
 
+    // Wolfe line search parameters.
+
+    // The strong Wolfe conditions consist of the sufficient decrease
+    // condition above and the curvature condition
+    //
+    //   |f'(step_size)| <= sufficient_curvature_decrease * |f'(0)|
+    //
+    // where 0 < sufficient_decrease < sufficient_curvature_decrease < 1.
+    double sufficient_curvature_decrease;
+
+    // While bracketing a step size satisfying the Wolfe conditions,
+    // each new trial step size is at most max_step_expansion times
+    // the previous one.
+    double max_step_expansion;
+
+    // Maximum number of function evaluations performed by the Wolfe
+    // line search.
+    int max_num_iterations;
+
     // The one dimensional function that the line search algorithm
     // minimizes.
     Function* function;
@@ -156,6 +179,9 @@ class LineSearch {
 
   virtual ~LineSearch() {}
 
+  // Returns NULL if the line search type is not known.
+  static LineSearch* Create(LineSearchType line_search_type);
+
   // Perform the line search.
   //
   // initial_step_size must be a positive number.
@@ -175,15 +201,36 @@ class LineSearch {
 
 class LineSearchFunction : public LineSearch::Function {
  public:
-  explicit LineSearchFunction(Evaluator* evaluator);
+  LineSearchFunction(Evaluator* evaluator, int num_threads);
   virtual ~LineSearchFunction() {}
-  void Init(const Vector& position, const Vector& direction);
+
+  // position and direction are not copied, and must remain valid and
+  // unchanged until the next call to Init.
+  void Init(const double* position, const double* direction);
   virtual bool Evaluate(const double x, double* f, double* g);
 
+  // Returns true if the most recent call to Evaluate was for the step
+  // size x, succeeded and computed the gradient. The minimizer uses
+  // this to avoid evaluating the objective again at the point
+  // accepted by the line search. In that case evaluation_point(),
+  // cost() and gradient() are the point, the value of the objective
+  // and its gradient at that step.
+  bool HasGradientAt(double x) const;
+  const Vector& evaluation_point() const { return evaluation_point_; }
+  double cost() const { return cost_; }
+  const Vector& gradient() const { return gradient_; }
+
  private:
   Evaluator* evaluator_;
-  Vector position_;
-  Vector direction_;
+  const int num_threads_;
+  const double* position_;
+  const double* direction_;
+
+  // The step size and the cost of the most recent call to Evaluate,
+  // and whether it computed the gradient.
+  double step_size_;
+  double cost_;
+  bool has_gradient_;
 
   // evaluation_point = Evaluator::Plus(position_,  x * direction_);
   Vector evaluation_point_;
@@ -208,6 +255,26 @@ class ArmijoLineSearch : public LineSearch {
                       Summary* summary);
 };
 
+// Line search for a step size satisfying the strong Wolfe conditions,
+// following Algorithms 3.5 and 3.6 in "Numerical Optimization" by
+// Nocedal & Wright. Every trial step is evaluated with its gradient,
+// and new trial step sizes are computed by minimizing the cubic
+// polynomial interpolating the values and gradients at the two most
+// relevant step sizes.
+//
+// If the number of evaluations exceeds options.max_num_iterations,
+// the best step size satisfying the sufficient decrease condition is
+// returned.
+class WolfeLineSearch : public LineSearch {
+ public:
+  virtual ~WolfeLineSearch() {}
+  virtual void Search(const LineSearch::Options& options,
+                      double initial_step_size,
+                      double initial_cost,
+                      double initial_gradient,
+                      Summary* summary);
+};
+
 }  // namespace internal
 }  // namespace ceres
 
@@ -34,6 +34,7 @@
 #include "ceres/line_search_minimizer.h"
 #include "ceres/low_rank_inverse_hessian.h"
 #include "ceres/internal/eigen.h"
+#include "ceres/parallel_vector_ops.h"
 #include "glog/logging.h"
 
 namespace ceres {
@@ -41,53 +42,99 @@ namespace internal {
 
 class SteepestDescent : public LineSearchDirection {
  public:
+  explicit SteepestDescent(const int num_threads)
+      : num_threads_(num_threads) {
+  }
+
   virtual ~SteepestDescent() {}
   bool NextDirection(const LineSearchMinimizer::State& previous,
                      const LineSearchMinimizer::State& current,
                      Vector* search_direction) {
-    *search_direction = -current.gradient;
+    const double* gradient = current.gradient.data();
+    ParallelLinearCombination(current.gradient.rows(),
+                              -1.0, gradient,
+                              0.0, gradient,
+                              search_direction->data(),
+                              num_threads_);
     return true;
   }
+
+ private:
+  const int num_threads_;
 };
 
 class NonlinearConjugateGradient : public LineSearchDirection {
  public:
   NonlinearConjugateGradient(const NonlinearConjugateGradientType type,
-                             const double function_tolerance)
+                             const double function_tolerance,
+                             const int num_parameters,
+                             const int num_threads)
       : type_(type),
-        function_tolerance_(function_tolerance) {
+        function_tolerance_(function_tolerance),
+        num_threads_(num_threads) {
+    if (type_ != FLETCHER_REEVES) {
+      gradient_change_.resize(num_parameters);
+    }
   }
 
   bool NextDirection(const LineSearchMinimizer::State& previous,
                      const LineSearchMinimizer::State& current,
                      Vector* search_direction) {
+    const int num_parameters = current.gradient.rows();
+    const double* gradient = current.gradient.data();
     double beta = 0.0;
-    Vector gradient_change;
     switch (type_) {
       case FLETCHER_REEVES:
         beta = current.gradient_squared_norm / previous.gradient_squared_norm;
         break;
       case POLAK_RIBIRERE:
-        gradient_change = current.gradient - previous.gradient;
-        beta = (current.gradient.dot(gradient_change) /
+        ParallelLinearCombination(num_parameters,
+                                  1.0, gradient,
+                                  -1.0, previous.gradient.data(),
+                                  gradient_change_.data(),
+                                  num_threads_);
+        beta = (ParallelDot(num_parameters,
+                            gradient,
+                            gradient_change_.data(),
+                            num_threads_) /
                 previous.gradient_squared_norm);
         break;
       case HESTENES_STIEFEL:
-        gradient_change = current.gradient - previous.gradient;
-        beta =  (current.gradient.dot(gradient_change) /
-                 previous.search_direction.dot(gradient_change));
+        ParallelLinearCombination(num_parameters,
+                                  1.0, gradient,
+                                  -1.0, previous.gradient.data(),
+                                  gradient_change_.data(),
+                                  num_threads_);
+        beta =  (ParallelDot(num_parameters,
+                             gradient,
+                             gradient_change_.data(),
+                             num_threads_) /
+                 ParallelDot(num_parameters,
+                             previous.search_direction.data(),
+                             gradient_change_.data(),
+                             num_threads_));
         break;
       default:
         LOG(FATAL) << "Unknown nonlinear conjugate gradient type: " << type_;
     }
 
-    *search_direction =  -current.gradient + beta * previous.search_direction;
+    // search_direction = -gradient + beta * previous.search_direction,
+    // and its directional derivative in the same pass.
     const double directional_derivative =
-        current.gradient.dot(*search_direction);
+        ParallelLinearCombinationDot(num_parameters,
+                                     -1.0, gradient,
+                                     beta, previous.search_direction.data(),
+                                     gradient,
+                                     search_direction->data(),
+                                     num_threads_);
     if (directional_derivative > -function_tolerance_) {
       LOG(WARNING) << "Restarting non-linear conjugate gradients: "
                    << directional_derivative;
-      *search_direction = -current.gradient;
+      ParallelLinearCombination(num_parameters,
+                                -1.0, gradient,
+                                0.0, gradient,
+                                search_direction->data(),
+                                num_threads_);
     };
 
     return true;
@@ -96,47 +143,78 @@ class NonlinearConjugateGradient : public LineSearchDirection {
  private:
   const NonlinearConjugateGradientType type_;
   const double function_tolerance_;
+  const int num_threads_;
+  Vector gradient_change_;
 };
 
 class LBFGS : public LineSearchDirection {
  public:
-  LBFGS(const int num_parameters, const int max_lbfgs_rank)
-      : low_rank_inverse_hessian_(num_parameters, max_lbfgs_rank) {}
+  LBFGS(const int num_parameters,
+        const int max_lbfgs_rank,
+        const int num_threads)
+      : low_rank_inverse_hessian_(num_parameters,
+                                  max_lbfgs_rank,
+                                  num_threads),
+        num_threads_(num_threads),
+        delta_x_(num_parameters),
+        delta_gradient_(num_parameters) {
+  }
 
   virtual ~LBFGS() {}
 
   bool NextDirection(const LineSearchMinimizer::State& previous,
                      const LineSearchMinimizer::State& current,
                      Vector* search_direction) {
-    low_rank_inverse_hessian_.Update(
-        previous.search_direction * previous.step_size,
-        current.gradient - previous.gradient);
-    search_direction->setZero();
+    const int num_parameters = current.gradient.rows();
+    ParallelLinearCombination(num_parameters,
+                              previous.step_size,
+                              previous.search_direction.data(),
+                              0.0,
+                              previous.search_direction.data(),
+                              delta_x_.data(),
+                              num_threads_);
+    ParallelLinearCombination(num_parameters,
+                              1.0, current.gradient.data(),
+                              -1.0, previous.gradient.data(),
+                              delta_gradient_.data(),
+                              num_threads_);
+    low_rank_inverse_hessian_.Update(delta_x_, delta_gradient_);
     low_rank_inverse_hessian_.RightMultiply(current.gradient.data(),
                                             search_direction->data());
-    *search_direction *= -1.0;
+    ParallelLinearCombination(num_parameters,
+                              -1.0, search_direction->data(),
+                              0.0, search_direction->data(),
+                              search_direction->data(),
+                              num_threads_);
     return true;
   }
 
  private:
   LowRankInverseHessian low_rank_inverse_hessian_;
+  const int num_threads_;
+  // Scratch space for the arguments of LowRankInverseHessian::Update.
+  Vector delta_x_;
+  Vector delta_gradient_;
 };
 
 LineSearchDirection*
 LineSearchDirection::Create(const LineSearchDirection::Options& options) {
   if (options.type == STEEPEST_DESCENT) {
-    return new SteepestDescent;
+    return new SteepestDescent(options.num_threads);
   }
 
   if (options.type == NONLINEAR_CONJUGATE_GRADIENT) {
     return new NonlinearConjugateGradient(
         options.nonlinear_conjugate_gradient_type,
-        options.function_tolerance);
+        options.function_tolerance,
+        options.num_parameters,
+        options.num_threads);
   }
 
   if (options.type == ceres::LBFGS) {
     return new ceres::internal::LBFGS(options.num_parameters,
-                                      options.max_lbfgs_rank);
+                                      options.max_lbfgs_rank,
+                                      options.num_threads);
   }
 
   LOG(ERROR) << "Unknown line search direction type: " << options.type;
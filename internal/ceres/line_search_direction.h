@@ -48,7 +48,8 @@ class LineSearchDirection {
           type(LBFGS),
           nonlinear_conjugate_gradient_type(FLETCHER_REEVES),
           function_tolerance(1e-12),
-          max_lbfgs_rank(20) {
+          max_lbfgs_rank(20),
+          num_threads(1) {
     }
 
     int num_parameters;
@@ -56,6 +57,9 @@ class LineSearchDirection {
     NonlinearConjugateGradientType nonlinear_conjugate_gradient_type;
     double function_tolerance;
     int max_lbfgs_rank;
+
+    // Number of threads used by the vector operations.
+    int num_threads;
   };
 
   static LineSearchDirection* Create(const Options& options);
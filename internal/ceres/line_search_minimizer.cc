@@ -56,6 +56,7 @@
 #include "ceres/internal/scoped_ptr.h"
 #include "ceres/line_search.h"
 #include "ceres/line_search_direction.h"
+#include "ceres/parallel_vector_ops.h"
 #include "ceres/stringprintf.h"
 #include "ceres/types.h"
 #include "ceres/wall_time.h"
@@ -69,22 +70,42 @@ namespace {
 // use.
 const double kEpsilon = 1e-12;
 
+void ComputeGradientNorms(const int num_threads,
+                          LineSearchMinimizer::State* state) {
+  ParallelSquaredNormAndMaxNorm(state->gradient.rows(),
+                                state->gradient.data(),
+                                num_threads,
+                                &(state->gradient_squared_norm),
+                                &(state->gradient_max_norm));
+}
+
 bool Evaluate(Evaluator* evaluator,
-              const Vector& x,
+              const double* x,
+              const int num_threads,
               LineSearchMinimizer::State* state) {
-  const bool status = evaluator->Evaluate(x.data(),
+  const bool status = evaluator->Evaluate(x,
                                           &(state->cost),
                                           NULL,
                                           state->gradient.data(),
                                           NULL);
   if (status) {
-    state->gradient_squared_norm = state->gradient.squaredNorm();
-    state->gradient_max_norm = state->gradient.lpNorm<Eigen::Infinity>();
+    ComputeGradientNorms(num_threads, state);
   }
 
   return status;
 }
 
+// Exchanges the contents of two states without copying the vectors.
+void SwapStates(LineSearchMinimizer::State* a, LineSearchMinimizer::State* b) {
+  std::swap(a->cost, b->cost);
+  a->gradient.swap(b->gradient);
+  std::swap(a->gradient_squared_norm, b->gradient_squared_norm);
+  std::swap(a->gradient_max_norm, b->gradient_max_norm);
+  a->search_direction.swap(b->search_direction);
+  std::swap(a->directional_derivative, b->directional_derivative);
+  std::swap(a->step_size, b->step_size);
+}
+
 }  // namespace
 
 void LineSearchMinimizer::Minimize(const Minimizer::Options& options,
@@ -96,6 +117,7 @@ void LineSearchMinimizer::Minimize(const Minimizer::Options& options,
   Evaluator* evaluator = CHECK_NOTNULL(options.evaluator);
   const int num_parameters = evaluator->NumParameters();
   const int num_effective_parameters = evaluator->NumEffectiveParameters();
+  const int num_threads = options.num_threads;
 
   summary->termination_type = NO_CONVERGENCE;
   summary->num_successful_steps = 0;
@@ -120,7 +142,7 @@ void LineSearchMinimizer::Minimize(const Minimizer::Options& options,
   iteration_summary.step_solver_time_in_seconds = 0;
 
   // Do initial cost and Jacobian evaluation.
-  if (!Evaluate(evaluator, x, &current_state)) {
+  if (!Evaluate(evaluator, x.data(), num_threads, &current_state)) {
     LOG(WARNING) << "Terminating: Cost and gradient evaluation failed.";
     summary->termination_type = NUMERICAL_FAILURE;
     return;
@@ -160,16 +182,17 @@ void LineSearchMinimizer::Minimize(const Minimizer::Options& options,
   line_search_direction_options.nonlinear_conjugate_gradient_type =
       options.nonlinear_conjugate_gradient_type;
   line_search_direction_options.max_lbfgs_rank = options.max_lbfgs_rank;
+  line_search_direction_options.num_threads = num_threads;
   scoped_ptr<LineSearchDirection> line_search_direction(
       LineSearchDirection::Create(line_search_direction_options));
 
-  LineSearchFunction line_search_function(evaluator);
+  LineSearchFunction line_search_function(evaluator, num_threads);
   LineSearch::Options line_search_options;
   line_search_options.function = &line_search_function;
 
-  // TODO(sameeragarwal): Make this parameterizable over different
-  // line searches.
-  ArmijoLineSearch line_search;
+  scoped_ptr<LineSearch> line_search(
+      LineSearch::Create(options.line_search_type));
+  CHECK_NOTNULL(line_search.get());
   LineSearch::Summary line_search_summary;
 
   while (true) {
@@ -197,7 +220,11 @@ void LineSearchMinimizer::Minimize(const Minimizer::Options& options,
 
     bool line_search_status = true;
     if (iteration_summary.iteration == 1) {
-      current_state.search_direction = -current_state.gradient;
+      ParallelLinearCombination(num_effective_parameters,
+                                -1.0, current_state.gradient.data(),
+                                0.0, current_state.gradient.data(),
+                                current_state.search_direction.data(),
+                                num_threads);
     } else {
       line_search_status = line_search_direction->NextDirection(
           previous_state,
@@ -208,12 +235,19 @@ void LineSearchMinimizer::Minimize(const Minimizer::Options& options,
     if (!line_search_status) {
       LOG(WARNING) << "Line search direction computation failed. "
           "Resorting to steepest descent.";
-      current_state.search_direction = -current_state.gradient;
+      ParallelLinearCombination(num_effective_parameters,
+                                -1.0, current_state.gradient.data(),
+                                0.0, current_state.gradient.data(),
+                                current_state.search_direction.data(),
+                                num_threads);
     }
 
-    line_search_function.Init(x, current_state.search_direction);
+    line_search_function.Init(x.data(), current_state.search_direction.data());
     current_state.directional_derivative =
-        current_state.gradient.dot(current_state.search_direction);
+        ParallelDot(num_effective_parameters,
+                    current_state.gradient.data(),
+                    current_state.search_direction.data(),
+                    num_threads);
 
     // TODO(sameeragarwal): Refactor this into its own object and add
     // explanations for the various choices.
@@ -222,21 +256,38 @@ void LineSearchMinimizer::Minimize(const Minimizer::Options& options,
         : min(1.0, 2.0 * (current_state.cost - previous_state.cost) /
               current_state.directional_derivative);
 
-    line_search.Search(line_search_options,
-                       initial_step_size,
-                       current_state.cost,
-                       current_state.directional_derivative,
-                       &line_search_summary);
+    line_search->Search(line_search_options,
+                        initial_step_size,
+                        current_state.cost,
+                        current_state.directional_derivative,
+                        &line_search_summary);
 
     current_state.step_size = line_search_summary.optimal_step_size;
-    delta = current_state.step_size * current_state.search_direction;
-
-    previous_state = current_state;
-
-    // TODO(sameeragarwal): Collect stats.
-    if (!evaluator->Plus(x.data(), delta.data(), x_plus_delta.data()) ||
-        !Evaluate(evaluator, x_plus_delta, &current_state)) {
+    const double step_norm = sqrt(ParallelLinearCombinationDot(
+        num_effective_parameters,
+        current_state.step_size, current_state.search_direction.data(),
+        0.0, current_state.search_direction.data(),
+        delta.data(),
+        delta.data(),
+        num_threads));
+
+    // previous_state = current_state. The contents of current_state
+    // are overwritten by the evaluation below.
+    SwapStates(&previous_state, &current_state);
+
+    if (line_search_function.HasGradientAt(previous_state.step_size)) {
+      // The line search has already evaluated the cost and the
+      // gradient at the accepted step.
+      x = line_search_function.evaluation_point();
+      current_state.cost = line_search_function.cost();
+      current_state.gradient = line_search_function.gradient();
+      ComputeGradientNorms(num_threads, &current_state);
+    } else if (!evaluator->Plus(x.data(), delta.data(), x_plus_delta.data()) ||
+               !Evaluate(evaluator, x_plus_delta.data(), num_threads,
+                         &current_state)) {
+      // TODO(sameeragarwal): Collect stats.
       LOG(WARNING) << "Evaluation failed.";
+      current_state = previous_state;
     } else {
       x = x_plus_delta;
     }
@@ -264,11 +315,12 @@ void LineSearchMinimizer::Minimize(const Minimizer::Options& options,
     }
 
     iteration_summary.cost = current_state.cost + summary->fixed_cost;
-    iteration_summary.step_norm = delta.norm();
+    iteration_summary.step_norm = step_norm;
     iteration_summary.step_is_valid = true;
     iteration_summary.step_is_successful = true;
-    iteration_summary.step_norm = delta.norm();
-    iteration_summary.step_size =  current_state.step_size;
+    // The states were swapped after the line search, so the step
+    // size of this iteration is in previous_state.
+    iteration_summary.step_size =  previous_state.step_size;
     iteration_summary.line_search_function_evaluations =
         line_search_summary.num_evaluations;
     iteration_summary.iteration_time_in_seconds =
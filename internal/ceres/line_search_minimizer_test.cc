@@ -0,0 +1,264 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Tests the LineSearchMinimizer loop using a direct Evaluator
+// implementation of the Rosenbrock function.
+
+#ifndef CERES_NO_LINE_SEARCH_MINIMIZER
+
+#include "ceres/line_search_minimizer.h"
+
+#include <vector>
+#include "ceres/evaluator.h"
+#include "ceres/internal/eigen.h"
+#include "ceres/internal/port.h"
+#include "ceres/iteration_callback.h"
+#include "ceres/minimizer.h"
+#include "ceres/solver.h"
+#include "ceres/types.h"
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+namespace ceres {
+namespace internal {
+
+// f(x, y) = (1 - x)^2 + 100 (y - x^2)^2, which has its minimum at
+// (1, 1).
+double RosenbrockCost(const double* x) {
+  const double a = 1.0 - x[0];
+  const double b = x[1] - x[0] * x[0];
+  return a * a + 100.0 * b * b;
+}
+
+void RosenbrockGradient(const double* x, double* gradient) {
+  const double b = x[1] - x[0] * x[0];
+  gradient[0] = -2.0 * (1.0 - x[0]) - 400.0 * b * x[0];
+  gradient[1] = 200.0 * b;
+}
+
+// Evaluates the Rosenbrock function, and records the points at which
+// it was evaluated.
+class RosenbrockEvaluator : public Evaluator {
+ public:
+  virtual ~RosenbrockEvaluator() {}
+
+  virtual SparseMatrix* CreateJacobian() const {
+    LOG(FATAL) << "The line search minimizer does not need a jacobian.";
+    return NULL;
+  }
+
+  virtual bool Evaluate(const Evaluator::EvaluateOptions& evaluate_options,
+                        const double* state,
+                        double* cost,
+                        double* residuals,
+                        double* gradient,
+                        SparseMatrix* jacobian) {
+    CHECK(residuals == NULL);
+    CHECK(jacobian == NULL);
+    evaluation_points_.push_back(ConstVectorRef(state, 2));
+    *cost = RosenbrockCost(state);
+    if (gradient != NULL) {
+      RosenbrockGradient(state, gradient);
+    }
+    return true;
+  }
+
+  virtual bool Plus(const double* state,
+                    const double* delta,
+                    double* state_plus_delta) const {
+    state_plus_delta[0] = state[0] + delta[0];
+    state_plus_delta[1] = state[1] + delta[1];
+    return true;
+  }
+
+  virtual int NumParameters()          const { return 2; }
+  virtual int NumEffectiveParameters() const { return 2; }
+  virtual int NumResiduals()           const { return 1; }
+
+  const vector<Vector>& evaluation_points() const {
+    return evaluation_points_;
+  }
+
+ private:
+  vector<Vector> evaluation_points_;
+};
+
+// Checks the iteration summaries against the iterates. The
+// minimizer updates the parameters in place, so they are the
+// current iterate when the callback is invoked.
+class CheckIteratesCallback : public IterationCallback {
+ public:
+  explicit CheckIteratesCallback(const double* parameters)
+      : parameters_(parameters),
+        previous_parameters_(ConstVectorRef(parameters, 2)),
+        previous_gradient_(2) {
+    RosenbrockGradient(parameters, previous_gradient_.data());
+  }
+
+  virtual ~CheckIteratesCallback() {}
+
+  virtual CallbackReturnType operator()(const IterationSummary& summary) {
+    if (summary.iteration == 0) {
+      return SOLVER_CONTINUE;
+    }
+
+    const ConstVectorRef x(parameters_, 2);
+    EXPECT_NEAR((x - previous_parameters_).norm(), summary.step_norm,
+                1e-12 * summary.step_norm);
+
+    // Steepest descent moves along the negative gradient at the
+    // previous iterate, scaled by the step size of this iteration.
+    EXPECT_GT(summary.step_size, 0.0);
+    const Vector expected_x =
+        previous_parameters_ - summary.step_size * previous_gradient_;
+    EXPECT_NEAR((x - expected_x).norm(), 0.0, 1e-12 * summary.step_norm);
+
+    previous_parameters_ = x;
+    RosenbrockGradient(parameters_, previous_gradient_.data());
+    return SOLVER_CONTINUE;
+  }
+
+ private:
+  const double* parameters_;
+  Vector previous_parameters_;
+  Vector previous_gradient_;
+};
+
+TEST(LineSearchMinimizer, ReportsTheStepSizeOfEachIteration) {
+  double parameters[2] = { -1.2, 1.0 };
+
+  Solver::Options solver_options;
+  solver_options.minimizer_type = LINE_SEARCH;
+  solver_options.line_search_direction_type = STEEPEST_DESCENT;
+  solver_options.max_num_iterations = 20;
+
+  RosenbrockEvaluator evaluator;
+  CheckIteratesCallback callback(parameters);
+  Minimizer::Options minimizer_options(solver_options);
+  minimizer_options.evaluator = &evaluator;
+  minimizer_options.callbacks.push_back(&callback);
+
+  LineSearchMinimizer minimizer;
+  Solver::Summary summary;
+  minimizer.Minimize(minimizer_options, parameters, &summary);
+
+  EXPECT_GT(summary.iterations.size(), 2);
+}
+
+// Checks that the cost and the gradient reported for each iteration
+// are those of the iterate, and that the minimizer only evaluates the
+// iterate if the line search did not already do so with the gradient.
+class CheckEvaluationsCallback : public IterationCallback {
+ public:
+  CheckEvaluationsCallback(const double* parameters,
+                           const RosenbrockEvaluator* evaluator)
+      : parameters_(parameters),
+        evaluator_(evaluator),
+        num_evaluations_(0),
+        num_reused_evaluations_(0) {
+  }
+
+  virtual ~CheckEvaluationsCallback() {}
+
+  virtual CallbackReturnType operator()(const IterationSummary& summary) {
+    const vector<Vector>& evaluation_points = evaluator_->evaluation_points();
+    if (summary.iteration > 0) {
+      const ConstVectorRef x(parameters_, 2);
+      EXPECT_EQ(RosenbrockCost(parameters_), summary.cost);
+      Vector gradient(2);
+      RosenbrockGradient(parameters_, gradient.data());
+      EXPECT_EQ(gradient.lpNorm<Eigen::Infinity>(), summary.gradient_max_norm);
+
+      // The last point evaluated by the line search is the iterate
+      // exactly when the line search accepted it, in which case it is
+      // not evaluated again.
+      const int num_line_search_evaluations =
+          summary.line_search_function_evaluations;
+      if (num_line_search_evaluations <= 0 ||
+          evaluation_points.size() <
+          num_evaluations_ + num_line_search_evaluations) {
+        ADD_FAILURE() << "Missing line search evaluations.";
+        return SOLVER_ABORT;
+      }
+      const Vector& last_line_search_point =
+          evaluation_points[num_evaluations_ + num_line_search_evaluations - 1];
+      if (last_line_search_point == x) {
+        ++num_reused_evaluations_;
+        EXPECT_EQ(evaluation_points.size(),
+                  num_evaluations_ + num_line_search_evaluations);
+      } else {
+        EXPECT_EQ(evaluation_points.size(),
+                  num_evaluations_ + num_line_search_evaluations + 1);
+        EXPECT_TRUE(evaluation_points.back() == x);
+      }
+    }
+    num_evaluations_ = evaluation_points.size();
+    return SOLVER_CONTINUE;
+  }
+
+  int num_reused_evaluations() const { return num_reused_evaluations_; }
+
+ private:
+  const double* parameters_;
+  const RosenbrockEvaluator* evaluator_;
+  int num_evaluations_;
+  int num_reused_evaluations_;
+};
+
+TEST(LineSearchMinimizer, ReusesTheEvaluationsOfTheWolfeLineSearch) {
+  double parameters[2] = { -1.2, 1.0 };
+
+  Solver::Options solver_options;
+  solver_options.minimizer_type = LINE_SEARCH;
+  solver_options.line_search_direction_type = LBFGS;
+  solver_options.line_search_type = WOLFE;
+  solver_options.max_num_iterations = 100;
+  solver_options.function_tolerance = 1e-16;
+  solver_options.gradient_tolerance = 1e-12;
+
+  RosenbrockEvaluator evaluator;
+  CheckEvaluationsCallback callback(parameters, &evaluator);
+  Minimizer::Options minimizer_options(solver_options);
+  minimizer_options.evaluator = &evaluator;
+  minimizer_options.callbacks.push_back(&callback);
+
+  LineSearchMinimizer minimizer;
+  Solver::Summary summary;
+  summary.fixed_cost = 0.0;
+  minimizer.Minimize(minimizer_options, parameters, &summary);
+
+  EXPECT_EQ(summary.termination_type, GRADIENT_TOLERANCE);
+  EXPECT_NEAR(parameters[0], 1.0, 1e-6);
+  EXPECT_NEAR(parameters[1], 1.0, 1e-6);
+  EXPECT_GT(callback.num_reused_evaluations(), 0);
+}
+
+}  // namespace internal
+}  // namespace ceres
+
+#endif  // CERES_NO_LINE_SEARCH_MINIMIZER
@@ -0,0 +1,148 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CERES_NO_LINE_SEARCH_MINIMIZER
+
+#include "ceres/line_search.h"
+
+#include <cmath>
+#include "ceres/internal/scoped_ptr.h"
+#include "gtest/gtest.h"
+
+namespace ceres {
+namespace internal {
+
+// f(x) = (x - 3)^4 + (x - 3)^2 + 1, which has its minimum at x = 3.
+class QuarticFunction : public LineSearch::Function {
+ public:
+  QuarticFunction() : num_evaluations_(0) {}
+  virtual bool Evaluate(double x, double* f, double* g) {
+    ++num_evaluations_;
+    const double y = x - 3.0;
+    *f = y * y * y * y + y * y + 1.0;
+    if (g != NULL) {
+      *g = 4.0 * y * y * y + 2.0 * y;
+    }
+    return true;
+  }
+
+  int num_evaluations_;
+};
+
+// Evaluation fails for x > 2.
+class RestrictedDomainFunction : public QuarticFunction {
+ public:
+  virtual bool Evaluate(double x, double* f, double* g) {
+    if (x > 2.0) {
+      ++num_evaluations_;
+      return false;
+    }
+    return QuarticFunction::Evaluate(x, f, g);
+  }
+};
+
+void ExpectStrongWolfeConditions(const LineSearch::Options& options,
+                                 const double step_size) {
+  double initial_cost;
+  double initial_gradient;
+  double cost;
+  double gradient;
+  options.function->Evaluate(0.0, &initial_cost, &initial_gradient);
+  options.function->Evaluate(step_size, &cost, &gradient);
+  EXPECT_LE(cost, initial_cost +
+            options.sufficient_decrease * initial_gradient * step_size);
+  EXPECT_LE(fabs(gradient),
+            options.sufficient_curvature_decrease * fabs(initial_gradient));
+}
+
+TEST(WolfeLineSearch, ExtrapolatesFromSmallSteps) {
+  QuarticFunction function;
+  double initial_cost;
+  double initial_gradient;
+  function.Evaluate(0.0, &initial_cost, &initial_gradient);
+  function.num_evaluations_ = 0;
+
+  LineSearch::Options options;
+  options.function = &function;
+  scoped_ptr<LineSearch> line_search(LineSearch::Create(WOLFE));
+  LineSearch::Summary summary;
+  line_search->Search(options, 1e-3, initial_cost, initial_gradient,
+                      &summary);
+  EXPECT_TRUE(summary.success);
+  EXPECT_EQ(summary.num_evaluations, function.num_evaluations_);
+  EXPECT_LE(summary.num_evaluations, options.max_num_iterations);
+  ExpectStrongWolfeConditions(options, summary.optimal_step_size);
+}
+
+TEST(WolfeLineSearch, ZoomsIntoLargeSteps) {
+  QuarticFunction function;
+  double initial_cost;
+  double initial_gradient;
+  function.Evaluate(0.0, &initial_cost, &initial_gradient);
+
+  LineSearch::Options options;
+  options.function = &function;
+  options.sufficient_curvature_decrease = 0.1;
+  WolfeLineSearch line_search;
+  LineSearch::Summary summary;
+  line_search.Search(options, 100.0, initial_cost, initial_gradient,
+                     &summary);
+  EXPECT_TRUE(summary.success);
+  EXPECT_LT(summary.optimal_step_size, 100.0);
+  ExpectStrongWolfeConditions(options, summary.optimal_step_size);
+}
+
+TEST(WolfeLineSearch, BacktracksFromFailedEvaluations) {
+  RestrictedDomainFunction function;
+  double initial_cost;
+  double initial_gradient;
+  function.Evaluate(0.0, &initial_cost, &initial_gradient);
+
+  LineSearch::Options options;
+  options.function = &function;
+  WolfeLineSearch line_search;
+  LineSearch::Summary summary;
+  line_search.Search(options, 10.0, initial_cost, initial_gradient,
+                     &summary);
+  EXPECT_TRUE(summary.success);
+  EXPECT_GT(summary.optimal_step_size, 0.0);
+  EXPECT_LE(summary.optimal_step_size, 2.0);
+
+  // The minimum is outside the domain, so only the sufficient
+  // decrease condition can be expected to hold.
+  double cost;
+  double gradient;
+  function.Evaluate(summary.optimal_step_size, &cost, &gradient);
+  EXPECT_LE(cost, initial_cost + options.sufficient_decrease *
+            initial_gradient * summary.optimal_step_size);
+}
+
+}  // namespace internal
+}  // namespace ceres
+
+#endif  // CERES_NO_LINE_SEARCH_MINIMIZER
@@ -37,8 +37,10 @@
 #include "ceres/block_structure.h"
 #include "ceres/casts.h"
 #include "ceres/compressed_row_sparse_matrix.h"
+#include "ceres/dense_sparse_matrix.h"
 #include "ceres/file.h"
 #include "ceres/internal/scoped_ptr.h"
+#include "ceres/lsqp_binary_file.h"
 #include "ceres/matrix_proto.h"
 #include "ceres/stringprintf.h"
 #include "ceres/triplet_sparse_matrix.h"
@@ -132,6 +134,463 @@ LinearLeastSquaresProblem* CreateLinearLeastSquaresProblemFromFile(
 }
 #endif  // CERES_NO_PROTOCOL_BUFFERS
 
+namespace {
+
+// Returns true if a payload of num_bytes bytes can hold count items
+// of num_ints_per_item ints each. Used to reject corrupt counts before
+// allocating memory for them.
+bool PayloadCanHold(int64 num_bytes, int count, int num_ints_per_item) {
+  if (count < 0 ||
+      static_cast<int64>(count) * num_ints_per_item * sizeof(int) >
+      num_bytes) {
+    LOG(ERROR) << "Corrupt linear least squares problem file.";
+    return false;
+  }
+  return true;
+}
+
+// Returns true if all the size indices are in the range [0, bound).
+bool IndicesAreInRange(const int* indices, int size, int bound) {
+  for (int i = 0; i < size; ++i) {
+    if (indices[i] < 0 || indices[i] >= bound) {
+      LOG(ERROR) << "Corrupt linear least squares problem file.";
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns true if the blocks have positive sizes and are laid out
+// contiguously starting at position zero.
+bool BlocksAreContiguous(const vector<Block>& blocks) {
+  int position = 0;
+  for (int i = 0; i < blocks.size(); ++i) {
+    if (blocks[i].size <= 0 || blocks[i].position != position) {
+      LOG(ERROR) << "Corrupt linear least squares problem file.";
+      return false;
+    }
+    position += blocks[i].size;
+  }
+  return true;
+}
+
+// Returns true if the cells of the block structure refer to existing
+// column blocks, and their values lie within the values array of the
+// matrix.
+bool CellsAreInRange(const CompressedRowBlockStructure& bs) {
+  const int num_col_blocks = bs.cols.size();
+  int64 num_nonzeros = 0;
+  for (int i = 0; i < bs.rows.size(); ++i) {
+    const vector<Cell>& cells = bs.rows[i].cells;
+    for (int j = 0; j < cells.size(); ++j) {
+      if (cells[j].block_id < 0 || cells[j].block_id >= num_col_blocks) {
+        LOG(ERROR) << "Corrupt linear least squares problem file.";
+        return false;
+      }
+      num_nonzeros += static_cast<int64>(bs.rows[i].block.size) *
+          bs.cols[cells[j].block_id].size;
+    }
+  }
+
+  for (int i = 0; i < bs.rows.size(); ++i) {
+    const vector<Cell>& cells = bs.rows[i].cells;
+    for (int j = 0; j < cells.size(); ++j) {
+      const int64 cell_size = static_cast<int64>(bs.rows[i].block.size) *
+          bs.cols[cells[j].block_id].size;
+      if (cells[j].position < 0 ||
+          cells[j].position + cell_size > num_nonzeros) {
+        LOG(ERROR) << "Corrupt linear least squares problem file.";
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+BlockSparseMatrix* ReadBlockSparseMatrix(FILE* file,
+                                         int64 num_bytes,
+                                         int64* num_ints) {
+  scoped_ptr<CompressedRowBlockStructure> bs(new CompressedRowBlockStructure);
+  int num_col_blocks;
+  if (!ReadLsqpInts(file, 1, &num_col_blocks) ||
+      !PayloadCanHold(num_bytes, num_col_blocks, 2)) {
+    return NULL;
+  }
+  bs->cols.resize(num_col_blocks);
+  for (int i = 0; i < num_col_blocks; ++i) {
+    int block[2];
+    if (!ReadLsqpInts(file, 2, block)) {
+      return NULL;
+    }
+    bs->cols[i].size = block[0];
+    bs->cols[i].position = block[1];
+  }
+  *num_ints += 1 + 2 * num_col_blocks;
+
+  int num_row_blocks;
+  if (!ReadLsqpInts(file, 1, &num_row_blocks) ||
+      !PayloadCanHold(num_bytes, num_row_blocks, 3)) {
+    return NULL;
+  }
+  bs->rows.resize(num_row_blocks);
+  for (int i = 0; i < num_row_blocks; ++i) {
+    int row[3];
+    if (!ReadLsqpInts(file, 3, row) ||
+        !PayloadCanHold(num_bytes, row[2], 2)) {
+      return NULL;
+    }
+    CompressedRow& compressed_row = bs->rows[i];
+    compressed_row.block.size = row[0];
+    compressed_row.block.position = row[1];
+    compressed_row.cells.resize(row[2]);
+    for (int j = 0; j < row[2]; ++j) {
+      int cell[2];
+      if (!ReadLsqpInts(file, 2, cell)) {
+        return NULL;
+      }
+      compressed_row.cells[j].block_id = cell[0];
+      compressed_row.cells[j].position = cell[1];
+    }
+    *num_ints += 3 + 2 * row[2];
+  }
+  *num_ints += 1;
+
+  vector<Block> row_blocks(num_row_blocks);
+  for (int i = 0; i < num_row_blocks; ++i) {
+    row_blocks[i] = bs->rows[i].block;
+  }
+  if (!BlocksAreContiguous(bs->cols) ||
+      !BlocksAreContiguous(row_blocks) ||
+      !CellsAreInRange(*bs)) {
+    return NULL;
+  }
+  return new BlockSparseMatrix(bs.release());
+}
+
+CompressedRowSparseMatrix* ReadCompressedRowSparseMatrix(FILE* file,
+                                                         int64 num_bytes,
+                                                         int num_rows,
+                                                         int num_cols,
+                                                         int num_nonzeros,
+                                                         int64* num_ints) {
+  if (!PayloadCanHold(num_bytes, num_rows + 1, 1) ||
+      !PayloadCanHold(num_bytes, num_nonzeros, 1)) {
+    return NULL;
+  }
+  scoped_ptr<CompressedRowSparseMatrix> A(
+      new CompressedRowSparseMatrix(num_rows, num_cols, num_nonzeros));
+  if (!ReadLsqpInts(file, num_rows + 1, A->mutable_rows()) ||
+      !ReadLsqpInts(file, num_nonzeros, A->mutable_cols()) ||
+      !IndicesAreInRange(A->cols(), num_nonzeros, num_cols)) {
+    return NULL;
+  }
+  *num_ints += num_rows + 1 + num_nonzeros;
+
+  const int* rows = A->rows();
+  if (rows[0] != 0 || rows[num_rows] != num_nonzeros) {
+    LOG(ERROR) << "Corrupt linear least squares problem file.";
+    return NULL;
+  }
+  for (int i = 0; i < num_rows; ++i) {
+    if (rows[i] > rows[i + 1]) {
+      LOG(ERROR) << "Corrupt linear least squares problem file.";
+      return NULL;
+    }
+  }
+
+  vector<int>* blocks[2] = { A->mutable_row_blocks(), A->mutable_col_blocks() };
+  for (int i = 0; i < 2; ++i) {
+    int num_blocks;
+    if (!ReadLsqpInts(file, 1, &num_blocks) ||
+        !PayloadCanHold(num_bytes, num_blocks, 1)) {
+      return NULL;
+    }
+    blocks[i]->resize(num_blocks);
+    if (num_blocks > 0 && !ReadLsqpInts(file, num_blocks, &(*blocks[i])[0])) {
+      return NULL;
+    }
+    *num_ints += 1 + num_blocks;
+
+    // The blocks are optional, but if present they must partition
+    // the rows (columns) of the matrix.
+    const int size = (i == 0) ? num_rows : num_cols;
+    int total = 0;
+    for (int j = 0; j < num_blocks; ++j) {
+      if ((*blocks[i])[j] <= 0 || (*blocks[i])[j] > size - total) {
+        LOG(ERROR) << "Corrupt linear least squares problem file.";
+        return NULL;
+      }
+      total += (*blocks[i])[j];
+    }
+    if (num_blocks > 0 && total != size) {
+      LOG(ERROR) << "Corrupt linear least squares problem file.";
+      return NULL;
+    }
+  }
+  return A.release();
+}
+
+TripletSparseMatrix* ReadTripletSparseMatrix(FILE* file,
+                                             int64 num_bytes,
+                                             int num_rows,
+                                             int num_cols,
+                                             int num_nonzeros,
+                                             int64* num_ints) {
+  if (!PayloadCanHold(num_bytes, num_nonzeros, 2)) {
+    return NULL;
+  }
+  scoped_ptr<TripletSparseMatrix> A(
+      new TripletSparseMatrix(num_rows, num_cols, num_nonzeros));
+  if (!ReadLsqpInts(file, num_nonzeros, A->mutable_rows()) ||
+      !ReadLsqpInts(file, num_nonzeros, A->mutable_cols()) ||
+      !IndicesAreInRange(A->rows(), num_nonzeros, num_rows) ||
+      !IndicesAreInRange(A->cols(), num_nonzeros, num_cols)) {
+    return NULL;
+  }
+  A->set_num_nonzeros(num_nonzeros);
+  *num_ints += 2 * static_cast<int64>(num_nonzeros);
+  return A.release();
+}
+
+// Read the chunk describing the sparsity structure of A. The values
+// of the returned matrix are filled in by the LSQP_A_VALUES chunks
+// that follow it.
+SparseMatrix* ReadSparseMatrix(FILE* file, int type, int64 num_bytes) {
+  int header[3];
+  if (!PayloadCanHold(num_bytes, 1, 3) ||
+      !ReadLsqpInts(file, 3, header)) {
+    return NULL;
+  }
+
+  const int num_rows = header[0];
+  const int num_cols = header[1];
+  const int num_nonzeros = header[2];
+  if (num_rows < 0 || num_cols < 0 || num_nonzeros < 0) {
+    LOG(ERROR) << "Corrupt linear least squares problem file.";
+    return NULL;
+  }
+
+  int64 num_ints = 3;
+  scoped_ptr<SparseMatrix> A;
+  switch (type) {
+    case LSQP_BLOCK_SPARSE_MATRIX:
+      A.reset(ReadBlockSparseMatrix(file, num_bytes, &num_ints));
+      break;
+    case LSQP_COMPRESSED_ROW_SPARSE_MATRIX:
+      A.reset(ReadCompressedRowSparseMatrix(file,
+                                            num_bytes,
+                                            num_rows,
+                                            num_cols,
+                                            num_nonzeros,
+                                            &num_ints));
+      break;
+    case LSQP_TRIPLET_SPARSE_MATRIX:
+      A.reset(ReadTripletSparseMatrix(file,
+                                      num_bytes,
+                                      num_rows,
+                                      num_cols,
+                                      num_nonzeros,
+                                      &num_ints));
+      break;
+    case LSQP_DENSE_SPARSE_MATRIX:
+      A.reset(new DenseSparseMatrix(num_rows, num_cols));
+      break;
+    default:
+      LOG(FATAL) << "Unknown matrix chunk type: " << type;
+  }
+
+  if (A.get() == NULL) {
+    return NULL;
+  }
+
+  if (num_ints * sizeof(int) != num_bytes ||
+      A->num_rows() != num_rows ||
+      A->num_cols() != num_cols ||
+      A->num_nonzeros() != num_nonzeros) {
+    LOG(ERROR) << "Corrupt linear least squares problem file.";
+    return NULL;
+  }
+  return A.release();
+}
+
+// Read a chunk of doubles into the array values of the given size,
+// starting at *offset, allocating it if needed.
+bool ReadDoubleChunk(FILE* file,
+                     int64 num_bytes,
+                     int size,
+                     scoped_array<double>* values,
+                     int* offset) {
+  const int64 chunk_size = num_bytes / sizeof(double);
+  if (chunk_size * sizeof(double) != num_bytes ||
+      chunk_size > size - *offset) {
+    LOG(ERROR) << "Corrupt linear least squares problem file.";
+    return false;
+  }
+
+  if (values->get() == NULL) {
+    values->reset(new double[size]);
+  }
+
+  if (!ReadLsqpDoubles(file, chunk_size, values->get() + *offset)) {
+    return false;
+  }
+  *offset += chunk_size;
+  return true;
+}
+
+bool ReadLinearLeastSquaresProblemFromBinaryFile(
+    FILE* file,
+    LinearLeastSquaresProblem* problem,
+    LsqpChunkType* matrix_type) {
+  if (!ReadLsqpFileHeader(file)) {
+    return false;
+  }
+
+  scoped_array<double> x;
+  int a_offset = 0;
+  int d_offset = 0;
+  int b_offset = 0;
+  int x_offset = 0;
+  while (true) {
+    int type;
+    int64 num_bytes;
+    if (!ReadLsqpChunkHeader(file, &type, &num_bytes)) {
+      return false;
+    }
+
+    if (type == LSQP_END) {
+      break;
+    }
+
+    if (type == LSQP_PROBLEM) {
+      if (!PayloadCanHold(num_bytes, 1, 1) ||
+          !ReadLsqpInts(file, 1, &problem->num_eliminate_blocks) ||
+          !SkipLsqpPayload(file, num_bytes - sizeof(int))) {
+        return false;
+      }
+      continue;
+    }
+
+    // The remaining chunks describe A, or are arrays whose sizes
+    // depend on the dimensions of A.
+    const bool is_matrix_chunk =
+        (type == LSQP_BLOCK_SPARSE_MATRIX ||
+         type == LSQP_COMPRESSED_ROW_SPARSE_MATRIX ||
+         type == LSQP_TRIPLET_SPARSE_MATRIX ||
+         type == LSQP_DENSE_SPARSE_MATRIX);
+    const bool is_array_chunk =
+        (type == LSQP_A_VALUES ||
+         type == LSQP_D ||
+         type == LSQP_B ||
+         type == LSQP_X);
+
+    if (!is_matrix_chunk && !is_array_chunk) {
+      VLOG(1) << "Skipping unknown chunk of type " << type;
+      if (!SkipLsqpPayload(file, num_bytes)) {
+        return false;
+      }
+      continue;
+    }
+
+    if (is_matrix_chunk) {
+      if (problem->A.get() != NULL) {
+        LOG(ERROR) << "The linear least squares problem file describes "
+                   << "more than one matrix.";
+        return false;
+      }
+      problem->A.reset(ReadSparseMatrix(file, type, num_bytes));
+      if (problem->A.get() == NULL) {
+        return false;
+      }
+      if (matrix_type != NULL) {
+        *matrix_type = static_cast<LsqpChunkType>(type);
+      }
+      continue;
+    }
+
+    if (problem->A.get() == NULL) {
+      LOG(ERROR) << "The matrix in a linear least squares problem file "
+                 << "must be described before the arrays.";
+      return false;
+    }
+
+    const SparseMatrix& A = *problem->A;
+    bool ok = true;
+    switch (type) {
+      case LSQP_A_VALUES: {
+        // The values are read directly into the matrix.
+        const int64 chunk_size = num_bytes / sizeof(double);
+        ok = (chunk_size * sizeof(double) == num_bytes &&
+              chunk_size <= A.num_nonzeros() - a_offset &&
+              ReadLsqpDoubles(file,
+                              chunk_size,
+                              problem->A->mutable_values() + a_offset));
+        a_offset += chunk_size;
+        break;
+      }
+      case LSQP_D:
+        ok = ReadDoubleChunk(file, num_bytes, A.num_cols(),
+                             &problem->D, &d_offset);
+        break;
+      case LSQP_B:
+        ok = ReadDoubleChunk(file, num_bytes, A.num_rows(),
+                             &problem->b, &b_offset);
+        break;
+      case LSQP_X:
+        ok = ReadDoubleChunk(file, num_bytes, A.num_cols(), &x, &x_offset);
+        break;
+    }
+
+    if (!ok) {
+      LOG(ERROR) << "Corrupt linear least squares problem file.";
+      return false;
+    }
+  }
+
+  if (problem->A.get() == NULL ||
+      a_offset != problem->A->num_nonzeros() ||
+      (problem->D.get() != NULL && d_offset != problem->A->num_cols()) ||
+      (problem->b.get() != NULL && b_offset != problem->A->num_rows()) ||
+      (x.get() != NULL && x_offset != problem->A->num_cols())) {
+    LOG(ERROR) << "Truncated linear least squares problem file.";
+    return false;
+  }
+
+  // As with the protocol buffer format, the solution is the solution
+  // of the regularized problem if D is present.
+  if (problem->D.get() != NULL) {
+    problem->x_D.reset(x.release());
+  } else {
+    problem->x.reset(x.release());
+  }
+  return true;
+}
+
+}  // namespace
+
+LinearLeastSquaresProblem* CreateLinearLeastSquaresProblemFromBinaryFile(
+    const string& filename,
+    LsqpChunkType* matrix_type) {
+  FILE* file = fopen(filename.c_str(), "rb");
+  if (file == NULL) {
+    LOG(ERROR) << "Unable to open linear least squares problem file: "
+               << filename;
+    return NULL;
+  }
+
+  scoped_ptr<LinearLeastSquaresProblem> problem(new LinearLeastSquaresProblem);
+  const bool ok = ReadLinearLeastSquaresProblemFromBinaryFile(file,
+                                                              problem.get(),
+                                                              matrix_type);
+  fclose(file);
+  if (!ok) {
+    LOG(ERROR) << "Unable to read linear least squares problem file: "
+               << filename;
+    return NULL;
+  }
+  return problem.release();
+}
+
 /*
 A = [1   2]
     [3   4]
@@ -656,6 +1115,50 @@ bool DumpLinearLeastSquaresProblemToProtocolBuffer(const string& directory,
 }
 #endif
 
+bool DumpLinearLeastSquaresProblemToBinaryFile(const string& directory,
+                                               int iteration,
+                                               const SparseMatrix* A,
+                                               const double* D,
+                                               const double* b,
+                                               const double* x,
+                                               int num_eliminate_blocks) {
+  CHECK_NOTNULL(A);
+  string format_string = JoinPath(directory,
+                                  "lm_iteration_%03d.lsqp.bin");
+  string filename =
+      StringPrintf(format_string.c_str(),  iteration);
+  LOG(INFO) << "Dumping least squares problem for iteration " << iteration
+            << " to disk. File: " << filename;
+
+  FILE* file = fopen(filename.c_str(), "wb");
+  if (file == NULL) {
+    LOG(ERROR) << "Unable to open " << filename << " for writing.";
+    return false;
+  }
+
+  WriteLsqpFileHeader(file);
+  WriteLsqpChunkHeader(file, LSQP_PROBLEM, sizeof(num_eliminate_blocks));
+  WriteLsqpInts(file, &num_eliminate_blocks, 1);
+  A->ToBinaryFile(file);
+  if (D != NULL) {
+    WriteLsqpDoubleChunks(file, LSQP_D, D, A->num_cols());
+  }
+  if (b != NULL) {
+    WriteLsqpDoubleChunks(file, LSQP_B, b, A->num_rows());
+  }
+  if (x != NULL) {
+    WriteLsqpDoubleChunks(file, LSQP_X, x, A->num_cols());
+  }
+  WriteLsqpChunkHeader(file, LSQP_END, 0);
+
+  const bool write_failed = ferror(file);
+  if (fclose(file) != 0 || write_failed) {
+    LOG(ERROR) << "Error writing " << filename;
+    return false;
+  }
+  return true;
+}
+
 void WriteArrayToFileOrDie(const string& filename,
                            const double* x,
                            const int size) {
@@ -760,6 +1263,11 @@ bool DumpLinearLeastSquaresProblem(const string& directory,
                                                      iteration,
                                                      A, D, b, x,
                                                      num_eliminate_blocks);
+    case BINARY:
+      return DumpLinearLeastSquaresProblemToBinaryFile(directory,
+                                                       iteration,
+                                                       A, D, b, x,
+                                                       num_eliminate_blocks);
     default:
       LOG(FATAL) << "Unknown DumpFormatType " << dump_format_type;
   };
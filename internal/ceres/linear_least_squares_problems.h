@@ -33,6 +33,7 @@
 
 #include <string>
 #include <vector>
+#include "ceres/lsqp_binary_file.h"
 #include "ceres/sparse_matrix.h"
 #include "ceres/internal/port.h"
 #include "ceres/internal/scoped_ptr.h"
@@ -66,6 +67,15 @@ LinearLeastSquaresProblem* CreateLinearLeastSquaresProblemFromId(int id);
 LinearLeastSquaresProblem* CreateLinearLeastSquaresProblemFromFile(
     const string& filename);
 
+// Load a linear least squares problem written by
+// DumpLinearLeastSquaresProblem using the BINARY format. Returns NULL
+// if the file cannot be read. If matrix_type is not NULL, it is set
+// to the chunk type describing the matrix A, which identifies the
+// kind of SparseMatrix that A is.
+LinearLeastSquaresProblem* CreateLinearLeastSquaresProblemFromBinaryFile(
+    const string& filename,
+    LsqpChunkType* matrix_type);
+
 LinearLeastSquaresProblem* LinearLeastSquaresProblem0();
 LinearLeastSquaresProblem* LinearLeastSquaresProblem1();
 LinearLeastSquaresProblem* LinearLeastSquaresProblem2();
@@ -50,6 +50,7 @@ namespace ceres {
 namespace internal {
 
 class LinearOperator;
+class SchurStructureCache;
 
 // Abstract base class for objects that implement algorithms for
 // solving linear systems
@@ -75,13 +76,19 @@ class LinearSolver {
           preconditioner_type(JACOBI),
           sparse_linear_algebra_library(SUITE_SPARSE),
           use_block_amd(true),
+          use_nested_dissection_ordering(false),
+          use_mixed_precision_solves(false),
+          max_num_refinement_iterations(10),
+          max_schur_products_memory_in_mb(1024),
+          use_single_precision_jacobian(false),
           min_num_iterations(1),
           max_num_iterations(1),
           num_threads(1),
           residual_reset_period(10),
           row_block_size(Eigen::Dynamic),
           e_block_size(Eigen::Dynamic),
-          f_block_size(Eigen::Dynamic) {
+          f_block_size(Eigen::Dynamic),
+          schur_structure_cache(NULL) {
     }
 
     LinearSolverType type;
@@ -90,8 +97,19 @@ class LinearSolver {
 
     SparseLinearAlgebraLibraryType sparse_linear_algebra_library;
 
-    // See solver.h for explanation of this option.
+    // See solver.h for explanation of these options.
     bool use_block_amd;
+    bool use_nested_dissection_ordering;
+
+    // See solver.h for explanation of these options.
+    bool use_mixed_precision_solves;
+    int max_num_refinement_iterations;
+
+    // See solver.h for explanation of this option.
+    int max_schur_products_memory_in_mb;
+
+    // See solver.h for explanation of this option.
+    bool use_single_precision_jacobian;
 
     // Number of internal iterations that the solver uses. This
     // parameter only makes sense for iterative solvers like CG.
@@ -138,12 +156,20 @@ class LinearSolver {
     int row_block_size;
     int e_block_size;
     int f_block_size;
+
+    // If not NULL, Schur type solvers and their preconditioners look
+    // up the symbolic state derived from the block structure of the
+    // linear system (eliminators, clusterings, sparsity patterns) in
+    // this cache instead of recomputing it. The solver does not take
+    // ownership of the cache.
+    SchurStructureCache* schur_structure_cache;
   };
 
   // Options for the Solve method.
   struct PerSolveOptions {
     PerSolveOptions()
         : D(NULL),
+          A_and_b_are_unchanged(false),
           preconditioner(NULL),
           r_tolerance(0.0),
           q_tolerance(0.0) {
@@ -174,6 +200,15 @@ class LinearSolver {
     // size n.  b is an array of size m and x is an array of size n.
     double * D;
 
+    // If true, the caller guarantees that A and b have the same
+    // values as in the previous call to Solve, and only D has
+    // changed. This is the case when a Levenberg-Marquardt step is
+    // rejected and the step is recomputed with a larger
+    // regularization. Solvers which form products of A and b that do
+    // not depend on D can then reuse them instead of recomputing
+    // them. Solvers which do not cache anything ignore this option.
+    bool A_and_b_are_unchanged;
+
     // This option only makes sense for iterative solvers.
     //
     // In general the performance of an iterative linear solver
@@ -34,8 +34,31 @@
 
 #include <cmath>
 #include <cstddef>
+#include "Eigen/Core"
 
 namespace ceres {
+namespace {
+
+// The batched evaluations below are written in terms of Eigen arrays,
+// which vectorizes the arithmetic and sqrt.
+typedef Eigen::Map<Eigen::ArrayXd> ArrayRef;
+typedef Eigen::Map<const Eigen::ArrayXd> ConstArrayRef;
+
+}  // namespace
+
+void LossFunction::EvaluateBatch(int num_sq_norms,
+                                 const double* sq_norms,
+                                 double* rho0,
+                                 double* rho1,
+                                 double* rho2) const {
+  double rho[3];
+  for (int i = 0; i < num_sq_norms; ++i) {
+    Evaluate(sq_norms[i], rho);
+    rho0[i] = rho[0];
+    rho1[i] = rho[1];
+    rho2[i] = rho[2];
+  }
+}
 
 void TrivialLoss::Evaluate(double s, double rho[3]) const {
   rho[0] = s;
@@ -43,6 +66,16 @@ void TrivialLoss::Evaluate(double s, double rho[3]) const {
   rho[2] = 0;
 }
 
+void TrivialLoss::EvaluateBatch(int n,
+                                const double* s,
+                                double* rho0,
+                                double* rho1,
+                                double* rho2) const {
+  ArrayRef(rho0, n) = ConstArrayRef(s, n);
+  ArrayRef(rho1, n).setOnes();
+  ArrayRef(rho2, n).setZero();
+}
+
 void HuberLoss::Evaluate(double s, double rho[3]) const {
   if (s > b_) {
     // Outlier region.
@@ -59,6 +92,24 @@ void HuberLoss::Evaluate(double s, double rho[3]) const {
   }
 }
 
+void HuberLoss::EvaluateBatch(int n,
+                              const double* sq_norms,
+                              double* rho0,
+                              double* rho1,
+                              double* rho2) const {
+  ConstArrayRef s(sq_norms, n);
+  ArrayRef r0(rho0, n);
+  ArrayRef r1(rho1, n);
+  ArrayRef r2(rho2, n);
+  // Evaluate both regions and select, which avoids branching on each
+  // residual. The values computed for the other region, including
+  // the infinities at s = 0, are discarded.
+  r2 = s.sqrt();
+  r1 = (s > b_).select(a_ / r2, 1.0);
+  r0 = (s > b_).select(2 * a_ * r2 - b_, s);
+  r2 = (s > b_).select(-r1 / (2 * s), 0.0);
+}
+
 void SoftLOneLoss::Evaluate(double s, double rho[3]) const {
   const double sum = 1 + s * c_;
   const double tmp = sqrt(sum);
@@ -68,6 +119,23 @@ void SoftLOneLoss::Evaluate(double s, double rho[3]) const {
   rho[2] = - (c_ * rho[1]) / (2 * sum);
 }
 
+void SoftLOneLoss::EvaluateBatch(int n,
+                                 const double* sq_norms,
+                                 double* rho0,
+                                 double* rho1,
+                                 double* rho2) const {
+  ConstArrayRef s(sq_norms, n);
+  ArrayRef r0(rho0, n);
+  ArrayRef r1(rho1, n);
+  ArrayRef r2(rho2, n);
+  // r2 holds sum and r1 holds tmp until they are overwritten.
+  r2 = 1 + s * c_;
+  r1 = r2.sqrt();
+  r0 = 2 * b_ * (r1 - 1);
+  r1 = r1.inverse();
+  r2 = -(c_ * r1) / (2 * r2);
+}
+
 void CauchyLoss::Evaluate(double s, double rho[3]) const {
   const double sum = 1 + s * c_;
   const double inv = 1 / sum;
@@ -77,6 +145,25 @@ void CauchyLoss::Evaluate(double s, double rho[3]) const {
   rho[2] = - c_ * (inv * inv);
 }
 
+void CauchyLoss::EvaluateBatch(int n,
+                               const double* sq_norms,
+                               double* rho0,
+                               double* rho1,
+                               double* rho2) const {
+  ConstArrayRef s(sq_norms, n);
+  ArrayRef r1(rho1, n);
+  ArrayRef r2(rho2, n);
+  // r2 holds sum until it is overwritten. The vectorized log is
+  // slower than the one in libm, so it is computed one value at a
+  // time.
+  r2 = 1 + s * c_;
+  for (int i = 0; i < n; ++i) {
+    rho0[i] = b_ * log(rho2[i]);
+  }
+  r1 = r2.inverse();
+  r2 = -c_ * r1.square();
+}
+
 void ArctanLoss::Evaluate(double s, double rho[3]) const {
   const double sum = 1 + s * s * b_;
   const double inv = 1 / sum;
@@ -86,6 +173,22 @@ void ArctanLoss::Evaluate(double s, double rho[3]) const {
   rho[2] = -2 * s * b_ * (inv * inv);
 }
 
+void ArctanLoss::EvaluateBatch(int n,
+                               const double* sq_norms,
+                               double* rho0,
+                               double* rho1,
+                               double* rho2) const {
+  ConstArrayRef s(sq_norms, n);
+  ArrayRef r1(rho1, n);
+  ArrayRef r2(rho2, n);
+  // atan2 is not vectorized, but the loop is free of virtual calls.
+  for (int i = 0; i < n; ++i) {
+    rho0[i] = a_ * atan2(sq_norms[i], a_);
+  }
+  r1 = (1 + s * s * b_).inverse();
+  r2 = -2 * s * b_ * r1.square();
+}
+
 TolerantLoss::TolerantLoss(double a, double b)
     : a_(a),
       b_(b),
@@ -154,4 +257,21 @@ void ScaledLoss::Evaluate(double s, double rho[3]) const {
   }
 }
 
+void ScaledLoss::EvaluateBatch(int n,
+                               const double* sq_norms,
+                               double* rho0,
+                               double* rho1,
+                               double* rho2) const {
+  if (rho_.get() == NULL) {
+    ArrayRef(rho0, n) = a_ * ConstArrayRef(sq_norms, n);
+    ArrayRef(rho1, n).setConstant(a_);
+    ArrayRef(rho2, n).setZero();
+  } else {
+    rho_->EvaluateBatch(n, sq_norms, rho0, rho1, rho2);
+    ArrayRef(rho0, n) *= a_;
+    ArrayRef(rho1, n) *= a_;
+    ArrayRef(rho2, n) *= a_;
+  }
+}
+
 }  // namespace ceres
@@ -30,7 +30,10 @@
 
 #include "ceres/loss_function.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
+#include <vector>
 
 #include "glog/logging.h"
 #include "gtest/gtest.h"
@@ -69,6 +72,30 @@ void AssertLossFunctionIsValid(const LossFunction& loss, double s) {
   const double fd_2 = (fwd[0] - 2*rho[0] + bwd[0]) / (kH * kH);
   ASSERT_NEAR(fd_2, rho[2], 1e-6);
 }
+
+// Compares LossFunction::EvaluateBatch with LossFunction::Evaluate on
+// a range of squared norms, including zero.
+void ExpectBatchEvaluationMatchesEvaluation(const LossFunction& loss) {
+  const int kNumSqNorms = 37;
+  vector<double> sq_norms(kNumSqNorms);
+  for (int i = 0; i < kNumSqNorms; ++i) {
+    sq_norms[i] = 0.1 * i * i;
+  }
+
+  vector<double> rho0(kNumSqNorms);
+  vector<double> rho1(kNumSqNorms);
+  vector<double> rho2(kNumSqNorms);
+  loss.EvaluateBatch(kNumSqNorms, &sq_norms[0], &rho0[0], &rho1[0], &rho2[0]);
+
+  for (int i = 0; i < kNumSqNorms; ++i) {
+    double rho[3];
+    loss.Evaluate(sq_norms[i], rho);
+    EXPECT_NEAR(rho0[i], rho[0], 1e-14 * std::max(1.0, std::abs(rho[0])));
+    EXPECT_NEAR(rho1[i], rho[1], 1e-14 * std::max(1.0, std::abs(rho[1])));
+    EXPECT_NEAR(rho2[i], rho[2], 1e-14 * std::max(1.0, std::abs(rho[2])));
+  }
+}
+
 }  // namespace
 
 // Try two values of the scaling a = 0.7 and 1.3
@@ -223,5 +250,38 @@ TEST(LossFunction, LossFunctionWrapper) {
   }
 }
 
+TEST(LossFunction, EvaluateBatch) {
+  ExpectBatchEvaluationMatchesEvaluation(TrivialLoss());
+  ExpectBatchEvaluationMatchesEvaluation(HuberLoss(0.7));
+  ExpectBatchEvaluationMatchesEvaluation(HuberLoss(1.3));
+  ExpectBatchEvaluationMatchesEvaluation(SoftLOneLoss(0.7));
+  ExpectBatchEvaluationMatchesEvaluation(SoftLOneLoss(1.3));
+  ExpectBatchEvaluationMatchesEvaluation(CauchyLoss(0.7));
+  ExpectBatchEvaluationMatchesEvaluation(CauchyLoss(1.3));
+  ExpectBatchEvaluationMatchesEvaluation(ArctanLoss(0.7));
+  ExpectBatchEvaluationMatchesEvaluation(ArctanLoss(1.3));
+  // TolerantLoss and ComposedLoss use the default implementation.
+  ExpectBatchEvaluationMatchesEvaluation(TolerantLoss(0.7, 0.4));
+  {
+    HuberLoss f(0.7);
+    CauchyLoss g(1.3);
+    ComposedLoss c(&f, DO_NOT_TAKE_OWNERSHIP, &g, DO_NOT_TAKE_OWNERSHIP);
+    ExpectBatchEvaluationMatchesEvaluation(c);
+  }
+  {
+    ScaledLoss scaled_loss(NULL, 6, TAKE_OWNERSHIP);
+    ExpectBatchEvaluationMatchesEvaluation(scaled_loss);
+  }
+  {
+    ScaledLoss scaled_loss(new CauchyLoss(1.3), 10, TAKE_OWNERSHIP);
+    ExpectBatchEvaluationMatchesEvaluation(scaled_loss);
+  }
+  {
+    LossFunctionWrapper loss_function_wrapper(new SoftLOneLoss(0.5),
+                                              TAKE_OWNERSHIP);
+    ExpectBatchEvaluationMatchesEvaluation(loss_function_wrapper);
+  }
+}
+
 }  // namespace internal
 }  // namespace ceres
@@ -30,16 +30,20 @@
 
 #include "ceres/internal/eigen.h"
 #include "ceres/low_rank_inverse_hessian.h"
+#include "ceres/parallel_vector_ops.h"
 #include "glog/logging.h"
 
 namespace ceres {
 namespace internal {
 
 LowRankInverseHessian::LowRankInverseHessian(int num_parameters,
-                                             int max_num_corrections)
+                                             int max_num_corrections,
+                                             int num_threads)
     : num_parameters_(num_parameters),
       max_num_corrections_(max_num_corrections),
+      num_threads_(num_threads),
       num_corrections_(0),
+      oldest_correction_(0),
       diagonal_(1.0),
       delta_x_history_(num_parameters, max_num_corrections),
       delta_gradient_history_(num_parameters, max_num_corrections),
@@ -48,60 +52,104 @@ LowRankInverseHessian::LowRankInverseHessian(int num_parameters,
 
 bool LowRankInverseHessian::Update(const Vector& delta_x,
                                    const Vector& delta_gradient) {
-  const double delta_x_dot_delta_gradient = delta_x.dot(delta_gradient);
+  double delta_x_dot_delta_gradient;
+  double delta_gradient_squared_norm;
+  ParallelDotAndSquaredNorm(num_parameters_,
+                            delta_x.data(),
+                            delta_gradient.data(),
+                            num_threads_,
+                            &delta_x_dot_delta_gradient,
+                            &delta_gradient_squared_norm);
   if (delta_x_dot_delta_gradient <= 1e-10) {
     VLOG(2) << "Skipping LBFGS Update. " << delta_x_dot_delta_gradient;
     return false;
   }
 
+  // Overwrite the oldest correction if the buffer is full.
   if (num_corrections_ == max_num_corrections_) {
-    // TODO(sameeragarwal): This can be done more efficiently using
-    // a circular buffer/indexing scheme, but for simplicity we will
-    // do the expensive copy for now.
-    delta_x_history_.block(0, 0, num_parameters_, max_num_corrections_ - 2) =
-        delta_x_history_
-        .block(0, 1, num_parameters_, max_num_corrections_ - 1);
-
-    delta_gradient_history_
-        .block(0, 0, num_parameters_, max_num_corrections_ - 2) =
-        delta_gradient_history_
-        .block(0, 1, num_parameters_, max_num_corrections_ - 1);
-
-    delta_x_dot_delta_gradient_.head(num_corrections_ - 2) =
-        delta_x_dot_delta_gradient_.tail(num_corrections_ - 1);
+    oldest_correction_ = Column(1);
   } else {
     ++num_corrections_;
   }
 
-  delta_x_history_.col(num_corrections_ - 1) = delta_x;
-  delta_gradient_history_.col(num_corrections_ - 1) = delta_gradient;
-  delta_x_dot_delta_gradient_(num_corrections_ - 1) =
-      delta_x_dot_delta_gradient;
-  diagonal_ = delta_x_dot_delta_gradient / delta_gradient.squaredNorm();
+  const int column = Column(num_corrections_ - 1);
+  ParallelLinearCombination(num_parameters_,
+                            1.0, delta_x.data(),
+                            0.0, delta_x.data(),
+                            delta_x_history_.col(column).data(),
+                            num_threads_);
+  ParallelLinearCombination(num_parameters_,
+                            1.0, delta_gradient.data(),
+                            0.0, delta_gradient.data(),
+                            delta_gradient_history_.col(column).data(),
+                            num_threads_);
+  delta_x_dot_delta_gradient_(column) = delta_x_dot_delta_gradient;
+  diagonal_ = delta_x_dot_delta_gradient / delta_gradient_squared_norm;
   return true;
 }
 
 void LowRankInverseHessian::RightMultiply(const double* x_ptr,
                                           double* y_ptr) const {
-  ConstVectorRef gradient(x_ptr, num_parameters_);
-  VectorRef search_direction(y_ptr, num_parameters_);
-
-  search_direction = gradient;
+  const int n = num_parameters_;
+  if (num_corrections_ == 0) {
+    ParallelLinearCombination(n, diagonal_, x_ptr, 0.0, x_ptr, y_ptr,
+                              num_threads_);
+    return;
+  }
 
+  // Each step of the two loops below updates the search direction
+  // using one correction pair and computes the dot product needed by
+  // the next step in the same pass over memory.
   Vector alpha(num_corrections_);
 
+  // search_direction = gradient.
+  double dot = ParallelLinearCombinationDot(
+      n,
+      1.0, x_ptr,
+      0.0, x_ptr,
+      delta_x_history_.col(Column(num_corrections_ - 1)).data(),
+      y_ptr,
+      num_threads_);
+
   for (int i = num_corrections_ - 1; i >= 0; --i) {
-    alpha(i) = delta_x_history_.col(i).dot(search_direction) /
-        delta_x_dot_delta_gradient_(i);
-    search_direction -= alpha(i) * delta_gradient_history_.col(i);
+    const int column = Column(i);
+    alpha(i) = dot / delta_x_dot_delta_gradient_(column);
+    const double* delta_gradient = delta_gradient_history_.col(column).data();
+    if (i > 0) {
+      // search_direction -= alpha(i) * delta_gradient_history_(i).
+      dot = ParallelLinearCombinationDot(
+          n,
+          -alpha(i), delta_gradient,
+          1.0, y_ptr,
+          delta_x_history_.col(Column(i - 1)).data(),
+          y_ptr,
+          num_threads_);
+    } else {
+      // The last update of the first loop is combined with the
+      // scaling by diagonal_.
+      dot = ParallelLinearCombinationDot(
+          n,
+          -alpha(i) * diagonal_, delta_gradient,
+          diagonal_, y_ptr,
+          delta_gradient,
+          y_ptr,
+          num_threads_);
+    }
   }
 
-  search_direction *= diagonal_;
-
   for (int i = 0; i < num_corrections_; ++i) {
-    const double beta = delta_gradient_history_.col(i).dot(search_direction) /
-        delta_x_dot_delta_gradient_(i);
-    search_direction += delta_x_history_.col(i) * (alpha(i) - beta);
+    const int column = Column(i);
+    const double beta = dot / delta_x_dot_delta_gradient_(column);
+    // search_direction += delta_x_history_(i) * (alpha(i) - beta).
+    dot = ParallelLinearCombinationDot(
+        n,
+        alpha(i) - beta, delta_x_history_.col(column).data(),
+        1.0, y_ptr,
+        (i + 1 < num_corrections_)
+        ? delta_gradient_history_.col(Column(i + 1)).data()
+        : NULL,
+        y_ptr,
+        num_threads_);
   }
 }
 
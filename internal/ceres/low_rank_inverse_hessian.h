@@ -64,7 +64,12 @@ class LowRankInverseHessian : public LinearOperator {
   // The approximation uses:
   // 2 * max_num_corrections * num_parameters + max_num_corrections
   // doubles.
-  LowRankInverseHessian(int num_parameters, int max_num_corrections);
+  //
+  // num_threads is the number of threads used by the vector
+  // operations in Update and RightMultiply.
+  LowRankInverseHessian(int num_parameters,
+                        int max_num_corrections,
+                        int num_threads);
   virtual ~LowRankInverseHessian() {}
 
   // Update the low rank approximation. delta_x is the change in the
@@ -76,6 +81,11 @@ class LowRankInverseHessian : public LinearOperator {
   bool Update(const Vector& delta_x, const Vector& delta_gradient);
 
   // LinearOperator interface
+  //
+  // Unlike other LinearOperators, y is overwritten with the product
+  // instead of being incremented by it. The two loop recursion is
+  // fused so that each correction pair is read from memory once per
+  // loop.
   virtual void RightMultiply(const double* x, double* y) const;
   virtual void LeftMultiply(const double* x, double* y) const {
     RightMultiply(x, y);
@@ -84,12 +94,21 @@ class LowRankInverseHessian : public LinearOperator {
   virtual int num_cols() const { return num_parameters_; }
 
  private:
+  // The corrections are stored in a circular buffer. The i^th oldest
+  // correction is stored in column Column(i) of the history matrices.
+  int Column(int i) const {
+    return (oldest_correction_ + i) % max_num_corrections_;
+  }
+
   const int num_parameters_;
   const int max_num_corrections_;
+  const int num_threads_;
   int num_corrections_;
+  int oldest_correction_;
   double diagonal_;
-  Matrix delta_x_history_;
-  Matrix delta_gradient_history_;
+  // Column major, so that each correction is contiguous in memory.
+  ColMajorMatrix delta_x_history_;
+  ColMajorMatrix delta_gradient_history_;
   Vector delta_x_dot_delta_gradient_;
 };
 
@@ -0,0 +1,122 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "ceres/low_rank_inverse_hessian.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+#include "ceres/internal/eigen.h"
+#include "ceres/internal/port.h"
+#include "gtest/gtest.h"
+
+namespace ceres {
+namespace internal {
+
+// Dense version of the LBFGS inverse Hessian approximation using the
+// most recent max_num_corrections updates.
+Matrix DenseInverseHessian(const vector<Vector>& delta_x,
+                           const vector<Vector>& delta_gradient,
+                           const int max_num_corrections) {
+  const int num_parameters = delta_x[0].rows();
+  const int end = delta_x.size();
+  const int begin = std::max(0, end - max_num_corrections);
+  const Vector& s = delta_x[end - 1];
+  const Vector& y = delta_gradient[end - 1];
+  Matrix inverse_hessian =
+      Matrix::Identity(num_parameters, num_parameters) *
+      s.dot(y) / y.squaredNorm();
+
+  for (int i = begin; i < end; ++i) {
+    const double rho = 1.0 / delta_x[i].dot(delta_gradient[i]);
+    const Matrix v = Matrix::Identity(num_parameters, num_parameters) -
+        rho * delta_gradient[i] * delta_x[i].transpose();
+    inverse_hessian = v.transpose() * inverse_hessian * v +
+        rho * delta_x[i] * delta_x[i].transpose();
+  }
+  return inverse_hessian;
+}
+
+TEST(LowRankInverseHessian, MatchesDenseBFGSUpdates) {
+  srand(5);
+  const int kNumParameters = 10000;
+  const int kNumDenseParameters = 6;
+  const int kMaxNumCorrections = 3;
+
+  // Only the first kNumDenseParameters coordinates are non-zero, so
+  // that the dense reference stays small while the vectors are long
+  // enough to be split across threads.
+  LowRankInverseHessian inverse_hessian(kNumParameters,
+                                        kMaxNumCorrections,
+                                        4);
+  vector<Vector> delta_x;
+  vector<Vector> delta_gradient;
+  for (int k = 0; k < 2 * kMaxNumCorrections; ++k) {
+    Vector s = Vector::Zero(kNumParameters);
+    Vector y = Vector::Zero(kNumParameters);
+    s.head(kNumDenseParameters).setRandom();
+    y.head(kNumDenseParameters) =
+        s.head(kNumDenseParameters) +
+        0.1 * Vector::Random(kNumDenseParameters);
+    ASSERT_TRUE(inverse_hessian.Update(s, y));
+    delta_x.push_back(s.head(kNumDenseParameters));
+    delta_gradient.push_back(y.head(kNumDenseParameters));
+
+    const Matrix expected = DenseInverseHessian(delta_x,
+                                                delta_gradient,
+                                                kMaxNumCorrections);
+    Vector x = Vector::Zero(kNumParameters);
+    x.head(kNumDenseParameters).setRandom();
+    Vector y_out = Vector::Random(kNumParameters);
+    inverse_hessian.RightMultiply(x.data(), y_out.data());
+    EXPECT_NEAR((y_out.head(kNumDenseParameters) -
+                 expected * x.head(kNumDenseParameters)).norm(),
+                0.0,
+                1e-10);
+    EXPECT_EQ(y_out.tail(kNumParameters - kNumDenseParameters).norm(), 0.0);
+  }
+}
+
+TEST(LowRankInverseHessian, SkipsUpdatesWithNonPositiveCurvature) {
+  LowRankInverseHessian inverse_hessian(2, 2, 1);
+  Vector s(2);
+  Vector y(2);
+  s << 1.0, 0.0;
+  y << -1.0, 0.0;
+  EXPECT_FALSE(inverse_hessian.Update(s, y));
+
+  // With no corrections the approximation is the identity.
+  const double x[2] = {1.0, 2.0};
+  double product[2];
+  inverse_hessian.RightMultiply(x, product);
+  EXPECT_EQ(product[0], 1.0);
+  EXPECT_EQ(product[1], 2.0);
+}
+
+}  // namespace internal
+}  // namespace ceres
@@ -0,0 +1,161 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "ceres/lsqp_binary_file.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include "ceres/integral_types.h"
+#include "glog/logging.h"
+
+namespace ceres {
+namespace internal {
+namespace {
+
+const char kLsqpFileMagic[8] = { 'C', 'E', 'R', 'E', 'S', 'L', 'S', 'Q' };
+const int32 kLsqpByteOrderMark = 0x01020304;
+
+}  // namespace
+
+void WriteLsqpFileHeader(FILE* file) {
+  CHECK_NOTNULL(file);
+  const int32 header[2] = { kLsqpByteOrderMark, kLsqpFileVersion };
+  fwrite(kLsqpFileMagic, sizeof(kLsqpFileMagic), 1, file);
+  fwrite(header, sizeof(header[0]), 2, file);
+}
+
+void WriteLsqpChunkHeader(FILE* file, LsqpChunkType type, int64 num_bytes) {
+  CHECK_NOTNULL(file);
+  const int32 chunk_type = type;
+  fwrite(&chunk_type, sizeof(chunk_type), 1, file);
+  fwrite(&num_bytes, sizeof(num_bytes), 1, file);
+}
+
+void WriteLsqpInts(FILE* file, const int* values, int64 size) {
+  CHECK_NOTNULL(file);
+  if (size > 0) {
+    fwrite(CHECK_NOTNULL(values), sizeof(*values), size, file);
+  }
+}
+
+void WriteLsqpDoubleChunks(FILE* file,
+                           LsqpChunkType type,
+                           const double* values,
+                           int64 size) {
+  CHECK_NOTNULL(file);
+  for (int64 begin = 0; begin < size; begin += kLsqpMaxNumDoublesPerChunk) {
+    const int64 chunk_size = std::min(size - begin,
+                                      kLsqpMaxNumDoublesPerChunk);
+    WriteLsqpChunkHeader(file, type, chunk_size * sizeof(*values));
+    fwrite(values + begin, sizeof(*values), chunk_size, file);
+  }
+}
+
+bool ReadLsqpFileHeader(FILE* file) {
+  CHECK_NOTNULL(file);
+  char magic[sizeof(kLsqpFileMagic)];
+  int32 header[2];
+  if (fread(magic, sizeof(magic), 1, file) != 1 ||
+      memcmp(magic, kLsqpFileMagic, sizeof(magic)) != 0) {
+    LOG(ERROR) << "Not a linear least squares problem file.";
+    return false;
+  }
+
+  if (fread(header, sizeof(header[0]), 2, file) != 2) {
+    LOG(ERROR) << "Truncated linear least squares problem file.";
+    return false;
+  }
+
+  if (header[0] != kLsqpByteOrderMark) {
+    LOG(ERROR) << "The linear least squares problem file was written "
+               << "on a machine with a different byte order.";
+    return false;
+  }
+
+  if (header[1] > kLsqpFileVersion) {
+    LOG(ERROR) << "Unsupported linear least squares problem file version "
+               << header[1] << ". The newest supported version is "
+               << kLsqpFileVersion;
+    return false;
+  }
+  return true;
+}
+
+bool ReadLsqpChunkHeader(FILE* file, int* type, int64* num_bytes) {
+  CHECK_NOTNULL(file);
+  int32 chunk_type;
+  if (fread(&chunk_type, sizeof(chunk_type), 1, file) != 1 ||
+      fread(num_bytes, sizeof(*num_bytes), 1, file) != 1 ||
+      *num_bytes < 0) {
+    LOG(ERROR) << "Truncated linear least squares problem file.";
+    return false;
+  }
+  *type = chunk_type;
+  return true;
+}
+
+bool ReadLsqpInts(FILE* file, int64 size, int* values) {
+  CHECK_NOTNULL(file);
+  if (size > 0 &&
+      fread(CHECK_NOTNULL(values), sizeof(*values), size, file) != size) {
+    LOG(ERROR) << "Truncated linear least squares problem file.";
+    return false;
+  }
+  return true;
+}
+
+bool ReadLsqpDoubles(FILE* file, int64 size, double* values) {
+  CHECK_NOTNULL(file);
+  if (size > 0 &&
+      fread(CHECK_NOTNULL(values), sizeof(*values), size, file) != size) {
+    LOG(ERROR) << "Truncated linear least squares problem file.";
+    return false;
+  }
+  return true;
+}
+
+// fseek succeeds past the end of the file, so the payload is read
+// instead, which detects truncated files.
+bool SkipLsqpPayload(FILE* file, int64 num_bytes) {
+  CHECK_NOTNULL(file);
+  char buffer[4096];
+  while (num_bytes > 0) {
+    const size_t size = static_cast<size_t>(
+        std::min(num_bytes, static_cast<int64>(sizeof(buffer))));
+    if (fread(buffer, 1, size, file) != size) {
+      LOG(ERROR) << "Truncated linear least squares problem file.";
+      return false;
+    }
+    num_bytes -= size;
+  }
+  return true;
+}
+
+}  // namespace internal
+}  // namespace ceres
@@ -0,0 +1,144 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// A chunked binary file format for linear least squares problems,
+// used by DumpLinearLeastSquaresProblem to stream the problems solved
+// by the minimizer to disk and by
+// CreateLinearLeastSquaresProblemFromBinaryFile to load them. Unlike
+// the protocol buffer format it has no external dependencies, and
+// unlike the text format it is compact and fast to read and write.
+//
+// A file starts with the header
+//
+//   char[8]  "CERESLSQ"
+//   int32    0x01020304, to detect files written on a machine with a
+//            different byte order.
+//   int32    kLsqpFileVersion
+//
+// followed by a sequence of chunks, each of which is
+//
+//   int32    the LsqpChunkType of the chunk.
+//   int64    size of the payload in bytes.
+//   payload
+//
+// The sequence ends with a chunk of type LSQP_END. All integers and
+// doubles are stored in the byte order of the machine that wrote the
+// file. Readers skip chunks of types they do not know about.
+//
+// The payload of the chunk describing the matrix A starts with the
+// int32s num_rows, num_cols and num_nonzeros, and is followed by the
+// sparsity structure of the matrix. The values of A, and the vectors
+// D, b and x are stored as arrays of doubles, which are split across
+// consecutive chunks of the same type of at most
+// kLsqpMaxNumDoublesPerChunk doubles each. This way, neither the
+// writer nor the reader ever need to hold more than the matrix
+// itself in memory.
+
+#ifndef CERES_INTERNAL_LSQP_BINARY_FILE_H_
+#define CERES_INTERNAL_LSQP_BINARY_FILE_H_
+
+#include <cstdio>
+#include "ceres/integral_types.h"
+
+namespace ceres {
+namespace internal {
+
+const int kLsqpFileVersion = 1;
+const int64 kLsqpMaxNumDoublesPerChunk = 1 << 20;
+
+enum LsqpChunkType {
+  LSQP_END = 0,
+
+  // int32 num_eliminate_blocks.
+  LSQP_PROBLEM = 1,
+
+  // Exactly one of the following chunks describes the matrix A. It
+  // precedes the LSQP_A_VALUES chunks.
+  //
+  // A BlockSparseMatrix. The header is followed by
+  //
+  //   int32 num_col_blocks, and for each column block
+  //     int32 size, int32 position.
+  //   int32 num_row_blocks, and for each row block
+  //     int32 size, int32 position, int32 num_cells, and for each cell
+  //       int32 block_id, int32 position.
+  LSQP_BLOCK_SPARSE_MATRIX = 2,
+
+  // A CompressedRowSparseMatrix. The header is followed by
+  //
+  //   int32 rows[num_rows + 1]
+  //   int32 cols[num_nonzeros]
+  //   int32 num_row_blocks, int32 row_blocks[num_row_blocks]
+  //   int32 num_col_blocks, int32 col_blocks[num_col_blocks]
+  LSQP_COMPRESSED_ROW_SPARSE_MATRIX = 3,
+
+  // A TripletSparseMatrix. The header is followed by
+  //
+  //   int32 rows[num_nonzeros]
+  //   int32 cols[num_nonzeros]
+  LSQP_TRIPLET_SPARSE_MATRIX = 4,
+
+  // A DenseSparseMatrix. There is nothing after the header, the
+  // values are stored in column major order.
+  LSQP_DENSE_SPARSE_MATRIX = 5,
+
+  // Arrays of doubles.
+  LSQP_A_VALUES = 6,
+  LSQP_D = 7,
+  LSQP_B = 8,
+  LSQP_X = 9
+};
+
+// The writers do not check for errors, callers are expected to check
+// ferror once they are done writing to the file.
+void WriteLsqpFileHeader(FILE* file);
+void WriteLsqpChunkHeader(FILE* file, LsqpChunkType type, int64 num_bytes);
+
+// Write the payload of a chunk, or a part of it.
+void WriteLsqpInts(FILE* file, const int* values, int64 size);
+
+// Write the array values as a sequence of chunks of the given type.
+void WriteLsqpDoubleChunks(FILE* file,
+                           LsqpChunkType type,
+                           const double* values,
+                           int64 size);
+
+// The readers return false if the file is truncated or
+// malformed. Payloads are read using the raw readers below, and the
+// caller is responsible for reading exactly num_bytes bytes of
+// payload after each chunk header.
+bool ReadLsqpFileHeader(FILE* file);
+bool ReadLsqpChunkHeader(FILE* file, int* type, int64* num_bytes);
+bool ReadLsqpInts(FILE* file, int64 size, int* values);
+bool ReadLsqpDoubles(FILE* file, int64 size, double* values);
+bool SkipLsqpPayload(FILE* file, int64 num_bytes);
+
+}  // namespace internal
+}  // namespace ceres
+
+#endif  // CERES_INTERNAL_LSQP_BINARY_FILE_H_
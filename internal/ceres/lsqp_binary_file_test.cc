@@ -0,0 +1,400 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "ceres/lsqp_binary_file.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "ceres/block_sparse_matrix.h"
+#include "ceres/casts.h"
+#include "ceres/compressed_row_sparse_matrix.h"
+#include "ceres/dense_sparse_matrix.h"
+#include "ceres/file.h"
+#include "ceres/internal/eigen.h"
+#include "ceres/internal/scoped_ptr.h"
+#include "ceres/linear_least_squares_problems.h"
+#include "ceres/stringprintf.h"
+#include "ceres/triplet_sparse_matrix.h"
+#include "gtest/gtest.h"
+
+namespace ceres {
+namespace internal {
+
+string TempDirectory() {
+  const char* tmpdir = getenv("TMPDIR");
+  return (tmpdir != NULL) ? tmpdir : "/tmp";
+}
+
+string DumpFilename(int iteration) {
+  return JoinPath(TempDirectory(),
+                  StringPrintf("lm_iteration_%03d.lsqp.bin", iteration));
+}
+
+void ExpectMatricesEqual(const SparseMatrix& expected,
+                         const SparseMatrix& actual) {
+  ASSERT_EQ(expected.num_rows(), actual.num_rows());
+  ASSERT_EQ(expected.num_cols(), actual.num_cols());
+  EXPECT_EQ(expected.num_nonzeros(), actual.num_nonzeros());
+
+  Matrix expected_dense;
+  Matrix actual_dense;
+  expected.ToDenseMatrix(&expected_dense);
+  actual.ToDenseMatrix(&actual_dense);
+  EXPECT_EQ((expected_dense - actual_dense).norm(), 0.0);
+}
+
+void ExpectArraysEqual(int size, const double* expected, const double* actual) {
+  if (expected == NULL) {
+    EXPECT_TRUE(actual == NULL);
+    return;
+  }
+  ASSERT_TRUE(actual != NULL);
+  for (int i = 0; i < size; ++i) {
+    EXPECT_EQ(expected[i], actual[i]) << i;
+  }
+}
+
+// Dump the problem with the given jacobian, and check that loading it
+// returns the same problem.
+void ExpectRoundTrip(const LinearLeastSquaresProblem& problem,
+                     const SparseMatrix& A,
+                     int iteration,
+                     LsqpChunkType expected_matrix_type) {
+  const double* x = (problem.D.get() != NULL)
+      ? problem.x_D.get()
+      : problem.x.get();
+  ASSERT_TRUE(DumpLinearLeastSquaresProblem(TempDirectory(),
+                                            iteration,
+                                            BINARY,
+                                            &A,
+                                            problem.D.get(),
+                                            problem.b.get(),
+                                            x,
+                                            problem.num_eliminate_blocks));
+
+  const string filename = DumpFilename(iteration);
+  LsqpChunkType matrix_type;
+  scoped_ptr<LinearLeastSquaresProblem> actual(
+      CreateLinearLeastSquaresProblemFromBinaryFile(filename, &matrix_type));
+  remove(filename.c_str());
+  ASSERT_TRUE(actual.get() != NULL);
+
+  EXPECT_EQ(matrix_type, expected_matrix_type);
+  EXPECT_EQ(actual->num_eliminate_blocks, problem.num_eliminate_blocks);
+  ExpectMatricesEqual(A, *actual->A);
+  ExpectArraysEqual(A.num_cols(), problem.D.get(), actual->D.get());
+  ExpectArraysEqual(A.num_rows(), problem.b.get(), actual->b.get());
+  if (problem.D.get() != NULL) {
+    ExpectArraysEqual(A.num_cols(), x, actual->x_D.get());
+    EXPECT_TRUE(actual->x.get() == NULL);
+  } else {
+    ExpectArraysEqual(A.num_cols(), x, actual->x.get());
+    EXPECT_TRUE(actual->x_D.get() == NULL);
+  }
+}
+
+TEST(LsqpBinaryFile, BlockSparseMatrix) {
+  scoped_ptr<LinearLeastSquaresProblem> problem(
+      CreateLinearLeastSquaresProblemFromId(2));
+  ExpectRoundTrip(*problem, *problem->A, 1, LSQP_BLOCK_SPARSE_MATRIX);
+
+  const BlockSparseMatrix* A =
+      down_cast<BlockSparseMatrix*>(problem->A.get());
+  LsqpChunkType matrix_type;
+  ASSERT_TRUE(DumpLinearLeastSquaresProblem(TempDirectory(),
+                                            2,
+                                            BINARY,
+                                            A,
+                                            NULL,
+                                            problem->b.get(),
+                                            NULL,
+                                            problem->num_eliminate_blocks));
+  scoped_ptr<LinearLeastSquaresProblem> actual(
+      CreateLinearLeastSquaresProblemFromBinaryFile(DumpFilename(2),
+                                                    &matrix_type));
+  remove(DumpFilename(2).c_str());
+  ASSERT_TRUE(actual.get() != NULL);
+  EXPECT_TRUE(actual->D.get() == NULL);
+  EXPECT_TRUE(actual->x.get() == NULL);
+
+  // The block structure is preserved.
+  const CompressedRowBlockStructure* expected_bs = A->block_structure();
+  const CompressedRowBlockStructure* actual_bs =
+      down_cast<BlockSparseMatrix*>(actual->A.get())->block_structure();
+  ASSERT_EQ(expected_bs->cols.size(), actual_bs->cols.size());
+  for (int i = 0; i < expected_bs->cols.size(); ++i) {
+    EXPECT_EQ(expected_bs->cols[i].size, actual_bs->cols[i].size);
+    EXPECT_EQ(expected_bs->cols[i].position, actual_bs->cols[i].position);
+  }
+  ASSERT_EQ(expected_bs->rows.size(), actual_bs->rows.size());
+  for (int i = 0; i < expected_bs->rows.size(); ++i) {
+    const CompressedRow& expected_row = expected_bs->rows[i];
+    const CompressedRow& actual_row = actual_bs->rows[i];
+    EXPECT_EQ(expected_row.block.size, actual_row.block.size);
+    EXPECT_EQ(expected_row.block.position, actual_row.block.position);
+    ASSERT_EQ(expected_row.cells.size(), actual_row.cells.size());
+    for (int j = 0; j < expected_row.cells.size(); ++j) {
+      EXPECT_EQ(expected_row.cells[j].block_id, actual_row.cells[j].block_id);
+      EXPECT_EQ(expected_row.cells[j].position, actual_row.cells[j].position);
+    }
+  }
+}
+
+TEST(LsqpBinaryFile, TripletSparseMatrix) {
+  scoped_ptr<LinearLeastSquaresProblem> problem(
+      CreateLinearLeastSquaresProblemFromId(1));
+  ExpectRoundTrip(*problem, *problem->A, 3, LSQP_TRIPLET_SPARSE_MATRIX);
+}
+
+TEST(LsqpBinaryFile, CompressedRowSparseMatrix) {
+  scoped_ptr<LinearLeastSquaresProblem> problem(
+      CreateLinearLeastSquaresProblemFromId(1));
+  CompressedRowSparseMatrix A(
+      *down_cast<TripletSparseMatrix*>(problem->A.get()));
+  A.mutable_row_blocks()->push_back(A.num_rows());
+  A.mutable_col_blocks()->push_back(2);
+  A.mutable_col_blocks()->push_back(A.num_cols() - 2);
+  ExpectRoundTrip(*problem, A, 4, LSQP_COMPRESSED_ROW_SPARSE_MATRIX);
+}
+
+TEST(LsqpBinaryFile, DenseSparseMatrix) {
+  scoped_ptr<LinearLeastSquaresProblem> problem(
+      CreateLinearLeastSquaresProblemFromId(0));
+  DenseSparseMatrix A(*down_cast<TripletSparseMatrix*>(problem->A.get()));
+  ExpectRoundTrip(*problem, A, 5, LSQP_DENSE_SPARSE_MATRIX);
+}
+
+TEST(LsqpBinaryFile, DenseSparseMatrixWithReservedDiagonal) {
+  scoped_ptr<LinearLeastSquaresProblem> problem(
+      CreateLinearLeastSquaresProblemFromId(0));
+  const SparseMatrix& triplet_A = *problem->A;
+  Matrix dense_A;
+  triplet_A.ToDenseMatrix(&dense_A);
+
+  // The reserved rows are not part of the matrix.
+  DenseSparseMatrix A(triplet_A.num_rows(), triplet_A.num_cols(), true);
+  A.mutable_matrix() = dense_A;
+  ExpectRoundTrip(*problem, A, 6, LSQP_DENSE_SPARSE_MATRIX);
+}
+
+TEST(LsqpBinaryFile, ArraysSpanningSeveralChunks) {
+  // A single column matrix with more rows than fit in a chunk.
+  const int num_rows = 2 * kLsqpMaxNumDoublesPerChunk + 3;
+  TripletSparseMatrix A(num_rows, 1, num_rows);
+  LinearLeastSquaresProblem problem;
+  problem.b.reset(new double[num_rows]);
+  for (int i = 0; i < num_rows; ++i) {
+    A.mutable_rows()[i] = i;
+    A.mutable_cols()[i] = 0;
+    A.mutable_values()[i] = i;
+    problem.b[i] = -i;
+  }
+  A.set_num_nonzeros(num_rows);
+  ExpectRoundTrip(problem, A, 7, LSQP_TRIPLET_SPARSE_MATRIX);
+}
+
+TEST(LsqpBinaryFile, UnknownChunksAreSkipped) {
+  scoped_ptr<LinearLeastSquaresProblem> problem(
+      CreateLinearLeastSquaresProblemFromId(2));
+  const string filename = DumpFilename(8);
+  FILE* file = fopen(filename.c_str(), "wb");
+  ASSERT_TRUE(file != NULL);
+  WriteLsqpFileHeader(file);
+  const int unknown_payload[3] = { 1, 2, 3 };
+  WriteLsqpChunkHeader(file,
+                       static_cast<LsqpChunkType>(1000),
+                       sizeof(unknown_payload));
+  WriteLsqpInts(file, unknown_payload, 3);
+  problem->A->ToBinaryFile(file);
+  WriteLsqpDoubleChunks(file, LSQP_B, problem->b.get(),
+                        problem->A->num_rows());
+  WriteLsqpChunkHeader(file, LSQP_END, 0);
+  fclose(file);
+
+  scoped_ptr<LinearLeastSquaresProblem> actual(
+      CreateLinearLeastSquaresProblemFromBinaryFile(filename, NULL));
+  remove(filename.c_str());
+  ASSERT_TRUE(actual.get() != NULL);
+  EXPECT_EQ(actual->num_eliminate_blocks, 0);
+  ExpectMatricesEqual(*problem->A, *actual->A);
+  ExpectArraysEqual(problem->A->num_rows(),
+                    problem->b.get(),
+                    actual->b.get());
+}
+
+TEST(LsqpBinaryFile, TruncatedFilesAreRejected) {
+  scoped_ptr<LinearLeastSquaresProblem> problem(
+      CreateLinearLeastSquaresProblemFromId(2));
+  ASSERT_TRUE(DumpLinearLeastSquaresProblem(TempDirectory(),
+                                            9,
+                                            BINARY,
+                                            problem->A.get(),
+                                            problem->D.get(),
+                                            problem->b.get(),
+                                            problem->x_D.get(),
+                                            problem->num_eliminate_blocks));
+  const string filename = DumpFilename(9);
+  string contents;
+  ReadFileToStringOrDie(filename, &contents);
+
+  // Every prefix of the file is invalid.
+  for (int size = 0; size < contents.size(); size += 7) {
+    WriteStringToFileOrDie(contents.substr(0, size), filename);
+    EXPECT_TRUE(CreateLinearLeastSquaresProblemFromBinaryFile(filename,
+                                                              NULL) == NULL)
+        << size;
+  }
+
+  WriteStringToFileOrDie("Not a linear least squares problem", filename);
+  EXPECT_TRUE(CreateLinearLeastSquaresProblemFromBinaryFile(filename,
+                                                            NULL) == NULL);
+  remove(filename.c_str());
+}
+
+// Returns true if a file with the given matrix chunk, followed by
+// num_nonzeros values, is loaded successfully.
+bool LoadsMatrixChunk(LsqpChunkType type,
+                      const vector<int>& payload,
+                      int num_nonzeros) {
+  const string filename = DumpFilename(10);
+  FILE* file = fopen(filename.c_str(), "wb");
+  CHECK_NOTNULL(file);
+  WriteLsqpFileHeader(file);
+  WriteLsqpChunkHeader(file, type, payload.size() * sizeof(int));
+  WriteLsqpInts(file, &payload[0], payload.size());
+  const vector<double> values(num_nonzeros, 1.0);
+  WriteLsqpDoubleChunks(file, LSQP_A_VALUES, &values[0], num_nonzeros);
+  WriteLsqpChunkHeader(file, LSQP_END, 0);
+  fclose(file);
+
+  scoped_ptr<LinearLeastSquaresProblem> problem(
+      CreateLinearLeastSquaresProblemFromBinaryFile(filename, NULL));
+  remove(filename.c_str());
+  return problem.get() != NULL;
+}
+
+TEST(LsqpBinaryFile, OutOfRangeTripletIndicesAreRejected) {
+  // A 2x3 matrix with non-zeros at (0, 0), (1, 2).
+  const int kPayload[] = { 2, 3, 2,  0, 1,  0, 2 };
+  vector<int> payload(kPayload, kPayload + arraysize(kPayload));
+  EXPECT_TRUE(LoadsMatrixChunk(LSQP_TRIPLET_SPARSE_MATRIX, payload, 2));
+
+  payload[4] = 2;
+  EXPECT_FALSE(LoadsMatrixChunk(LSQP_TRIPLET_SPARSE_MATRIX, payload, 2));
+  payload[4] = 1;
+  payload[6] = 3;
+  EXPECT_FALSE(LoadsMatrixChunk(LSQP_TRIPLET_SPARSE_MATRIX, payload, 2));
+  payload[6] = -1;
+  EXPECT_FALSE(LoadsMatrixChunk(LSQP_TRIPLET_SPARSE_MATRIX, payload, 2));
+}
+
+TEST(LsqpBinaryFile, CorruptCompressedRowStructuresAreRejected) {
+  // A 3x3 matrix with two non-zeros in the first and the last
+  // rows. One row block of size 3, two column blocks of sizes 1 and 2.
+  const int kPayload[] = { 3, 3, 4,
+                           0, 2, 2, 4,
+                           0, 1, 1, 2,
+                           1, 3,
+                           2, 1, 2 };
+  const vector<int> valid(kPayload, kPayload + arraysize(kPayload));
+  EXPECT_TRUE(LoadsMatrixChunk(LSQP_COMPRESSED_ROW_SPARSE_MATRIX, valid, 4));
+
+  // Rows which are not monotonic.
+  vector<int> payload = valid;
+  payload[4] = 3;
+  payload[5] = 1;
+  EXPECT_FALSE(LoadsMatrixChunk(LSQP_COMPRESSED_ROW_SPARSE_MATRIX,
+                                payload, 4));
+
+  // Rows which do not start at zero.
+  payload = valid;
+  payload[3] = 1;
+  EXPECT_FALSE(LoadsMatrixChunk(LSQP_COMPRESSED_ROW_SPARSE_MATRIX,
+                                payload, 4));
+
+  // A column index out of range.
+  payload = valid;
+  payload[10] = 3;
+  EXPECT_FALSE(LoadsMatrixChunk(LSQP_COMPRESSED_ROW_SPARSE_MATRIX,
+                                payload, 4));
+
+  // Column blocks which do not add up to the number of columns.
+  payload = valid;
+  payload[15] = 3;
+  EXPECT_FALSE(LoadsMatrixChunk(LSQP_COMPRESSED_ROW_SPARSE_MATRIX,
+                                payload, 4));
+}
+
+TEST(LsqpBinaryFile, CorruptBlockStructuresAreRejected) {
+  // Two column blocks of sizes 1 and 2, and two row blocks of size
+  // 1. The first row block has a cell in each column block, the
+  // second one a cell in the second column block.
+  const int kPayload[] = { 2, 3, 5,
+                           2,  1, 0,  2, 1,
+                           2,
+                           1, 0, 2,  0, 0,  1, 1,
+                           1, 1, 1,  1, 3 };
+  const vector<int> valid(kPayload, kPayload + arraysize(kPayload));
+  EXPECT_TRUE(LoadsMatrixChunk(LSQP_BLOCK_SPARSE_MATRIX, valid, 5));
+
+  // A cell in a column block which does not exist.
+  vector<int> payload = valid;
+  payload[19] = 2;
+  EXPECT_FALSE(LoadsMatrixChunk(LSQP_BLOCK_SPARSE_MATRIX, payload, 5));
+
+  // A cell whose values are past the end of the values array.
+  payload = valid;
+  payload[20] = 4;
+  EXPECT_FALSE(LoadsMatrixChunk(LSQP_BLOCK_SPARSE_MATRIX, payload, 5));
+
+  // A column block which does not follow the previous one.
+  payload = valid;
+  payload[7] = 2;
+  EXPECT_FALSE(LoadsMatrixChunk(LSQP_BLOCK_SPARSE_MATRIX, payload, 5));
+
+  // A row block of size zero.
+  payload = valid;
+  payload[16] = 0;
+  EXPECT_FALSE(LoadsMatrixChunk(LSQP_BLOCK_SPARSE_MATRIX, payload, 5));
+}
+
+TEST(LsqpBinaryFile, SkippingPastTheEndOfTheFileFails) {
+  const string filename = DumpFilename(11);
+  WriteStringToFileOrDie("0123456789", filename);
+  FILE* file = fopen(filename.c_str(), "rb");
+  ASSERT_TRUE(file != NULL);
+  EXPECT_TRUE(SkipLsqpPayload(file, 4));
+  EXPECT_FALSE(SkipLsqpPayload(file, 7));
+  fclose(file);
+  remove(filename.c_str());
+}
+
+}  // namespace internal
+}  // namespace ceres
@@ -0,0 +1,282 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Load a linear least squares problem dumped by the solver using
+// DumpFormatType BINARY, and benchmark a linear solver and
+// preconditioner combination on it. e.g.
+//
+//   lsqp_replay --input=/tmp/lm_iteration_005.lsqp.bin
+//               --linear_solver=iterative_schur
+//               --preconditioner=schur_jacobi
+//
+// The problem is solved --num_repetitions times, and the solve times,
+// the number of iterations and the quality of the solution, compared
+// to the one computed when the problem was dumped, are reported.
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ceres/block_sparse_matrix.h"
+#include "ceres/block_structure.h"
+#include "ceres/casts.h"
+#include "ceres/compressed_row_sparse_matrix.h"
+#include "ceres/dense_sparse_matrix.h"
+#include "ceres/internal/eigen.h"
+#include "ceres/internal/scoped_ptr.h"
+#include "ceres/linear_least_squares_problems.h"
+#include "ceres/linear_solver.h"
+#include "ceres/lsqp_binary_file.h"
+#include "ceres/triplet_sparse_matrix.h"
+#include "ceres/types.h"
+#include "ceres/wall_time.h"
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+
+DEFINE_string(input, "", "Linear least squares problem dumped using "
+              "DumpFormatType BINARY.");
+DEFINE_string(linear_solver, "sparse_schur", "Options are: "
+              "sparse_schur, dense_schur, iterative_schur, "
+              "sparse_normal_cholesky, dense_qr, dense_normal_cholesky "
+              "and cgnr.");
+DEFINE_string(preconditioner, "jacobi", "Options are: "
+              "identity, jacobi, schur_jacobi, cluster_jacobi, "
+              "cluster_tridiagonal, additive_schwarz.");
+DEFINE_string(sparse_linear_algebra_library, "suite_sparse",
+              "Options are: suite_sparse and cx_sparse.");
+DEFINE_bool(use_block_amd, true, "Use a block oriented fill reducing "
+            "ordering.");
+DEFINE_bool(use_single_precision_jacobian, false, "Use a single precision "
+            "copy of the Jacobian in ITERATIVE_SCHUR and CGNR.");
+DEFINE_int32(num_threads, 1, "Number of threads.");
+DEFINE_int32(num_eliminate_blocks, -1, "Number of e_blocks used by the "
+             "Schur type solvers. If negative, the number stored in the "
+             "input file is used.");
+DEFINE_int32(max_num_iterations, 500, "Maximum number of iterations of "
+             "the iterative linear solvers.");
+DEFINE_double(eta, 1e-1, "Accuracy of the solves of the iterative linear "
+              "solvers. See Solver::Options::eta.");
+DEFINE_bool(regularize, true, "Use the diagonal D stored in the input "
+            "file, i.e., solve the same regularized problem as the "
+            "solver did.");
+DEFINE_int32(num_repetitions, 10, "Number of times the problem is solved.");
+
+namespace ceres {
+namespace internal {
+
+// Convert the jacobian, which is stored as a matrix of type
+// matrix_type, into the kind of matrix that linear solvers of type
+// linear_solver_type expect. Returns false if this is not possible.
+bool ConvertJacobian(LinearSolverType linear_solver_type,
+                     LsqpChunkType matrix_type,
+                     scoped_ptr<SparseMatrix>* A) {
+  switch (linear_solver_type) {
+    case DENSE_QR:
+    case DENSE_NORMAL_CHOLESKY:
+      if (matrix_type != LSQP_DENSE_SPARSE_MATRIX) {
+        Matrix dense_A;
+        (*A)->ToDenseMatrix(&dense_A);
+        A->reset(new DenseSparseMatrix(ColMajorMatrix(dense_A)));
+      }
+      return true;
+
+    case SPARSE_NORMAL_CHOLESKY:
+      if (matrix_type == LSQP_TRIPLET_SPARSE_MATRIX) {
+        A->reset(new CompressedRowSparseMatrix(
+            *down_cast<TripletSparseMatrix*>(A->get())));
+      } else if (matrix_type == LSQP_BLOCK_SPARSE_MATRIX) {
+        const BlockSparseMatrix* block_A =
+            down_cast<BlockSparseMatrix*>(A->get());
+        TripletSparseMatrix triplet_A;
+        block_A->ToTripletSparseMatrix(&triplet_A);
+        CompressedRowSparseMatrix* crs_A =
+            new CompressedRowSparseMatrix(triplet_A);
+
+        // Keep the block structure for the block AMD ordering.
+        const CompressedRowBlockStructure* bs = block_A->block_structure();
+        for (int i = 0; i < bs->rows.size(); ++i) {
+          crs_A->mutable_row_blocks()->push_back(bs->rows[i].block.size);
+        }
+        for (int i = 0; i < bs->cols.size(); ++i) {
+          crs_A->mutable_col_blocks()->push_back(bs->cols[i].size);
+        }
+        A->reset(crs_A);
+      } else if (matrix_type != LSQP_COMPRESSED_ROW_SPARSE_MATRIX) {
+        return false;
+      }
+      return true;
+
+    default:
+      // The Schur type solvers and CGNR need a BlockSparseMatrix.
+      return (matrix_type == LSQP_BLOCK_SPARSE_MATRIX);
+  }
+}
+
+void ReplayLinearLeastSquaresProblem() {
+  LsqpChunkType matrix_type;
+  scoped_ptr<LinearLeastSquaresProblem> problem(
+      CreateLinearLeastSquaresProblemFromBinaryFile(FLAGS_input,
+                                                    &matrix_type));
+  CHECK(problem.get() != NULL) << "Unable to load " << FLAGS_input;
+  CHECK(problem->b.get() != NULL)
+      << FLAGS_input << " does not contain the vector b.";
+
+  LinearSolver::Options options;
+  CHECK(StringToLinearSolverType(FLAGS_linear_solver, &options.type));
+  CHECK(StringToPreconditionerType(FLAGS_preconditioner,
+                                   &options.preconditioner_type));
+  CHECK(StringToSparseLinearAlgebraLibraryType(
+            FLAGS_sparse_linear_algebra_library,
+            &options.sparse_linear_algebra_library));
+  options.use_block_amd = FLAGS_use_block_amd;
+  options.use_single_precision_jacobian = FLAGS_use_single_precision_jacobian;
+  options.num_threads = FLAGS_num_threads;
+  options.max_num_iterations = FLAGS_max_num_iterations;
+
+  // The block structure is lost when converting to the matrix types
+  // used by the other solvers, so record it first.
+  int num_col_blocks = 0;
+  if (matrix_type == LSQP_BLOCK_SPARSE_MATRIX) {
+    num_col_blocks = down_cast<BlockSparseMatrix*>(problem->A.get())
+        ->block_structure()->cols.size();
+  }
+
+  CHECK(ConvertJacobian(options.type, matrix_type, &problem->A))
+      << "The jacobian in " << FLAGS_input << " cannot be used with "
+      << LinearSolverTypeToString(options.type) << ". Dump the problem "
+      << "using one of the Schur type solvers or CGNR instead.";
+
+  const int num_eliminate_blocks = (FLAGS_num_eliminate_blocks < 0)
+      ? problem->num_eliminate_blocks
+      : FLAGS_num_eliminate_blocks;
+  if (IsSchurType(options.type)) {
+    CHECK_GT(num_eliminate_blocks, 0)
+        << "The Schur type solvers need a positive number of e_blocks. "
+        << "Use --num_eliminate_blocks to specify it.";
+    CHECK_LE(num_eliminate_blocks, num_col_blocks);
+    options.elimination_groups.push_back(num_eliminate_blocks);
+    options.elimination_groups.push_back(num_col_blocks -
+                                         num_eliminate_blocks);
+  }
+
+  scoped_ptr<LinearSolver> linear_solver(LinearSolver::Create(options));
+  CHECK(linear_solver.get() != NULL);
+
+  SparseMatrix* A = problem->A.get();
+  const double* D = FLAGS_regularize ? problem->D.get() : NULL;
+  const double* b = problem->b.get();
+
+  LinearSolver::PerSolveOptions per_solve_options;
+  per_solve_options.D = const_cast<double*>(D);
+  per_solve_options.q_tolerance = FLAGS_eta;
+  per_solve_options.r_tolerance = -1.0;
+
+  printf("Problem: %s\n", FLAGS_input.c_str());
+  printf("%d rows, %d columns, %d non-zeros, %d e_blocks, %s.\n",
+         A->num_rows(),
+         A->num_cols(),
+         A->num_nonzeros(),
+         num_eliminate_blocks,
+         D == NULL ? "unregularized" : "regularized");
+  printf("Linear solver: %s, preconditioner: %s, threads: %d\n\n",
+         LinearSolverTypeToString(options.type),
+         PreconditionerTypeToString(options.preconditioner_type),
+         options.num_threads);
+
+  Vector x(A->num_cols());
+  vector<double> solve_times;
+  LinearSolver::Summary summary;
+  for (int i = 0; i < FLAGS_num_repetitions; ++i) {
+    x.setZero();
+    const double start_time = WallTimeInSeconds();
+    summary = linear_solver->Solve(A, b, per_solve_options, x.data());
+    solve_times.push_back(WallTimeInSeconds() - start_time);
+    CHECK_NE(summary.termination_type, FAILURE)
+        << "The linear solver failed.";
+  }
+
+  sort(solve_times.begin(), solve_times.end());
+  double total_time = 0.0;
+  for (int i = 0; i < solve_times.size(); ++i) {
+    total_time += solve_times[i];
+  }
+
+  printf("%-30s %d\n", "Repetitions", FLAGS_num_repetitions);
+  if (!solve_times.empty()) {
+    printf("%-30s %e\n", "Minimum solve time (s)", solve_times.front());
+    printf("%-30s %e\n", "Median solve time (s)",
+           solve_times[solve_times.size() / 2]);
+    printf("%-30s %e\n", "Mean solve time (s)",
+           total_time / solve_times.size());
+    printf("%-30s %d\n", "Linear solver iterations", summary.num_iterations);
+  }
+
+  // Cost of the solution, |Ax - b|^2 + |Dx|^2.
+  Vector residual = -ConstVectorRef(b, A->num_rows());
+  A->RightMultiply(x.data(), residual.data());
+  double cost = residual.squaredNorm();
+  if (D != NULL) {
+    cost += (ConstVectorRef(D, A->num_cols()).array() *
+             x.array()).matrix().squaredNorm();
+  }
+  printf("%-30s %e\n", "Cost", cost);
+
+  // Compare with the solution computed when the problem was dumped.
+  const double* expected_x = (D != NULL) ? problem->x_D.get()
+                                         : problem->x.get();
+  if (expected_x != NULL) {
+    ConstVectorRef expected(expected_x, A->num_cols());
+    printf("%-30s %e\n", "Relative difference to dump",
+           (x - expected).norm() / std::max(expected.norm(), 1e-300));
+  }
+
+  printf("\n");
+  const map<string, double> times = linear_solver->TimeStatistics();
+  for (map<string, double>::const_iterator it = times.begin();
+       it != times.end();
+       ++it) {
+    printf("%-50s %e\n", it->first.c_str(), it->second);
+  }
+}
+
+}  // namespace internal
+}  // namespace ceres
+
+int main(int argc, char** argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  if (FLAGS_input.empty()) {
+    LOG(ERROR) << "Usage: lsqp_replay --input=lm_iteration_???.lsqp.bin";
+    return 1;
+  }
+
+  ceres::internal::ReplayLinearLeastSquaresProblem();
+  return 0;
+}
@@ -73,6 +73,8 @@ class Minimizer {
       use_nonmonotonic_steps = options.use_nonmonotonic_steps;
       max_consecutive_nonmonotonic_steps =
           options.max_consecutive_nonmonotonic_steps;
+      use_speculative_jacobian_evaluation =
+          options.use_speculative_jacobian_evaluation;
       lsqp_dump_directory = options.lsqp_dump_directory;
       lsqp_iterations_to_dump = options.lsqp_iterations_to_dump;
       lsqp_dump_format_type = options.lsqp_dump_format_type;
@@ -109,6 +111,11 @@ class Minimizer {
     bool jacobi_scaling;
     bool use_nonmonotonic_steps;
     int max_consecutive_nonmonotonic_steps;
+
+    // If true, the trust region minimizer evaluates the residuals and
+    // the Jacobian at each candidate point into a second Jacobian,
+    // and swaps it in if the step is accepted.
+    bool use_speculative_jacobian_evaluation;
     vector<int> lsqp_iterations_to_dump;
     DumpFormatType lsqp_dump_format_type;
     string lsqp_dump_directory;
@@ -149,6 +149,256 @@ TEST(NumericDiffCostFunction, TranscendentalCaseCostFunctionForwardDifferences)
   functor.ExpectCostFunctionEvaluationIsNearlyCorrect(*cost_function, FORWARD);
 }
 
+TEST(NumericDiffCostFunction, EasyCaseFunctorRidders) {
+  internal::scoped_ptr<CostFunction> cost_function;
+  cost_function.reset(
+      new NumericDiffCostFunction<EasyFunctor,
+                                  RIDDERS,
+                                  3,  /* number of residuals */
+                                  5,  /* size of x1 */
+                                  5   /* size of x2 */>(
+          new EasyFunctor, TAKE_OWNERSHIP, NumericDiffOptions()));
+  EasyFunctor functor;
+  functor.ExpectCostFunctionEvaluationIsNearlyCorrect(*cost_function, RIDDERS);
+}
+
+TEST(NumericDiffCostFunction, TranscendentalCaseFunctorRidders) {
+  internal::scoped_ptr<CostFunction> cost_function;
+  cost_function.reset(
+      new NumericDiffCostFunction<TranscendentalFunctor,
+                                  RIDDERS,
+                                  2,  /* number of residuals */
+                                  5,  /* size of x1 */
+                                  5   /* size of x2 */>(
+          new TranscendentalFunctor, TAKE_OWNERSHIP, NumericDiffOptions()));
+  TranscendentalFunctor functor;
+  functor.ExpectCostFunctionEvaluationIsNearlyCorrect(*cost_function, RIDDERS);
+}
+
+TEST(NumericDiffCostFunction, TranscendentalCaseCostFunctionRidders) {
+  internal::scoped_ptr<CostFunction> cost_function;
+  cost_function.reset(
+      new NumericDiffCostFunction<TranscendentalCostFunction,
+                                  RIDDERS,
+                                  2,  /* number of residuals */
+                                  5,  /* size of x1 */
+                                  5   /* size of x2 */>(
+          new TranscendentalCostFunction, TAKE_OWNERSHIP,
+          NumericDiffOptions()));
+  TranscendentalFunctor functor;
+  functor.ExpectCostFunctionEvaluationIsNearlyCorrect(*cost_function, RIDDERS);
+}
+
+// TranscendentalFunctor with an EvaluateBatch member, which counts
+// the number of times it is called.
+class BatchedTranscendentalFunctor {
+ public:
+  BatchedTranscendentalFunctor(int* num_batch_calls)
+      : num_batch_calls_(num_batch_calls) {}
+
+  bool operator()(const double* x1, const double* x2, double* residuals) const {
+    return functor_(x1, x2, residuals);
+  }
+
+  bool EvaluateBatch(int num_evaluations,
+                     double const* const* parameters,
+                     double* residuals) const {
+    ++(*num_batch_calls_);
+    for (int k = 0; k < num_evaluations; ++k) {
+      if (!functor_(parameters[0] + 5 * k,
+                    parameters[1] + 5 * k,
+                    residuals + 2 * k)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  TranscendentalFunctor functor_;
+  int* num_batch_calls_;
+};
+
+TEST(NumericDiffCostFunction, HasEvaluateBatch) {
+  EXPECT_FALSE(HasEvaluateBatch<TranscendentalFunctor>::value);
+  EXPECT_FALSE(HasEvaluateBatch<TranscendentalCostFunction>::value);
+  EXPECT_TRUE(HasEvaluateBatch<BatchedTranscendentalFunctor>::value);
+}
+
+TEST(NumericDiffCostFunction, TranscendentalCaseBatchedCentralDifferences) {
+  int num_batch_calls = 0;
+  internal::scoped_ptr<CostFunction> cost_function;
+  cost_function.reset(
+      new NumericDiffCostFunction<BatchedTranscendentalFunctor,
+                                  CENTRAL,
+                                  2,  /* number of residuals */
+                                  5,  /* size of x1 */
+                                  5   /* size of x2 */>(
+          new BatchedTranscendentalFunctor(&num_batch_calls)));
+  TranscendentalFunctor functor;
+  functor.ExpectCostFunctionEvaluationIsNearlyCorrect(*cost_function, CENTRAL);
+  // One batch per jacobian evaluation.
+  EXPECT_EQ(num_batch_calls, 6);
+}
+
+TEST(NumericDiffCostFunction, TranscendentalCaseBatchedForwardDifferences) {
+  int num_batch_calls = 0;
+  internal::scoped_ptr<CostFunction> cost_function;
+  cost_function.reset(
+      new NumericDiffCostFunction<BatchedTranscendentalFunctor,
+                                  FORWARD,
+                                  2,  /* number of residuals */
+                                  5,  /* size of x1 */
+                                  5   /* size of x2 */>(
+          new BatchedTranscendentalFunctor(&num_batch_calls)));
+  TranscendentalFunctor functor;
+  functor.ExpectCostFunctionEvaluationIsNearlyCorrect(*cost_function, FORWARD);
+  EXPECT_EQ(num_batch_calls, 6);
+}
+
+// The batched and the unbatched code paths must produce bitwise
+// identical jacobians, including when some of them are not requested.
+TEST(NumericDiffCostFunction, BatchedMatchesUnbatched) {
+  int num_batch_calls = 0;
+  NumericDiffCostFunction<BatchedTranscendentalFunctor, CENTRAL, 2, 5, 5>
+      batched(new BatchedTranscendentalFunctor(&num_batch_calls));
+  NumericDiffCostFunction<TranscendentalFunctor, CENTRAL, 2, 5, 5>
+      unbatched(new TranscendentalFunctor);
+
+  double x1[] = { 1.0, 2.0, 3.0, 4.0, 5.0 };
+  double x2[] = { 0.1, -0.2, 0.3, -0.4, 0.5 };
+  double* parameters[] = { x1, x2 };
+
+  for (int missing = -1; missing < 2; ++missing) {
+    double batched_residuals[2];
+    double unbatched_residuals[2];
+    double batched_jacobian[2][10];
+    double unbatched_jacobian[2][10];
+    double* batched_jacobians[] = { batched_jacobian[0], batched_jacobian[1] };
+    double* unbatched_jacobians[] = {
+      unbatched_jacobian[0], unbatched_jacobian[1]
+    };
+    if (missing >= 0) {
+      batched_jacobians[missing] = NULL;
+      unbatched_jacobians[missing] = NULL;
+    }
+
+    ASSERT_TRUE(batched.Evaluate(parameters,
+                                 batched_residuals,
+                                 batched_jacobians));
+    ASSERT_TRUE(unbatched.Evaluate(parameters,
+                                   unbatched_residuals,
+                                   unbatched_jacobians));
+    for (int i = 0; i < 2; ++i) {
+      EXPECT_EQ(batched_residuals[i], unbatched_residuals[i]);
+      if (batched_jacobians[i] == NULL) {
+        continue;
+      }
+      for (int j = 0; j < 10; ++j) {
+        EXPECT_EQ(batched_jacobian[i][j], unbatched_jacobian[i][j]);
+      }
+    }
+  }
+  EXPECT_EQ(num_batch_calls, 3);
+}
+
+// Evaluating the jacobian columns using several threads must produce
+// bitwise identical jacobians, including when some of them are not
+// requested.
+TEST(NumericDiffCostFunction, MultiThreadedMatchesSingleThreaded) {
+  NumericDiffOptions options;
+  options.num_threads = 4;
+  NumericDiffCostFunction<TranscendentalFunctor, CENTRAL, 2, 5, 5>
+      central(new TranscendentalFunctor);
+  NumericDiffCostFunction<TranscendentalFunctor, CENTRAL, 2, 5, 5>
+      multi_threaded_central(new TranscendentalFunctor,
+                             TAKE_OWNERSHIP,
+                             options);
+  NumericDiffCostFunction<TranscendentalFunctor, FORWARD, 2, 5, 5>
+      forward(new TranscendentalFunctor);
+  NumericDiffCostFunction<TranscendentalFunctor, FORWARD, 2, 5, 5>
+      multi_threaded_forward(new TranscendentalFunctor,
+                             TAKE_OWNERSHIP,
+                             options);
+  const CostFunction* single_threaded[] = { &central, &forward };
+  const CostFunction* multi_threaded[] = {
+    &multi_threaded_central, &multi_threaded_forward
+  };
+
+  double x1[] = { 1.0, 0.0, 3.0, 4.0, 5.0 };
+  double x2[] = { 0.1, -0.2, 0.3, -0.4, 0.5 };
+  double* parameters[] = { x1, x2 };
+
+  for (int c = 0; c < 2; ++c) {
+    for (int missing = -1; missing < 2; ++missing) {
+      double expected_residuals[2];
+      double actual_residuals[2];
+      double expected_jacobian[2][10];
+      double actual_jacobian[2][10];
+      double* expected_jacobians[] = {
+        expected_jacobian[0], expected_jacobian[1]
+      };
+      double* actual_jacobians[] = { actual_jacobian[0], actual_jacobian[1] };
+      if (missing >= 0) {
+        expected_jacobians[missing] = NULL;
+        actual_jacobians[missing] = NULL;
+      }
+
+      ASSERT_TRUE(single_threaded[c]->Evaluate(parameters,
+                                               expected_residuals,
+                                               expected_jacobians));
+      ASSERT_TRUE(multi_threaded[c]->Evaluate(parameters,
+                                              actual_residuals,
+                                              actual_jacobians));
+      for (int i = 0; i < 2; ++i) {
+        EXPECT_EQ(expected_residuals[i], actual_residuals[i]);
+        if (expected_jacobians[i] == NULL) {
+          continue;
+        }
+        for (int j = 0; j < 10; ++j) {
+          EXPECT_EQ(expected_jacobian[i][j], actual_jacobian[i][j]);
+        }
+      }
+    }
+  }
+}
+
+// Ridders' method should be much more accurate than central
+// differences when the function has large higher order derivatives.
+TEST(NumericDiffCostFunction, RiddersIsMoreAccurateThanCentralDifferences) {
+  NumericDiffCostFunction<TranscendentalFunctor, CENTRAL, 2, 5, 5>
+      central(new TranscendentalFunctor);
+  NumericDiffCostFunction<TranscendentalFunctor, RIDDERS, 2, 5, 5>
+      ridders(new TranscendentalFunctor, TAKE_OWNERSHIP, NumericDiffOptions());
+
+  double x1[] = { 1.0, 2.0, 3.0, 4.0, 5.0 };
+  double x2[] = { 9.0, 9.0, 5.0, 5.0, 1.0 };
+  double* parameters[] = { x1, x2 };
+  double x1x2 = 0.0;
+  for (int i = 0; i < 5; ++i) {
+    x1x2 += x1[i] * x2[i];
+  }
+
+  double residuals[2];
+  double central_jacobian[10];
+  double ridders_jacobian[10];
+  double* central_jacobians[] = { central_jacobian, NULL };
+  double* ridders_jacobians[] = { ridders_jacobian, NULL };
+  ASSERT_TRUE(central.Evaluate(parameters, residuals, central_jacobians));
+  ASSERT_TRUE(ridders.Evaluate(parameters, residuals, ridders_jacobians));
+
+  double central_error = 0.0;
+  double ridders_error = 0.0;
+  for (int i = 0; i < 5; ++i) {
+    const double expected = x2[i] * cos(x1x2);
+    central_error = std::max(central_error,
+                             std::abs(central_jacobian[i] - expected));
+    ridders_error = std::max(ridders_error,
+                             std::abs(ridders_jacobian[i] - expected));
+  }
+  EXPECT_LT(ridders_error, central_error);
+}
+
 template<int num_rows, int num_cols>
 class SizeTestingCostFunction : public SizedCostFunction<num_rows, num_cols> {
  public:
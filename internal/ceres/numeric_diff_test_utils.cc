@@ -41,6 +41,21 @@
 
 namespace ceres {
 namespace internal {
+namespace {
+
+double NumericDiffTolerance(NumericDiffMethod method) {
+  switch (method) {
+    case FORWARD:
+      return 2e-5;
+    case CENTRAL:
+      return 3e-9;
+    case RIDDERS:
+      return 1e-11;
+  }
+  return 0.0;
+}
+
+}  // namespace
 
 bool EasyFunctor::operator()(const double* x1,
                              const double* x2,
@@ -75,7 +90,7 @@ void EasyFunctor::ExpectCostFunctionEvaluationIsNearlyCorrect(
   EXPECT_EQ(residuals[1], 4489);
   EXPECT_EQ(residuals[2], 213);
 
-  const double tolerance = (method == CENTRAL)? 3e-9 : 2e-5;
+  const double tolerance = NumericDiffTolerance(method);
 
   for (int i = 0; i < 5; ++i) {
     ExpectClose(x2[i],                    dydx1[5 * 0 + i], tolerance);  // y1
@@ -145,7 +160,7 @@ void TranscendentalFunctor::ExpectCostFunctionEvaluationIsNearlyCorrect(
       x1x2 += x1[i] * x2[i];
     }
 
-    const double tolerance = (method == CENTRAL)? 3e-9 : 2e-5;
+    const double tolerance = NumericDiffTolerance(method);
 
     for (int i = 0; i < 5; ++i) {
       ExpectClose( x2[i] * cos(x1x2),              dydx1[5 * 0 + i], tolerance);
@@ -0,0 +1,182 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "ceres/parallel_vector_ops.h"
+
+#include <algorithm>
+#include <vector>
+#include "ceres/internal/eigen.h"
+#include "ceres/internal/port.h"
+#include "glog/logging.h"
+
+namespace ceres {
+namespace internal {
+namespace {
+
+// 4096 doubles is 32KB, so the three or four chunks touched by one
+// task fit comfortably in the L2 cache.
+const int kChunkSize = 4096;
+
+int NumChunks(const int num_elements) {
+  return (num_elements + kChunkSize - 1) / kChunkSize;
+}
+
+// Computes out = a * x + b * y and returns z'out for the elements
+// [begin, begin + size).
+double LinearCombinationDot(const int begin,
+                            const int size,
+                            const double a,
+                            const double* x,
+                            const double b,
+                            const double* y,
+                            const double* z,
+                            double* out) {
+  VectorRef out_ref(out + begin, size);
+  out_ref = a * ConstVectorRef(x + begin, size) +
+      b * ConstVectorRef(y + begin, size);
+  if (z == NULL) {
+    return 0.0;
+  }
+  return ConstVectorRef(z + begin, size).dot(out_ref);
+}
+
+double Sum(const vector<double>& values) {
+  double sum = 0.0;
+  for (int i = 0; i < values.size(); ++i) {
+    sum += values[i];
+  }
+  return sum;
+}
+
+}  // namespace
+
+double ParallelDot(const int num_elements,
+                   const double* x,
+                   const double* y,
+                   const int num_threads) {
+  const int num_chunks = NumChunks(num_elements);
+  if (num_chunks <= 1) {
+    return ConstVectorRef(x, num_elements).dot(
+        ConstVectorRef(y, num_elements));
+  }
+
+  vector<double> partial_dots(num_chunks);
+#pragma omp parallel for num_threads(num_threads) schedule(static)
+  for (int c = 0; c < num_chunks; ++c) {
+    const int begin = c * kChunkSize;
+    const int size = std::min(kChunkSize, num_elements - begin);
+    partial_dots[c] =
+        ConstVectorRef(x + begin, size).dot(ConstVectorRef(y + begin, size));
+  }
+  return Sum(partial_dots);
+}
+
+void ParallelLinearCombination(const int num_elements,
+                               const double a,
+                               const double* x,
+                               const double b,
+                               const double* y,
+                               double* out,
+                               const int num_threads) {
+  ParallelLinearCombinationDot(num_elements, a, x, b, y, NULL, out,
+                               num_threads);
+}
+
+double ParallelLinearCombinationDot(const int num_elements,
+                                    const double a,
+                                    const double* x,
+                                    const double b,
+                                    const double* y,
+                                    const double* z,
+                                    double* out,
+                                    const int num_threads) {
+  const int num_chunks = NumChunks(num_elements);
+  if (num_chunks <= 1) {
+    return LinearCombinationDot(0, num_elements, a, x, b, y, z, out);
+  }
+
+  vector<double> partial_dots(num_chunks);
+#pragma omp parallel for num_threads(num_threads) schedule(static)
+  for (int c = 0; c < num_chunks; ++c) {
+    const int begin = c * kChunkSize;
+    const int size = std::min(kChunkSize, num_elements - begin);
+    partial_dots[c] = LinearCombinationDot(begin, size, a, x, b, y, z, out);
+  }
+  return Sum(partial_dots);
+}
+
+void ParallelDotAndSquaredNorm(const int num_elements,
+                               const double* x,
+                               const double* y,
+                               const int num_threads,
+                               double* x_dot_y,
+                               double* y_squared_norm) {
+  const int num_chunks = std::max(NumChunks(num_elements), 1);
+  vector<double> partial_dots(num_chunks);
+  vector<double> partial_squared_norms(num_chunks);
+#pragma omp parallel for num_threads(num_threads) schedule(static) \
+    if (num_chunks > 1)
+  for (int c = 0; c < num_chunks; ++c) {
+    const int begin = c * kChunkSize;
+    const int size = std::min(kChunkSize, num_elements - begin);
+    ConstVectorRef y_ref(y + begin, size);
+    partial_dots[c] = ConstVectorRef(x + begin, size).dot(y_ref);
+    partial_squared_norms[c] = y_ref.squaredNorm();
+  }
+  *CHECK_NOTNULL(x_dot_y) = Sum(partial_dots);
+  *CHECK_NOTNULL(y_squared_norm) = Sum(partial_squared_norms);
+}
+
+void ParallelSquaredNormAndMaxNorm(const int num_elements,
+                                   const double* x,
+                                   const int num_threads,
+                                   double* squared_norm,
+                                   double* max_norm) {
+  const int num_chunks = std::max(NumChunks(num_elements), 1);
+  vector<double> partial_squared_norms(num_chunks);
+  vector<double> partial_max_norms(num_chunks);
+#pragma omp parallel for num_threads(num_threads) schedule(static) \
+    if (num_chunks > 1)
+  for (int c = 0; c < num_chunks; ++c) {
+    const int begin = c * kChunkSize;
+    const int size = std::min(kChunkSize, num_elements - begin);
+    ConstVectorRef x_ref(x + begin, size);
+    partial_squared_norms[c] = x_ref.squaredNorm();
+    partial_max_norms[c] = (size > 0) ? x_ref.lpNorm<Eigen::Infinity>() : 0.0;
+  }
+
+  *CHECK_NOTNULL(squared_norm) = Sum(partial_squared_norms);
+  double result = 0.0;
+  for (int c = 0; c < num_chunks; ++c) {
+    result = std::max(result, partial_max_norms[c]);
+  }
+  *CHECK_NOTNULL(max_norm) = result;
+}
+
+}  // namespace internal
+}  // namespace ceres
@@ -0,0 +1,103 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Multithreaded level one BLAS routines for the long vectors used by
+// the line search minimizer.
+
+#ifndef CERES_INTERNAL_PARALLEL_VECTOR_OPS_H_
+#define CERES_INTERNAL_PARALLEL_VECTOR_OPS_H_
+
+namespace ceres {
+namespace internal {
+
+// All the routines below split their arguments into consecutive
+// chunks of a fixed size, which are processed in parallel using
+// num_threads threads. Each chunk is small enough to stay in cache,
+// so a fused routine like ParallelLinearCombinationDot reads its
+// arguments from main memory only once.
+//
+// Reductions are done by summing the per chunk results in a fixed
+// order, so the results do not depend on the number of threads.
+//
+// Vectors that are too short to be split are processed by the
+// calling thread.
+
+// Returns x'y.
+double ParallelDot(int num_elements,
+                   const double* x,
+                   const double* y,
+                   int num_threads);
+
+// out = a * x + b * y.
+//
+// out may be the same array as x or y. y is read even if b is zero,
+// so it must be initialized; passing x as y is a simple way to
+// compute out = a * x.
+void ParallelLinearCombination(int num_elements,
+                               double a,
+                               const double* x,
+                               double b,
+                               const double* y,
+                               double* out,
+                               int num_threads);
+
+// out = a * x + b * y, and returns z'out.
+//
+// The same as ParallelLinearCombination followed by ParallelDot but
+// in a single pass over memory. z may be the same array as out, in
+// which case the squared norm of out is returned. If z is NULL, the
+// dot product is not computed and zero is returned.
+double ParallelLinearCombinationDot(int num_elements,
+                                    double a,
+                                    const double* x,
+                                    double b,
+                                    const double* y,
+                                    const double* z,
+                                    double* out,
+                                    int num_threads);
+
+// Computes x'y and y'y in a single pass over memory.
+void ParallelDotAndSquaredNorm(int num_elements,
+                               const double* x,
+                               const double* y,
+                               int num_threads,
+                               double* x_dot_y,
+                               double* y_squared_norm);
+
+// Computes the squared Euclidean norm and the max norm of x in a
+// single pass over memory.
+void ParallelSquaredNormAndMaxNorm(int num_elements,
+                                   const double* x,
+                                   int num_threads,
+                                   double* squared_norm,
+                                   double* max_norm);
+
+}  // namespace internal
+}  // namespace ceres
+
+#endif  // CERES_INTERNAL_PARALLEL_VECTOR_OPS_H_
@@ -0,0 +1,136 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "ceres/parallel_vector_ops.h"
+
+#include <cmath>
+#include <cstdlib>
+#include "ceres/internal/eigen.h"
+#include "gtest/gtest.h"
+
+namespace ceres {
+namespace internal {
+
+const double kTolerance = 1e-12;
+
+// Sizes smaller than, equal to and not a multiple of the chunk size.
+const int kNumElements[] = {0, 1, 17, 4096, 10000, 50001};
+
+class ParallelVectorOpsTest : public ::testing::TestWithParam<int> {
+ protected:
+  virtual void SetUp() {
+    srand(5);
+    n_ = GetParam();
+    x_ = Vector::Random(n_);
+    y_ = Vector::Random(n_);
+    z_ = Vector::Random(n_);
+  }
+
+  int n_;
+  Vector x_;
+  Vector y_;
+  Vector z_;
+};
+
+TEST_P(ParallelVectorOpsTest, Dot) {
+  for (int num_threads = 1; num_threads <= 4; num_threads += 3) {
+    EXPECT_NEAR(ParallelDot(n_, x_.data(), y_.data(), num_threads),
+                x_.dot(y_),
+                kTolerance * n_);
+  }
+}
+
+TEST_P(ParallelVectorOpsTest, LinearCombinationDot) {
+  const Vector expected = 2.0 * x_ - 3.0 * y_;
+  for (int num_threads = 1; num_threads <= 4; num_threads += 3) {
+    Vector out(n_);
+    const double dot = ParallelLinearCombinationDot(n_,
+                                                    2.0, x_.data(),
+                                                    -3.0, y_.data(),
+                                                    z_.data(),
+                                                    out.data(),
+                                                    num_threads);
+    EXPECT_NEAR((out - expected).norm(), 0.0, kTolerance);
+    EXPECT_NEAR(dot, z_.dot(expected), kTolerance * n_);
+
+    // In place, with the squared norm of the result.
+    Vector y = y_;
+    const double squared_norm =
+        ParallelLinearCombinationDot(n_,
+                                     2.0, x_.data(),
+                                     -3.0, y.data(),
+                                     y.data(),
+                                     y.data(),
+                                     num_threads);
+    EXPECT_NEAR((y - expected).norm(), 0.0, kTolerance);
+    EXPECT_NEAR(squared_norm, expected.squaredNorm(), kTolerance * n_);
+
+    // Scaling, without a dot product.
+    ParallelLinearCombination(n_, 0.5, x_.data(), 0.0, x_.data(), out.data(),
+                              num_threads);
+    EXPECT_NEAR((out - 0.5 * x_).norm(), 0.0, kTolerance);
+  }
+}
+
+TEST_P(ParallelVectorOpsTest, DotAndSquaredNorm) {
+  for (int num_threads = 1; num_threads <= 4; num_threads += 3) {
+    double x_dot_y;
+    double y_squared_norm;
+    ParallelDotAndSquaredNorm(n_, x_.data(), y_.data(), num_threads,
+                              &x_dot_y, &y_squared_norm);
+    EXPECT_NEAR(x_dot_y, x_.dot(y_), kTolerance * n_);
+    EXPECT_NEAR(y_squared_norm, y_.squaredNorm(), kTolerance * n_);
+  }
+}
+
+TEST_P(ParallelVectorOpsTest, SquaredNormAndMaxNorm) {
+  const double expected_max_norm =
+      (n_ > 0) ? x_.lpNorm<Eigen::Infinity>() : 0.0;
+  for (int num_threads = 1; num_threads <= 4; num_threads += 3) {
+    double squared_norm;
+    double max_norm;
+    ParallelSquaredNormAndMaxNorm(n_, x_.data(), num_threads,
+                                  &squared_norm, &max_norm);
+    EXPECT_NEAR(squared_norm, x_.squaredNorm(), kTolerance * n_);
+    EXPECT_EQ(max_norm, expected_max_norm);
+  }
+}
+
+TEST_P(ParallelVectorOpsTest, ResultsDoNotDependOnTheNumberOfThreads) {
+  const double dot = ParallelDot(n_, x_.data(), y_.data(), 1);
+  for (int num_threads = 2; num_threads <= 8; ++num_threads) {
+    EXPECT_EQ(ParallelDot(n_, x_.data(), y_.data(), num_threads), dot);
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(ParallelVectorOps,
+                        ParallelVectorOpsTest,
+                        ::testing::ValuesIn(kNumElements));
+
+}  // namespace internal
+}  // namespace ceres
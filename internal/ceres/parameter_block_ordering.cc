@@ -30,7 +30,8 @@
 
 #include "ceres/parameter_block_ordering.h"
 
-#include "ceres/graph.h"
+#include "ceres/collections_port.h"
+#include "ceres/compressed_graph.h"
 #include "ceres/graph_algorithms.h"
 #include "ceres/internal/scoped_ptr.h"
 #include "ceres/map_util.h"
@@ -43,14 +44,22 @@ namespace ceres {
 namespace internal {
 
 int ComputeSchurOrdering(const Program& program,
+                         int num_threads,
                          vector<ParameterBlock*>* ordering) {
   CHECK_NOTNULL(ordering)->clear();
 
-  scoped_ptr<Graph< ParameterBlock*> > graph(CreateHessianGraph(program));
-  int independent_set_size = IndependentSetOrdering(*graph, ordering);
-  const vector<ParameterBlock*>& parameter_blocks = program.parameter_blocks();
+  vector<ParameterBlock*> vertices;
+  scoped_ptr<CompressedGraph> graph(
+      CreateHessianGraph(program, num_threads, &vertices));
+  vector<int> vertex_ordering;
+  const int independent_set_size =
+      IndependentSetOrdering(*graph, num_threads, &vertex_ordering);
+  for (int i = 0; i < vertex_ordering.size(); ++i) {
+    ordering->push_back(vertices[vertex_ordering[i]]);
+  }
 
   // Add the excluded blocks to back of the ordering vector.
+  const vector<ParameterBlock*>& parameter_blocks = program.parameter_blocks();
   for (int i = 0; i < parameter_blocks.size(); ++i) {
     ParameterBlock* parameter_block = parameter_blocks[i];
     if (parameter_block->IsConstant()) {
@@ -62,60 +71,102 @@ int ComputeSchurOrdering(const Program& program,
 }
 
 void ComputeRecursiveIndependentSetOrdering(const Program& program,
+                                            int num_threads,
                                             ParameterBlockOrdering* ordering) {
   CHECK_NOTNULL(ordering)->Clear();
-  const vector<ParameterBlock*> parameter_blocks = program.parameter_blocks();
-  scoped_ptr<Graph< ParameterBlock*> > graph(CreateHessianGraph(program));
+  vector<ParameterBlock*> vertices;
+  scoped_ptr<CompressedGraph> graph(
+      CreateHessianGraph(program, num_threads, &vertices));
 
+  // Instead of removing the vertices of each independent set from
+  // the graph, they are marked inactive.
+  vector<bool> is_active(vertices.size(), true);
   int num_covered = 0;
   int round = 0;
-  while (num_covered < parameter_blocks.size()) {
-    vector<ParameterBlock*> independent_set_ordering;
+  while (num_covered < vertices.size()) {
+    vector<int> independent_set_ordering;
     const int independent_set_size =
-        IndependentSetOrdering(*graph, &independent_set_ordering);
+        IndependentSetOrdering(*graph,
+                               is_active,
+                               num_threads,
+                               &independent_set_ordering);
     for (int i = 0; i < independent_set_size; ++i) {
-      ParameterBlock* parameter_block = independent_set_ordering[i];
-      ordering->AddElementToGroup(parameter_block->mutable_user_state(), round);
-      graph->RemoveVertex(parameter_block);
+      const int vertex = independent_set_ordering[i];
+      ordering->AddElementToGroup(vertices[vertex]->mutable_user_state(),
+                                  round);
+      is_active[vertex] = false;
     }
     num_covered += independent_set_size;
     ++round;
   }
 }
 
-Graph<ParameterBlock*>*
-CreateHessianGraph(const Program& program) {
-  Graph<ParameterBlock*>* graph = CHECK_NOTNULL(new Graph<ParameterBlock*>);
+CompressedGraph* CreateHessianGraph(const Program& program,
+                                    int num_threads,
+                                    vector<ParameterBlock*>* vertices) {
+  CHECK_NOTNULL(vertices)->clear();
   const vector<ParameterBlock*>& parameter_blocks = program.parameter_blocks();
+  HashMap<const ParameterBlock*, int> vertex_ids;
   for (int i = 0; i < parameter_blocks.size(); ++i) {
     ParameterBlock* parameter_block = parameter_blocks[i];
     if (!parameter_block->IsConstant()) {
-      graph->AddVertex(parameter_block);
+      vertex_ids[parameter_block] = vertices->size();
+      vertices->push_back(parameter_block);
     }
   }
 
+  // Every pair of non-constant parameter blocks in a residual block
+  // is an edge. Count the edges contributed by each residual block,
+  // so that they can be written out in parallel.
   const vector<ResidualBlock*>& residual_blocks = program.residual_blocks();
-  for (int i = 0; i < residual_blocks.size(); ++i) {
+  const int num_residual_blocks = residual_blocks.size();
+  vector<int> edge_offsets(num_residual_blocks + 1, 0);
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic, 256)
+  for (int i = 0; i < num_residual_blocks; ++i) {
+    const ResidualBlock* residual_block = residual_blocks[i];
+    const int num_parameter_blocks = residual_block->NumParameterBlocks();
+    ParameterBlock* const* parameter_blocks =
+        residual_block->parameter_blocks();
+    int num_varying = 0;
+    for (int j = 0; j < num_parameter_blocks; ++j) {
+      if (!parameter_blocks[j]->IsConstant()) {
+        ++num_varying;
+      }
+    }
+    edge_offsets[i + 1] = num_varying * (num_varying - 1) / 2;
+  }
+
+  for (int i = 0; i < num_residual_blocks; ++i) {
+    edge_offsets[i + 1] += edge_offsets[i];
+  }
+
+  vector<pair<int, int> > edges(edge_offsets.back());
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic, 256)
+  for (int i = 0; i < num_residual_blocks; ++i) {
     const ResidualBlock* residual_block = residual_blocks[i];
     const int num_parameter_blocks = residual_block->NumParameterBlocks();
     ParameterBlock* const* parameter_blocks =
         residual_block->parameter_blocks();
+    int edge = edge_offsets[i];
     for (int j = 0; j < num_parameter_blocks; ++j) {
       if (parameter_blocks[j]->IsConstant()) {
         continue;
       }
 
+      const int vertex1 = FindOrDie(vertex_ids, parameter_blocks[j]);
       for (int k = j + 1; k < num_parameter_blocks; ++k) {
         if (parameter_blocks[k]->IsConstant()) {
           continue;
         }
 
-        graph->AddEdge(parameter_blocks[j], parameter_blocks[k]);
+        edges[edge++] =
+            make_pair(vertex1, FindOrDie(vertex_ids, parameter_blocks[k]));
       }
     }
+    DCHECK_EQ(edge, edge_offsets[i + 1]);
   }
 
-  return graph;
+  return new CompressedGraph(vertices->size(), edges, num_threads);
 }
 
 }  // namespace internal
@@ -32,8 +32,8 @@
 #define CERES_INTERNAL_PARAMETER_BLOCK_ORDERING_H_
 
 #include <vector>
+#include "ceres/compressed_graph.h"
 #include "ceres/ordered_groups.h"
-#include "ceres/graph.h"
 #include "ceres/types.h"
 
 namespace ceres {
@@ -55,7 +55,11 @@ class ParameterBlock;
 // ordering = [independent set,
 //             complement of the independent set,
 //             fixed blocks]
+//
+// num_threads threads are used to construct the Hessian graph and
+// to compute the independent set.
 int ComputeSchurOrdering(const Program& program,
+                         int num_threads,
                          vector<ParameterBlock* >* ordering);
 
 // Use an approximate independent set ordering to decompose the
@@ -63,6 +67,7 @@ int ComputeSchurOrdering(const Program& program,
 // sets. The ordering covers all the non-constant parameter blocks in
 // the program.
 void ComputeRecursiveIndependentSetOrdering(const Program& program,
+                                            int num_threads,
                                             ParameterBlockOrdering* ordering);
 
 // Builds a graph on the parameter blocks of a Problem, whose
@@ -70,7 +75,14 @@ void ComputeRecursiveIndependentSetOrdering(const Program& program,
 // vertex corresponds to a parameter block in the Problem except for
 // parameter blocks that are marked constant. An edge connects two
 // parameter blocks, if they co-occur in a residual block.
-Graph<ParameterBlock*>* CreateHessianGraph(const Program& program);
+//
+// Vertex i of the graph corresponds to the parameter block
+// (*parameter_blocks)[i]; these are the non-constant parameter blocks
+// of the program, in the same order. The edges are enumerated in
+// parallel using num_threads threads. Caller owns the result.
+CompressedGraph* CreateHessianGraph(const Program& program,
+                                    int num_threads,
+                                    vector<ParameterBlock*>* parameter_blocks);
 
 }  // namespace internal
 }  // namespace ceres
@@ -34,7 +34,8 @@
 #include <vector>
 #include "gtest/gtest.h"
 #include "ceres/collections_port.h"
-#include "ceres/graph.h"
+#include "ceres/compressed_graph.h"
+#include "ceres/parameter_block.h"
 #include "ceres/problem_impl.h"
 #include "ceres/program.h"
 #include "ceres/stl_util.h"
@@ -45,9 +46,21 @@
 namespace ceres {
 namespace internal {
 
-typedef Graph<ParameterBlock*> HessianGraph;
 typedef HashSet<ParameterBlock*> VertexSet;
 
+// Returns the parameter blocks adjacent to the parameter block
+// corresponding to vertex in the Hessian graph.
+VertexSet Neighbors(const CompressedGraph& graph,
+                    const vector<ParameterBlock*>& vertices,
+                    const int vertex) {
+  VertexSet neighbors;
+  const int* cols = graph.Neighbors(vertex);
+  for (int i = 0; i < graph.Degree(vertex); ++i) {
+    neighbors.insert(vertices[cols[i]]);
+  }
+  return neighbors;
+}
+
 template <int M, int N1 = 0, int N2 = 0, int N3 = 0>
 class DummyCostFunction: public SizedCostFunction<M, N1, N2, N3> {
   virtual bool Evaluate(double const* const* parameters,
@@ -83,30 +96,30 @@ class SchurOrderingTest : public ::testing::Test {
 TEST_F(SchurOrderingTest, NoFixed) {
   const Program& program = problem_.program();
   const vector<ParameterBlock*>& parameter_blocks = program.parameter_blocks();
-  scoped_ptr<HessianGraph> graph(CreateHessianGraph(program));
-
-  const VertexSet& vertices = graph->vertices();
-  EXPECT_EQ(vertices.size(), 4);
+  vector<ParameterBlock*> vertices;
+  scoped_ptr<CompressedGraph> graph(CreateHessianGraph(program, 1, &vertices));
 
+  EXPECT_EQ(graph->num_vertices(), 4);
+  ASSERT_EQ(vertices.size(), 4);
   for (int i = 0; i < 4; ++i) {
-    EXPECT_TRUE(vertices.find(parameter_blocks[i]) != vertices.end());
+    EXPECT_EQ(vertices[i], parameter_blocks[i]);
   }
 
   {
-    const VertexSet& neighbors = graph->Neighbors(parameter_blocks[0]);
+    const VertexSet neighbors = Neighbors(*graph, vertices, 0);
     EXPECT_EQ(neighbors.size(), 2);
     EXPECT_TRUE(neighbors.find(parameter_blocks[2]) != neighbors.end());
     EXPECT_TRUE(neighbors.find(parameter_blocks[3]) != neighbors.end());
   }
 
   {
-    const VertexSet& neighbors = graph->Neighbors(parameter_blocks[1]);
+    const VertexSet neighbors = Neighbors(*graph, vertices, 1);
     EXPECT_EQ(neighbors.size(), 1);
     EXPECT_TRUE(neighbors.find(parameter_blocks[2]) != neighbors.end());
   }
 
   {
-    const VertexSet& neighbors = graph->Neighbors(parameter_blocks[2]);
+    const VertexSet neighbors = Neighbors(*graph, vertices, 2);
     EXPECT_EQ(neighbors.size(), 3);
     EXPECT_TRUE(neighbors.find(parameter_blocks[0]) != neighbors.end());
     EXPECT_TRUE(neighbors.find(parameter_blocks[1]) != neighbors.end());
@@ -114,13 +127,29 @@ TEST_F(SchurOrderingTest, NoFixed) {
   }
 
   {
-    const VertexSet& neighbors = graph->Neighbors(parameter_blocks[3]);
+    const VertexSet neighbors = Neighbors(*graph, vertices, 3);
     EXPECT_EQ(neighbors.size(), 2);
     EXPECT_TRUE(neighbors.find(parameter_blocks[0]) != neighbors.end());
     EXPECT_TRUE(neighbors.find(parameter_blocks[2]) != neighbors.end());
   }
 }
 
+TEST_F(SchurOrderingTest, NoFixedMultiThreaded) {
+  const Program& program = problem_.program();
+  vector<ParameterBlock*> vertices;
+  scoped_ptr<CompressedGraph> expected_graph(
+      CreateHessianGraph(program, 1, &vertices));
+  scoped_ptr<CompressedGraph> graph(CreateHessianGraph(program, 4, &vertices));
+
+  ASSERT_EQ(graph->num_vertices(), expected_graph->num_vertices());
+  for (int i = 0; i < graph->num_vertices(); ++i) {
+    ASSERT_EQ(graph->Degree(i), expected_graph->Degree(i));
+    for (int j = 0; j < graph->Degree(i); ++j) {
+      EXPECT_EQ(graph->Neighbors(i)[j], expected_graph->Neighbors(i)[j]);
+    }
+  }
+}
+
 TEST_F(SchurOrderingTest, AllFixed) {
   problem_.SetParameterBlockConstant(x_);
   problem_.SetParameterBlockConstant(y_);
@@ -128,8 +157,10 @@ TEST_F(SchurOrderingTest, AllFixed) {
   problem_.SetParameterBlockConstant(w_);
 
   const Program& program = problem_.program();
-  scoped_ptr<HessianGraph> graph(CreateHessianGraph(program));
-  EXPECT_EQ(graph->vertices().size(), 0);
+  vector<ParameterBlock*> vertices;
+  scoped_ptr<CompressedGraph> graph(CreateHessianGraph(program, 1, &vertices));
+  EXPECT_EQ(graph->num_vertices(), 0);
+  EXPECT_EQ(vertices.size(), 0);
 }
 
 TEST_F(SchurOrderingTest, OneFixed) {
@@ -137,41 +168,58 @@ TEST_F(SchurOrderingTest, OneFixed) {
 
   const Program& program = problem_.program();
   const vector<ParameterBlock*>& parameter_blocks = program.parameter_blocks();
-  scoped_ptr<HessianGraph> graph(CreateHessianGraph(program));
-
-  const VertexSet& vertices = graph->vertices();
+  vector<ParameterBlock*> vertices;
+  scoped_ptr<CompressedGraph> graph(CreateHessianGraph(program, 1, &vertices));
 
-  EXPECT_EQ(vertices.size(), 3);
-  EXPECT_TRUE(vertices.find(parameter_blocks[0]) == vertices.end());
-
-  for (int i = 1; i < 3; ++i) {
-    EXPECT_TRUE(vertices.find(parameter_blocks[i]) != vertices.end());
+  EXPECT_EQ(graph->num_vertices(), 3);
+  ASSERT_EQ(vertices.size(), 3);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(vertices[i], parameter_blocks[i + 1]);
   }
 
   {
-    const VertexSet& neighbors = graph->Neighbors(parameter_blocks[1]);
+    const VertexSet neighbors = Neighbors(*graph, vertices, 0);
     EXPECT_EQ(neighbors.size(), 1);
     EXPECT_TRUE(neighbors.find(parameter_blocks[2]) != neighbors.end());
   }
 
   {
-    const VertexSet& neighbors = graph->Neighbors(parameter_blocks[2]);
+    const VertexSet neighbors = Neighbors(*graph, vertices, 1);
     EXPECT_EQ(neighbors.size(), 2);
     EXPECT_TRUE(neighbors.find(parameter_blocks[1]) != neighbors.end());
     EXPECT_TRUE(neighbors.find(parameter_blocks[3]) != neighbors.end());
   }
 
   {
-    const VertexSet& neighbors = graph->Neighbors(parameter_blocks[3]);
+    const VertexSet neighbors = Neighbors(*graph, vertices, 2);
     EXPECT_EQ(neighbors.size(), 1);
     EXPECT_TRUE(neighbors.find(parameter_blocks[2]) != neighbors.end());
   }
 
   // The constant parameter block is at the end.
   vector<ParameterBlock*> ordering;
-  ComputeSchurOrdering(program, &ordering);
+  ComputeSchurOrdering(program, 1, &ordering);
   EXPECT_EQ(ordering.back(), parameter_blocks[0]);
 }
 
+TEST_F(SchurOrderingTest, RecursiveIndependentSetOrdering) {
+  const Program& program = problem_.program();
+  ParameterBlockOrdering ordering;
+  ComputeRecursiveIndependentSetOrdering(program, 1, &ordering);
+  EXPECT_EQ(ordering.NumElements(), 4);
+
+  // Every group must be an independent set in the Hessian graph.
+  vector<ParameterBlock*> vertices;
+  scoped_ptr<CompressedGraph> graph(CreateHessianGraph(program, 1, &vertices));
+  for (int i = 0; i < vertices.size(); ++i) {
+    const int group = ordering.GroupId(vertices[i]->mutable_user_state());
+    const int* neighbors = graph->Neighbors(i);
+    for (int j = 0; j < graph->Degree(i); ++j) {
+      EXPECT_NE(ordering.GroupId(vertices[neighbors[j]]->mutable_user_state()),
+                group);
+    }
+  }
+}
+
 }  // namespace internal
 }  // namespace ceres
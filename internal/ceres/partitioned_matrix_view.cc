@@ -48,6 +48,7 @@ PartitionedMatrixView::PartitionedMatrixView(
     const BlockSparseMatrixBase& matrix,
     int num_col_blocks_a)
     : matrix_(matrix),
+      single_precision_matrix_(NULL),
       num_col_blocks_e_(num_col_blocks_a) {
   const CompressedRowBlockStructure* bs = matrix_.block_structure();
   CHECK_NOTNULL(bs);
@@ -91,13 +92,29 @@ PartitionedMatrixView::~PartitionedMatrixView() {
 // input matrix is constructed. These methods will benefit from
 // multithreading as well as improved data layout.
 
-void PartitionedMatrixView::RightMultiplyE(const double* x, double* y) const {
+// The products with E and F use the single precision copy of the
+// values of the matrix if one is set.
+template <>
+const double* PartitionedMatrixView::RowBlockValues<double>(
+    int row_block_index) const {
+  return matrix_.RowBlockValues(row_block_index);
+}
+
+template <>
+const float* PartitionedMatrixView::RowBlockValues<float>(
+    int row_block_index) const {
+  return single_precision_matrix_->values();
+}
+
+template <typename T>
+void PartitionedMatrixView::RightMultiplyEInternal(const double* x,
+                                                   double* y) const {
   const CompressedRowBlockStructure* bs = matrix_.block_structure();
 
   // Iterate over the first num_row_blocks_e_ row blocks, and multiply
   // by the first cell in each row block.
   for (int r = 0; r < num_row_blocks_e_; ++r) {
-    const double* row_values = matrix_.RowBlockValues(r);
+    const T* row_values = RowBlockValues<T>(r);
     const Cell& cell = bs->rows[r].cells[0];
     const int row_block_pos = bs->rows[r].block.position;
     const int row_block_size = bs->rows[r].block.size;
@@ -111,7 +128,9 @@ void PartitionedMatrixView::RightMultiplyE(const double* x, double* y) const {
   }
 }
 
-void PartitionedMatrixView::RightMultiplyF(const double* x, double* y) const {
+template <typename T>
+void PartitionedMatrixView::RightMultiplyFInternal(const double* x,
+                                                   double* y) const {
   const CompressedRowBlockStructure* bs = matrix_.block_structure();
 
   // Iterate over row blocks, and if the row block is in E, then
@@ -124,7 +143,7 @@ void PartitionedMatrixView::RightMultiplyF(const double* x, double* y) const {
     const int row_block_size = bs->rows[r].block.size;
     const vector<Cell>& cells = bs->rows[r].cells;
     for (int c = (r < num_row_blocks_e_) ? 1 : 0; c < cells.size(); ++c) {
-      const double* row_values = matrix_.RowBlockValues(r);
+      const T* row_values = RowBlockValues<T>(r);
       const int col_block_id = cells[c].block_id;
       const int col_block_pos = bs->cols[col_block_id].position;
       const int col_block_size = bs->cols[col_block_id].size;
@@ -136,14 +155,16 @@ void PartitionedMatrixView::RightMultiplyF(const double* x, double* y) const {
   }
 }
 
-void PartitionedMatrixView::LeftMultiplyE(const double* x, double* y) const {
+template <typename T>
+void PartitionedMatrixView::LeftMultiplyEInternal(const double* x,
+                                                  double* y) const {
   const CompressedRowBlockStructure* bs = matrix_.block_structure();
 
   // Iterate over the first num_row_blocks_e_ row blocks, and multiply
   // by the first cell in each row block.
   for (int r = 0; r < num_row_blocks_e_; ++r) {
     const Cell& cell = bs->rows[r].cells[0];
-    const double* row_values = matrix_.RowBlockValues(r);
+    const T* row_values = RowBlockValues<T>(r);
     const int row_block_pos = bs->rows[r].block.position;
     const int row_block_size = bs->rows[r].block.size;
     const int col_block_id = cell.block_id;
@@ -156,7 +177,9 @@ void PartitionedMatrixView::LeftMultiplyE(const double* x, double* y) const {
   }
 }
 
-void PartitionedMatrixView::LeftMultiplyF(const double* x, double* y) const {
+template <typename T>
+void PartitionedMatrixView::LeftMultiplyFInternal(const double* x,
+                                                  double* y) const {
   const CompressedRowBlockStructure* bs = matrix_.block_structure();
 
   // Iterate over row blocks, and if the row block is in E, then
@@ -169,7 +192,7 @@ void PartitionedMatrixView::LeftMultiplyF(const double* x, double* y) const {
     const int row_block_size = bs->rows[r].block.size;
     const vector<Cell>& cells = bs->rows[r].cells;
     for (int c = (r < num_row_blocks_e_) ? 1 : 0; c < cells.size(); ++c) {
-      const double* row_values = matrix_.RowBlockValues(r);
+      const T* row_values = RowBlockValues<T>(r);
       const int col_block_id = cells[c].block_id;
       const int col_block_pos = bs->cols[col_block_id].position;
       const int col_block_size = bs->cols[col_block_id].size;
@@ -181,6 +204,38 @@ void PartitionedMatrixView::LeftMultiplyF(const double* x, double* y) const {
   }
 }
 
+void PartitionedMatrixView::RightMultiplyE(const double* x, double* y) const {
+  if (single_precision_matrix_ != NULL) {
+    RightMultiplyEInternal<float>(x, y);
+  } else {
+    RightMultiplyEInternal<double>(x, y);
+  }
+}
+
+void PartitionedMatrixView::RightMultiplyF(const double* x, double* y) const {
+  if (single_precision_matrix_ != NULL) {
+    RightMultiplyFInternal<float>(x, y);
+  } else {
+    RightMultiplyFInternal<double>(x, y);
+  }
+}
+
+void PartitionedMatrixView::LeftMultiplyE(const double* x, double* y) const {
+  if (single_precision_matrix_ != NULL) {
+    LeftMultiplyEInternal<float>(x, y);
+  } else {
+    LeftMultiplyEInternal<double>(x, y);
+  }
+}
+
+void PartitionedMatrixView::LeftMultiplyF(const double* x, double* y) const {
+  if (single_precision_matrix_ != NULL) {
+    LeftMultiplyFInternal<float>(x, y);
+  } else {
+    LeftMultiplyFInternal<double>(x, y);
+  }
+}
+
 // Given a range of columns blocks of a matrix m, compute the block
 // structure of the block diagonal of the matrix m(:,
 // start_col_block:end_col_block)'m(:, start_col_block:end_col_block)
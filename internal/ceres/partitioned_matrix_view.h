@@ -37,6 +37,7 @@
 #define CERES_INTERNAL_PARTITIONED_MATRIX_VIEW_H_
 
 #include "ceres/block_sparse_matrix.h"
+#include "ceres/single_precision_block_sparse_matrix.h"
 
 namespace ceres {
 namespace internal {
@@ -76,6 +77,15 @@ class PartitionedMatrixView {
   // y += Fx
   void RightMultiplyF(const double* x, double* y) const;
 
+  // Use single_precision_matrix, a single precision copy of the
+  // values of the matrix, for the four products above. The products
+  // are still accumulated in double precision. Does not take
+  // ownership. If it is NULL, the values of the matrix are used.
+  void set_single_precision_matrix(
+      const SinglePrecisionBlockSparseMatrix* single_precision_matrix) {
+    single_precision_matrix_ = single_precision_matrix;
+  }
+
   // Create and return the block diagonal of the matrix E'E.
   BlockSparseMatrix* CreateBlockDiagonalEtE() const;
 
@@ -102,12 +112,27 @@ class PartitionedMatrixView {
   int num_cols_f()       const { return num_cols_f_;        }
   int num_rows()         const { return matrix_.num_rows(); }
   int num_cols()         const { return matrix_.num_cols(); }
+  const BlockSparseMatrixBase& matrix() const { return matrix_; }
 
  private:
   BlockSparseMatrix* CreateBlockDiagonalMatrixLayout(int start_col_block,
                                                      int end_col_block) const;
 
+  // Values of the row block, in single precision if T is float.
+  template <typename T>
+  const T* RowBlockValues(int row_block_index) const;
+
+  template <typename T>
+  void RightMultiplyEInternal(const double* x, double* y) const;
+  template <typename T>
+  void RightMultiplyFInternal(const double* x, double* y) const;
+  template <typename T>
+  void LeftMultiplyEInternal(const double* x, double* y) const;
+  template <typename T>
+  void LeftMultiplyFInternal(const double* x, double* y) const;
+
   const BlockSparseMatrixBase& matrix_;
+  const SinglePrecisionBlockSparseMatrix* single_precision_matrix_;
   int num_row_blocks_e_;
   int num_col_blocks_e_;
   int num_col_blocks_f_;
@@ -37,6 +37,7 @@
 #include "ceres/internal/scoped_ptr.h"
 #include "ceres/linear_least_squares_problems.h"
 #include "ceres/random.h"
+#include "ceres/single_precision_block_sparse_matrix.h"
 #include "ceres/sparse_matrix.h"
 #include "glog/logging.h"
 #include "gtest/gtest.h"
@@ -187,5 +188,51 @@ TEST_F(PartitionedMatrixViewTest, BlockDiagonalFtF) {
   EXPECT_NEAR(block_diagonal_ff->values()[2], 37.0, kEpsilon);
 }
 
+// The entries of the test matrix are exactly representable in single
+// precision, so using a single precision copy of them should not
+// change the products.
+TEST_F(PartitionedMatrixViewTest, SinglePrecisionMatrix) {
+  const BlockSparseMatrix& A = *down_cast<BlockSparseMatrix*>(A_.get());
+  PartitionedMatrixView m(A, num_eliminate_blocks_);
+  PartitionedMatrixView single_precision_m(A, num_eliminate_blocks_);
+  SinglePrecisionBlockSparseMatrix single_precision_A(A);
+  single_precision_A.UpdateValues(A, 1);
+  single_precision_m.set_single_precision_matrix(&single_precision_A);
+
+  srand(5);
+  Vector x_e(m.num_cols_e());
+  Vector x_f(m.num_cols_f());
+  Vector x_rows(m.num_rows());
+  for (int i = 0; i < m.num_cols_e(); ++i) {
+    x_e(i) = RandDouble();
+  }
+  for (int i = 0; i < m.num_cols_f(); ++i) {
+    x_f(i) = RandDouble();
+  }
+  for (int i = 0; i < m.num_rows(); ++i) {
+    x_rows(i) = RandDouble();
+  }
+
+  Vector y1 = Vector::Zero(m.num_rows());
+  Vector y2 = Vector::Zero(m.num_rows());
+  m.RightMultiplyE(x_e.data(), y1.data());
+  single_precision_m.RightMultiplyE(x_e.data(), y2.data());
+  m.RightMultiplyF(x_f.data(), y1.data());
+  single_precision_m.RightMultiplyF(x_f.data(), y2.data());
+  EXPECT_LT((y1 - y2).norm(), kEpsilon);
+
+  Vector z1 = Vector::Zero(m.num_cols_e());
+  Vector z2 = Vector::Zero(m.num_cols_e());
+  m.LeftMultiplyE(x_rows.data(), z1.data());
+  single_precision_m.LeftMultiplyE(x_rows.data(), z2.data());
+  EXPECT_LT((z1 - z2).norm(), kEpsilon);
+
+  z1 = Vector::Zero(m.num_cols_f());
+  z2 = Vector::Zero(m.num_cols_f());
+  m.LeftMultiplyF(x_rows.data(), z1.data());
+  single_precision_m.LeftMultiplyF(x_rows.data(), z2.data());
+  EXPECT_LT((z1 - z2).norm(), kEpsilon);
+}
+
 }  // namespace internal
 }  // namespace ceres
@@ -39,6 +39,7 @@ namespace ceres {
 namespace internal {
 
 class BlockSparseMatrixBase;
+class SchurStructureCache;
 class SparseMatrix;
 
 class Preconditioner : public LinearOperator {
@@ -51,7 +52,8 @@ class Preconditioner : public LinearOperator {
           num_threads(1),
           row_block_size(Eigen::Dynamic),
           e_block_size(Eigen::Dynamic),
-          f_block_size(Eigen::Dynamic) {
+          f_block_size(Eigen::Dynamic),
+          schur_structure_cache(NULL) {
     }
 
     PreconditionerType type;
@@ -94,6 +96,9 @@ class Preconditioner : public LinearOperator {
     int row_block_size;
     int e_block_size;
     int f_block_size;
+
+    // See LinearSolver::Options::schur_structure_cache.
+    SchurStructureCache* schur_structure_cache;
   };
 
   virtual ~Preconditioner();
@@ -190,6 +190,11 @@ bool Problem::Evaluate(const EvaluateOptions& evaluate_options,
                                  jacobian);
 }
 
+Problem::EvaluationContext* Problem::CreateEvaluationContext(
+    const EvaluateOptions& evaluate_options) {
+  return problem_impl_->CreateEvaluationContext(evaluate_options);
+}
+
 int Problem::NumParameterBlocks() const {
   return problem_impl_->NumParameterBlocks();
 }
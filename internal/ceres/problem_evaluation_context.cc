@@ -0,0 +1,239 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "ceres/problem_evaluation_context.h"
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "ceres/casts.h"
+#include "ceres/compressed_row_sparse_matrix.h"
+#include "ceres/crs_matrix.h"
+#include "ceres/evaluator.h"
+#include "ceres/parameter_block.h"
+#include "ceres/program.h"
+#include "ceres/residual_block.h"
+#include "glog/logging.h"
+
+namespace ceres {
+namespace internal {
+namespace {
+
+// Returns true if crs_matrix already holds the sparsity structure of
+// matrix, in which case only the values need to be copied into it.
+bool HasSameStructure(const CompressedRowSparseMatrix& matrix,
+                      const CRSMatrix& crs_matrix) {
+  const int num_nonzeros = matrix.num_nonzeros();
+  return (crs_matrix.num_rows == matrix.num_rows() &&
+          crs_matrix.num_cols == matrix.num_cols() &&
+          crs_matrix.rows.size() == matrix.num_rows() + 1 &&
+          crs_matrix.cols.size() == num_nonzeros &&
+          crs_matrix.values.size() == num_nonzeros &&
+          equal(crs_matrix.rows.begin(),
+                crs_matrix.rows.end(),
+                matrix.rows()) &&
+          equal(crs_matrix.cols.begin(),
+                crs_matrix.cols.end(),
+                matrix.cols()));
+}
+
+}  // namespace
+
+ProblemEvaluationContext::ProblemEvaluationContext(
+    Program* program,
+    const Problem::EvaluateOptions& options)
+    : program_(program),
+      apply_loss_function_(options.apply_loss_function) {
+  const vector<ParameterBlock*>& parameter_blocks =
+      program_->parameter_blocks();
+  parameter_block_is_constant_.resize(parameter_blocks.size());
+  parameter_block_local_size_.resize(parameter_blocks.size());
+  for (int i = 0; i < parameter_blocks.size(); ++i) {
+    parameter_block_is_constant_[i] = parameter_blocks[i]->IsConstant();
+    parameter_block_local_size_[i] = parameter_blocks[i]->LocalSize();
+  }
+
+  // Only the parameter blocks used by the residual blocks of the
+  // program can affect the evaluation, so only those which are not
+  // in the program need to be excluded.
+  vector<ParameterBlock*> used_parameter_blocks;
+  const vector<ResidualBlock*>& residual_blocks = program_->residual_blocks();
+  for (int i = 0; i < residual_blocks.size(); ++i) {
+    const ResidualBlock* residual_block = residual_blocks[i];
+    for (int j = 0; j < residual_block->NumParameterBlocks(); ++j) {
+      used_parameter_blocks.push_back(residual_block->parameter_blocks()[j]);
+    }
+  }
+  sort(used_parameter_blocks.begin(), used_parameter_blocks.end());
+  used_parameter_blocks.erase(unique(used_parameter_blocks.begin(),
+                                     used_parameter_blocks.end()),
+                              used_parameter_blocks.end());
+
+  vector<ParameterBlock*> included_parameter_blocks(parameter_blocks);
+  sort(included_parameter_blocks.begin(), included_parameter_blocks.end());
+  set_difference(used_parameter_blocks.begin(),
+                 used_parameter_blocks.end(),
+                 included_parameter_blocks.begin(),
+                 included_parameter_blocks.end(),
+                 back_inserter(excluded_parameter_blocks_));
+  varying_excluded_parameter_blocks_.reserve(
+      excluded_parameter_blocks_.size());
+}
+
+ProblemEvaluationContext::~ProblemEvaluationContext() {
+}
+
+ProblemEvaluationContext* ProblemEvaluationContext::Create(
+    Program* program,
+    const Problem::EvaluateOptions& options,
+    string* error) {
+  scoped_ptr<ProblemEvaluationContext> context(
+      new ProblemEvaluationContext(program, options));
+
+  Evaluator::Options evaluator_options;
+
+  // Even though using SPARSE_NORMAL_CHOLESKY requires SuiteSparse or
+  // CXSparse, here it just being used for telling the evaluator to
+  // use a SparseRowCompressedMatrix for the jacobian. This is because
+  // the Evaluator decides the storage for the Jacobian based on the
+  // type of linear solver being used.
+  evaluator_options.linear_solver_type = SPARSE_NORMAL_CHOLESKY;
+  evaluator_options.num_threads = options.num_threads;
+
+  context->PrepareParameterBlocks();
+  context->evaluator_.reset(
+      Evaluator::Create(evaluator_options, program, error));
+  context->RestoreParameterBlocks();
+  if (context->evaluator_.get() == NULL) {
+    return NULL;
+  }
+
+  context->parameters_.resize(program->NumParameters());
+  return context.release();
+}
+
+bool ProblemEvaluationContext::Evaluate(double* cost,
+                                        double* residuals,
+                                        double* gradient,
+                                        CRSMatrix* jacobian) {
+  const vector<ParameterBlock*>& parameter_blocks =
+      program_->parameter_blocks();
+  for (int i = 0; i < parameter_blocks.size(); ++i) {
+    if (parameter_blocks[i]->IsConstant() != parameter_block_is_constant_[i]) {
+      LOG(ERROR) << "A parameter block was made "
+                 << (parameter_block_is_constant_[i] ? "variable" : "constant")
+                 << " after the evaluation context was created. "
+                 << "Please create a new evaluation context.";
+      return false;
+    }
+
+    if (parameter_blocks[i]->LocalSize() != parameter_block_local_size_[i]) {
+      LOG(ERROR) << "The local parameterization of a parameter block was "
+                 << "changed after the evaluation context was created. "
+                 << "Please create a new evaluation context.";
+      return false;
+    }
+  }
+
+  PrepareParameterBlocks();
+
+  if (jacobian != NULL && jacobian_.get() == NULL) {
+    jacobian_.reset(
+        down_cast<CompressedRowSparseMatrix*>(evaluator_->CreateJacobian()));
+  }
+
+  // Point the state pointers to the user state pointers, and copy
+  // their values into a vector, since Evaluator::Evaluate needs its
+  // input as such.
+  program_->SetParameterBlockStatePtrsToUserStatePtrs();
+  program_->ParameterBlocksToStateVector(parameters_.data());
+
+  double tmp_cost = 0.0;
+  Evaluator::EvaluateOptions evaluate_options;
+  evaluate_options.apply_loss_function = apply_loss_function_;
+  const bool status =
+      evaluator_->Evaluate(evaluate_options,
+                           parameters_.data(),
+                           &tmp_cost,
+                           residuals,
+                           gradient,
+                           (jacobian != NULL) ? jacobian_.get() : NULL);
+
+  RestoreParameterBlocks();
+
+  if (!status) {
+    return false;
+  }
+
+  if (cost != NULL) {
+    *cost = tmp_cost;
+  }
+
+  if (jacobian != NULL) {
+    if (HasSameStructure(*jacobian_, *jacobian)) {
+      copy(jacobian_->values(),
+           jacobian_->values() + jacobian_->num_nonzeros(),
+           jacobian->values.begin());
+    } else {
+      jacobian_->ToCRSMatrix(jacobian);
+    }
+  }
+
+  return true;
+}
+
+int ProblemEvaluationContext::NumResiduals() const {
+  return evaluator_->NumResiduals();
+}
+
+int ProblemEvaluationContext::NumEffectiveParameters() const {
+  return evaluator_->NumEffectiveParameters();
+}
+
+void ProblemEvaluationContext::PrepareParameterBlocks() {
+  varying_excluded_parameter_blocks_.clear();
+  for (int i = 0; i < excluded_parameter_blocks_.size(); ++i) {
+    ParameterBlock* parameter_block = excluded_parameter_blocks_[i];
+    if (!parameter_block->IsConstant()) {
+      varying_excluded_parameter_blocks_.push_back(parameter_block);
+      parameter_block->SetConstant();
+    }
+  }
+  program_->SetParameterOffsetsAndIndex();
+}
+
+void ProblemEvaluationContext::RestoreParameterBlocks() {
+  for (int i = 0; i < varying_excluded_parameter_blocks_.size(); ++i) {
+    varying_excluded_parameter_blocks_[i]->SetVarying();
+  }
+  varying_excluded_parameter_blocks_.clear();
+}
+
+}  // namespace internal
+}  // namespace ceres
@@ -0,0 +1,120 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Implementation of Problem::EvaluationContext.
+
+#ifndef CERES_INTERNAL_PROBLEM_EVALUATION_CONTEXT_H_
+#define CERES_INTERNAL_PROBLEM_EVALUATION_CONTEXT_H_
+
+#include <string>
+#include <vector>
+#include "ceres/internal/eigen.h"
+#include "ceres/internal/macros.h"
+#include "ceres/internal/port.h"
+#include "ceres/internal/scoped_ptr.h"
+#include "ceres/problem.h"
+
+namespace ceres {
+namespace internal {
+
+class CompressedRowSparseMatrix;
+class Evaluator;
+class ParameterBlock;
+class Program;
+
+// Holds the Program and the Evaluator used to evaluate a subset of
+// the residual and parameter blocks of a problem, so that they are
+// created once instead of in every call to Problem::Evaluate.
+//
+// The parameter blocks used by the residual blocks of the program
+// which are not in it are excluded from the evaluation by marking
+// them constant for the duration of each call to Evaluate.
+class ProblemEvaluationContext : public Problem::EvaluationContext {
+ public:
+  // Takes ownership of program, whose residual and parameter blocks
+  // are the ones to be evaluated. Returns NULL and sets error if the
+  // evaluator cannot be created.
+  static ProblemEvaluationContext* Create(
+      Program* program,
+      const Problem::EvaluateOptions& options,
+      string* error);
+
+  virtual ~ProblemEvaluationContext();
+
+  // Problem::EvaluationContext interface.
+  virtual bool Evaluate(double* cost,
+                        double* residuals,
+                        double* gradient,
+                        CRSMatrix* jacobian);
+  virtual int NumResiduals() const;
+  virtual int NumEffectiveParameters() const;
+
+ private:
+  ProblemEvaluationContext(Program* program,
+                           const Problem::EvaluateOptions& options);
+
+  // Mark the excluded parameter blocks which are not constant as
+  // constant, and set up the parameter block indices and offsets of
+  // the program, which may have been changed by other users of the
+  // parameter blocks since the last evaluation.
+  void PrepareParameterBlocks();
+
+  // Undo the changes to the excluded parameter blocks made by
+  // PrepareParameterBlocks.
+  void RestoreParameterBlocks();
+
+  scoped_ptr<Program> program_;
+  const bool apply_loss_function_;
+
+  // Constancy and local sizes of the parameter blocks of the program
+  // when the context was created. The structure of the jacobian and
+  // the size of the gradient depend on them.
+  vector<bool> parameter_block_is_constant_;
+  vector<int> parameter_block_local_size_;
+
+  // Parameter blocks not in the program which are used by its
+  // residual blocks, and the ones among them which were made constant
+  // by the last call to PrepareParameterBlocks.
+  vector<ParameterBlock*> excluded_parameter_blocks_;
+  vector<ParameterBlock*> varying_excluded_parameter_blocks_;
+
+  scoped_ptr<Evaluator> evaluator_;
+  Vector parameters_;
+
+  // The jacobian is created the first time it is requested. Its
+  // structure is only copied into the CRSMatrix passed by the user
+  // if the matrix does not already hold it.
+  scoped_ptr<CompressedRowSparseMatrix> jacobian_;
+
+  CERES_DISALLOW_COPY_AND_ASSIGN(ProblemEvaluationContext);
+};
+
+}  // namespace internal
+}  // namespace ceres
+
+#endif  // CERES_INTERNAL_PROBLEM_EVALUATION_CONTEXT_H_
@@ -46,8 +46,10 @@
 #include "ceres/loss_function.h"
 #include "ceres/map_util.h"
 #include "ceres/parameter_block.h"
+#include "ceres/problem_evaluation_context.h"
 #include "ceres/program.h"
 #include "ceres/residual_block.h"
+#include "ceres/schur_structure_cache.h"
 #include "ceres/stl_util.h"
 #include "ceres/stringprintf.h"
 #include "glog/logging.h"
@@ -187,10 +189,19 @@ void ProblemImpl::DeleteBlock(ParameterBlock* parameter_block) {
   delete parameter_block;
 }
 
-ProblemImpl::ProblemImpl() : program_(new internal::Program) {}
+// The number of distinct block structures for which the symbolic
+// state of the Schur type linear solvers is remembered.
+static const int kMaxNumCachedSchurStructures = 2;
+
+ProblemImpl::ProblemImpl()
+    : program_(new internal::Program),
+      schur_structure_cache_(
+          new SchurStructureCache(kMaxNumCachedSchurStructures)) {}
 ProblemImpl::ProblemImpl(const Problem::Options& options)
     : options_(options),
-      program_(new internal::Program) {}
+      program_(new internal::Program),
+      schur_structure_cache_(
+          new SchurStructureCache(kMaxNumCachedSchurStructures)) {}
 
 ProblemImpl::~ProblemImpl() {
   // Collect the unique cost/loss functions and delete the residuals.
@@ -544,155 +555,69 @@ bool ProblemImpl::Evaluate(const Problem::EvaluateOptions& evaluate_options,
     return true;
   }
 
+  scoped_ptr<Problem::EvaluationContext> context(
+      CreateEvaluationContext(evaluate_options));
+  if (context.get() == NULL) {
+    return false;
+  }
+
+  if (residuals != NULL) {
+    residuals->resize(context->NumResiduals());
+  }
+
+  if (gradient != NULL) {
+    gradient->resize(context->NumEffectiveParameters());
+  }
+
+  return context->Evaluate(
+      cost,
+      (residuals != NULL && !residuals->empty()) ? &(*residuals)[0] : NULL,
+      (gradient != NULL && !gradient->empty()) ? &(*gradient)[0] : NULL,
+      jacobian);
+}
+
+Problem::EvaluationContext* ProblemImpl::CreateEvaluationContext(
+    const Problem::EvaluateOptions& evaluate_options) {
   // If the user supplied residual blocks, then use them, otherwise
   // take the residual blocks from the underlying program.
-  Program program;
-  *program.mutable_residual_blocks() =
+  scoped_ptr<Program> program(new Program);
+  *program->mutable_residual_blocks() =
       ((evaluate_options.residual_blocks.size() > 0)
        ? evaluate_options.residual_blocks : program_->residual_blocks());
 
   const vector<double*>& parameter_block_ptrs =
       evaluate_options.parameter_blocks;
-
-  vector<ParameterBlock*> variable_parameter_blocks;
   vector<ParameterBlock*>& parameter_blocks =
-      *program.mutable_parameter_blocks();
-
+      *program->mutable_parameter_blocks();
   if (parameter_block_ptrs.size() == 0) {
     // The user did not provide any parameter blocks, so default to
     // using all the parameter blocks in the order that they are in
     // the underlying program object.
     parameter_blocks = program_->parameter_blocks();
   } else {
-    // The user supplied a vector of parameter blocks. Using this list
-    // requires a number of steps.
-
-    // 1. Convert double* into ParameterBlock*
+    // The user supplied a vector of parameter blocks. The ones used
+    // by the residual blocks which are not in it are held constant
+    // during evaluation by the context, so that they are not
+    // included in the columns of the jacobian.
     parameter_blocks.resize(parameter_block_ptrs.size());
     for (int i = 0; i < parameter_block_ptrs.size(); ++i) {
       parameter_blocks[i] =
           FindParameterBlockOrDie(parameter_block_map_,
                                   parameter_block_ptrs[i]);
     }
-
-    // 2. The user may have only supplied a subset of parameter
-    // blocks, so identify the ones that are not supplied by the user
-    // and are NOT constant. These parameter blocks are stored in
-    // variable_parameter_blocks.
-    //
-    // To ensure that the parameter blocks are not included in the
-    // columns of the jacobian, we need to make sure that they are
-    // constant during evaluation and then make them variable again
-    // after we are done.
-    vector<ParameterBlock*> all_parameter_blocks(program_->parameter_blocks());
-    vector<ParameterBlock*> included_parameter_blocks(
-        program.parameter_blocks());
-
-    vector<ParameterBlock*> excluded_parameter_blocks;
-    sort(all_parameter_blocks.begin(), all_parameter_blocks.end());
-    sort(included_parameter_blocks.begin(), included_parameter_blocks.end());
-    set_difference(all_parameter_blocks.begin(),
-                   all_parameter_blocks.end(),
-                   included_parameter_blocks.begin(),
-                   included_parameter_blocks.end(),
-                   back_inserter(excluded_parameter_blocks));
-
-    variable_parameter_blocks.reserve(excluded_parameter_blocks.size());
-    for (int i = 0; i < excluded_parameter_blocks.size(); ++i) {
-      ParameterBlock* parameter_block = excluded_parameter_blocks[i];
-      if (!parameter_block->IsConstant()) {
-        variable_parameter_blocks.push_back(parameter_block);
-        parameter_block->SetConstant();
-      }
-    }
   }
 
-  // Setup the Parameter indices and offsets before an evaluator can
-  // be constructed and used.
-  program.SetParameterOffsetsAndIndex();
-
-  Evaluator::Options evaluator_options;
-
-  // Even though using SPARSE_NORMAL_CHOLESKY requires SuiteSparse or
-  // CXSparse, here it just being used for telling the evaluator to
-  // use a SparseRowCompressedMatrix for the jacobian. This is because
-  // the Evaluator decides the storage for the Jacobian based on the
-  // type of linear solver being used.
-  evaluator_options.linear_solver_type = SPARSE_NORMAL_CHOLESKY;
-  evaluator_options.num_threads = evaluate_options.num_threads;
-
   string error;
-  scoped_ptr<Evaluator> evaluator(
-      Evaluator::Create(evaluator_options, &program, &error));
-  if (evaluator.get() == NULL) {
+  ProblemEvaluationContext* context =
+      ProblemEvaluationContext::Create(program.release(),
+                                       evaluate_options,
+                                       &error);
+  if (context == NULL) {
     LOG(ERROR) << "Unable to create an Evaluator object. "
                << "Error: " << error
                << "This is a Ceres bug; please contact the developers!";
-
-    // Make the parameter blocks that were temporarily marked
-    // constant, variable again.
-    for (int i = 0; i < variable_parameter_blocks.size(); ++i) {
-      variable_parameter_blocks[i]->SetVarying();
-    }
-    return false;
-  }
-
-  if (residuals !=NULL) {
-    residuals->resize(evaluator->NumResiduals());
-  }
-
-  if (gradient != NULL) {
-    gradient->resize(evaluator->NumEffectiveParameters());
   }
-
-  scoped_ptr<CompressedRowSparseMatrix> tmp_jacobian;
-  if (jacobian != NULL) {
-    tmp_jacobian.reset(
-        down_cast<CompressedRowSparseMatrix*>(evaluator->CreateJacobian()));
-  }
-
-  // Point the state pointers to the user state pointers. This is
-  // needed so that we can extract a parameter vector which is then
-  // passed to Evaluator::Evaluate.
-  program.SetParameterBlockStatePtrsToUserStatePtrs();
-
-  // Copy the value of the parameter blocks into a vector, since the
-  // Evaluate::Evaluate method needs its input as such. The previous
-  // call to SetParameterBlockStatePtrsToUserStatePtrs ensures that
-  // these values are the ones corresponding to the actual state of
-  // the parameter blocks, rather than the temporary state pointer
-  // used for evaluation.
-  Vector parameters(program.NumParameters());
-  program.ParameterBlocksToStateVector(parameters.data());
-
-  double tmp_cost = 0;
-
-  Evaluator::EvaluateOptions evaluator_evaluate_options;
-  evaluator_evaluate_options.apply_loss_function =
-      evaluate_options.apply_loss_function;
-  bool status = evaluator->Evaluate(evaluator_evaluate_options,
-                                    parameters.data(),
-                                    &tmp_cost,
-                                    residuals != NULL ? &(*residuals)[0] : NULL,
-                                    gradient != NULL ? &(*gradient)[0] : NULL,
-                                    tmp_jacobian.get());
-
-  // Make the parameter blocks that were temporarily marked constant,
-  // variable again.
-  for (int i = 0; i < variable_parameter_blocks.size(); ++i) {
-    variable_parameter_blocks[i]->SetVarying();
-  }
-
-  if (status) {
-    if (cost != NULL) {
-      *cost = tmp_cost;
-    }
-    if (jacobian != NULL) {
-      tmp_jacobian->ToCRSMatrix(jacobian);
-    }
-  }
-
-  return status;
+  return context;
 }
 
 int ProblemImpl::NumParameterBlocks() const {
@@ -59,6 +59,7 @@ namespace internal {
 
 class Program;
 class ResidualBlock;
+class SchurStructureCache;
 
 class ProblemImpl {
  public:
@@ -134,6 +135,9 @@ class ProblemImpl {
                 vector<double>* gradient,
                 CRSMatrix* jacobian);
 
+  Problem::EvaluationContext* CreateEvaluationContext(
+      const Problem::EvaluateOptions& options);
+
   int NumParameterBlocks() const;
   int NumParameters() const;
   int NumResidualBlocks() const;
@@ -144,6 +148,14 @@ class ProblemImpl {
 
   const ParameterMap& parameter_map() const { return parameter_block_map_; }
 
+  // Symbolic state of the Schur type linear solvers used to solve
+  // this problem, kept around so that it can be reused by subsequent
+  // calls to Solver::Solve if the structure of the problem does not
+  // change.
+  SchurStructureCache* mutable_schur_structure_cache() {
+    return schur_structure_cache_.get();
+  }
+
  private:
   ParameterBlock* InternalAddParameterBlock(double* values, int size);
 
@@ -170,6 +182,8 @@ class ProblemImpl {
   // The actual parameter and residual blocks.
   internal::scoped_ptr<internal::Program> program_;
 
+  internal::scoped_ptr<SchurStructureCache> schur_structure_cache_;
+
   // When removing residual and parameter blocks, cost/loss functions and
   // parameterizations have ambiguous ownership. Instead of scanning the entire
   // problem to see if the cost/loss/parameterization is shared with other
@@ -32,6 +32,8 @@
 #include "ceres/problem.h"
 #include "ceres/problem_impl.h"
 
+#include <algorithm>
+
 #include "ceres/casts.h"
 #include "ceres/cost_function.h"
 #include "ceres/crs_matrix.h"
@@ -1217,5 +1219,111 @@ TEST_F(ProblemEvaluateTest, LocalParameterization) {
   CheckAllEvaluationCombinations(Problem::EvaluateOptions(), expected);
 }
 
+TEST_F(ProblemEvaluateTest, EvaluationContext) {
+  Problem::EvaluateOptions evaluate_options;
+  // x, z
+  evaluate_options.parameter_blocks.push_back(parameter_blocks_[0]);
+  evaluate_options.parameter_blocks.push_back(parameter_blocks_[2]);
+  evaluate_options.residual_blocks = residual_blocks_;
+
+  scoped_ptr<Problem::EvaluationContext> context(
+      problem_.CreateEvaluationContext(evaluate_options));
+  ASSERT_TRUE(context.get() != NULL);
+  EXPECT_EQ(context->NumResiduals(), 6);
+  EXPECT_EQ(context->NumEffectiveParameters(), 4);
+
+  double cost;
+  vector<double> residuals(context->NumResiduals());
+  vector<double> gradient(context->NumEffectiveParameters());
+  CRSMatrix jacobian;
+  const double* jacobian_values = NULL;
+  for (int k = 0; k < 3; ++k) {
+    parameters_[0] = k + 1.0;
+    parameters_[5] = 2.0 * k;
+    ASSERT_TRUE(context->Evaluate(&cost,
+                                  &residuals[0],
+                                  &gradient[0],
+                                  &jacobian));
+
+    // The jacobian is not reallocated by repeated evaluations.
+    if (k == 0) {
+      jacobian_values = &jacobian.values[0];
+    }
+    EXPECT_EQ(jacobian_values, &jacobian.values[0]);
+
+    // The excluded parameter block y is not left constant.
+    EXPECT_FALSE(problem_.program().parameter_blocks()[1]->IsConstant());
+
+    double expected_cost;
+    vector<double> expected_residuals;
+    vector<double> expected_gradient;
+    CRSMatrix expected_jacobian;
+    ASSERT_TRUE(problem_.Evaluate(evaluate_options,
+                                  &expected_cost,
+                                  &expected_residuals,
+                                  &expected_gradient,
+                                  &expected_jacobian));
+    EXPECT_EQ(cost, expected_cost);
+    EXPECT_TRUE(residuals == expected_residuals);
+    EXPECT_TRUE(gradient == expected_gradient);
+    EXPECT_EQ(jacobian.num_rows, expected_jacobian.num_rows);
+    EXPECT_EQ(jacobian.num_cols, expected_jacobian.num_cols);
+    EXPECT_TRUE(jacobian.rows == expected_jacobian.rows);
+    EXPECT_TRUE(jacobian.cols == expected_jacobian.cols);
+    EXPECT_TRUE(jacobian.values == expected_jacobian.values);
+  }
+}
+
+TEST_F(ProblemEvaluateTest, EvaluationContextRestoresJacobianStructure) {
+  scoped_ptr<Problem::EvaluationContext> context(
+      problem_.CreateEvaluationContext(Problem::EvaluateOptions()));
+  ASSERT_TRUE(context.get() != NULL);
+
+  double cost;
+  CRSMatrix jacobian;
+  ASSERT_TRUE(context->Evaluate(&cost, NULL, NULL, &jacobian));
+  const CRSMatrix expected_jacobian = jacobian;
+
+  // Change the structure of the jacobian without changing the number
+  // of non-zeros, as a user reusing the same CRSMatrix for another
+  // matrix would.
+  reverse(jacobian.cols.begin(), jacobian.cols.end());
+  ASSERT_TRUE(context->Evaluate(&cost, NULL, NULL, &jacobian));
+  EXPECT_TRUE(jacobian.rows == expected_jacobian.rows);
+  EXPECT_TRUE(jacobian.cols == expected_jacobian.cols);
+  EXPECT_TRUE(jacobian.values == expected_jacobian.values);
+}
+
+TEST_F(ProblemEvaluateTest, EvaluationContextDetectsConstancyChange) {
+  scoped_ptr<Problem::EvaluationContext> context(
+      problem_.CreateEvaluationContext(Problem::EvaluateOptions()));
+  ASSERT_TRUE(context.get() != NULL);
+
+  double cost;
+  EXPECT_TRUE(context->Evaluate(&cost, NULL, NULL, NULL));
+  problem_.SetParameterBlockConstant(parameters_);
+  EXPECT_FALSE(context->Evaluate(&cost, NULL, NULL, NULL));
+  problem_.SetParameterBlockVariable(parameters_);
+  EXPECT_TRUE(context->Evaluate(&cost, NULL, NULL, NULL));
+}
+
+TEST_F(ProblemEvaluateTest, EvaluationContextDetectsParameterizationChange) {
+  scoped_ptr<Problem::EvaluationContext> context(
+      problem_.CreateEvaluationContext(Problem::EvaluateOptions()));
+  ASSERT_TRUE(context.get() != NULL);
+  EXPECT_EQ(context->NumEffectiveParameters(), 6);
+
+  double cost;
+  EXPECT_TRUE(context->Evaluate(&cost, NULL, NULL, NULL));
+
+  // x gets a local parameterization, which changes the size of the
+  // gradient and the jacobian.
+  vector<int> constant_parameters;
+  constant_parameters.push_back(0);
+  problem_.SetParameterization(
+      parameters_, new SubsetParameterization(2, constant_parameters));
+  EXPECT_FALSE(context->Evaluate(&cost, NULL, NULL, NULL));
+}
+
 }  // namespace internal
 }  // namespace ceres
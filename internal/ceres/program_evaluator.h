@@ -45,18 +45,31 @@
 //
 // The evaluation is threaded with OpenMP.
 //
-// The EvaluatePreparer and JacobianWriter interfaces are as follows:
+// When only the cost and the residuals are requested, the loss
+// functions are not applied one residual block at a time. Instead the
+// squared norms of the residual blocks are stored, and once all the
+// cost functions have been evaluated, the loss functions are applied
+// in batches of residual blocks sharing the same loss function (see
+// EvaluationPlan::LossFunctionBatch).
+//
+// The residual blocks are evaluated by scanning an EvaluationPlan built
+// when the evaluator is created, which the EvaluatePreparer and the
+// JacobianWriter share with the evaluator. The EvaluatePreparer and
+// JacobianWriter interfaces are as follows:
 //
 //   class EvaluatePreparer {
 //     // Prepare the jacobians array for use as the destination of a call to
 //     // a cost function's evaluate method.
-//     void Prepare(const ResidualBlock* residual_block,
-//                  int residual_block_index,
+//     void Prepare(int residual_block_index,
 //                  SparseMatrix* jacobian,
 //                  double** jacobians);
 //   }
 //
 //   class JacobianWriter {
+//     JacobianWriter(const Evaluator::Options& options,
+//                    Program* program,
+//                    const EvaluationPlan* plan);
+//
 //     // Create a jacobian that this writer can write. Same as
 //     // Evaluator::CreateJacobian.
 //     SparseMatrix* CreateJacobian() const;
@@ -85,9 +98,12 @@
 
 #include <map>
 #include <vector>
+#include "ceres/corrector.h"
+#include "ceres/evaluation_plan.h"
 #include "ceres/execution_summary.h"
 #include "ceres/internal/eigen.h"
 #include "ceres/internal/scoped_ptr.h"
+#include "ceres/loss_function.h"
 #include "ceres/parameter_block.h"
 #include "ceres/program.h"
 #include "ceres/residual_block.h"
@@ -101,16 +117,17 @@ class ProgramEvaluator : public Evaluator {
   ProgramEvaluator(const Evaluator::Options &options, Program* program)
       : options_(options),
         program_(program),
-        jacobian_writer_(options, program),
+        plan_(*program),
+        jacobian_writer_(options, program, &plan_),
         evaluate_preparers_(
-            jacobian_writer_.CreateEvaluatePreparers(options.num_threads)) {
+            jacobian_writer_.CreateEvaluatePreparers(options.num_threads)),
+        squared_norms_(new double[plan_.num_residual_blocks()]) {
 #ifndef CERES_USE_OPENMP
     CHECK_EQ(1, options_.num_threads)
         << "OpenMP support is not compiled into this binary; "
         << "only options.num_threads=1 is supported.";
 #endif
 
-    BuildResidualLayout(*program, &residual_layout_);
     evaluate_scratch_.reset(CreateEvaluatorScratch(*program,
                                                    options.num_threads));
   }
@@ -132,7 +149,10 @@ class ProgramEvaluator : public Evaluator {
                                          : "Evaluator::Jacobian",
                                          &execution_summary_);
 
-    // The parameters are stateful, so set the state before evaluating.
+    // The cost functions are evaluated directly on the state vector
+    // (see EvaluationPlan::GetParameters), but the local
+    // parameterization jacobians are computed by the parameter blocks
+    // when their state is set, so set the state before evaluating.
     if (!program_->StateVectorToParameterBlocks(state)) {
       return false;
     }
@@ -154,11 +174,19 @@ class ProgramEvaluator : public Evaluator {
       }
     }
 
+    // Without jacobians, the loss functions are applied in batches
+    // after the cost functions have been evaluated.
+    const bool batch_loss_functions =
+        evaluate_options.apply_loss_function &&
+        jacobian == NULL &&
+        gradient == NULL &&
+        plan_.num_loss_function_batches() > 0;
+
     // This bool is used to disable the loop if an error is encountered
     // without breaking out of it. The remaining loop iterations are still run,
     // but with an empty body, and so will finish quickly.
     bool abort = false;
-    int num_residual_blocks = program_->NumResidualBlocks();
+    const int num_residual_blocks = plan_.num_residual_blocks();
 #pragma omp parallel for num_threads(options_.num_threads)
     for (int i = 0; i < num_residual_blocks; ++i) {
 // Disable the loop instead of breaking, as required by OpenMP.
@@ -176,10 +204,10 @@ class ProgramEvaluator : public Evaluator {
       EvaluateScratch* scratch = &evaluate_scratch_[thread_id];
 
       // Prepare block residuals if requested.
-      const ResidualBlock* residual_block = program_->residual_blocks()[i];
+      const EvaluationPlan::ResidualBlockEntry& entry = plan_.residual_block(i);
       double* block_residuals = NULL;
       if (residuals != NULL) {
-        block_residuals = residuals + residual_layout_[i];
+        block_residuals = residuals + entry.residual_offset;
       } else if (gradient != NULL) {
         block_residuals = scratch->residual_block_residuals.get();
       }
@@ -187,17 +215,20 @@ class ProgramEvaluator : public Evaluator {
       // Prepare block jacobians if requested.
       double** block_jacobians = NULL;
       if (jacobian != NULL || gradient != NULL) {
-        preparer->Prepare(residual_block,
-                          i,
-                          jacobian,
-                          scratch->jacobian_block_ptrs.get());
+        preparer->Prepare(i, jacobian, scratch->jacobian_block_ptrs.get());
         block_jacobians = scratch->jacobian_block_ptrs.get();
       }
 
       // Evaluate the cost, residuals, and jacobians.
+      const double** block_parameters = scratch->parameter_block_ptrs.get();
+      plan_.GetParameters(i, state, block_parameters);
+      const bool defer_loss_function =
+          batch_loss_functions &&
+          entry.residual_block->loss_function() != NULL;
       double block_cost;
-      if (!residual_block->Evaluate(
-              evaluate_options.apply_loss_function,
+      if (!entry.residual_block->Evaluate(
+              evaluate_options.apply_loss_function && !defer_loss_function,
+              block_parameters,
               &block_cost,
               block_residuals,
               block_jacobians,
@@ -210,38 +241,55 @@ class ProgramEvaluator : public Evaluator {
         continue;
       }
 
+      if (defer_loss_function) {
+        squared_norms_[i] = 2.0 * block_cost;
+        continue;
+      }
+
       scratch->cost += block_cost;
 
       // Store the jacobians, if they were requested.
       if (jacobian != NULL) {
         jacobian_writer_.Write(i,
-                               residual_layout_[i],
+                               entry.residual_offset,
                                block_jacobians,
                                jacobian);
       }
 
       // Compute and store the gradient, if it was requested.
       if (gradient != NULL) {
-        int num_residuals = residual_block->NumResiduals();
-        int num_parameter_blocks = residual_block->NumParameterBlocks();
-        for (int j = 0; j < num_parameter_blocks; ++j) {
-          const ParameterBlock* parameter_block =
-              residual_block->parameter_blocks()[j];
-          if (parameter_block->IsConstant()) {
+        const EvaluationPlan::Argument* arguments = plan_.arguments(i);
+        ConstVectorRef block_residual(block_residuals, entry.num_residuals);
+        for (int j = 0; j < entry.num_arguments; ++j) {
+          if (arguments[j].delta_offset < 0) {
             continue;
           }
-          MatrixRef block_jacobian(block_jacobians[j],
-                                   num_residuals,
-                                   parameter_block->LocalSize());
+          ConstMatrixRef block_jacobian(block_jacobians[j],
+                                        entry.num_residuals,
+                                        arguments[j].local_size);
           VectorRef block_gradient(scratch->gradient.get() +
-                                   parameter_block->delta_offset(),
-                                   parameter_block->LocalSize());
-          VectorRef block_residual(block_residuals, num_residuals);
+                                   arguments[j].delta_offset,
+                                   arguments[j].local_size);
           block_gradient += block_residual.transpose() * block_jacobian;
         }
       }
     }
 
+    if (!abort && batch_loss_functions) {
+      const int num_batches = plan_.num_loss_function_batches();
+#pragma omp parallel for num_threads(options_.num_threads)
+      for (int i = 0; i < num_batches; ++i) {
+#ifdef CERES_USE_OPENMP
+        int thread_id = omp_get_thread_num();
+#else
+        int thread_id = 0;
+#endif
+        ApplyLossFunctionBatch(plan_.loss_function_batch(i),
+                               residuals,
+                               &evaluate_scratch_[thread_id]);
+      }
+    }
+
     if (!abort) {
       // Sum the cost and gradient (if requested) from each thread.
       (*cost) = 0.0;
@@ -300,6 +348,10 @@ class ProgramEvaluator : public Evaluator {
           new double[max_residuals_per_residual_block]);
       jacobian_block_ptrs.reset(
           new double*[max_parameters_per_residual_block]);
+      parameter_block_ptrs.reset(
+          new const double*[max_parameters_per_residual_block]);
+      loss_function_batch.reset(
+          new double[4 * EvaluationPlan::kMaxLossFunctionBatchSize]);
     }
 
     double cost;
@@ -309,17 +361,51 @@ class ProgramEvaluator : public Evaluator {
     // Enough space to store the residual for the largest residual block.
     scoped_array<double> residual_block_residuals;
     scoped_array<double*> jacobian_block_ptrs;
+    scoped_array<const double*> parameter_block_ptrs;
+    // The squared norms and the values and derivatives of the loss
+    // function of a batch of residual blocks.
+    scoped_array<double> loss_function_batch;
   };
 
-  static void BuildResidualLayout(const Program& program,
-                                  vector<int>* residual_layout) {
-    const vector<ResidualBlock*>& residual_blocks = program.residual_blocks();
-    residual_layout->resize(program.NumResidualBlocks());
-    int residual_pos = 0;
-    for (int i = 0; i < residual_blocks.size(); ++i) {
-      const int num_residuals = residual_blocks[i]->NumResiduals();
-      (*residual_layout)[i] = residual_pos;
-      residual_pos += num_residuals;
+  // Applies the loss function of a batch of residual blocks to their
+  // squared norms, adding their cost to scratch->cost and correcting
+  // their residuals if requested.
+  void ApplyLossFunctionBatch(const EvaluationPlan::LossFunctionBatch& batch,
+                              double* residuals,
+                              EvaluateScratch* scratch) const {
+    const int kSize = EvaluationPlan::kMaxLossFunctionBatchSize;
+    double* sq_norms = scratch->loss_function_batch.get();
+    double* rho0 = sq_norms + kSize;
+    double* rho1 = rho0 + kSize;
+    double* rho2 = rho1 + kSize;
+
+    const int* residual_blocks =
+        plan_.robustified_residual_blocks() + batch.begin;
+    for (int j = 0; j < batch.size; ++j) {
+      sq_norms[j] = squared_norms_[residual_blocks[j]];
+    }
+
+    batch.loss_function->EvaluateBatch(batch.size,
+                                       sq_norms,
+                                       rho0,
+                                       rho1,
+                                       rho2);
+
+    for (int j = 0; j < batch.size; ++j) {
+      scratch->cost += 0.5 * rho0[j];
+    }
+
+    if (residuals == NULL) {
+      return;
+    }
+
+    for (int j = 0; j < batch.size; ++j) {
+      const EvaluationPlan::ResidualBlockEntry& entry =
+          plan_.residual_block(residual_blocks[j]);
+      const double rho[3] = { rho0[j], rho1[j], rho2[j] };
+      Corrector correct(sq_norms[j], rho);
+      correct.CorrectResiduals(entry.num_residuals,
+                               residuals + entry.residual_offset);
     }
   }
 
@@ -346,10 +432,15 @@ class ProgramEvaluator : public Evaluator {
 
   Evaluator::Options options_;
   Program* program_;
+  // Must be declared before jacobian_writer_, which is constructed
+  // with a pointer to it.
+  EvaluationPlan plan_;
   JacobianWriter jacobian_writer_;
   scoped_array<EvaluatePreparer> evaluate_preparers_;
   scoped_array<EvaluateScratch> evaluate_scratch_;
-  vector<int> residual_layout_;
+  // The squared norms of the residual blocks, used when the loss
+  // functions are applied in batches.
+  scoped_array<double> squared_norms_;
   ::ceres::internal::ExecutionSummary execution_summary_;
 };
 
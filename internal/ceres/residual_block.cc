@@ -68,7 +68,6 @@ bool ResidualBlock::Evaluate(const bool apply_loss_function,
                              double** jacobians,
                              double* scratch) const {
   const int num_parameter_blocks = NumParameterBlocks();
-  const int num_residuals = cost_function_->num_residuals();
 
   // Collect the parameters from their blocks. This will rarely allocate, since
   // residuals taking more than 8 parameter block arguments are rare.
@@ -77,6 +76,23 @@ bool ResidualBlock::Evaluate(const bool apply_loss_function,
     parameters[i] = parameter_blocks_[i]->state();
   }
 
+  return Evaluate(apply_loss_function,
+                  parameters.get(),
+                  cost,
+                  residuals,
+                  jacobians,
+                  scratch);
+}
+
+bool ResidualBlock::Evaluate(const bool apply_loss_function,
+                             double const* const* parameters,
+                             double* cost,
+                             double* residuals,
+                             double** jacobians,
+                             double* scratch) const {
+  const int num_parameter_blocks = NumParameterBlocks();
+  const int num_residuals = cost_function_->num_residuals();
+
   // Put pointers into the scratch space into global_jacobians as appropriate.
   FixedArray<double*, 8> global_jacobians(num_parameter_blocks);
   if (jacobians != NULL) {
@@ -105,12 +121,12 @@ bool ResidualBlock::Evaluate(const bool apply_loss_function,
 
   InvalidateEvaluation(*this, cost, residuals, eval_jacobians);
 
-  if (!cost_function_->Evaluate(parameters.get(), residuals, eval_jacobians)) {
+  if (!cost_function_->Evaluate(parameters, residuals, eval_jacobians)) {
     return false;
   }
 
   if (!IsEvaluationValid(*this,
-                         parameters.get(),
+                         parameters,
                          cost,
                          residuals,
                          eval_jacobians)) {
@@ -121,7 +137,7 @@ bool ResidualBlock::Evaluate(const bool apply_loss_function,
         "residual and jacobians that were requested or there was a non-finite value (nan/infinite)\n"  // NOLINT
         "generated during the or jacobian computation. \n\n" +
         EvaluationToString(*this,
-                           parameters.get(),
+                           parameters,
                            cost,
                            residuals,
                            eval_jacobians);
@@ -102,6 +102,16 @@ class ResidualBlock {
                 double** jacobians,
                 double* scratch) const;
 
+  // Same as above, except that the values of the parameter blocks are
+  // read from parameters instead of the states of the parameter
+  // blocks. This allows the ProgramEvaluator to point the cost
+  // function directly at the state vector being evaluated.
+  bool Evaluate(bool apply_loss_function,
+                double const* const* parameters,
+                double* cost,
+                double* residuals,
+                double** jacobians,
+                double* scratch) const;
 
   const CostFunction* cost_function() const { return cost_function_; }
   const LossFunction* loss_function() const { return loss_function_; }
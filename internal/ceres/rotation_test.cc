@@ -965,6 +965,199 @@ TEST(AngleAxis, NearZeroRotatePointGivesSameAnswerAsRotationMatrix) {
   }
 }
 
+// Computes the rotated point and its jacobians with respect to the
+// rotation and the point by differentiating through the generic (i.e.,
+// non-Jet specific) implementation of a RotatePoint function.
+template <int kRotationSize>
+struct RotatePointAutoDiff {
+  typedef Jet<double, kRotationSize + 3> JetT;
+  typedef void (*RotatePointFunction)(const JetT*, const JetT*, JetT*);
+
+  static void Evaluate(RotatePointFunction rotate_point,
+                       const double* rotation,
+                       const double* pt,
+                       double* result,
+                       double* jacobian_rotation,
+                       double* jacobian_pt) {
+    JetT rotation_jet[kRotationSize];
+    JetT pt_jet[3];
+    JetT result_jet[3];
+    for (int i = 0; i < kRotationSize; ++i) {
+      rotation_jet[i] = JetT(rotation[i], i);
+    }
+    for (int i = 0; i < 3; ++i) {
+      pt_jet[i] = JetT(pt[i], kRotationSize + i);
+    }
+    rotate_point(rotation_jet, pt_jet, result_jet);
+    for (int i = 0; i < 3; ++i) {
+      result[i] = result_jet[i].a;
+      for (int j = 0; j < kRotationSize; ++j) {
+        jacobian_rotation[i * kRotationSize + j] = result_jet[i].v[j];
+      }
+      for (int j = 0; j < 3; ++j) {
+        jacobian_pt[i * 3 + j] = result_jet[i].v[kRotationSize + j];
+      }
+    }
+  }
+};
+
+static void ExpectRotatePointWithJacobiansIsCorrect(
+    const double* angle_axis,
+    const double* pt) {
+  double expected_result[3];
+  double expected_jacobian_angle_axis[9];
+  double expected_jacobian_pt[9];
+  RotatePointAutoDiff<3>::Evaluate(
+      &AngleAxisRotatePoint<RotatePointAutoDiff<3>::JetT>,
+      angle_axis,
+      pt,
+      expected_result,
+      expected_jacobian_angle_axis,
+      expected_jacobian_pt);
+
+  double result[3];
+  double jacobian_angle_axis[9];
+  double jacobian_pt[9];
+  AngleAxisRotatePointWithJacobians(angle_axis,
+                                    pt,
+                                    result,
+                                    jacobian_angle_axis,
+                                    jacobian_pt);
+  ExpectArraysClose(3, result, expected_result, kLooseTolerance);
+  ExpectArraysClose(9,
+                    jacobian_angle_axis,
+                    expected_jacobian_angle_axis,
+                    kLooseTolerance);
+  ExpectArraysClose(9, jacobian_pt, expected_jacobian_pt, kLooseTolerance);
+}
+
+TEST(AngleAxis, RotatePointWithJacobians) {
+  double angle_axis[3];
+  double pt[3];
+  for (int i = 0; i < 1000; ++i) {
+    // Cover both sides of the switch to the Taylor series.
+    const double scale = pow(10.0, -4.0 * RandDouble());
+    for (int k = 0; k < 3; ++k) {
+      angle_axis[k] = scale * (2.0 * RandDouble() - 1.0);
+      pt[k] = 2.0 * RandDouble() - 1.0;
+    }
+    ExpectRotatePointWithJacobiansIsCorrect(angle_axis, pt);
+  }
+
+  const double zero[3] = { 0.0, 0.0, 0.0 };
+  ExpectRotatePointWithJacobiansIsCorrect(zero, pt);
+}
+
+TEST(AngleAxis, RotatePointWithJacobiansAllowsNullJacobians) {
+  const double angle_axis[3] = { 0.1, -0.3, 0.7 };
+  const double pt[3] = { 1.0, 2.0, 3.0 };
+  double expected_result[3];
+  AngleAxisRotatePoint(angle_axis, pt, expected_result);
+
+  double result[3];
+  AngleAxisRotatePointWithJacobians<double>(angle_axis, pt, result, NULL, NULL);
+  ExpectArraysClose(3, result, expected_result, kTolerance);
+}
+
+TEST(Quaternion, RotatePointWithJacobians) {
+  double q[4];
+  double pt[3];
+  for (int i = 0; i < 1000; ++i) {
+    for (int k = 0; k < 4; ++k) {
+      q[k] = 2.0 * RandDouble() - 1.0;
+    }
+    for (int k = 0; k < 3; ++k) {
+      pt[k] = 2.0 * RandDouble() - 1.0;
+    }
+
+    double expected_result[3];
+    double expected_jacobian_q[12];
+    double expected_jacobian_pt[9];
+    double result[3];
+    double jacobian_q[12];
+    double jacobian_pt[9];
+
+    RotatePointAutoDiff<4>::Evaluate(
+        &QuaternionRotatePoint<RotatePointAutoDiff<4>::JetT>,
+        q,
+        pt,
+        expected_result,
+        expected_jacobian_q,
+        expected_jacobian_pt);
+    QuaternionRotatePointWithJacobians(q, pt, result, jacobian_q, jacobian_pt);
+    ExpectArraysClose(3, result, expected_result, kLooseTolerance);
+    ExpectArraysClose(12, jacobian_q, expected_jacobian_q, kLooseTolerance);
+    ExpectArraysClose(9, jacobian_pt, expected_jacobian_pt, kLooseTolerance);
+
+    // The unit quaternion version is only correct for unit quaternions,
+    // but its jacobian is that of the (unnormalized) formula.
+    RotatePointAutoDiff<4>::Evaluate(
+        &UnitQuaternionRotatePoint<RotatePointAutoDiff<4>::JetT>,
+        q,
+        pt,
+        expected_result,
+        expected_jacobian_q,
+        expected_jacobian_pt);
+    UnitQuaternionRotatePointWithJacobians(q,
+                                           pt,
+                                           result,
+                                           jacobian_q,
+                                           jacobian_pt);
+    ExpectArraysClose(3, result, expected_result, kLooseTolerance);
+    ExpectArraysClose(12, jacobian_q, expected_jacobian_q, kLooseTolerance);
+    ExpectArraysClose(9, jacobian_pt, expected_jacobian_pt, kLooseTolerance);
+  }
+}
+
+template <int N>
+void ExpectJetArraysNear(int n,
+                         const Jet<double, N>* x,
+                         const Jet<double, N>* y) {
+  for (int i = 0; i < n; ++i) {
+    EXPECT_NEAR(x[i].a, y[i].a, kLooseTolerance);
+    for (int j = 0; j < N; ++j) {
+      EXPECT_NEAR(x[i].v[j], y[i].v[j], kLooseTolerance);
+    }
+  }
+}
+
+// The overloads for Jets must agree with differentiating through the
+// generic implementations, which are selected here by passing the
+// template argument explicitly.
+TEST(Rotation, RotatePointOverloadsForJets) {
+  typedef Jet<double, 7> JetT;
+  JetT angle_axis[3];
+  JetT q[4];
+  JetT pt[3];
+  for (int k = 0; k < 3; ++k) {
+    angle_axis[k] = JetT(2.0 * RandDouble() - 1.0, k);
+    pt[k] = JetT(2.0 * RandDouble() - 1.0, 4 + k);
+  }
+  for (int k = 0; k < 4; ++k) {
+    q[k] = JetT(2.0 * RandDouble() - 1.0, k);
+  }
+
+  JetT expected[3];
+  JetT actual[3];
+  AngleAxisRotatePoint<JetT>(angle_axis, pt, expected);
+  AngleAxisRotatePoint(angle_axis, pt, actual);
+  ExpectJetArraysNear(3, actual, expected);
+
+  QuaternionRotatePoint<JetT>(q, pt, expected);
+  QuaternionRotatePoint(q, pt, actual);
+  ExpectJetArraysNear(3, actual, expected);
+
+  UnitQuaternionRotatePoint<JetT>(q, pt, expected);
+  UnitQuaternionRotatePoint(q, pt, actual);
+  ExpectJetArraysNear(3, actual, expected);
+
+  // Rotating in place.
+  JetT pt_copy[3] = { pt[0], pt[1], pt[2] };
+  AngleAxisRotatePoint<JetT>(angle_axis, pt, expected);
+  AngleAxisRotatePoint(angle_axis, pt_copy, pt_copy);
+  ExpectJetArraysNear(3, pt_copy, expected);
+}
+
 TEST(MatrixAdapter, RowMajor3x3ReturnTypeAndAccessIsCorrect) {
   double array[9] = { 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0 };
   const float const_array[9] =
@@ -32,11 +32,17 @@
 
 #include "ceres/runtime_numeric_diff_cost_function.h"
 
+#ifdef CERES_USE_OPENMP
+#include <omp.h>
+#endif
+
 #include <algorithm>
 #include <numeric>
 #include <vector>
 #include "Eigen/Dense"
 #include "ceres/cost_function.h"
+#include "ceres/internal/eigen.h"
+#include "ceres/internal/numeric_diff.h"
 #include "ceres/internal/scoped_ptr.h"
 #include "glog/logging.h"
 
@@ -44,88 +50,62 @@ namespace ceres {
 namespace internal {
 namespace {
 
-bool EvaluateJacobianForParameterBlock(const CostFunction* function,
-                                       int parameter_block_size,
-                                       int parameter_block,
-                                       RuntimeNumericDiffMethod method,
-                                       double relative_step_size,
-                                       double const* residuals_at_eval_point,
-                                       double** parameters,
-                                       double** jacobians) {
-  using Eigen::Map;
-  using Eigen::Matrix;
-  using Eigen::Dynamic;
-  using Eigen::RowMajor;
-
-  typedef Matrix<double, Dynamic, 1> ResidualVector;
-  typedef Matrix<double, Dynamic, 1> ParameterVector;
-  typedef Matrix<double, Dynamic, Dynamic, RowMajor> JacobianMatrix;
-
-  int num_residuals = function->num_residuals();
-
-  Map<JacobianMatrix> parameter_jacobian(jacobians[parameter_block],
-                                         num_residuals,
-                                         parameter_block_size);
-
-  // Mutate one element at a time and then restore.
-  Map<ParameterVector> x_plus_delta(parameters[parameter_block],
-                                    parameter_block_size);
-  ParameterVector x(x_plus_delta);
-  ParameterVector step_size = x.array().abs() * relative_step_size;
-
-  // To handle cases where a paremeter is exactly zero, instead use the mean
-  // step_size for the other dimensions.
-  double fallback_step_size = step_size.sum() / step_size.rows();
-  if (fallback_step_size == 0.0) {
-    // If all the parameters are zero, there's no good answer. Use the given
-    // relative step_size as absolute step_size and hope for the best.
-    fallback_step_size = relative_step_size;
+// Computes column j of the jacobian of the parameter block
+// parameter_block by perturbing parameters[parameter_block][j]. The
+// parameter is restored before returning. residuals is scratch space
+// for num_residuals doubles.
+bool EvaluateJacobianColumn(const CostFunction* function,
+                            int parameter_block_size,
+                            int parameter_block,
+                            int j,
+                            double step_size,
+                            RuntimeNumericDiffMethod method,
+                            double const* residuals_at_eval_point,
+                            double** parameters,
+                            double* residuals,
+                            double** jacobians) {
+  const int num_residuals = function->num_residuals();
+  double* x_plus_delta = parameters[parameter_block];
+  const double x = x_plus_delta[j];
+
+  MatrixRef parameter_jacobian(jacobians[parameter_block],
+                               num_residuals,
+                               parameter_block_size);
+  ConstVectorRef residuals_vector(residuals, num_residuals);
+
+  x_plus_delta[j] = x + step_size;
+  if (!function->Evaluate(parameters, residuals, NULL)) {
+    // Something went wrong; bail.
+    x_plus_delta[j] = x;
+    return false;
   }
 
-  // For each parameter in the parameter block, use finite differences to
-  // compute the derivative for that parameter.
-  for (int j = 0; j < parameter_block_size; ++j) {
-    if (step_size(j) == 0.0) {
-      // The parameter is exactly zero, so compromise and use the mean step_size
-      // from the other parameters. This can break in many cases, but it's hard
-      // to pick a good number without problem specific knowledge.
-      step_size(j) = fallback_step_size;
-    }
-    x_plus_delta(j) = x(j) + step_size(j);
+  // Compute this column of the jacobian in 3 steps:
+  // 1. Store residuals for the forward part.
+  // 2. Subtract residuals for the backward (or 0) part.
+  // 3. Divide out the run.
+  parameter_jacobian.col(j) = residuals_vector;
 
-    ResidualVector residuals(num_residuals);
-    if (!function->Evaluate(parameters, &residuals[0], NULL)) {
+  double one_over_h = 1 / step_size;
+  if (method == CENTRAL) {
+    // Compute the function on the other side of x.
+    x_plus_delta[j] = x - step_size;
+    if (!function->Evaluate(parameters, residuals, NULL)) {
       // Something went wrong; bail.
+      x_plus_delta[j] = x;
       return false;
     }
-
-    // Compute this column of the jacobian in 3 steps:
-    // 1. Store residuals for the forward part.
-    // 2. Subtract residuals for the backward (or 0) part.
-    // 3. Divide out the run.
-    parameter_jacobian.col(j) = residuals;
-
-    double one_over_h = 1 / step_size(j);
-    if (method == CENTRAL) {
-      // Compute the function on the other side of x(j).
-      x_plus_delta(j) = x(j) - step_size(j);
-
-      if (!function->Evaluate(parameters, &residuals[0], NULL)) {
-        // Something went wrong; bail.
-        return false;
-      }
-      parameter_jacobian.col(j) -= residuals;
-      one_over_h /= 2;
-    } else {
-      // Forward difference only; reuse existing residuals evaluation.
-      parameter_jacobian.col(j) -=
-          Map<const ResidualVector>(residuals_at_eval_point, num_residuals);
-    }
-    x_plus_delta(j) = x(j);  // Restore x_plus_delta.
-
-    // Divide out the run to get slope.
-    parameter_jacobian.col(j) *= one_over_h;
+    parameter_jacobian.col(j) -= residuals_vector;
+    one_over_h /= 2;
+  } else {
+    // Forward difference only; reuse existing residuals evaluation.
+    parameter_jacobian.col(j) -=
+        ConstVectorRef(residuals_at_eval_point, num_residuals);
   }
+  x_plus_delta[j] = x;  // Restore x_plus_delta.
+
+  // Divide out the run to get slope.
+  parameter_jacobian.col(j) *= one_over_h;
   return true;
 }
 
@@ -133,10 +113,20 @@ class RuntimeNumericDiffCostFunction : public CostFunction {
  public:
   RuntimeNumericDiffCostFunction(const CostFunction* function,
                                  RuntimeNumericDiffMethod method,
-                                 double relative_step_size)
+                                 double relative_step_size,
+                                 int num_threads)
       : function_(function),
         method_(method),
-        relative_step_size_(relative_step_size) {
+        relative_step_size_(relative_step_size),
+        num_threads_(num_threads) {
+    CHECK_GE(num_threads, 1);
+#ifndef CERES_USE_OPENMP
+    LOG_IF(WARNING, num_threads > 1)
+        << "OpenMP support is not compiled into this binary; "
+        << "only num_threads = 1 is supported. Switching to single "
+        << "threaded mode.";
+    num_threads_ = 1;
+#endif
     *mutable_parameter_block_sizes() = function->parameter_block_sizes();
     set_num_residuals(function->num_residuals());
   }
@@ -157,60 +147,136 @@ class RuntimeNumericDiffCostFunction : public CostFunction {
       return true;
     }
 
-    const vector<int16>& block_sizes = function_->parameter_block_sizes();
-    CHECK(!block_sizes.empty());
-
-    // Create local space for a copy of the parameters which will get mutated.
-    int parameters_size = accumulate(block_sizes.begin(), block_sizes.end(), 0);
-    vector<double> parameters_copy(parameters_size);
-    vector<double*> parameters_references_copy(block_sizes.size());
-    parameters_references_copy[0] = &parameters_copy[0];
-    for (int block = 1; block < block_sizes.size(); ++block) {
-      parameters_references_copy[block] = parameters_references_copy[block - 1]
-          + block_sizes[block - 1];
-    }
-
-    // Copy the parameters into the local temp space.
-    for (int block = 0; block < block_sizes.size(); ++block) {
-      memcpy(parameters_references_copy[block],
-             parameters[block],
-             block_sizes[block] * sizeof(*parameters[block]));
-    }
-
-    for (int block = 0; block < block_sizes.size(); ++block) {
-      if (!jacobians[block]) {
-        // No jacobian requested for this parameter / residual pair.
-        continue;
-      }
-      if (!EvaluateJacobianForParameterBlock(function_,
-                                             block_sizes[block],
-                                             block,
-                                             method_,
-                                             relative_step_size_,
-                                             residuals,
-                                             &parameters_references_copy[0],
-                                             jacobians)) {
-        return false;
-      }
-    }
-    return true;
+    return EvaluateJacobianColumnsInParallel(
+        function_,
+        (method_ == CENTRAL) ? ceres::CENTRAL : ceres::FORWARD,
+        relative_step_size_,
+        num_threads_,
+        parameters,
+        residuals,
+        jacobians);
   }
 
  private:
   const CostFunction* function_;
   RuntimeNumericDiffMethod method_;
   double relative_step_size_;
+  int num_threads_;
 };
 
 }  // namespace
 
+bool EvaluateJacobianColumnsInParallel(const CostFunction* cost_function,
+                                       const NumericDiffMethod method,
+                                       const double relative_step_size,
+                                       const int num_threads,
+                                       double const* const* parameters,
+                                       double const* residuals,
+                                       double** jacobians) {
+  CHECK(method == ceres::CENTRAL || method == ceres::FORWARD);
+  const vector<int16>& block_sizes = cost_function->parameter_block_sizes();
+  CHECK(!block_sizes.empty());
+  const int num_blocks = block_sizes.size();
+  const int num_residuals = cost_function->num_residuals();
+  const int parameters_size =
+      accumulate(block_sizes.begin(), block_sizes.end(), 0);
+
+  // Enumerate the (parameter block, coordinate) pairs for which a
+  // jacobian column is requested, along with their step sizes.
+  vector<int> block_offsets(num_blocks);
+  vector<int> column_blocks;
+  vector<int> column_coordinates;
+  vector<double> step_sizes(parameters_size);
+  for (int block = 0, offset = 0; block < num_blocks; ++block) {
+    block_offsets[block] = offset;
+    if (jacobians[block] != NULL) {
+      ComputeStepSizes(parameters[block],
+                       block_sizes[block],
+                       relative_step_size,
+                       &step_sizes[offset]);
+      for (int j = 0; j < block_sizes[block]; ++j) {
+        column_blocks.push_back(block);
+        column_coordinates.push_back(j);
+      }
+    }
+    offset += block_sizes[block];
+  }
+
+  const int num_columns = column_blocks.size();
+  if (num_columns == 0) {
+    return true;
+  }
+
+#ifdef CERES_USE_OPENMP
+  const int num_used_threads = std::max(1, std::min(num_threads, num_columns));
+#else
+  const int num_used_threads = 1;
+#endif
+
+  // Each thread perturbs its own copy of the parameters, so the
+  // columns can be evaluated independently of each other.
+  vector<double> parameters_copy(num_used_threads * parameters_size);
+  vector<double*> parameters_references_copy(num_used_threads * num_blocks);
+  vector<double> residuals_scratch(num_used_threads * num_residuals);
+  for (int thread_id = 0; thread_id < num_used_threads; ++thread_id) {
+    double* cursor = &parameters_copy[thread_id * parameters_size];
+    for (int block = 0; block < num_blocks; ++block) {
+      memcpy(cursor,
+             parameters[block],
+             block_sizes[block] * sizeof(*parameters[block]));
+      parameters_references_copy[thread_id * num_blocks + block] = cursor;
+      cursor += block_sizes[block];
+    }
+  }
+
+  const RuntimeNumericDiffMethod column_method =
+      (method == ceres::CENTRAL) ? CENTRAL : FORWARD;
+
+  // This bool is used to disable the loop if an error is encountered
+  // without breaking out of it.
+  bool abort = false;
+#pragma omp parallel for num_threads(num_used_threads) schedule(dynamic)
+  for (int i = 0; i < num_columns; ++i) {
+// Disable the loop instead of breaking, as required by OpenMP.
+#pragma omp flush(abort)
+    if (abort) {
+      continue;
+    }
+
+#ifdef CERES_USE_OPENMP
+    const int thread_id = omp_get_thread_num();
+#else
+    const int thread_id = 0;
+#endif
+    const int block = column_blocks[i];
+    const int j = column_coordinates[i];
+    if (!EvaluateJacobianColumn(
+            cost_function,
+            block_sizes[block],
+            block,
+            j,
+            step_sizes[block_offsets[block] + j],
+            column_method,
+            residuals,
+            &parameters_references_copy[thread_id * num_blocks],
+            &residuals_scratch[thread_id * num_residuals],
+            jacobians)) {
+      abort = true;
+#pragma omp flush(abort)
+    }
+  }
+  return !abort;
+}
+
 CostFunction* CreateRuntimeNumericDiffCostFunction(
     const CostFunction* cost_function,
     RuntimeNumericDiffMethod method,
-    double relative_step_size) {
+    double relative_step_size,
+    int num_threads) {
   return new RuntimeNumericDiffCostFunction(cost_function,
                                             method,
-                                            relative_step_size);
+                                            relative_step_size,
+                                            num_threads);
 }
 
 }  // namespace internal
@@ -46,7 +46,8 @@
 //   CostFunction* cost_function =
 //     CreateRuntimeNumericDiffCostFunction(new MyCostFunction(...),
 //                                          CENTRAL,
-//                                          TAKE_OWNERSHIP);
+//                                          1e-6,  // relative step size
+//                                          1);    // num_threads
 //
 // The central difference method is considerably more accurate; consider using
 // to start and only after that works, trying forward difference.
@@ -76,10 +77,17 @@ enum RuntimeNumericDiffMethod {
 // differencing, is set with relative eps. Caller owns the resulting cost
 // function, and the resulting cost function does not own the base cost
 // function.
+//
+// If num_threads > 1, the columns of the jacobians are evaluated in
+// parallel, each thread perturbing its own copy of the parameters. In
+// that case the Evaluate() method of the base cost function must be
+// thread safe. This is only worth it for large parameter blocks or
+// expensive cost functions.
 CostFunction *CreateRuntimeNumericDiffCostFunction(
     const CostFunction *cost_function,
     RuntimeNumericDiffMethod method,
-    double relative_eps);
+    double relative_eps,
+    int num_threads);
 
 }  // namespace internal
 }  // namespace ceres
@@ -81,10 +81,10 @@ TEST(NumericDiffCostFunction, EasyCase) {
   TestCostFunction term;
   scoped_ptr<CostFunction> cfs[2];
   cfs[0].reset(
-      CreateRuntimeNumericDiffCostFunction(&term, CENTRAL, kRelativeEps));
+      CreateRuntimeNumericDiffCostFunction(&term, CENTRAL, kRelativeEps, 1));
 
   cfs[1].reset(
-      CreateRuntimeNumericDiffCostFunction(&term, FORWARD, kRelativeEps));
+      CreateRuntimeNumericDiffCostFunction(&term, FORWARD, kRelativeEps, 1));
 
 
   for (int c = 0; c < 2; ++c) {
@@ -154,10 +154,10 @@ TEST(NumericDiffCostFunction, TransendentalOperationsInCostFunction) {
   TranscendentalTestCostFunction term;
   scoped_ptr<CostFunction> cfs[2];
   cfs[0].reset(
-      CreateRuntimeNumericDiffCostFunction(&term, CENTRAL, kRelativeEps));
+      CreateRuntimeNumericDiffCostFunction(&term, CENTRAL, kRelativeEps, 1));
 
   cfs[1].reset(
-      CreateRuntimeNumericDiffCostFunction(&term, FORWARD, kRelativeEps));
+      CreateRuntimeNumericDiffCostFunction(&term, FORWARD, kRelativeEps, 1));
 
   for (int c = 0; c < 2; ++c) {
     CostFunction *cost_function = cfs[c].get();
@@ -218,5 +218,53 @@ TEST(NumericDiffCostFunction, TransendentalOperationsInCostFunction) {
   }
 }
 
+// The multithreaded evaluation of the jacobian columns must match the
+// single threaded one exactly.
+TEST(NumericDiffCostFunction, MultiThreadedEvaluation) {
+  TranscendentalTestCostFunction term;
+  for (int c = 0; c < 2; ++c) {
+    const RuntimeNumericDiffMethod method = (c == 0) ? CENTRAL : FORWARD;
+    scoped_ptr<CostFunction> single_threaded(
+        CreateRuntimeNumericDiffCostFunction(&term, method, kRelativeEps, 1));
+    scoped_ptr<CostFunction> multi_threaded(
+        CreateRuntimeNumericDiffCostFunction(&term, method, kRelativeEps, 4));
+
+    double x1[] = { 1.0, 0.0, 3.0, 4.0, 5.0 };
+    double x2[] = { 0.1, -0.2, 0.3, -0.4, 0.5 };
+    double *parameters[] = { &x1[0], &x2[0] };
+
+    // Also check that the columns of parameter blocks for which no
+    // jacobian is requested are skipped.
+    for (int skipped = -1; skipped < 2; ++skipped) {
+      double expected_jacobians[2][10];
+      double actual_jacobians[2][10];
+      double* expected[] = { expected_jacobians[0], expected_jacobians[1] };
+      double* actual[] = { actual_jacobians[0], actual_jacobians[1] };
+      if (skipped >= 0) {
+        expected[skipped] = NULL;
+        actual[skipped] = NULL;
+      }
+
+      double expected_residuals[2];
+      double actual_residuals[2];
+      ASSERT_TRUE(single_threaded->Evaluate(&parameters[0],
+                                            &expected_residuals[0],
+                                            &expected[0]));
+      ASSERT_TRUE(multi_threaded->Evaluate(&parameters[0],
+                                           &actual_residuals[0],
+                                           &actual[0]));
+      for (int i = 0; i < 2; ++i) {
+        EXPECT_EQ(expected_residuals[i], actual_residuals[i]);
+        if (expected[i] == NULL) {
+          continue;
+        }
+        for (int j = 0; j < 10; ++j) {
+          EXPECT_EQ(expected_jacobians[i][j], actual_jacobians[i][j]);
+        }
+      }
+    }
+  }
+}
+
 }  // namespace internal
 }  // namespace ceres
@@ -0,0 +1,405 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "ceres/schur_complement_pattern.h"
+
+#ifdef CERES_USE_OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "ceres/block_structure.h"
+#include "ceres/integral_types.h"
+#include "ceres/internal/port.h"
+#include "glog/logging.h"
+
+namespace ceres {
+namespace internal {
+namespace {
+
+// "SCBP" in little endian byte order, followed by the version of
+// the format.
+const uint32 kPatternMagic = 0x50424353;
+const uint32 kPatternVersion = 1;
+
+// Gather the distinct f_blocks in rows [row_begin, row_end) of bs,
+// skipping the first skip_cells cells of each row, into blocks and
+// return their number. If blocks is NULL, they are only counted.
+//
+// marks is an array with one entry per f_block, and an f_block is
+// considered seen if its entry is equal to stamp. It is the caller's
+// responsibility to ensure that stamp is not already present in
+// marks.
+int GatherFBlocks(const CompressedRowBlockStructure& bs,
+                  const int num_eliminate_blocks,
+                  const int row_begin,
+                  const int row_end,
+                  const int skip_cells,
+                  const int stamp,
+                  int* marks,
+                  int* blocks) {
+  int num_blocks = 0;
+  for (int r = row_begin; r < row_end; ++r) {
+    const vector<Cell>& cells = bs.rows[r].cells;
+    for (int c = skip_cells; c < cells.size(); ++c) {
+      const int f_block_id = cells[c].block_id - num_eliminate_blocks;
+      DCHECK_GE(f_block_id, 0);
+      if (marks[f_block_id] == stamp) {
+        continue;
+      }
+      marks[f_block_id] = stamp;
+      if (blocks != NULL) {
+        blocks[num_blocks] = f_block_id;
+      }
+      ++num_blocks;
+    }
+  }
+  return num_blocks;
+}
+
+// Gather the column blocks j <= row of the lower triangular part of
+// the Schur complement in row block row, given the f_blocks of each
+// group and the groups each f_block occurs in. See GatherFBlocks for
+// the meaning of stamp, marks and blocks.
+int GatherLowerTriangularRow(const vector<int>& group_offsets,
+                             const vector<int>& group_blocks,
+                             const vector<int>& block_group_offsets,
+                             const vector<int>& block_groups,
+                             const int row,
+                             int* marks,
+                             int* blocks) {
+  marks[row] = row;
+  if (blocks != NULL) {
+    blocks[0] = row;
+  }
+  int num_blocks = 1;
+
+  for (int i = block_group_offsets[row];
+       i < block_group_offsets[row + 1];
+       ++i) {
+    const int group = block_groups[i];
+    for (int j = group_offsets[group]; j < group_offsets[group + 1]; ++j) {
+      const int col = group_blocks[j];
+      if (col > row || marks[col] == row) {
+        continue;
+      }
+      marks[col] = row;
+      if (blocks != NULL) {
+        blocks[num_blocks] = col;
+      }
+      ++num_blocks;
+    }
+  }
+  return num_blocks;
+}
+
+// Replace counts[i] by the sum of counts[0], ..., counts[i - 1].
+void ExclusivePrefixSum(vector<int>* counts) {
+  int sum = 0;
+  for (int i = 0; i < counts->size(); ++i) {
+    const int count = (*counts)[i];
+    (*counts)[i] = sum;
+    sum += count;
+  }
+}
+
+void AppendUInt32(const uint32 value, string* data) {
+  for (int i = 0; i < 4; ++i) {
+    data->push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+uint32 ReadUInt32(const string& data, const int word) {
+  uint32 value = 0;
+  for (int i = 0; i < 4; ++i) {
+    value |= static_cast<uint32>(
+        static_cast<unsigned char>(data[4 * word + i])) << (8 * i);
+  }
+  return value;
+}
+
+}  // namespace
+
+void ComputeSchurComplementPattern(const CompressedRowBlockStructure& bs,
+                                   const int num_eliminate_blocks,
+                                   const int num_threads,
+                                   BlockSparsityPattern* pattern) {
+  CHECK_NOTNULL(pattern);
+  const int num_row_blocks = bs.rows.size();
+  const int num_f_blocks = bs.cols.size() - num_eliminate_blocks;
+  CHECK_GE(num_f_blocks, 0);
+  if (num_f_blocks == 0) {
+    pattern->rows.assign(1, 0);
+    pattern->cols.clear();
+    return;
+  }
+
+  // The Schur complement is the sum of a dense block for each chunk,
+  // i.e., maximal run of rows with the same e_block, coupling the
+  // f_blocks of the chunk, and a dense block for each of the
+  // remaining rows, coupling the f_blocks of the row. We refer to
+  // the chunks and the remaining rows collectively as groups.
+  vector<int> group_rows;
+  int r = 0;
+  while (r < num_row_blocks) {
+    const int e_block_id = bs.rows[r].cells.front().block_id;
+    if (e_block_id >= num_eliminate_blocks) {
+      break;
+    }
+    group_rows.push_back(r);
+    while (r < num_row_blocks &&
+           bs.rows[r].cells.front().block_id == e_block_id) {
+      ++r;
+    }
+  }
+  const int num_chunks = group_rows.size();
+  for (; r < num_row_blocks; ++r) {
+    CHECK_GE(bs.rows[r].cells.front().block_id, num_eliminate_blocks);
+    group_rows.push_back(r);
+  }
+  const int num_groups = group_rows.size();
+  group_rows.push_back(num_row_blocks);
+
+  // Per thread marker arrays used to remove duplicates.
+  vector<int> marks(max(num_threads, 1) * num_f_blocks, -1);
+
+  // Find the distinct f_blocks of each group. The first pass counts
+  // them, and the second pass stores them.
+  vector<int> group_offsets(num_groups + 1, 0);
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic, 64)
+  for (int g = 0; g < num_groups; ++g) {
+#ifdef CERES_USE_OPENMP
+    int thread_id = omp_get_thread_num();
+#else
+    int thread_id = 0;
+#endif
+    group_offsets[g] = GatherFBlocks(bs,
+                                     num_eliminate_blocks,
+                                     group_rows[g],
+                                     group_rows[g + 1],
+                                     (g < num_chunks) ? 1 : 0,
+                                     g,
+                                     &marks[thread_id * num_f_blocks],
+                                     NULL);
+  }
+  ExclusivePrefixSum(&group_offsets);
+
+  // The arrays filled in parallel have an extra entry at the end, so
+  // that the address of the start of an empty group or row is valid.
+  vector<int> group_blocks(group_offsets.back() + 1);
+  fill(marks.begin(), marks.end(), -1);
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic, 64)
+  for (int g = 0; g < num_groups; ++g) {
+#ifdef CERES_USE_OPENMP
+    int thread_id = omp_get_thread_num();
+#else
+    int thread_id = 0;
+#endif
+    GatherFBlocks(bs,
+                  num_eliminate_blocks,
+                  group_rows[g],
+                  group_rows[g + 1],
+                  (g < num_chunks) ? 1 : 0,
+                  g,
+                  &marks[thread_id * num_f_blocks],
+                  &group_blocks[group_offsets[g]]);
+  }
+
+  // Transpose the group to f_block incidence, so that the groups
+  // each f_block occurs in can be enumerated.
+  vector<int> block_group_offsets(num_f_blocks + 1, 0);
+  for (int i = 0; i < group_offsets.back(); ++i) {
+    ++block_group_offsets[group_blocks[i]];
+  }
+  ExclusivePrefixSum(&block_group_offsets);
+
+  vector<int> block_groups(group_offsets.back());
+  {
+    vector<int> position(block_group_offsets.begin(),
+                         block_group_offsets.end() - 1);
+    for (int g = 0; g < num_groups; ++g) {
+      for (int i = group_offsets[g]; i < group_offsets[g + 1]; ++i) {
+        block_groups[position[group_blocks[i]]++] = g;
+      }
+    }
+  }
+
+  // Compute the lower triangular part of the Schur complement, one
+  // row block at a time. As before, the first pass counts the
+  // column blocks in each row block, and the second pass stores
+  // them.
+  vector<int> lower_rows(num_f_blocks + 1, 0);
+  fill(marks.begin(), marks.end(), -1);
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic, 64)
+  for (int i = 0; i < num_f_blocks; ++i) {
+#ifdef CERES_USE_OPENMP
+    int thread_id = omp_get_thread_num();
+#else
+    int thread_id = 0;
+#endif
+    lower_rows[i] =
+        GatherLowerTriangularRow(group_offsets,
+                                 group_blocks,
+                                 block_group_offsets,
+                                 block_groups,
+                                 i,
+                                 &marks[thread_id * num_f_blocks],
+                                 NULL);
+  }
+  ExclusivePrefixSum(&lower_rows);
+
+  vector<int> lower_cols(lower_rows.back() + 1);
+  fill(marks.begin(), marks.end(), -1);
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic, 64)
+  for (int i = 0; i < num_f_blocks; ++i) {
+#ifdef CERES_USE_OPENMP
+    int thread_id = omp_get_thread_num();
+#else
+    int thread_id = 0;
+#endif
+    GatherLowerTriangularRow(group_offsets,
+                             group_blocks,
+                             block_group_offsets,
+                             block_groups,
+                             i,
+                             &marks[thread_id * num_f_blocks],
+                             &lower_cols[lower_rows[i]]);
+  }
+
+  // The column blocks of each row block of the lower triangular part
+  // are in no particular order. Transposing it, yields the upper
+  // triangular part with the column blocks of each row block in
+  // increasing order, since the row blocks of the lower triangular
+  // part are visited in increasing order.
+  const int num_nonzero_blocks = lower_rows.back();
+  pattern->rows.assign(num_f_blocks + 1, 0);
+  for (int i = 0; i < num_nonzero_blocks; ++i) {
+    ++pattern->rows[lower_cols[i]];
+  }
+  ExclusivePrefixSum(&pattern->rows);
+
+  pattern->cols.resize(num_nonzero_blocks);
+  vector<int> position(pattern->rows.begin(), pattern->rows.end() - 1);
+  for (int i = 0; i < num_f_blocks; ++i) {
+    for (int j = lower_rows[i]; j < lower_rows[i + 1]; ++j) {
+      pattern->cols[position[lower_cols[j]]++] = i;
+    }
+  }
+}
+
+void SerializeBlockSparsityPattern(const BlockSparsityPattern& pattern,
+                                   string* data) {
+  CHECK_NOTNULL(data)->clear();
+  const int num_row_blocks = pattern.num_row_blocks();
+  const int num_nonzero_blocks = pattern.num_nonzero_blocks();
+  data->reserve(4 * (5 + num_row_blocks + num_nonzero_blocks));
+
+  AppendUInt32(kPatternMagic, data);
+  AppendUInt32(kPatternVersion, data);
+  AppendUInt32(num_row_blocks, data);
+  AppendUInt32(num_nonzero_blocks, data);
+  if (pattern.rows.empty()) {
+    AppendUInt32(0, data);
+  }
+  for (int i = 0; i < pattern.rows.size(); ++i) {
+    AppendUInt32(pattern.rows[i], data);
+  }
+  for (int i = 0; i < num_nonzero_blocks; ++i) {
+    AppendUInt32(pattern.cols[i], data);
+  }
+}
+
+bool ParseBlockSparsityPattern(const string& data,
+                               BlockSparsityPattern* pattern) {
+  CHECK_NOTNULL(pattern);
+  const int kHeaderSize = 4;
+  if (data.size() % 4 != 0 || data.size() < 4 * (kHeaderSize + 1)) {
+    LOG(ERROR) << "Invalid block sparsity pattern: bad size.";
+    return false;
+  }
+
+  if (ReadUInt32(data, 0) != kPatternMagic ||
+      ReadUInt32(data, 1) != kPatternVersion) {
+    LOG(ERROR) << "Invalid block sparsity pattern: bad header.";
+    return false;
+  }
+
+  const uint64 num_words = data.size() / 4;
+  if (static_cast<uint64>(kHeaderSize) + ReadUInt32(data, 2) + 1 +
+      ReadUInt32(data, 3) != num_words) {
+    LOG(ERROR) << "Invalid block sparsity pattern: bad size.";
+    return false;
+  }
+  const int num_row_blocks = ReadUInt32(data, 2);
+  const int num_nonzero_blocks = ReadUInt32(data, 3);
+
+  BlockSparsityPattern parsed;
+  parsed.rows.resize(num_row_blocks + 1);
+  parsed.cols.resize(num_nonzero_blocks);
+  int word = kHeaderSize;
+  for (int i = 0; i <= num_row_blocks; ++i) {
+    parsed.rows[i] = ReadUInt32(data, word++);
+  }
+  for (int i = 0; i < num_nonzero_blocks; ++i) {
+    parsed.cols[i] = ReadUInt32(data, word++);
+  }
+
+  // Validate the pattern, so that users of it can index into arrays
+  // of size num_row_blocks without further checks.
+  if (parsed.rows[0] != 0 ||
+      parsed.rows[num_row_blocks] != num_nonzero_blocks) {
+    LOG(ERROR) << "Invalid block sparsity pattern: bad row offsets.";
+    return false;
+  }
+
+  for (int i = 0; i < num_row_blocks; ++i) {
+    if (parsed.rows[i] > parsed.rows[i + 1]) {
+      LOG(ERROR) << "Invalid block sparsity pattern: bad row offsets.";
+      return false;
+    }
+    for (int j = parsed.rows[i]; j < parsed.rows[i + 1]; ++j) {
+      const int col = parsed.cols[j];
+      if (col < i ||
+          col >= num_row_blocks ||
+          (j > parsed.rows[i] && col <= parsed.cols[j - 1])) {
+        LOG(ERROR) << "Invalid block sparsity pattern: bad column block "
+                   << col << " in row block " << i;
+        return false;
+      }
+    }
+  }
+
+  pattern->rows.swap(parsed.rows);
+  pattern->cols.swap(parsed.cols);
+  return true;
+}
+
+}  // namespace internal
+}  // namespace ceres
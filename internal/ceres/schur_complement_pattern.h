@@ -0,0 +1,97 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// The block sparsity pattern of the Schur complement of a Jacobian
+// with respect to its e_blocks.
+
+#ifndef CERES_INTERNAL_SCHUR_COMPLEMENT_PATTERN_H_
+#define CERES_INTERNAL_SCHUR_COMPLEMENT_PATTERN_H_
+
+#include <string>
+#include <vector>
+#include "ceres/internal/port.h"
+
+namespace ceres {
+namespace internal {
+
+struct CompressedRowBlockStructure;
+
+// The block sparsity pattern of the upper triangular part of a
+// symmetric block matrix, stored in compressed row form. The column
+// blocks of row block i are
+//
+//   cols[rows[i]], ..., cols[rows[i + 1] - 1]
+//
+// in increasing order, and since the pattern is upper triangular,
+// all of them are >= i.
+struct BlockSparsityPattern {
+  int num_row_blocks() const {
+    return rows.empty() ? 0 : static_cast<int>(rows.size()) - 1;
+  }
+  int num_nonzero_blocks() const { return cols.size(); }
+
+  vector<int> rows;
+  vector<int> cols;
+};
+
+// Compute the block sparsity pattern of the Schur complement
+//
+//   S = F'F - F'E (E'E)^{-1} E'F
+//
+// of the matrix with block structure bs, whose first
+// num_eliminate_blocks column blocks are eliminated. Row block i of
+// the result corresponds to column block num_eliminate_blocks + i of
+// bs. The diagonal blocks are always part of the pattern.
+//
+// The rows of bs are expected to be ordered as required by the
+// SchurEliminator, i.e. the rows containing an e_block come first
+// and are grouped into chunks by their e_block.
+//
+// The pattern is computed in time linear in its size without sorting
+// or searching, using marker arrays to remove duplicates, and the
+// row blocks are processed using num_threads threads. The result
+// does not depend on num_threads.
+void ComputeSchurComplementPattern(const CompressedRowBlockStructure& bs,
+                                   int num_eliminate_blocks,
+                                   int num_threads,
+                                   BlockSparsityPattern* pattern);
+
+// Serialize pattern into a platform independent binary string.
+void SerializeBlockSparsityPattern(const BlockSparsityPattern& pattern,
+                                   string* data);
+
+// Parse a string written by SerializeBlockSparsityPattern. Returns
+// false and leaves pattern unchanged if data is not a valid
+// serialized pattern.
+bool ParseBlockSparsityPattern(const string& data,
+                               BlockSparsityPattern* pattern);
+
+}  // namespace internal
+}  // namespace ceres
+
+#endif  // CERES_INTERNAL_SCHUR_COMPLEMENT_PATTERN_H_
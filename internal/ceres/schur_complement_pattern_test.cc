@@ -0,0 +1,271 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "ceres/schur_complement_pattern.h"
+
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include "ceres/block_structure.h"
+#include "ceres/internal/port.h"
+#include "ceres/random.h"
+#include "gtest/gtest.h"
+
+namespace ceres {
+namespace internal {
+
+// Add num_col_blocks column blocks of size 1 to bs.
+void AddCols(const int num_col_blocks, CompressedRowBlockStructure* bs) {
+  for (int i = 0; i < num_col_blocks; ++i) {
+    bs->cols.push_back(Block());
+    bs->cols.back().size = 1;
+    bs->cols.back().position = bs->cols.size() - 1;
+  }
+}
+
+// Add a row block with the given column blocks to bs.
+void AddRow(const vector<int>& col_blocks, CompressedRowBlockStructure* bs) {
+  bs->rows.push_back(CompressedRow());
+  CompressedRow& row = bs->rows.back();
+  row.block.size = 1;
+  row.block.position = bs->rows.size() - 1;
+  for (int i = 0; i < col_blocks.size(); ++i) {
+    row.cells.push_back(Cell(col_blocks[i], 0));
+  }
+}
+
+// A random block structure whose rows are ordered as expected by
+// the SchurEliminator, i.e., each e_block is followed by a chunk of
+// rows containing it, and the remaining rows only contain f_blocks.
+void CreateRandomBlockStructure(const int num_eliminate_blocks,
+                                const int num_f_blocks,
+                                CompressedRowBlockStructure* bs) {
+  AddCols(num_eliminate_blocks + num_f_blocks, bs);
+
+  for (int e = 0; e < num_eliminate_blocks; ++e) {
+    const int num_rows = 1 + Uniform(4);
+    for (int r = 0; r < num_rows; ++r) {
+      vector<int> col_blocks(1, e);
+      const int f_block = num_eliminate_blocks + Uniform(num_f_blocks);
+      col_blocks.push_back(f_block);
+      if (Uniform(2) == 0) {
+        const int other = num_eliminate_blocks + Uniform(num_f_blocks);
+        if (other != f_block) {
+          col_blocks.push_back(other);
+        }
+      }
+      AddRow(col_blocks, bs);
+    }
+  }
+
+  for (int r = 0; r < num_f_blocks / 2; ++r) {
+    const int f_block1 = num_eliminate_blocks + Uniform(num_f_blocks);
+    const int f_block2 = num_eliminate_blocks + Uniform(num_f_blocks);
+    vector<int> col_blocks(1, f_block1);
+    if (f_block2 != f_block1) {
+      col_blocks.push_back(f_block2);
+    }
+    AddRow(col_blocks, bs);
+  }
+}
+
+// The block pairs of the upper triangular part of the Schur
+// complement, computed the straightforward way.
+set<pair<int, int> > ExpectedBlockPairs(const CompressedRowBlockStructure& bs,
+                                        const int num_eliminate_blocks) {
+  const int num_f_blocks = bs.cols.size() - num_eliminate_blocks;
+  set<pair<int, int> > block_pairs;
+  for (int i = 0; i < num_f_blocks; ++i) {
+    block_pairs.insert(make_pair(i, i));
+  }
+
+  // Each chunk and each of the remaining rows contributes a dense
+  // block.
+  int r = 0;
+  while (r < bs.rows.size()) {
+    const int first_block_id = bs.rows[r].cells.front().block_id;
+    set<int> f_blocks;
+    for (; r < bs.rows.size(); ++r) {
+      if (bs.rows[r].cells.front().block_id != first_block_id ||
+          (first_block_id >= num_eliminate_blocks && !f_blocks.empty())) {
+        break;
+      }
+      const vector<Cell>& cells = bs.rows[r].cells;
+      for (int c = 0; c < cells.size(); ++c) {
+        if (cells[c].block_id >= num_eliminate_blocks) {
+          f_blocks.insert(cells[c].block_id - num_eliminate_blocks);
+        }
+      }
+    }
+
+    for (set<int>::const_iterator it1 = f_blocks.begin();
+         it1 != f_blocks.end();
+         ++it1) {
+      for (set<int>::const_iterator it2 = it1; it2 != f_blocks.end(); ++it2) {
+        block_pairs.insert(make_pair(*it1, *it2));
+      }
+    }
+  }
+  return block_pairs;
+}
+
+void ExpectPatternEquals(const BlockSparsityPattern& pattern,
+                         const set<pair<int, int> >& block_pairs) {
+  ASSERT_EQ(pattern.num_nonzero_blocks(), block_pairs.size());
+  int row_block = 0;
+  int i = 0;
+  for (set<pair<int, int> >::const_iterator it = block_pairs.begin();
+       it != block_pairs.end();
+       ++it, ++i) {
+    while (pattern.rows[row_block + 1] <= i) {
+      ++row_block;
+    }
+    EXPECT_EQ(row_block, it->first);
+    EXPECT_EQ(pattern.cols[i], it->second);
+  }
+}
+
+TEST(SchurComplementPattern, SmallExample) {
+  // Two e_blocks and three f_blocks. The first chunk couples f_blocks
+  // 0 and 2, the second chunk only contains f_block 2 and the last
+  // row couples f_blocks 1 and 2.
+  CompressedRowBlockStructure bs;
+  AddCols(5, &bs);
+
+  vector<int> col_blocks;
+  col_blocks.push_back(0);
+  col_blocks.push_back(2);
+  AddRow(col_blocks, &bs);
+  col_blocks[1] = 4;
+  AddRow(col_blocks, &bs);
+  col_blocks[0] = 1;
+  AddRow(col_blocks, &bs);
+  col_blocks[0] = 3;
+  AddRow(col_blocks, &bs);
+
+  BlockSparsityPattern pattern;
+  ComputeSchurComplementPattern(bs, 2, 1, &pattern);
+
+  const int kExpectedRows[] = {0, 2, 4, 5};
+  const int kExpectedCols[] = {0, 2, 1, 2, 2};
+  EXPECT_EQ(pattern.num_row_blocks(), 3);
+  EXPECT_EQ(pattern.rows,
+            vector<int>(kExpectedRows, kExpectedRows + 4));
+  EXPECT_EQ(pattern.cols,
+            vector<int>(kExpectedCols, kExpectedCols + 5));
+}
+
+TEST(SchurComplementPattern, MatchesBlockPairs) {
+  SetRandomState(5);
+  for (int trial = 0; trial < 10; ++trial) {
+    CompressedRowBlockStructure bs;
+    const int num_eliminate_blocks = 1 + Uniform(50);
+    CreateRandomBlockStructure(num_eliminate_blocks, 1 + Uniform(30), &bs);
+    const set<pair<int, int> > expected =
+        ExpectedBlockPairs(bs, num_eliminate_blocks);
+
+    for (int num_threads = 1; num_threads <= 4; num_threads *= 2) {
+      BlockSparsityPattern pattern;
+      ComputeSchurComplementPattern(bs,
+                                    num_eliminate_blocks,
+                                    num_threads,
+                                    &pattern);
+      ExpectPatternEquals(pattern, expected);
+    }
+  }
+}
+
+TEST(SchurComplementPattern, NoFBlocks) {
+  CompressedRowBlockStructure bs;
+  AddCols(3, &bs);
+  AddRow(vector<int>(1, 0), &bs);
+  AddRow(vector<int>(1, 2), &bs);
+
+  BlockSparsityPattern pattern;
+  ComputeSchurComplementPattern(bs, 3, 1, &pattern);
+  EXPECT_EQ(pattern.num_row_blocks(), 0);
+  EXPECT_EQ(pattern.num_nonzero_blocks(), 0);
+}
+
+TEST(SchurComplementPattern, SerializationRoundTrip) {
+  SetRandomState(7);
+  CompressedRowBlockStructure bs;
+  CreateRandomBlockStructure(20, 10, &bs);
+  BlockSparsityPattern pattern;
+  ComputeSchurComplementPattern(bs, 20, 1, &pattern);
+
+  string data;
+  SerializeBlockSparsityPattern(pattern, &data);
+
+  BlockSparsityPattern parsed;
+  EXPECT_TRUE(ParseBlockSparsityPattern(data, &parsed));
+  EXPECT_EQ(parsed.rows, pattern.rows);
+  EXPECT_EQ(parsed.cols, pattern.cols);
+
+  // An empty pattern also survives the round trip.
+  SerializeBlockSparsityPattern(BlockSparsityPattern(), &data);
+  EXPECT_TRUE(ParseBlockSparsityPattern(data, &parsed));
+  EXPECT_EQ(parsed.num_row_blocks(), 0);
+  EXPECT_EQ(parsed.num_nonzero_blocks(), 0);
+}
+
+TEST(SchurComplementPattern, ParseRejectsInvalidData) {
+  SetRandomState(11);
+  CompressedRowBlockStructure bs;
+  CreateRandomBlockStructure(20, 10, &bs);
+  BlockSparsityPattern pattern;
+  ComputeSchurComplementPattern(bs, 20, 1, &pattern);
+
+  string data;
+  SerializeBlockSparsityPattern(pattern, &data);
+
+  BlockSparsityPattern parsed;
+  EXPECT_FALSE(ParseBlockSparsityPattern("", &parsed));
+  EXPECT_FALSE(ParseBlockSparsityPattern(data.substr(0, data.size() - 4),
+                                         &parsed));
+
+  // Corrupt the magic number.
+  string corrupted = data;
+  corrupted[0] ^= 1;
+  EXPECT_FALSE(ParseBlockSparsityPattern(corrupted, &parsed));
+
+  // Make the last column block point below the diagonal.
+  corrupted = data;
+  corrupted[corrupted.size() - 4] = 0;
+  corrupted[corrupted.size() - 3] = 0;
+  corrupted[corrupted.size() - 2] = 0;
+  corrupted[corrupted.size() - 1] = 0;
+  EXPECT_FALSE(ParseBlockSparsityPattern(corrupted, &parsed));
+
+  // Failed parses leave the output untouched.
+  EXPECT_EQ(parsed.num_row_blocks(), 0);
+}
+
+}  // namespace internal
+}  // namespace ceres
@@ -29,6 +29,7 @@
 // Author: sameeragarwal@google.com (Sameer Agarwal)
 
 #include <algorithm>
+#include <cstring>
 #include <ctime>
 #include <set>
 #include <vector>
@@ -43,12 +44,18 @@
 #include "ceres/block_random_access_sparse_matrix.h"
 #include "ceres/block_sparse_matrix.h"
 #include "ceres/block_structure.h"
+#include "ceres/compressed_column_scatter.h"
+#include "ceres/compressed_graph.h"
+#include "ceres/dense_cholesky.h"
 #include "ceres/detect_structure.h"
+#include "ceres/graph_algorithms.h"
 #include "ceres/internal/eigen.h"
 #include "ceres/internal/port.h"
 #include "ceres/internal/scoped_ptr.h"
 #include "ceres/linear_solver.h"
+#include "ceres/schur_complement_pattern.h"
 #include "ceres/schur_complement_solver.h"
+#include "ceres/schur_structure_cache.h"
 #include "ceres/suitesparse.h"
 #include "ceres/triplet_sparse_matrix.h"
 #include "ceres/types.h"
@@ -64,15 +71,26 @@ LinearSolver::Summary SchurComplementSolver::SolveImpl(
     double* x) {
   EventLogger event_logger("SchurComplementSolver::Solve");
 
-  if (eliminator_.get() == NULL) {
+  if (eliminator_ == NULL) {
     InitStorage(A->block_structure());
     DetectStructure(*A->block_structure(),
                     options_.elimination_groups[0],
                     &options_.row_block_size,
                     &options_.e_block_size,
                     &options_.f_block_size);
-    eliminator_.reset(CHECK_NOTNULL(SchurEliminatorBase::Create(options_)));
-    eliminator_->Init(options_.elimination_groups[0], A->block_structure());
+    if (options_.schur_structure_cache != NULL) {
+      eliminator_ =
+          options_.schur_structure_cache
+          ->FindOrCreate(*A->block_structure(),
+                         options_.elimination_groups[0])
+          ->Eliminator(*A->block_structure(), options_.num_threads);
+    } else {
+      owned_eliminator_.reset(
+          CHECK_NOTNULL(SchurEliminatorBase::Create(options_)));
+      owned_eliminator_->Init(options_.elimination_groups[0],
+                              A->block_structure());
+      eliminator_ = owned_eliminator_.get();
+    }
   };
   fill(x, x + A->num_cols(), 0.0);
   event_logger.AddEvent("Setup");
@@ -80,8 +98,35 @@ LinearSolver::Summary SchurComplementSolver::SolveImpl(
   LinearSolver::Summary summary;
   summary.num_iterations = 1;
   summary.termination_type = FAILURE;
-  eliminator_->Eliminate(A, b, per_solve_options.D, lhs_.get(), rhs_.get());
-  event_logger.AddEvent("Eliminate");
+  // The products are stored only if they fit in the memory budget.
+  const bool store_products =
+      static_cast<double>(eliminator_->ProductsSize()) * sizeof(double) <=
+      options_.max_schur_products_memory_in_mb * 1024.0 * 1024.0;
+  if (!store_products) {
+    eliminator_->Eliminate(A,
+                           b,
+                           per_solve_options.D,
+                           lhs_.get(),
+                           rhs_.get());
+    products_are_valid_ = false;
+    event_logger.AddEvent("Eliminate");
+  } else if (per_solve_options.A_and_b_are_unchanged && products_are_valid_) {
+    eliminator_->EliminateWithNewDiagonal(A,
+                                          per_solve_options.D,
+                                          &products_,
+                                          lhs_.get(),
+                                          rhs_.get());
+    event_logger.AddEvent("EliminateWithNewDiagonal");
+  } else {
+    eliminator_->EliminateAndStoreProducts(A,
+                                           b,
+                                           per_solve_options.D,
+                                           &products_,
+                                           lhs_.get(),
+                                           rhs_.get());
+    products_are_valid_ = true;
+    event_logger.AddEvent("Eliminate");
+  }
 
   double* reduced_solution = x + A->num_cols() - lhs_->num_cols();
   const bool status = SolveReducedLinearSystem(reduced_solution);
@@ -91,7 +136,18 @@ LinearSolver::Summary SchurComplementSolver::SolveImpl(
     return summary;
   }
 
-  eliminator_->BackSubstitute(A, b, per_solve_options.D, reduced_solution, x);
+  if (products_are_valid_) {
+    eliminator_->BackSubstituteUsingProducts(A,
+                                             products_,
+                                             reduced_solution,
+                                             x);
+  } else {
+    eliminator_->BackSubstitute(A,
+                                b,
+                                per_solve_options.D,
+                                reduced_solution,
+                                x);
+  }
   summary.termination_type = TOLERANCE;
 
   event_logger.AddEvent("BackSubstitute");
@@ -118,7 +174,7 @@ void DenseSchurComplementSolver::InitStorage(
 
 // Solve the system Sx = r, assuming that the matrix S is stored in a
 // BlockRandomAccessDenseMatrix. The linear system is solved using
-// Eigen's Cholesky factorization.
+// a dense Cholesky factorization, see dense_cholesky.h.
 bool DenseSchurComplementSolver::SolveReducedLinearSystem(double* solution) {
   const BlockRandomAccessDenseMatrix* m =
       down_cast<const BlockRandomAccessDenseMatrix*>(lhs());
@@ -130,13 +186,17 @@ bool DenseSchurComplementSolver::SolveReducedLinearSystem(double* solution) {
     return true;
   }
 
-  // TODO(sameeragarwal): Add proper error handling; this completely ignores
-  // the quality of the solution to the solve.
-  VectorRef(solution, num_rows) =
-      ConstMatrixRef(m->values(), num_rows, num_rows)
-      .selfadjointView<Eigen::Upper>()
-      .ldlt()
-      .solve(ConstVectorRef(rhs(), num_rows));
+  DenseCholeskyOptions cholesky_options;
+  cholesky_options.use_mixed_precision = options().use_mixed_precision_solves;
+  cholesky_options.max_num_refinement_iterations =
+      options().max_num_refinement_iterations;
+  cholesky_options.num_threads = options().num_threads;
+  cholesky_options.block_layout = m->block_layout();
+  SolveDenseSymmetricSystem(cholesky_options,
+                            m->values(),
+                            rhs(),
+                            num_rows,
+                            solution);
 
   return true;
 }
@@ -148,6 +208,8 @@ SparseSchurComplementSolver::SparseSchurComplementSolver(
     : SchurComplementSolver(options) {
 #ifndef CERES_NO_SUITESPARSE
   factor_ = NULL;
+  cholmod_rhs_ = NULL;
+  cholmod_solution_ = NULL;
 #endif  // CERES_NO_SUITESPARSE
 
 #ifndef CERES_NO_CXSPARSE
@@ -161,6 +223,16 @@ SparseSchurComplementSolver::~SparseSchurComplementSolver() {
     ss_.Free(factor_);
     factor_ = NULL;
   }
+
+  if (cholmod_rhs_ != NULL) {
+    ss_.Free(cholmod_rhs_);
+    cholmod_rhs_ = NULL;
+  }
+
+  if (cholmod_solution_ != NULL) {
+    ss_.Free(cholmod_solution_);
+    cholmod_solution_ = NULL;
+  }
 #endif  // CERES_NO_SUITESPARSE
 
 #ifndef CERES_NO_CXSPARSE
@@ -177,69 +249,72 @@ void SparseSchurComplementSolver::InitStorage(
     const CompressedRowBlockStructure* bs) {
   const int num_eliminate_blocks = options().elimination_groups[0];
   const int num_col_blocks = bs->cols.size();
-  const int num_row_blocks = bs->rows.size();
 
   blocks_.resize(num_col_blocks - num_eliminate_blocks, 0);
   for (int i = num_eliminate_blocks; i < num_col_blocks; ++i) {
     blocks_[i - num_eliminate_blocks] = bs->cols[i].size;
   }
 
-  set<pair<int, int> > block_pairs;
-  for (int i = 0; i < blocks_.size(); ++i) {
-    block_pairs.insert(make_pair(i, i));
+  // The pattern only depends on the block structure, so if a cache
+  // is available, it is computed once and shared with other solvers
+  // for the same structure.
+  BlockSparsityPattern owned_pattern;
+  const BlockSparsityPattern* pattern = &owned_pattern;
+  if (options().schur_structure_cache != NULL) {
+    pattern = &(options().schur_structure_cache
+                ->FindOrCreate(*bs, num_eliminate_blocks)
+                ->SchurComplementPattern(*bs, options().num_threads));
+  } else {
+    ComputeSchurComplementPattern(*bs,
+                                  num_eliminate_blocks,
+                                  options().num_threads,
+                                  &owned_pattern);
   }
 
-  int r = 0;
-  while (r < num_row_blocks) {
-    int e_block_id = bs->rows[r].cells.front().block_id;
-    if (e_block_id >= num_eliminate_blocks) {
-      break;
-    }
-    vector<int> f_blocks;
-
-    // Add to the chunk until the first block in the row is
-    // different than the one in the first row for the chunk.
-    for (; r < num_row_blocks; ++r) {
-      const CompressedRow& row = bs->rows[r];
-      if (row.cells.front().block_id != e_block_id) {
-        break;
-      }
+  if (options().use_nested_dissection_ordering) {
+    ComputeNestedDissectionOrdering(*pattern);
+  }
 
-      // Iterate over the blocks in the row, ignoring the first
-      // block since it is the one to be eliminated.
-      for (int c = 1; c < row.cells.size(); ++c) {
-        const Cell& cell = row.cells[c];
-        f_blocks.push_back(cell.block_id - num_eliminate_blocks);
-      }
-    }
+  set_lhs(new BlockRandomAccessSparseMatrix(blocks_, *pattern));
+  set_rhs(new double[lhs()->num_rows()]);
+}
 
-    sort(f_blocks.begin(), f_blocks.end());
-    f_blocks.erase(unique(f_blocks.begin(), f_blocks.end()), f_blocks.end());
-    for (int i = 0; i < f_blocks.size(); ++i) {
-      for (int j = i + 1; j < f_blocks.size(); ++j) {
-        block_pairs.insert(make_pair(f_blocks[i], f_blocks[j]));
+// Compute a nested dissection ordering of the graph whose vertices
+// are the blocks of the Schur complement, and expand it into an
+// ordering of its rows/columns.
+void SparseSchurComplementSolver::ComputeNestedDissectionOrdering(
+    const BlockSparsityPattern& pattern) {
+  const double start_time = WallTimeInSeconds();
+  const int num_blocks = blocks_.size();
+  vector<pair<int, int> > edges;
+  edges.reserve(pattern.num_nonzero_blocks());
+  for (int i = 0; i < num_blocks; ++i) {
+    for (int j = pattern.rows[i]; j < pattern.rows[i + 1]; ++j) {
+      if (pattern.cols[j] != i) {
+        edges.push_back(make_pair(i, pattern.cols[j]));
       }
     }
   }
 
-  // Remaing rows do not contribute to the chunks and directly go
-  // into the schur complement via an outer product.
-  for (; r < num_row_blocks; ++r) {
-    const CompressedRow& row = bs->rows[r];
-    CHECK_GE(row.cells.front().block_id, num_eliminate_blocks);
-    for (int i = 0; i < row.cells.size(); ++i) {
-      int r_block1_id = row.cells[i].block_id - num_eliminate_blocks;
-      for (int j = 0; j < row.cells.size(); ++j) {
-        int r_block2_id = row.cells[j].block_id - num_eliminate_blocks;
-        if (r_block1_id <= r_block2_id) {
-          block_pairs.insert(make_pair(r_block1_id, r_block2_id));
-        }
-      }
+  const CompressedGraph graph(num_blocks, edges, options().num_threads);
+  vector<int> block_ordering;
+  NestedDissectionOrdering(graph, &block_ordering);
+
+  vector<int> block_positions(num_blocks, 0);
+  for (int i = 1; i < num_blocks; ++i) {
+    block_positions[i] = block_positions[i - 1] + blocks_[i - 1];
+  }
+
+  ordering_.clear();
+  for (int i = 0; i < num_blocks; ++i) {
+    const int block = block_ordering[i];
+    for (int j = 0; j < blocks_[block]; ++j) {
+      ordering_.push_back(block_positions[block] + j);
     }
   }
 
-  set_lhs(new BlockRandomAccessSparseMatrix(blocks_, block_pairs));
-  set_rhs(new double[lhs()->num_rows()]);
+  VLOG(2) << "Nested dissection ordering time: "
+          << WallTimeInSeconds() - start_time;
 }
 
 bool SparseSchurComplementSolver::SolveReducedLinearSystem(double* solution) {
@@ -264,9 +339,8 @@ bool SparseSchurComplementSolver::SolveReducedLinearSystem(double* solution) {
 // CHOLMOD's sparse cholesky factorization routines.
 bool SparseSchurComplementSolver::SolveReducedLinearSystemUsingSuiteSparse(
     double* solution) {
-  TripletSparseMatrix* tsm =
-      const_cast<TripletSparseMatrix*>(
-          down_cast<const BlockRandomAccessSparseMatrix*>(lhs())->matrix());
+  const TripletSparseMatrix* tsm =
+      down_cast<const BlockRandomAccessSparseMatrix*>(lhs())->matrix();
 
   const int num_rows = tsm->num_rows();
 
@@ -276,39 +350,43 @@ bool SparseSchurComplementSolver::SolveReducedLinearSystemUsingSuiteSparse(
     return true;
   }
 
-  cholmod_sparse* cholmod_lhs = ss_.CreateSparseMatrix(tsm);
+  // The sparsity pattern of the Schur complement does not change
+  // between calls, so only the values need to be copied into the
+  // compressed column storage.
+  if (lhs_csc_.get() == NULL) {
+    lhs_csc_.reset(new CompressedColumnScatter(*tsm));
+  }
+  lhs_csc_->Scatter(*tsm, options().num_threads);
+
+  cholmod_sparse cholmod_lhs = ss_.CreateSparseMatrixView(lhs_csc_.get());
   // The matrix is symmetric, and the upper triangular part of the
   // matrix contains the values.
-  cholmod_lhs->stype = 1;
+  cholmod_lhs.stype = 1;
 
-  cholmod_dense*  cholmod_rhs =
-      ss_.CreateDenseVector(const_cast<double*>(rhs()), num_rows, num_rows);
+  if (cholmod_rhs_ == NULL) {
+    cholmod_rhs_ = ss_.CreateDenseVector(NULL, num_rows, num_rows);
+  }
+  memcpy(cholmod_rhs_->x, rhs(), num_rows * sizeof(*rhs()));
 
   // Symbolic factorization is computed if we don't already have one handy.
   if (factor_ == NULL) {
-    if (options().use_block_amd) {
-      factor_ = ss_.BlockAnalyzeCholesky(cholmod_lhs, blocks_, blocks_);
+    if (options().use_nested_dissection_ordering) {
+      factor_ = ss_.AnalyzeCholeskyWithUserOrdering(&cholmod_lhs, ordering_);
+    } else if (options().use_block_amd) {
+      factor_ = ss_.BlockAnalyzeCholesky(&cholmod_lhs, blocks_, blocks_);
     } else {
-      factor_ = ss_.AnalyzeCholesky(cholmod_lhs);
+      factor_ = ss_.AnalyzeCholesky(&cholmod_lhs);
     }
   }
 
-  cholmod_dense* cholmod_solution =
-      ss_.SolveCholesky(cholmod_lhs, factor_, cholmod_rhs);
-
-  ss_.Free(cholmod_lhs);
-  cholmod_lhs = NULL;
-  ss_.Free(cholmod_rhs);
-  cholmod_rhs = NULL;
-
-  if (cholmod_solution == NULL) {
+  if (!ss_.Cholesky(&cholmod_lhs, factor_) ||
+      !ss_.Solve(factor_, cholmod_rhs_, &cholmod_solution_)) {
     LOG(WARNING) << "CHOLMOD solve failed.";
     return false;
   }
 
   VectorRef(solution, num_rows)
-      = VectorRef(static_cast<double*>(cholmod_solution->x), num_rows);
-  ss_.Free(cholmod_solution);
+      = VectorRef(static_cast<double*>(cholmod_solution_->x), num_rows);
   return true;
 }
 #else
@@ -326,9 +404,8 @@ bool SparseSchurComplementSolver::SolveReducedLinearSystemUsingSuiteSparse(
 bool SparseSchurComplementSolver::SolveReducedLinearSystemUsingCXSparse(
     double* solution) {
   // Extract the TripletSparseMatrix that is used for actually storing S.
-  TripletSparseMatrix* tsm =
-      const_cast<TripletSparseMatrix*>(
-          down_cast<const BlockRandomAccessSparseMatrix*>(lhs())->matrix());
+  const TripletSparseMatrix* tsm =
+      down_cast<const BlockRandomAccessSparseMatrix*>(lhs())->matrix();
 
   const int num_rows = tsm->num_rows();
 
@@ -338,19 +415,27 @@ bool SparseSchurComplementSolver::SolveReducedLinearSystemUsingCXSparse(
     return true;
   }
 
-  cs_di* lhs = CHECK_NOTNULL(cxsparse_.CreateSparseMatrix(tsm));
+  // See SolveReducedLinearSystemUsingSuiteSparse.
+  if (lhs_csc_.get() == NULL) {
+    lhs_csc_.reset(new CompressedColumnScatter(*tsm));
+  }
+  lhs_csc_->Scatter(*tsm, options().num_threads);
+
+  cs_di lhs = cxsparse_.CreateSparseMatrixView(lhs_csc_.get());
   VectorRef(solution, num_rows) = ConstVectorRef(rhs(), num_rows);
 
   // Compute symbolic factorization if not available.
   if (cxsparse_factor_ == NULL) {
-    cxsparse_factor_ = CHECK_NOTNULL(cxsparse_.AnalyzeCholesky(lhs));
+    if (options().use_nested_dissection_ordering) {
+      cxsparse_factor_ = CHECK_NOTNULL(
+          cxsparse_.AnalyzeCholeskyWithUserOrdering(&lhs, ordering_));
+    } else {
+      cxsparse_factor_ = CHECK_NOTNULL(cxsparse_.AnalyzeCholesky(&lhs));
+    }
   }
 
   // Solve the linear system.
-  bool ok = cxsparse_.SolveCholesky(lhs, cxsparse_factor_, solution);
-
-  cxsparse_.Free(lhs);
-  return ok;
+  return cxsparse_.SolveCholesky(&lhs, cxsparse_factor_, solution);
 }
 #else
 bool SparseSchurComplementSolver::SolveReducedLinearSystemUsingCXSparse(
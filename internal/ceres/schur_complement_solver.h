@@ -38,8 +38,10 @@
 #include "ceres/block_random_access_matrix.h"
 #include "ceres/block_sparse_matrix.h"
 #include "ceres/block_structure.h"
+#include "ceres/compressed_column_scatter.h"
 #include "ceres/cxsparse.h"
 #include "ceres/linear_solver.h"
+#include "ceres/schur_complement_pattern.h"
 #include "ceres/schur_eliminator.h"
 #include "ceres/suitesparse.h"
 #include "ceres/internal/scoped_ptr.h"
@@ -103,7 +105,9 @@ class BlockSparseMatrixBase;
 class SchurComplementSolver : public BlockSparseMatrixBaseSolver {
  public:
   explicit SchurComplementSolver(const LinearSolver::Options& options)
-      : options_(options) {
+      : options_(options),
+        eliminator_(NULL),
+        products_are_valid_(false) {
     CHECK_GT(options.elimination_groups.size(), 1);
     CHECK_GT(options.elimination_groups[0], 0);
   }
@@ -130,10 +134,23 @@ class SchurComplementSolver : public BlockSparseMatrixBaseSolver {
 
   LinearSolver::Options options_;
 
-  scoped_ptr<SchurEliminatorBase> eliminator_;
+  // If options_.schur_structure_cache is not NULL, the eliminator is
+  // shared with other users of the cache, otherwise it is owned by
+  // this object.
+  scoped_ptr<SchurEliminatorBase> owned_eliminator_;
+  SchurEliminatorBase* eliminator_;
   scoped_ptr<BlockRandomAccessMatrix> lhs_;
   scoped_array<double> rhs_;
 
+  // Products of A and b computed by the last elimination. They are
+  // used to back substitute without touching A, and if
+  // LinearSolver::PerSolveOptions::A_and_b_are_unchanged is true, to
+  // update lhs_ and rhs_ for the new D instead of eliminating from
+  // scratch. They are only stored if their size is within
+  // LinearSolver::Options::max_schur_products_memory_in_mb.
+  SchurEliminationProducts products_;
+  bool products_are_valid_;
+
   CERES_DISALLOW_COPY_AND_ASSIGN(SchurComplementSolver);
 };
 
@@ -163,15 +180,29 @@ class SparseSchurComplementSolver : public SchurComplementSolver {
   virtual bool SolveReducedLinearSystem(double* solution);
   bool SolveReducedLinearSystemUsingSuiteSparse(double* solution);
   bool SolveReducedLinearSystemUsingCXSparse(double* solution);
+  void ComputeNestedDissectionOrdering(const BlockSparsityPattern& pattern);
 
   // Size of the blocks in the Schur complement.
   vector<int> blocks_;
 
+  // Fill-reducing ordering of the rows/columns of the Schur
+  // complement, if options().use_nested_dissection_ordering is true.
+  vector<int> ordering_;
+
+  // Compressed column copy of the Schur complement, created on the
+  // first call and updated in place afterwards.
+  scoped_ptr<CompressedColumnScatter> lhs_csc_;
+
 #ifndef CERES_NO_SUITESPARSE
   SuiteSparse ss_;
   // Symbolic factorization of the reduced linear system. Precomputed
   // once and reused in subsequent calls.
   cholmod_factor* factor_;
+
+  // Right hand side and solution of the reduced linear system,
+  // allocated on the first call and reused afterwards.
+  cholmod_dense* cholmod_rhs_;
+  cholmod_dense* cholmod_solution_;
 #endif  // CERES_NO_SUITESPARSE
 
 #ifndef CERES_NO_CXSPARSE
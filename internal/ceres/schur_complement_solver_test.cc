@@ -46,6 +46,10 @@ namespace internal {
 
 class SchurComplementSolverTest : public ::testing::Test {
  protected:
+  SchurComplementSolverTest()
+      : use_nested_dissection_ordering(false),
+        max_schur_products_memory_in_mb(1024) {}
+
   void SetUpFromProblemId(int problem_id) {
     scoped_ptr<LinearLeastSquaresProblem> problem(
         CreateLinearLeastSquaresProblemFromId(problem_id));
@@ -95,6 +99,8 @@ class SchurComplementSolverTest : public ::testing::Test {
         A->block_structure()->cols.size() - num_eliminate_blocks);
     options.type = linear_solver_type;
     options.sparse_linear_algebra_library = sparse_linear_algebra_library;
+    options.max_schur_products_memory_in_mb = max_schur_products_memory_in_mb;
+    options.use_nested_dissection_ordering = use_nested_dissection_ordering;
 
     scoped_ptr<LinearSolver> solver(LinearSolver::Create(options));
 
@@ -117,9 +123,43 @@ class SchurComplementSolverTest : public ::testing::Test {
     }
   }
 
+  // Solve without regularization, and then with regularization
+  // while telling the solver that A and b are unchanged, so that it
+  // reuses the products computed by the first solve.
+  void ComputeAndCompareSolutionsWithNewDiagonal(
+      int problem_id,
+      ceres::LinearSolverType linear_solver_type,
+      ceres::SparseLinearAlgebraLibraryType sparse_linear_algebra_library) {
+    SetUpFromProblemId(problem_id);
+    LinearSolver::Options options;
+    options.elimination_groups.push_back(num_eliminate_blocks);
+    options.elimination_groups.push_back(
+        A->block_structure()->cols.size() - num_eliminate_blocks);
+    options.type = linear_solver_type;
+    options.sparse_linear_algebra_library = sparse_linear_algebra_library;
+    options.max_schur_products_memory_in_mb = max_schur_products_memory_in_mb;
+
+    scoped_ptr<LinearSolver> solver(LinearSolver::Create(options));
+
+    LinearSolver::PerSolveOptions per_solve_options;
+    solver->Solve(A.get(), b.get(), per_solve_options, x.get());
+    for (int i = 0; i < num_cols; ++i) {
+      ASSERT_NEAR(sol.get()[i], x[i], 1e-10);
+    }
+
+    per_solve_options.D = D.get();
+    per_solve_options.A_and_b_are_unchanged = true;
+    solver->Solve(A.get(), b.get(), per_solve_options, x.get());
+    for (int i = 0; i < num_cols; ++i) {
+      ASSERT_NEAR(sol_d.get()[i], x[i], 1e-10);
+    }
+  }
+
   int num_rows;
   int num_cols;
   int num_eliminate_blocks;
+  bool use_nested_dissection_ordering;
+  int max_schur_products_memory_in_mb;
 
   scoped_ptr<BlockSparseMatrix> A;
   scoped_array<double> b;
@@ -135,6 +175,17 @@ TEST_F(SchurComplementSolverTest, SparseSchurWithSuiteSparse) {
   ComputeAndCompareSolutions(3, false, SPARSE_SCHUR, SUITE_SPARSE);
   ComputeAndCompareSolutions(2, true, SPARSE_SCHUR, SUITE_SPARSE);
   ComputeAndCompareSolutions(3, true, SPARSE_SCHUR, SUITE_SPARSE);
+  ComputeAndCompareSolutionsWithNewDiagonal(2, SPARSE_SCHUR, SUITE_SPARSE);
+  ComputeAndCompareSolutionsWithNewDiagonal(3, SPARSE_SCHUR, SUITE_SPARSE);
+}
+
+TEST_F(SchurComplementSolverTest,
+       SparseSchurWithSuiteSparseAndNestedDissection) {
+  use_nested_dissection_ordering = true;
+  ComputeAndCompareSolutions(2, false, SPARSE_SCHUR, SUITE_SPARSE);
+  ComputeAndCompareSolutions(3, false, SPARSE_SCHUR, SUITE_SPARSE);
+  ComputeAndCompareSolutions(2, true, SPARSE_SCHUR, SUITE_SPARSE);
+  ComputeAndCompareSolutions(3, true, SPARSE_SCHUR, SUITE_SPARSE);
 }
 #endif  // CERES_NO_SUITESPARSE
 
@@ -144,6 +195,17 @@ TEST_F(SchurComplementSolverTest, SparseSchurWithCXSparse) {
   ComputeAndCompareSolutions(3, false, SPARSE_SCHUR, CX_SPARSE);
   ComputeAndCompareSolutions(2, true, SPARSE_SCHUR, CX_SPARSE);
   ComputeAndCompareSolutions(3, true, SPARSE_SCHUR, CX_SPARSE);
+  ComputeAndCompareSolutionsWithNewDiagonal(2, SPARSE_SCHUR, CX_SPARSE);
+  ComputeAndCompareSolutionsWithNewDiagonal(3, SPARSE_SCHUR, CX_SPARSE);
+}
+
+TEST_F(SchurComplementSolverTest,
+       SparseSchurWithCXSparseAndNestedDissection) {
+  use_nested_dissection_ordering = true;
+  ComputeAndCompareSolutions(2, false, SPARSE_SCHUR, CX_SPARSE);
+  ComputeAndCompareSolutions(3, false, SPARSE_SCHUR, CX_SPARSE);
+  ComputeAndCompareSolutions(2, true, SPARSE_SCHUR, CX_SPARSE);
+  ComputeAndCompareSolutions(3, true, SPARSE_SCHUR, CX_SPARSE);
 }
 #endif  // CERES_NO_CXSPARSE
 
@@ -156,5 +218,18 @@ TEST_F(SchurComplementSolverTest, DenseSchur) {
   ComputeAndCompareSolutions(3, true, DENSE_SCHUR, SUITE_SPARSE);
 }
 
+TEST_F(SchurComplementSolverTest, DenseSchurWithNewDiagonal) {
+  ComputeAndCompareSolutionsWithNewDiagonal(2, DENSE_SCHUR, SUITE_SPARSE);
+  ComputeAndCompareSolutionsWithNewDiagonal(3, DENSE_SCHUR, SUITE_SPARSE);
+}
+
+TEST_F(SchurComplementSolverTest, DenseSchurWithoutStoredProducts) {
+  max_schur_products_memory_in_mb = 0;
+  ComputeAndCompareSolutions(2, true, DENSE_SCHUR, SUITE_SPARSE);
+  ComputeAndCompareSolutions(3, true, DENSE_SCHUR, SUITE_SPARSE);
+  ComputeAndCompareSolutionsWithNewDiagonal(2, DENSE_SCHUR, SUITE_SPARSE);
+  ComputeAndCompareSolutionsWithNewDiagonal(3, DENSE_SCHUR, SUITE_SPARSE);
+}
+
 }  // namespace internal
 }  // namespace ceres
@@ -161,6 +161,31 @@ namespace internal {
 // 2008 for an example of such use].
 //
 // Example usage: Please see schur_complement_solver.cc
+
+// Of the quantities computed during the elimination, the per chunk
+// products E_k'E_k, E_k'F_k and E_k'b do not depend on the diagonal
+// matrix D. When the elimination is repeated for the same A and b and
+// a different D, as is the case when a Levenberg-Marquardt step is
+// rejected, storing these products allows the Schur complement to be
+// updated without touching the rows of A. See
+// SchurEliminatorBase::EliminateAndStoreProducts and
+// SchurEliminatorBase::EliminateWithNewDiagonal.
+//
+// The layout of the arrays is private to the eliminator that fills
+// them, and the user should treat this struct as opaque.
+struct SchurEliminationProducts {
+  // E_k'E_k for each chunk, without the contribution of D.
+  Vector ete;
+  // (E_k'E_k + D_k'D_k)^{-1} for each chunk for the last D.
+  Vector inverse_ete;
+  // E_k'F_k for each chunk.
+  Vector etf;
+  // E'b.
+  Vector etb;
+  // The last D. Empty if it was NULL.
+  Vector D;
+};
+
 class SchurEliminatorBase {
  public:
   virtual ~SchurEliminatorBase() {}
@@ -191,6 +216,27 @@ class SchurEliminatorBase {
                          BlockRandomAccessMatrix* lhs,
                          double* rhs) = 0;
 
+  // Same as Eliminate, but also stores the products of A and b which
+  // do not depend on D in products.
+  virtual void EliminateAndStoreProducts(const BlockSparseMatrixBase* A,
+                                         const double* b,
+                                         const double* D,
+                                         SchurEliminationProducts* products,
+                                         BlockRandomAccessMatrix* lhs,
+                                         double* rhs) = 0;
+
+  // Update the Schur complement system in lhs and rhs, computed by
+  // the last call to EliminateAndStoreProducts or
+  // EliminateWithNewDiagonal with the same products, to the one for
+  // the diagonal matrix D. The values of A are not used, only its
+  // block structure. The cost of the update is that of the chunk
+  // outer products, independent of the number of rows of A.
+  virtual void EliminateWithNewDiagonal(const BlockSparseMatrixBase* A,
+                                        const double* D,
+                                        SchurEliminationProducts* products,
+                                        BlockRandomAccessMatrix* lhs,
+                                        double* rhs) = 0;
+
   // Given values for the variables z in the F block of A, solve for
   // the optimal values of the variables y corresponding to the E
   // block in A.
@@ -199,6 +245,26 @@ class SchurEliminatorBase {
                               const double* D,
                               const double* z,
                               double* y) = 0;
+
+  // Same as BackSubstitute, but using the products stored by the last
+  // call to EliminateAndStoreProducts or EliminateWithNewDiagonal,
+  // which already contain the factorized diagonal blocks
+  // (E_k'E_k + D_k'D_k)^{-1} for the last D. Thus
+  //
+  //   y_k = (E_k'E_k + D_k'D_k)^{-1} (E_k'b - E_k'F_k z)
+  //
+  // is computed without touching the rows of A, only its block
+  // structure is used.
+  virtual void BackSubstituteUsingProducts(
+      const BlockSparseMatrixBase* A,
+      const SchurEliminationProducts& products,
+      const double* z,
+      double* y) = 0;
+
+  // Number of doubles that EliminateAndStoreProducts stores in a
+  // SchurEliminationProducts object, not counting the diagonal D.
+  virtual int ProductsSize() const = 0;
+
   // Factory
   static SchurEliminatorBase* Create(const LinearSolver::Options& options);
 };
@@ -231,11 +297,28 @@ class SchurEliminator : public SchurEliminatorBase {
                          const double* D,
                          BlockRandomAccessMatrix* lhs,
                          double* rhs);
+  virtual void EliminateAndStoreProducts(const BlockSparseMatrixBase* A,
+                                         const double* b,
+                                         const double* D,
+                                         SchurEliminationProducts* products,
+                                         BlockRandomAccessMatrix* lhs,
+                                         double* rhs);
+  virtual void EliminateWithNewDiagonal(const BlockSparseMatrixBase* A,
+                                        const double* D,
+                                        SchurEliminationProducts* products,
+                                        BlockRandomAccessMatrix* lhs,
+                                        double* rhs);
   virtual void BackSubstitute(const BlockSparseMatrixBase* A,
                               const double* b,
                               const double* D,
                               const double* z,
                               double* y);
+  virtual void BackSubstituteUsingProducts(
+      const BlockSparseMatrixBase* A,
+      const SchurEliminationProducts& products,
+      const double* z,
+      double* y);
+  virtual int ProductsSize() const;
 
  private:
   // Chunk objects store combinatorial information needed to
@@ -263,14 +346,60 @@ class SchurEliminator : public SchurEliminatorBase {
   // buffer_layout[z1] = 0
   // buffer_layout[z5] = y1 * z1
   // buffer_layout[z2] = y1 * z1 + y1 * z5
+  //
+  // buffer_size is the total size of these blocks, and ete_position
+  // and etf_position are the offsets of the chunk's E'E and E'F
+  // blocks in the arrays of SchurEliminationProducts.
+  //
+  // If the y blocks of the rows in the chunk are stored one after the
+  // other, as BlockJacobianWriter lays them out, they form a single
+  // row major matrix with e_block_size columns, the e panel of the
+  // chunk, and e_panel_num_rows is its number of rows. E'E and E'b
+  // for the chunk are then computed with one matrix product each
+  // instead of one per row. Otherwise e_panel_num_rows is zero.
   typedef map<int, int> BufferLayoutType;
   struct Chunk {
-    Chunk() : size(0) {}
+    Chunk()
+        : size(0),
+          buffer_size(0),
+          ete_position(0),
+          etf_position(0),
+          e_panel_num_rows(0) {}
     int size;
     int start;
+    int buffer_size;
+    int ete_position;
+    int etf_position;
+    int e_panel_num_rows;
     BufferLayoutType buffer_layout;
   };
 
+  // Implementation of Eliminate and EliminateAndStoreProducts. If
+  // products is NULL, the per thread buffer_ is used for E'F.
+  void EliminateInternal(const BlockSparseMatrixBase* A,
+                         const double* b,
+                         const double* D,
+                         SchurEliminationProducts* products,
+                         BlockRandomAccessMatrix* lhs,
+                         double* rhs);
+
+  // Add the diagonal D to the blocks of lhs corresponding to the f
+  // blocks, subtracting old_D if it is not NULL.
+  void AddDiagonalToLhs(const CompressedRowBlockStructure* bs,
+                        const double* D,
+                        const double* old_D,
+                        BlockRandomAccessMatrix* lhs);
+
+  // Pointer to the first entry of the e panel of chunk. The chunk
+  // must have an e panel.
+  const double* ChunkPanel(const Chunk& chunk,
+                           const BlockSparseMatrixBase* A) const;
+
+  void AddChunkPanelGramian(
+      const Chunk& chunk,
+      const BlockSparseMatrixBase* A,
+      typename EigenTypes<kEBlockSize, kEBlockSize>::Matrix* ete) const;
+
   void ChunkDiagonalBlockAndGradient(
       const Chunk& chunk,
       const BlockSparseMatrixBase* A,
@@ -341,6 +470,12 @@ class SchurEliminator : public SchurEliminatorBase {
   scoped_array<double> chunk_outer_product_buffer_;
 
   int buffer_size_;
+
+  // Sizes of the arrays in SchurEliminationProducts.
+  int ete_storage_size_;
+  int etf_storage_size_;
+  int num_e_parameters_;
+
   int num_threads_;
   int uneliminated_row_begins_;
 
@@ -85,6 +85,12 @@ Init(int num_eliminate_blocks, const CompressedRowBlockStructure* bs) {
   const int num_row_blocks = bs->rows.size();
 
   buffer_size_ = 1;
+  ete_storage_size_ = 0;
+  etf_storage_size_ = 0;
+  num_e_parameters_ = 0;
+  for (int i = 0; i < num_eliminate_blocks_; ++i) {
+    num_e_parameters_ += bs->cols[i].size;
+  }
   chunks_.clear();
   lhs_row_layout_.clear();
 
@@ -140,6 +146,29 @@ Init(int num_eliminate_blocks, const CompressedRowBlockStructure* bs) {
     }
 
     CHECK_GT(chunk.size, 0);
+
+    // Check if the e_blocks of the chunk form an e panel, see Chunk.
+    const CompressedRow& first_row = bs->rows[r];
+    chunk.e_panel_num_rows = first_row.block.size;
+    for (int j = 1; j < chunk.size; ++j) {
+      const CompressedRow& previous_row = bs->rows[r + j - 1];
+      const CompressedRow& row = bs->rows[r + j];
+      if (row.cells.front().position !=
+          (previous_row.cells.front().position +
+           previous_row.block.size * e_block_size) ||
+          row.block.position !=
+          previous_row.block.position + previous_row.block.size) {
+        chunk.e_panel_num_rows = 0;
+        break;
+      }
+      chunk.e_panel_num_rows += row.block.size;
+    }
+
+    chunk.buffer_size = buffer_size;
+    chunk.ete_position = ete_storage_size_;
+    chunk.etf_position = etf_storage_size_;
+    ete_storage_size_ += e_block_size * e_block_size;
+    etf_storage_size_ += buffer_size;
     r += chunk.size;
   }
   const Chunk& chunk = chunks_.back();
@@ -171,35 +200,173 @@ Eliminate(const BlockSparseMatrixBase* A,
           const double* D,
           BlockRandomAccessMatrix* lhs,
           double* rhs) {
-  if (lhs->num_rows() > 0) {
-    lhs->SetZero();
-    VectorRef(rhs, lhs->num_rows()).setZero();
+  EliminateInternal(A, b, D, NULL, lhs, rhs);
+}
+
+template <int kRowBlockSize, int kEBlockSize, int kFBlockSize>
+void
+SchurEliminator<kRowBlockSize, kEBlockSize, kFBlockSize>::
+EliminateAndStoreProducts(const BlockSparseMatrixBase* A,
+                          const double* b,
+                          const double* D,
+                          SchurEliminationProducts* products,
+                          BlockRandomAccessMatrix* lhs,
+                          double* rhs) {
+  CHECK_NOTNULL(products);
+  products->ete.resize(ete_storage_size_);
+  products->inverse_ete.resize(ete_storage_size_);
+  products->etf.resize(etf_storage_size_);
+  products->etb.resize(num_e_parameters_);
+  EliminateInternal(A, b, D, products, lhs, rhs);
+  if (D != NULL) {
+    products->D = ConstVectorRef(D, A->num_cols());
+  } else {
+    products->D.resize(0);
   }
+}
+
+// Given the stored products, the only part of the Schur complement
+// system which depends on D is
+//
+//   S = D_F'D_F - sum_k F_k'E_k (E_k'E_k + D_k'D_k)^{-1} E_k'F_k
+//   r = - sum_k F_k'E_k (E_k'E_k + D_k'D_k)^{-1} E_k'b
+//
+// so instead of recomputing S and r from scratch, the difference
+// between the terms for the new and the old D is added to them.
+template <int kRowBlockSize, int kEBlockSize, int kFBlockSize>
+void
+SchurEliminator<kRowBlockSize, kEBlockSize, kFBlockSize>::
+EliminateWithNewDiagonal(const BlockSparseMatrixBase* A,
+                         const double* D,
+                         SchurEliminationProducts* products,
+                         BlockRandomAccessMatrix* lhs,
+                         double* rhs) {
+  CHECK_NOTNULL(products);
+  CHECK_EQ(products->ete.size(), ete_storage_size_);
+  CHECK_EQ(products->etf.size(), etf_storage_size_);
+  CHECK_EQ(products->etb.size(), num_e_parameters_);
 
   const CompressedRowBlockStructure* bs = A->block_structure();
-  const int num_col_blocks = bs->cols.size();
+  const double* old_D = (products->D.size() > 0) ? products->D.data() : NULL;
+  AddDiagonalToLhs(bs, D, old_D, lhs);
+
+#pragma omp parallel for num_threads(num_threads_) schedule(dynamic)
+  for (int i = 0; i < chunks_.size(); ++i) {
+    const Chunk& chunk = chunks_[i];
+    const int e_block_id = bs->rows[chunk.start].cells.front().block_id;
+    const int e_block_size = bs->cols[e_block_id].size;
+    const int e_block_position = bs->cols[e_block_id].position;
+
+    typename EigenTypes<kEBlockSize, kEBlockSize>::Matrix ete =
+        typename EigenTypes<kEBlockSize, kEBlockSize>::ConstMatrixRef(
+            products->ete.data() + chunk.ete_position,
+            e_block_size,
+            e_block_size);
+    if (D != NULL) {
+      const typename EigenTypes<kEBlockSize>::ConstVectorRef
+          diag(D + e_block_position, e_block_size);
+      ete.diagonal() += diag.array().square().matrix();
+    }
+
+    typename EigenTypes<kEBlockSize, kEBlockSize>::MatrixRef inverse_ete(
+        products->inverse_ete.data() + chunk.ete_position,
+        e_block_size,
+        e_block_size);
+
+    // delta = (E'E + D_new'D_new)^{-1} - (E'E + D_old'D_old)^{-1}
+    const Matrix delta =
+        ete
+        .template selfadjointView<Eigen::Upper>()
+        .llt()
+        .solve(Matrix::Identity(e_block_size, e_block_size))
+        - inverse_ete;
+    inverse_ete += delta;
+
+    //   rhs -= F'E delta E'b
+    const double* etf = products->etf.data() + chunk.etf_position;
+    const typename EigenTypes<kEBlockSize>::Vector delta_etb =
+        delta * typename EigenTypes<kEBlockSize>::ConstVectorRef(
+            products->etb.data() + e_block_position, e_block_size);
+    for (BufferLayoutType::const_iterator it = chunk.buffer_layout.begin();
+         it != chunk.buffer_layout.end();
+         ++it) {
+      const int block = it->first - num_eliminate_blocks_;
+      const int block_size = bs->cols[it->first].size;
+      CeresMutexLock l(rhs_locks_[block]);
+      MatrixTransposeVectorMultiply<kEBlockSize, kFBlockSize, -1>(
+          etf + it->second, e_block_size, block_size,
+          delta_etb.data(),
+          rhs + lhs_row_layout_[block]);
+    }
+
+    //   S -= F'E delta E'F
+    ChunkOuterProduct(bs, delta, etf, chunk.buffer_layout, lhs);
+  }
 
-  // Add the diagonal to the schur complement.
   if (D != NULL) {
+    products->D = ConstVectorRef(D, A->num_cols());
+  } else {
+    products->D.resize(0);
+  }
+}
+
+template <int kRowBlockSize, int kEBlockSize, int kFBlockSize>
+void
+SchurEliminator<kRowBlockSize, kEBlockSize, kFBlockSize>::
+AddDiagonalToLhs(const CompressedRowBlockStructure* bs,
+                 const double* D,
+                 const double* old_D,
+                 BlockRandomAccessMatrix* lhs) {
+  if (D == NULL && old_D == NULL) {
+    return;
+  }
+
+  const int num_col_blocks = bs->cols.size();
 #pragma omp parallel for num_threads(num_threads_) schedule(dynamic)
-    for (int i = num_eliminate_blocks_; i < num_col_blocks; ++i) {
-      const int block_id = i - num_eliminate_blocks_;
-      int r, c, row_stride, col_stride;
-      CellInfo* cell_info = lhs->GetCell(block_id, block_id,
-                                         &r, &c,
-                                         &row_stride, &col_stride);
-      if (cell_info != NULL) {
-        const int block_size = bs->cols[i].size;
+  for (int i = num_eliminate_blocks_; i < num_col_blocks; ++i) {
+    const int block_id = i - num_eliminate_blocks_;
+    int r, c, row_stride, col_stride;
+    CellInfo* cell_info = lhs->GetCell(block_id, block_id,
+                                       &r, &c,
+                                       &row_stride, &col_stride);
+    if (cell_info != NULL) {
+      const int block_size = bs->cols[i].size;
+      CeresMutexLock l(&cell_info->m);
+      MatrixRef m(cell_info->values, row_stride, col_stride);
+      if (D != NULL) {
         typename EigenTypes<kFBlockSize>::ConstVectorRef
             diag(D + bs->cols[i].position, block_size);
-
-        CeresMutexLock l(&cell_info->m);
-        MatrixRef m(cell_info->values, row_stride, col_stride);
         m.block(r, c, block_size, block_size).diagonal()
             += diag.array().square().matrix();
       }
+      if (old_D != NULL) {
+        typename EigenTypes<kFBlockSize>::ConstVectorRef
+            diag(old_D + bs->cols[i].position, block_size);
+        m.block(r, c, block_size, block_size).diagonal()
+            -= diag.array().square().matrix();
+      }
     }
   }
+}
+
+template <int kRowBlockSize, int kEBlockSize, int kFBlockSize>
+void
+SchurEliminator<kRowBlockSize, kEBlockSize, kFBlockSize>::
+EliminateInternal(const BlockSparseMatrixBase* A,
+                  const double* b,
+                  const double* D,
+                  SchurEliminationProducts* products,
+                  BlockRandomAccessMatrix* lhs,
+                  double* rhs) {
+  if (lhs->num_rows() > 0) {
+    lhs->SetZero();
+    VectorRef(rhs, lhs->num_rows()).setZero();
+  }
+
+  const CompressedRowBlockStructure* bs = A->block_structure();
+
+  // Add the diagonal to the schur complement.
+  AddDiagonalToLhs(bs, D, NULL, lhs);
 
   // Eliminate y blocks one chunk at a time.  For each chunk,x3
   // compute the entries of the normal equations and the gradient
@@ -222,23 +389,19 @@ Eliminate(const BlockSparseMatrixBase* A,
 #else
     int thread_id = 0;
 #endif
-    double* buffer = buffer_.get() + thread_id * buffer_size_;
     const Chunk& chunk = chunks_[i];
+    double* buffer = (products != NULL)
+        ? products->etf.data() + chunk.etf_position
+        : buffer_.get() + thread_id * buffer_size_;
     const int e_block_id = bs->rows[chunk.start].cells.front().block_id;
     const int e_block_size = bs->cols[e_block_id].size;
+    const int e_block_position = bs->cols[e_block_id].position;
 
-    VectorRef(buffer, buffer_size_).setZero();
+    VectorRef(buffer, chunk.buffer_size).setZero();
 
     typename EigenTypes<kEBlockSize, kEBlockSize>::Matrix
         ete(e_block_size, e_block_size);
-
-    if (D != NULL) {
-      const typename EigenTypes<kEBlockSize>::ConstVectorRef
-          diag(D + bs->cols[e_block_id].position, e_block_size);
-      ete = diag.array().square().matrix().asDiagonal();
-    } else {
-      ete.setZero();
-    }
+    ete.setZero();
 
     typename EigenTypes<kEBlockSize>::Vector g(e_block_size);
     g.setZero();
@@ -258,6 +421,21 @@ Eliminate(const BlockSparseMatrixBase* A,
     ChunkDiagonalBlockAndGradient(
         chunk, A, b, chunk.start, &ete, &g, buffer, lhs);
 
+    if (products != NULL) {
+      typename EigenTypes<kEBlockSize, kEBlockSize>::MatrixRef(
+          products->ete.data() + chunk.ete_position,
+          e_block_size,
+          e_block_size) = ete;
+      typename EigenTypes<kEBlockSize>::VectorRef(
+          products->etb.data() + e_block_position, e_block_size) = g;
+    }
+
+    if (D != NULL) {
+      const typename EigenTypes<kEBlockSize>::ConstVectorRef
+          diag(D + e_block_position, e_block_size);
+      ete.diagonal() += diag.array().square().matrix();
+    }
+
     // Normally one wouldn't compute the inverse explicitly, but
     // e_block_size will typically be a small number like 3, in
     // which case its much faster to compute the inverse once and
@@ -269,6 +447,13 @@ Eliminate(const BlockSparseMatrixBase* A,
         .llt()
         .solve(Matrix::Identity(e_block_size, e_block_size));
 
+    if (products != NULL) {
+      typename EigenTypes<kEBlockSize, kEBlockSize>::MatrixRef(
+          products->inverse_ete.data() + chunk.ete_position,
+          e_block_size,
+          e_block_size) = inverse_ete;
+    }
+
     // For the current chunk compute and update the rhs of the reduced
     // linear system.
     //
@@ -312,6 +497,10 @@ BackSubstitute(const BlockSparseMatrixBase* A,
       ete.setZero();
     }
 
+    if (chunk.e_panel_num_rows > 0) {
+      AddChunkPanelGramian(chunk, A, &ete);
+    }
+
     for (int j = 0; j < chunk.size; ++j) {
       const CompressedRow& row = bs->rows[chunk.start + j];
       const double* row_values = A->RowBlockValues(chunk.start + j);
@@ -338,17 +527,71 @@ BackSubstitute(const BlockSparseMatrixBase* A,
           sj.data(),
           y_ptr);
 
-      MatrixTransposeMatrixMultiply
-          <kRowBlockSize, kEBlockSize,kRowBlockSize, kEBlockSize, 1>(
-              row_values + e_cell.position, row.block.size, e_block_size,
-              row_values + e_cell.position, row.block.size, e_block_size,
-              ete.data(), 0, 0, e_block_size, e_block_size);
+      if (chunk.e_panel_num_rows == 0) {
+        MatrixTransposeMatrixMultiply
+            <kRowBlockSize, kEBlockSize,kRowBlockSize, kEBlockSize, 1>(
+                row_values + e_cell.position, row.block.size, e_block_size,
+                row_values + e_cell.position, row.block.size, e_block_size,
+                ete.data(), 0, 0, e_block_size, e_block_size);
+      }
     }
 
     ete.llt().solveInPlace(y_block);
   }
 }
 
+template <int kRowBlockSize, int kEBlockSize, int kFBlockSize>
+void
+SchurEliminator<kRowBlockSize, kEBlockSize, kFBlockSize>::
+BackSubstituteUsingProducts(const BlockSparseMatrixBase* A,
+                            const SchurEliminationProducts& products,
+                            const double* z,
+                            double* y) {
+  CHECK_EQ(products.inverse_ete.size(), ete_storage_size_);
+  CHECK_EQ(products.etf.size(), etf_storage_size_);
+  CHECK_EQ(products.etb.size(), num_e_parameters_);
+
+  const CompressedRowBlockStructure* bs = A->block_structure();
+#pragma omp parallel for num_threads(num_threads_) schedule(dynamic)
+  for (int i = 0; i < chunks_.size(); ++i) {
+    const Chunk& chunk = chunks_[i];
+    const int e_block_id = bs->rows[chunk.start].cells.front().block_id;
+    const int e_block_size = bs->cols[e_block_id].size;
+    const int e_block_position = bs->cols[e_block_id].position;
+
+    //   g = E'b - E'F z
+    typename EigenTypes<kEBlockSize>::Vector g =
+        typename EigenTypes<kEBlockSize>::ConstVectorRef(
+            products.etb.data() + e_block_position, e_block_size);
+    const double* etf = products.etf.data() + chunk.etf_position;
+    for (BufferLayoutType::const_iterator it = chunk.buffer_layout.begin();
+         it != chunk.buffer_layout.end();
+         ++it) {
+      const int block = it->first - num_eliminate_blocks_;
+      const int block_size = bs->cols[it->first].size;
+      MatrixVectorMultiply<kEBlockSize, kFBlockSize, -1>(
+          etf + it->second, e_block_size, block_size,
+          z + lhs_row_layout_[block],
+          g.data());
+    }
+
+    //   y = (E'E + D'D)^{-1} g
+    typename EigenTypes<kEBlockSize>::VectorRef(y + e_block_position,
+                                                e_block_size) =
+        typename EigenTypes<kEBlockSize, kEBlockSize>::ConstMatrixRef(
+            products.inverse_ete.data() + chunk.ete_position,
+            e_block_size,
+            e_block_size) * g;
+  }
+}
+
+template <int kRowBlockSize, int kEBlockSize, int kFBlockSize>
+int
+SchurEliminator<kRowBlockSize, kEBlockSize, kFBlockSize>::
+ProductsSize() const {
+  return 2 * ete_storage_size_ + etf_storage_size_ + num_e_parameters_;
+}
+
 // Update the rhs of the reduced linear system. Compute
 //
 //   F'b - F'E(E'E)^(-1) E'b
@@ -429,6 +672,19 @@ ChunkDiagonalBlockAndGradient(
   int b_pos = bs->rows[row_block_counter].block.position;
   const int e_block_size = ete->rows();
 
+  // If the e_blocks form an e panel, ETE += E'E and g += E'b for the
+  // whole chunk at once.
+  if (chunk.e_panel_num_rows > 0) {
+    AddChunkPanelGramian(chunk, A, ete);
+    const typename EigenTypes<Eigen::Dynamic, kEBlockSize>::ConstMatrixRef
+        e_panel(ChunkPanel(chunk, A),
+                chunk.e_panel_num_rows,
+                e_block_size);
+    g->noalias() += e_panel.transpose() *
+        typename EigenTypes<Eigen::Dynamic>::ConstVectorRef(
+            b + b_pos, chunk.e_panel_num_rows);
+  }
+
   // Iterate over the rows in this chunk, for each row, compute the
   // contribution of its F blocks to the Schur complement, the
   // contribution of its E block to the matrix EE' (ete), and the
@@ -441,19 +697,21 @@ ChunkDiagonalBlockAndGradient(
       EBlockRowOuterProduct(A, row_block_counter + j, lhs);
     }
 
-    // Extract the e_block, ETE += E_i' E_i
     const Cell& e_cell = row.cells.front();
-    MatrixTransposeMatrixMultiply
-        <kRowBlockSize, kEBlockSize, kRowBlockSize, kEBlockSize, 1>(
-            row_values + e_cell.position, row.block.size, e_block_size,
-            row_values + e_cell.position, row.block.size, e_block_size,
-            ete->data(), 0, 0, e_block_size, e_block_size);
+    if (chunk.e_panel_num_rows == 0) {
+      // Extract the e_block, ETE += E_i' E_i
+      MatrixTransposeMatrixMultiply
+          <kRowBlockSize, kEBlockSize, kRowBlockSize, kEBlockSize, 1>(
+              row_values + e_cell.position, row.block.size, e_block_size,
+              row_values + e_cell.position, row.block.size, e_block_size,
+              ete->data(), 0, 0, e_block_size, e_block_size);
 
-    // g += E_i' b_i
-    MatrixTransposeVectorMultiply<kRowBlockSize, kEBlockSize, 1>(
-        row_values + e_cell.position, row.block.size, e_block_size,
-        b + b_pos,
-        g->data());
+      // g += E_i' b_i
+      MatrixTransposeVectorMultiply<kRowBlockSize, kEBlockSize, 1>(
+          row_values + e_cell.position, row.block.size, e_block_size,
+          b + b_pos,
+          g->data());
+    }
 
 
     // buffer = E'F. This computation is done by iterating over the
@@ -473,6 +731,32 @@ ChunkDiagonalBlockAndGradient(
   }
 }
 
+template <int kRowBlockSize, int kEBlockSize, int kFBlockSize>
+const double*
+SchurEliminator<kRowBlockSize, kEBlockSize, kFBlockSize>::
+ChunkPanel(const Chunk& chunk, const BlockSparseMatrixBase* A) const {
+  DCHECK_GT(chunk.e_panel_num_rows, 0);
+  // The e panel spans several rows, which is only valid if all of
+  // them share one values array.
+  DCHECK_EQ(A->RowBlockValues(chunk.start),
+            A->RowBlockValues(chunk.start + chunk.size - 1));
+  return A->RowBlockValues(chunk.start) +
+      A->block_structure()->rows[chunk.start].cells.front().position;
+}
+
+// ete += E'E, where E is the e panel of the chunk.
+template <int kRowBlockSize, int kEBlockSize, int kFBlockSize>
+void
+SchurEliminator<kRowBlockSize, kEBlockSize, kFBlockSize>::
+AddChunkPanelGramian(
+    const Chunk& chunk,
+    const BlockSparseMatrixBase* A,
+    typename EigenTypes<kEBlockSize, kEBlockSize>::Matrix* ete) const {
+  const typename EigenTypes<Eigen::Dynamic, kEBlockSize>::ConstMatrixRef
+      e_panel(ChunkPanel(chunk, A), chunk.e_panel_num_rows, ete->rows());
+  ete->noalias() += e_panel.transpose() * e_panel;
+}
+
 // Compute the outer product F'E(E'E)^{-1}E'F and subtract it from the
 // Schur complement matrix, i.e
 //
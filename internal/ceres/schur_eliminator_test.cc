@@ -30,6 +30,7 @@
 
 #include "ceres/schur_eliminator.h"
 
+#include <algorithm>
 #include "Eigen/Dense"
 #include "ceres/block_random_access_dense_matrix.h"
 #include "ceres/block_sparse_matrix.h"
@@ -80,6 +81,42 @@ class SchurEliminatorTest : public ::testing::Test {
     }
   }
 
+  // Replace A by a copy whose e_blocks are stored before all other
+  // cells, in row order, as BlockJacobianWriter lays them out. This
+  // allows the eliminator to treat the e_blocks of each chunk as a
+  // single matrix.
+  void LayOutEBlocksFirst() {
+    const CompressedRowBlockStructure* bs = A->block_structure();
+    CompressedRowBlockStructure* new_bs =
+        new CompressedRowBlockStructure(*bs);
+    int position = 0;
+    for (int pass = 0; pass < 2; ++pass) {
+      for (int r = 0; r < new_bs->rows.size(); ++r) {
+        CompressedRow& row = new_bs->rows[r];
+        for (int c = 0; c < row.cells.size(); ++c) {
+          const bool is_e_block =
+              row.cells[c].block_id < num_eliminate_blocks;
+          if (is_e_block == (pass == 0)) {
+            row.cells[c].position = position;
+            position += row.block.size * bs->cols[row.cells[c].block_id].size;
+          }
+        }
+      }
+    }
+
+    BlockSparseMatrix* new_A = new BlockSparseMatrix(new_bs);
+    for (int r = 0; r < bs->rows.size(); ++r) {
+      const CompressedRow& row = bs->rows[r];
+      for (int c = 0; c < row.cells.size(); ++c) {
+        const int size = row.block.size * bs->cols[row.cells[c].block_id].size;
+        copy(A->values() + row.cells[c].position,
+             A->values() + row.cells[c].position + size,
+             new_A->mutable_values() + new_bs->rows[r].cells[c].position);
+      }
+    }
+    A.reset(new_A);
+  }
+
   // Compute the golden values for the reduced linear system and the
   // solution to the linear least squares problem using dense linear
   // algebra.
@@ -189,6 +226,105 @@ class SchurEliminatorTest : public ::testing::Test {
                 relative_tolerance);
   }
 
+  // Eliminate with one diagonal, and then update the reduced linear
+  // system for a sequence of other diagonals using the stored
+  // products. The result should match the reduced linear system
+  // computed from scratch, and back substituting using the stored
+  // products should match back substituting using A.
+  void EliminateWithNewDiagonalAndCompare(bool use_static_structure,
+                                          const double relative_tolerance) {
+    const CompressedRowBlockStructure* bs = A->block_structure();
+    const int num_col_blocks = bs->cols.size();
+    vector<int> blocks(num_col_blocks - num_eliminate_blocks, 0);
+    for (int i = num_eliminate_blocks; i < num_col_blocks; ++i) {
+      blocks[i - num_eliminate_blocks] = bs->cols[i].size;
+    }
+
+    const int num_cols = A->num_cols();
+    BlockRandomAccessDenseMatrix lhs(blocks);
+    BlockRandomAccessDenseMatrix expected_lhs(blocks);
+    const int schur_size = lhs.num_rows();
+    Vector rhs(schur_size);
+    Vector expected_rhs(schur_size);
+
+    LinearSolver::Options options;
+    options.elimination_groups.push_back(num_eliminate_blocks);
+    if (use_static_structure) {
+      DetectStructure(*bs,
+                      num_eliminate_blocks,
+                      &options.row_block_size,
+                      &options.e_block_size,
+                      &options.f_block_size);
+    }
+
+    scoped_ptr<SchurEliminatorBase> eliminator(
+        SchurEliminatorBase::Create(options));
+    eliminator->Init(num_eliminate_blocks, A->block_structure());
+
+    const ConstVectorRef diagonal(D.get(), num_cols);
+    vector<Vector> diagonals;
+    diagonals.push_back(diagonal);
+    diagonals.push_back(2.0 * diagonal);
+    diagonals.push_back(Vector::Zero(num_cols));
+    diagonals.push_back(10.0 * diagonal);
+
+    SchurEliminationProducts products;
+    eliminator->EliminateAndStoreProducts(A.get(),
+                                          b.get(),
+                                          NULL,
+                                          &products,
+                                          &lhs,
+                                          rhs.data());
+    for (int i = 0; i < diagonals.size(); ++i) {
+      eliminator->EliminateWithNewDiagonal(A.get(),
+                                           diagonals[i].data(),
+                                           &products,
+                                           &lhs,
+                                           rhs.data());
+      eliminator->Eliminate(A.get(),
+                            b.get(),
+                            diagonals[i].data(),
+                            &expected_lhs,
+                            expected_rhs.data());
+
+      const Matrix lhs_ref =
+          ConstMatrixRef(lhs.values(), schur_size, schur_size)
+          .triangularView<Eigen::Upper>();
+      const Matrix expected_lhs_ref =
+          ConstMatrixRef(expected_lhs.values(), schur_size, schur_size)
+          .triangularView<Eigen::Upper>();
+      EXPECT_NEAR((lhs_ref - expected_lhs_ref).norm() /
+                  expected_lhs_ref.norm(),
+                  0.0,
+                  relative_tolerance);
+      EXPECT_NEAR((rhs - expected_rhs).norm() / expected_rhs.norm(),
+                  0.0,
+                  relative_tolerance);
+
+      const Vector reduced_sol =
+          expected_lhs_ref
+          .selfadjointView<Eigen::Upper>()
+          .ldlt()
+          .solve(expected_rhs);
+      Vector sol(num_cols);
+      sol.setZero();
+      sol.tail(schur_size) = reduced_sol;
+      Vector expected_sol = sol;
+      eliminator->BackSubstituteUsingProducts(A.get(),
+                                              products,
+                                              reduced_sol.data(),
+                                              sol.data());
+      eliminator->BackSubstitute(A.get(),
+                                 b.get(),
+                                 diagonals[i].data(),
+                                 reduced_sol.data(),
+                                 expected_sol.data());
+      EXPECT_NEAR((sol - expected_sol).norm() / expected_sol.norm(),
+                  0.0,
+                  relative_tolerance);
+    }
+  }
+
   scoped_ptr<BlockSparseMatrix> A;
   scoped_array<double> b;
   scoped_array<double> D;
@@ -214,6 +350,29 @@ TEST_F(SchurEliminatorTest, ScalarProblem) {
   EliminateSolveAndCompare(VectorRef(D.get(), A->num_cols()), false, 1e-14);
 }
 
+TEST_F(SchurEliminatorTest, ScalarProblemWithNewDiagonal) {
+  SetUpFromId(2);
+  EliminateWithNewDiagonalAndCompare(true, 1e-14);
+  EliminateWithNewDiagonalAndCompare(false, 1e-14);
+}
+
+TEST_F(SchurEliminatorTest, ScalarProblemWithEBlocksFirst) {
+  SetUpFromId(2);
+  LayOutEBlocksFirst();
+  Vector zero(A->num_cols());
+  zero.setZero();
+
+  ComputeReferenceSolution(VectorRef(zero.data(), A->num_cols()));
+  EliminateSolveAndCompare(VectorRef(zero.data(), A->num_cols()), true, 1e-14);
+  EliminateSolveAndCompare(VectorRef(zero.data(), A->num_cols()), false, 1e-14);
+
+  ComputeReferenceSolution(VectorRef(D.get(), A->num_cols()));
+  EliminateSolveAndCompare(VectorRef(D.get(), A->num_cols()), true, 1e-14);
+  EliminateSolveAndCompare(VectorRef(D.get(), A->num_cols()), false, 1e-14);
+  EliminateWithNewDiagonalAndCompare(true, 1e-14);
+  EliminateWithNewDiagonalAndCompare(false, 1e-14);
+}
+
 #ifndef CERES_NO_PROTOCOL_BUFFERS
 TEST_F(SchurEliminatorTest, BlockProblem) {
   const string input_file = TestFileAbsolutePath("problem-6-1384-000.lsqp");
@@ -223,6 +382,24 @@ TEST_F(SchurEliminatorTest, BlockProblem) {
   EliminateSolveAndCompare(VectorRef(D.get(), A->num_cols()), true, 1e-10);
   EliminateSolveAndCompare(VectorRef(D.get(), A->num_cols()), false, 1e-10);
 }
+
+TEST_F(SchurEliminatorTest, BlockProblemWithNewDiagonal) {
+  const string input_file = TestFileAbsolutePath("problem-6-1384-000.lsqp");
+
+  SetUpFromFilename(input_file);
+  EliminateWithNewDiagonalAndCompare(true, 1e-10);
+  EliminateWithNewDiagonalAndCompare(false, 1e-10);
+}
+
+TEST_F(SchurEliminatorTest, BlockProblemWithEBlocksFirst) {
+  const string input_file = TestFileAbsolutePath("problem-6-1384-000.lsqp");
+
+  SetUpFromFilename(input_file);
+  LayOutEBlocksFirst();
+  ComputeReferenceSolution(VectorRef(D.get(), A->num_cols()));
+  EliminateSolveAndCompare(VectorRef(D.get(), A->num_cols()), true, 1e-10);
+  EliminateSolveAndCompare(VectorRef(D.get(), A->num_cols()), false, 1e-10);
+}
 #endif  // CERES_NO_PROTOCOL_BUFFERS
 
 }  // namespace internal
@@ -40,6 +40,7 @@
 #include "ceres/internal/scoped_ptr.h"
 #include "ceres/linear_solver.h"
 #include "ceres/schur_eliminator.h"
+#include "ceres/schur_structure_cache.h"
 #include "glog/logging.h"
 
 namespace ceres {
@@ -48,7 +49,8 @@ namespace internal {
 SchurJacobiPreconditioner::SchurJacobiPreconditioner(
     const CompressedRowBlockStructure& bs,
     const Preconditioner::Options& options)
-    : options_(options) {
+    : options_(options),
+      eliminator_(NULL) {
   CHECK_GT(options_.elimination_groups.size(), 1);
   CHECK_GT(options_.elimination_groups[0], 0);
   const int num_blocks = bs.cols.size() - options_.elimination_groups[0];
@@ -76,6 +78,14 @@ SchurJacobiPreconditioner::~SchurJacobiPreconditioner() {
 // Initialize the SchurEliminator.
 void SchurJacobiPreconditioner::InitEliminator(
     const CompressedRowBlockStructure& bs) {
+  if (options_.schur_structure_cache != NULL) {
+    eliminator_ =
+        options_.schur_structure_cache
+        ->FindOrCreate(bs, options_.elimination_groups[0])
+        ->Eliminator(bs, options_.num_threads);
+    return;
+  }
+
   LinearSolver::Options eliminator_options;
 
   eliminator_options.elimination_groups = options_.elimination_groups;
@@ -86,8 +96,9 @@ void SchurJacobiPreconditioner::InitEliminator(
                   &eliminator_options.e_block_size,
                   &eliminator_options.f_block_size);
 
-  eliminator_.reset(SchurEliminatorBase::Create(eliminator_options));
-  eliminator_->Init(options_.elimination_groups[0], &bs);
+  owned_eliminator_.reset(SchurEliminatorBase::Create(eliminator_options));
+  owned_eliminator_->Init(options_.elimination_groups[0], &bs);
+  eliminator_ = owned_eliminator_.get();
 }
 
 // Update the values of the preconditioner matrix and factorize it.
@@ -97,7 +97,12 @@ class SchurJacobiPreconditioner : public Preconditioner {
 
   // Sizes of the blocks in the schur complement.
   vector<int> block_size_;
-  scoped_ptr<SchurEliminatorBase> eliminator_;
+
+  // If options_.schur_structure_cache is not NULL, the eliminator is
+  // shared with other users of the cache, otherwise it is owned by
+  // this object.
+  scoped_ptr<SchurEliminatorBase> owned_eliminator_;
+  SchurEliminatorBase* eliminator_;
 
   // Preconditioner matrix.
   scoped_ptr<BlockRandomAccessSparseMatrix> m_;
@@ -0,0 +1,281 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "ceres/schur_structure_cache.h"
+
+#include <map>
+#include <utility>
+#include <vector>
+#include "ceres/block_structure.h"
+#include "ceres/detect_structure.h"
+#include "ceres/linear_solver.h"
+#include "ceres/schur_complement_pattern.h"
+#include "ceres/schur_eliminator.h"
+#include "glog/logging.h"
+
+namespace ceres {
+namespace internal {
+namespace {
+
+// 64 bit FNV-1a.
+const uint64 kFingerprintOffsetBasis = 14695981039346656037ULL;
+const uint64 kFingerprintPrime = 1099511628211ULL;
+
+inline void FingerprintCombine(int value, uint64* fingerprint) {
+  uint32 v = static_cast<uint32>(value);
+  for (int i = 0; i < 4; ++i) {
+    *fingerprint ^= (v & 0xff);
+    *fingerprint *= kFingerprintPrime;
+    v >>= 8;
+  }
+}
+
+}  // namespace
+
+uint64 BlockStructureFingerprint(const CompressedRowBlockStructure& bs,
+                                 const int num_eliminate_blocks) {
+  uint64 fingerprint = kFingerprintOffsetBasis;
+  FingerprintCombine(num_eliminate_blocks, &fingerprint);
+
+  FingerprintCombine(bs.cols.size(), &fingerprint);
+  for (int i = 0; i < bs.cols.size(); ++i) {
+    FingerprintCombine(bs.cols[i].size, &fingerprint);
+  }
+
+  FingerprintCombine(bs.rows.size(), &fingerprint);
+  for (int i = 0; i < bs.rows.size(); ++i) {
+    const CompressedRow& row = bs.rows[i];
+    FingerprintCombine(row.block.size, &fingerprint);
+    FingerprintCombine(row.cells.size(), &fingerprint);
+    for (int j = 0; j < row.cells.size(); ++j) {
+      FingerprintCombine(row.cells[j].block_id, &fingerprint);
+      FingerprintCombine(row.cells[j].position, &fingerprint);
+    }
+  }
+  return fingerprint;
+}
+
+namespace {
+
+// The invariants of a block structure compared by
+// SchurStructure::Matches.
+struct BlockStructureSize {
+  explicit BlockStructureSize(const CompressedRowBlockStructure& bs)
+      : num_row_blocks(bs.rows.size()),
+        num_col_blocks(bs.cols.size()),
+        num_rows(0),
+        num_cols(0),
+        num_cells(0),
+        num_nonzeros(0) {
+    for (int i = 0; i < bs.cols.size(); ++i) {
+      num_cols += bs.cols[i].size;
+    }
+    for (int i = 0; i < bs.rows.size(); ++i) {
+      const CompressedRow& row = bs.rows[i];
+      num_rows += row.block.size;
+      num_cells += row.cells.size();
+      for (int j = 0; j < row.cells.size(); ++j) {
+        num_nonzeros += row.block.size * bs.cols[row.cells[j].block_id].size;
+      }
+    }
+  }
+
+  int num_row_blocks;
+  int num_col_blocks;
+  int num_rows;
+  int num_cols;
+  int num_cells;
+  int num_nonzeros;
+};
+
+}  // namespace
+
+SchurStructure::SchurStructure(const CompressedRowBlockStructure& bs,
+                               const int num_eliminate_blocks)
+    : num_eliminate_blocks_(num_eliminate_blocks),
+      eliminator_num_threads_(0) {
+  CHECK_GT(num_eliminate_blocks_, 0);
+  const BlockStructureSize size(bs);
+  num_row_blocks_ = size.num_row_blocks;
+  num_col_blocks_ = size.num_col_blocks;
+  num_rows_ = size.num_rows;
+  num_cols_ = size.num_cols;
+  num_cells_ = size.num_cells;
+  num_nonzeros_ = size.num_nonzeros;
+
+  const int num_col_blocks = bs.cols.size();
+  f_block_sizes_.resize(num_col_blocks - num_eliminate_blocks_);
+  for (int i = num_eliminate_blocks_; i < num_col_blocks; ++i) {
+    f_block_sizes_[i - num_eliminate_blocks_] = bs.cols[i].size;
+  }
+}
+
+SchurStructure::~SchurStructure() {
+  for (map<PreconditionerType, VisibilityClustering*>::iterator it =
+           clusterings_.begin();
+       it != clusterings_.end();
+       ++it) {
+    delete it->second;
+  }
+}
+
+bool SchurStructure::Matches(const CompressedRowBlockStructure& bs,
+                             const int num_eliminate_blocks) const {
+  if (num_eliminate_blocks != num_eliminate_blocks_) {
+    return false;
+  }
+
+  const BlockStructureSize size(bs);
+  return (size.num_row_blocks == num_row_blocks_ &&
+          size.num_col_blocks == num_col_blocks_ &&
+          size.num_rows == num_rows_ &&
+          size.num_cols == num_cols_ &&
+          size.num_cells == num_cells_ &&
+          size.num_nonzeros == num_nonzeros_);
+}
+
+SchurEliminatorBase* SchurStructure::Eliminator(
+    const CompressedRowBlockStructure& bs,
+    const int num_threads) {
+  if (eliminator_.get() != NULL && eliminator_num_threads_ == num_threads) {
+    return eliminator_.get();
+  }
+
+  LinearSolver::Options eliminator_options;
+  eliminator_options.elimination_groups.push_back(num_eliminate_blocks_);
+  eliminator_options.elimination_groups.push_back(f_block_sizes_.size());
+  eliminator_options.num_threads = num_threads;
+  DetectStructure(bs, num_eliminate_blocks_,
+                  &eliminator_options.row_block_size,
+                  &eliminator_options.e_block_size,
+                  &eliminator_options.f_block_size);
+
+  eliminator_.reset(
+      CHECK_NOTNULL(SchurEliminatorBase::Create(eliminator_options)));
+  eliminator_->Init(num_eliminate_blocks_, &bs);
+  eliminator_num_threads_ = num_threads;
+  return eliminator_.get();
+}
+
+const BlockSparsityPattern& SchurStructure::SchurComplementPattern(
+    const CompressedRowBlockStructure& bs,
+    const int num_threads) {
+  if (schur_complement_pattern_.get() == NULL) {
+    schur_complement_pattern_.reset(new BlockSparsityPattern);
+    ComputeSchurComplementPattern(bs,
+                                  num_eliminate_blocks_,
+                                  num_threads,
+                                  schur_complement_pattern_.get());
+  }
+  return *schur_complement_pattern_;
+}
+
+const VisibilityClustering* SchurStructure::FindClustering(
+    const PreconditionerType type) const {
+  map<PreconditionerType, VisibilityClustering*>::const_iterator it =
+      clusterings_.find(type);
+  return (it == clusterings_.end()) ? NULL : it->second;
+}
+
+void SchurStructure::InsertClustering(
+    const PreconditionerType type,
+    const VisibilityClustering& clustering) {
+  VisibilityClustering*& entry = clusterings_[type];
+  if (entry == NULL) {
+    entry = new VisibilityClustering;
+  }
+  *entry = clustering;
+}
+
+SchurStructureCache::SchurStructureCache(const int max_num_structures)
+    : max_num_structures_(max_num_structures),
+      num_lookups_(0) {
+  CHECK_GT(max_num_structures_, 0);
+}
+
+SchurStructureCache::~SchurStructureCache() {
+  for (map<uint64, Entry>::iterator it = entries_.begin();
+       it != entries_.end();
+       ++it) {
+    delete it->second.structure;
+  }
+}
+
+SchurStructure* SchurStructureCache::FindOrCreate(
+    const CompressedRowBlockStructure& bs,
+    const int num_eliminate_blocks) {
+  const uint64 fingerprint =
+      BlockStructureFingerprint(bs, num_eliminate_blocks);
+
+  CeresMutexLock l(&mutex_);
+  ++num_lookups_;
+  map<uint64, Entry>::iterator it = entries_.find(fingerprint);
+  if (it != entries_.end()) {
+    Entry& entry = it->second;
+    entry.last_used = num_lookups_;
+    if (entry.structure->Matches(bs, num_eliminate_blocks)) {
+      VLOG(2) << "Reusing cached Schur structure: " << fingerprint;
+      return entry.structure;
+    }
+
+    // A different structure with the same fingerprint. Replace the
+    // cached one, as the next lookup is more likely to be for the
+    // most recent structure.
+    LOG(WARNING) << "Block structure fingerprint collision: "
+                 << fingerprint;
+    delete entry.structure;
+    entry.structure = new SchurStructure(bs, num_eliminate_blocks);
+    return entry.structure;
+  }
+
+  // Evict the least recently used structure to make space.
+  if (entries_.size() >= max_num_structures_) {
+    map<uint64, Entry>::iterator lru = entries_.begin();
+    for (it = entries_.begin(); it != entries_.end(); ++it) {
+      if (it->second.last_used < lru->second.last_used) {
+        lru = it;
+      }
+    }
+    delete lru->second.structure;
+    entries_.erase(lru);
+  }
+
+  Entry& entry = entries_[fingerprint];
+  entry.structure = new SchurStructure(bs, num_eliminate_blocks);
+  entry.last_used = num_lookups_;
+  return entry.structure;
+}
+
+int SchurStructureCache::num_structures() const {
+  CeresMutexLock l(&mutex_);
+  return entries_.size();
+}
+
+}  // namespace internal
+}  // namespace ceres
@@ -0,0 +1,180 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Symbolic state of Schur type linear systems that only depends on
+// the block structure of the Jacobian, and can therefore be shared
+// between the linear solver, its preconditioner and across calls to
+// Solver::Solve on a problem whose structure has not changed.
+
+#ifndef CERES_INTERNAL_SCHUR_STRUCTURE_CACHE_H_
+#define CERES_INTERNAL_SCHUR_STRUCTURE_CACHE_H_
+
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+#include "ceres/collections_port.h"
+#include "ceres/integral_types.h"
+#include "ceres/internal/macros.h"
+#include "ceres/internal/port.h"
+#include "ceres/internal/scoped_ptr.h"
+#include "ceres/mutex.h"
+#include "ceres/schur_complement_pattern.h"
+#include "ceres/types.h"
+
+namespace ceres {
+namespace internal {
+
+struct CompressedRowBlockStructure;
+class SchurEliminatorBase;
+
+// Returns a 64 bit hash of the block structure and the number of
+// e_blocks. Two block structures with the same fingerprint are
+// likely, but not guaranteed, to be identical; see
+// SchurStructure::Matches.
+uint64 BlockStructureFingerprint(const CompressedRowBlockStructure& bs,
+                                 int num_eliminate_blocks);
+
+// The sparsity structure of a visibility based preconditioner. See
+// visibility_based_preconditioner.h for the meaning of the fields.
+struct VisibilityClustering {
+  VisibilityClustering() : num_clusters(0) {}
+
+  int num_clusters;
+  vector<int> cluster_membership;
+  HashSet<pair<int, int> > cluster_pairs;
+  set<pair<int, int> > block_pairs;
+};
+
+// Value independent data derived from a CompressedRowBlockStructure
+// with num_eliminate_blocks e_blocks. The block structure itself is
+// not stored, since it is owned by the Jacobian whose lifetime is
+// limited to a single call to Solver::Solve. Instead, methods that
+// need it take it as an argument, and it is the caller's
+// responsibility to pass a structure with the same fingerprint as the
+// one this object was constructed with.
+//
+// This class is not thread safe.
+class SchurStructure {
+ public:
+  SchurStructure(const CompressedRowBlockStructure& bs,
+                 int num_eliminate_blocks);
+  ~SchurStructure();
+
+  int num_eliminate_blocks() const { return num_eliminate_blocks_; }
+
+  // Returns true if the number of e_blocks and the sizes and numbers
+  // of blocks and cells of bs are the ones of the structure this
+  // object was constructed with. This does not compare the block ids
+  // and positions of the cells, but it is cheap, and it guards
+  // SchurStructureCache against most fingerprint collisions.
+  bool Matches(const CompressedRowBlockStructure& bs,
+               int num_eliminate_blocks) const;
+
+  // Sizes of the f_blocks, i.e., the blocks of the Schur complement.
+  const vector<int>& f_block_sizes() const { return f_block_sizes_; }
+
+  // Returns a SchurEliminator initialized for bs. The eliminator is
+  // created on the first call and reused afterwards, unless
+  // num_threads changes. The returned object is owned by this object
+  // and must not be used by more than one caller at a time.
+  SchurEliminatorBase* Eliminator(const CompressedRowBlockStructure& bs,
+                                  int num_threads);
+
+  // Returns the block sparsity pattern of the Schur complement of
+  // bs. The pattern is computed using num_threads threads on the
+  // first call and reused afterwards.
+  const BlockSparsityPattern& SchurComplementPattern(
+      const CompressedRowBlockStructure& bs,
+      int num_threads);
+
+  // Returns the clustering computed by the visibility based
+  // preconditioner of the given type, or NULL if none is available.
+  const VisibilityClustering* FindClustering(PreconditionerType type) const;
+
+  // Store a copy of clustering for later use by visibility based
+  // preconditioners of the given type.
+  void InsertClustering(PreconditionerType type,
+                        const VisibilityClustering& clustering);
+
+ private:
+  const int num_eliminate_blocks_;
+  vector<int> f_block_sizes_;
+
+  // Invariants of the block structure checked by Matches.
+  int num_row_blocks_;
+  int num_col_blocks_;
+  int num_rows_;
+  int num_cols_;
+  int num_cells_;
+  int num_nonzeros_;
+
+  scoped_ptr<SchurEliminatorBase> eliminator_;
+  int eliminator_num_threads_;
+
+  scoped_ptr<BlockSparsityPattern> schur_complement_pattern_;
+
+  map<PreconditionerType, VisibilityClustering*> clusterings_;
+  CERES_DISALLOW_COPY_AND_ASSIGN(SchurStructure);
+};
+
+// A thread safe map from block structure fingerprints to
+// SchurStructure objects. The cache is bounded and evicts the least
+// recently used structure once it is full. Pointers returned by
+// FindOrCreate remain valid until the next call to FindOrCreate with
+// a different structure causes an eviction; in practice this means
+// the lifetime of a single call to Solver::Solve.
+class SchurStructureCache {
+ public:
+  explicit SchurStructureCache(int max_num_structures);
+  ~SchurStructureCache();
+
+  // Returns the cached SchurStructure corresponding to bs, creating
+  // it if needed. The cache retains ownership of the returned object.
+  SchurStructure* FindOrCreate(const CompressedRowBlockStructure& bs,
+                               int num_eliminate_blocks);
+
+  int num_structures() const;
+
+ private:
+  struct Entry {
+    SchurStructure* structure;
+    int64 last_used;
+  };
+
+  const int max_num_structures_;
+  mutable Mutex mutex_;
+  int64 num_lookups_;
+  map<uint64, Entry> entries_;
+  CERES_DISALLOW_COPY_AND_ASSIGN(SchurStructureCache);
+};
+
+}  // namespace internal
+}  // namespace ceres
+
+#endif  // CERES_INTERNAL_SCHUR_STRUCTURE_CACHE_H_
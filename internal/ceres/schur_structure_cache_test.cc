@@ -0,0 +1,211 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "ceres/schur_structure_cache.h"
+
+#include "ceres/block_sparse_matrix.h"
+#include "ceres/block_structure.h"
+#include "ceres/casts.h"
+#include "ceres/internal/scoped_ptr.h"
+#include "ceres/linear_least_squares_problems.h"
+#include "ceres/linear_solver.h"
+#include "ceres/schur_complement_pattern.h"
+#include "ceres/schur_eliminator.h"
+#include "ceres/types.h"
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+namespace ceres {
+namespace internal {
+
+class SchurStructureCacheTest : public ::testing::Test {
+ protected:
+  BlockSparseMatrix* CreateMatrix(int problem_id, int* num_eliminate_blocks) {
+    scoped_ptr<LinearLeastSquaresProblem> problem(
+        CHECK_NOTNULL(CreateLinearLeastSquaresProblemFromId(problem_id)));
+    *num_eliminate_blocks = problem->num_eliminate_blocks;
+    return down_cast<BlockSparseMatrix*>(problem->A.release());
+  }
+};
+
+TEST_F(SchurStructureCacheTest, FingerprintOnlyDependsOnStructure) {
+  int num_eliminate_blocks;
+  scoped_ptr<BlockSparseMatrix> A(CreateMatrix(2, &num_eliminate_blocks));
+  scoped_ptr<BlockSparseMatrix> B(CreateMatrix(2, &num_eliminate_blocks));
+  scoped_ptr<BlockSparseMatrix> C(CreateMatrix(3, &num_eliminate_blocks));
+
+  // Changing the values does not change the fingerprint.
+  B->mutable_values()[0] += 1.0;
+
+  const uint64 a = BlockStructureFingerprint(*A->block_structure(),
+                                             num_eliminate_blocks);
+  EXPECT_EQ(a, BlockStructureFingerprint(*B->block_structure(),
+                                         num_eliminate_blocks));
+  EXPECT_NE(a, BlockStructureFingerprint(*C->block_structure(),
+                                         num_eliminate_blocks));
+  EXPECT_NE(a, BlockStructureFingerprint(*A->block_structure(),
+                                         num_eliminate_blocks - 1));
+}
+
+TEST_F(SchurStructureCacheTest, FindOrCreateReusesStructures) {
+  int num_eliminate_blocks;
+  scoped_ptr<BlockSparseMatrix> A(CreateMatrix(2, &num_eliminate_blocks));
+  scoped_ptr<BlockSparseMatrix> B(CreateMatrix(2, &num_eliminate_blocks));
+  scoped_ptr<BlockSparseMatrix> C(CreateMatrix(3, &num_eliminate_blocks));
+
+  SchurStructureCache cache(1);
+  SchurStructure* a = cache.FindOrCreate(*A->block_structure(),
+                                         num_eliminate_blocks);
+  EXPECT_EQ(a, cache.FindOrCreate(*B->block_structure(),
+                                  num_eliminate_blocks));
+  EXPECT_EQ(cache.num_structures(), 1);
+  EXPECT_EQ(a->num_eliminate_blocks(), num_eliminate_blocks);
+  EXPECT_EQ(a->f_block_sizes().size(),
+            A->block_structure()->cols.size() - num_eliminate_blocks);
+
+  // The cache only holds one structure, so C evicts A.
+  SchurStructure* c = cache.FindOrCreate(*C->block_structure(),
+                                         num_eliminate_blocks);
+  EXPECT_EQ(cache.num_structures(), 1);
+  EXPECT_EQ(c, cache.FindOrCreate(*C->block_structure(),
+                                  num_eliminate_blocks));
+}
+
+TEST_F(SchurStructureCacheTest, StructureMatchesItsBlockStructure) {
+  int num_eliminate_blocks;
+  scoped_ptr<BlockSparseMatrix> A(CreateMatrix(2, &num_eliminate_blocks));
+  scoped_ptr<BlockSparseMatrix> C(CreateMatrix(3, &num_eliminate_blocks));
+
+  SchurStructure structure(*A->block_structure(), num_eliminate_blocks);
+  EXPECT_TRUE(structure.Matches(*A->block_structure(), num_eliminate_blocks));
+  EXPECT_FALSE(structure.Matches(*A->block_structure(),
+                                 num_eliminate_blocks - 1));
+  EXPECT_FALSE(structure.Matches(*C->block_structure(), num_eliminate_blocks));
+
+  CompressedRowBlockStructure bs = *A->block_structure();
+  bs.rows.back().block.size += 1;
+  EXPECT_FALSE(structure.Matches(bs, num_eliminate_blocks));
+
+  bs = *A->block_structure();
+  bs.rows.back().cells.pop_back();
+  EXPECT_FALSE(structure.Matches(bs, num_eliminate_blocks));
+}
+
+TEST_F(SchurStructureCacheTest, EliminatorIsShared) {
+  int num_eliminate_blocks;
+  scoped_ptr<BlockSparseMatrix> A(CreateMatrix(2, &num_eliminate_blocks));
+  const CompressedRowBlockStructure& bs = *A->block_structure();
+
+  SchurStructureCache cache(2);
+  SchurStructure* structure = cache.FindOrCreate(bs, num_eliminate_blocks);
+  SchurEliminatorBase* eliminator = structure->Eliminator(bs, 1);
+  EXPECT_TRUE(eliminator != NULL);
+  EXPECT_EQ(eliminator, structure->Eliminator(bs, 1));
+}
+
+TEST_F(SchurStructureCacheTest, SchurComplementPatternIsShared) {
+  int num_eliminate_blocks;
+  scoped_ptr<BlockSparseMatrix> A(CreateMatrix(2, &num_eliminate_blocks));
+  const CompressedRowBlockStructure& bs = *A->block_structure();
+
+  SchurStructureCache cache(2);
+  SchurStructure* structure = cache.FindOrCreate(bs, num_eliminate_blocks);
+  const BlockSparsityPattern& pattern =
+      structure->SchurComplementPattern(bs, 1);
+  EXPECT_EQ(pattern.num_row_blocks(), structure->f_block_sizes().size());
+  EXPECT_EQ(&pattern, &structure->SchurComplementPattern(bs, 1));
+
+  BlockSparsityPattern expected;
+  ComputeSchurComplementPattern(bs, num_eliminate_blocks, 1, &expected);
+  EXPECT_EQ(pattern.rows, expected.rows);
+  EXPECT_EQ(pattern.cols, expected.cols);
+}
+
+TEST_F(SchurStructureCacheTest, ClusteringsAreStoredPerPreconditioner) {
+  int num_eliminate_blocks;
+  scoped_ptr<BlockSparseMatrix> A(CreateMatrix(2, &num_eliminate_blocks));
+  SchurStructureCache cache(2);
+  SchurStructure* structure = cache.FindOrCreate(*A->block_structure(),
+                                                 num_eliminate_blocks);
+  EXPECT_TRUE(structure->FindClustering(CLUSTER_JACOBI) == NULL);
+
+  VisibilityClustering clustering;
+  clustering.num_clusters = 1;
+  clustering.cluster_membership.push_back(0);
+  clustering.cluster_pairs.insert(make_pair(0, 0));
+  clustering.block_pairs.insert(make_pair(0, 0));
+  structure->InsertClustering(CLUSTER_JACOBI, clustering);
+
+  const VisibilityClustering* cached =
+      structure->FindClustering(CLUSTER_JACOBI);
+  ASSERT_TRUE(cached != NULL);
+  EXPECT_EQ(cached->num_clusters, 1);
+  EXPECT_EQ(cached->block_pairs.size(), 1);
+  EXPECT_TRUE(structure->FindClustering(CLUSTER_TRIDIAGONAL) == NULL);
+}
+
+// Two solvers sharing a cache should produce the same solution as a
+// solver without one.
+TEST_F(SchurStructureCacheTest, DenseSchurSolversShareState) {
+  scoped_ptr<LinearLeastSquaresProblem> problem(
+      CHECK_NOTNULL(CreateLinearLeastSquaresProblemFromId(2)));
+  const int num_eliminate_blocks = problem->num_eliminate_blocks;
+  const int num_cols = problem->A->num_cols();
+
+  LinearSolver::Options options;
+  options.type = DENSE_SCHUR;
+  options.elimination_groups.push_back(num_eliminate_blocks);
+  options.elimination_groups.push_back(
+      down_cast<BlockSparseMatrix*>(problem->A.get())
+      ->block_structure()->cols.size() - num_eliminate_blocks);
+
+  LinearSolver::PerSolveOptions per_solve_options;
+  per_solve_options.D = problem->D.get();
+
+  Vector expected(num_cols);
+  scoped_ptr<LinearSolver> solver(LinearSolver::Create(options));
+  solver->Solve(problem->A.get(), problem->b.get(), per_solve_options,
+                expected.data());
+
+  SchurStructureCache cache(2);
+  options.schur_structure_cache = &cache;
+  for (int i = 0; i < 2; ++i) {
+    Vector x(num_cols);
+    scoped_ptr<LinearSolver> cached_solver(LinearSolver::Create(options));
+    cached_solver->Solve(problem->A.get(), problem->b.get(),
+                         per_solve_options, x.data());
+    EXPECT_EQ(cache.num_structures(), 1);
+    for (int j = 0; j < num_cols; ++j) {
+      EXPECT_NEAR(x[j], expected[j], 1e-12);
+    }
+  }
+}
+
+}  // namespace internal
+}  // namespace ceres
@@ -0,0 +1,315 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "ceres/schwarz_preconditioner.h"
+
+#include <algorithm>
+#include <ctime>
+#include <set>
+#include <utility>
+#include <vector>
+#include "Eigen/Dense"
+#include "ceres/block_random_access_sparse_matrix.h"
+#include "ceres/block_sparse_matrix.h"
+#include "ceres/block_structure.h"
+#include "ceres/canonical_views_clustering.h"
+#include "ceres/collections_port.h"
+#include "ceres/compressed_graph.h"
+#include "ceres/dense_cholesky.h"
+#include "ceres/detect_structure.h"
+#include "ceres/internal/scoped_ptr.h"
+#include "ceres/linear_solver.h"
+#include "ceres/map_util.h"
+#include "ceres/schur_eliminator.h"
+#include "ceres/schur_structure_cache.h"
+#include "ceres/visibility.h"
+#include "glog/logging.h"
+
+namespace ceres {
+namespace internal {
+
+// Same clustering weights as the visibility based preconditioner.
+static const double kSizePenaltyWeight = 3.0;
+static const double kSimilarityPenaltyWeight = 0.0;
+
+// A camera is added to the subdomain of a neighbouring cluster if the
+// weight of its edge in the Schur complement graph, i.e., the
+// normalized number of points it shares with a camera in that
+// cluster, is at least this large.
+static const double kMinOverlapWeight = 0.5;
+
+SchwarzPreconditioner::SchwarzPreconditioner(
+    const CompressedRowBlockStructure& bs,
+    const Preconditioner::Options& options)
+    : options_(options),
+      eliminator_(NULL) {
+  CHECK_GT(options_.elimination_groups.size(), 1);
+  CHECK_GT(options_.elimination_groups[0], 0);
+  CHECK_GT(bs.cols.size() - options_.elimination_groups[0], 0)
+      << "Jacobian should have atleast 1 f_block for "
+      << "ADDITIVE_SCHWARZ preconditioner.";
+
+  const time_t start_time = time(NULL);
+  ComputeSubdomains(bs);
+  InitEliminator(bs);
+  VLOG(2) << "Subdomain computation time: " << time(NULL) - start_time;
+}
+
+SchwarzPreconditioner::~SchwarzPreconditioner() {
+}
+
+// Cluster the cameras using the canonical views algorithm, and
+// extend each cluster by the cameras outside it which are strongly
+// connected to it.
+void SchwarzPreconditioner::ComputeSubdomains(
+    const CompressedRowBlockStructure& bs) {
+  const int num_eliminate_blocks = options_.elimination_groups[0];
+  const int num_blocks = bs.cols.size() - num_eliminate_blocks;
+
+  block_size_.resize(num_blocks);
+  block_position_.resize(num_blocks);
+  int num_rows = 0;
+  for (int i = 0; i < num_blocks; ++i) {
+    block_size_[i] = bs.cols[i + num_eliminate_blocks].size;
+    block_position_[i] = num_rows;
+    num_rows += block_size_[i];
+  }
+
+  vector<set<int> > visibility;
+  ComputeVisibility(bs, num_eliminate_blocks, &visibility);
+  scoped_ptr<CompressedGraph> schur_complement_graph(
+      CHECK_NOTNULL(CreateSchurComplementGraph(visibility,
+                                               options_.num_threads)));
+
+  CanonicalViewsClusteringOptions clustering_options;
+  clustering_options.size_penalty_weight = kSizePenaltyWeight;
+  clustering_options.similarity_penalty_weight = kSimilarityPenaltyWeight;
+  clustering_options.num_threads = options_.num_threads;
+
+  vector<int> centers;
+  HashMap<int, int> membership;
+  ComputeCanonicalViewsClustering(*schur_complement_graph,
+                                  clustering_options,
+                                  &centers,
+                                  &membership);
+  const int num_clusters = max(1, static_cast<int>(centers.size()));
+
+  // Cameras which were not clustered are assigned to an arbitrary
+  // cluster, as in the visibility based preconditioner.
+  vector<int> cluster_membership(num_blocks);
+  vector<set<int> > subdomain_blocks(num_clusters);
+  for (int i = 0; i < num_blocks; ++i) {
+    int cluster_id = FindWithDefault(membership, i, -1);
+    if (cluster_id == -1) {
+      cluster_id = i % num_clusters;
+    }
+    cluster_membership[i] = cluster_id;
+    subdomain_blocks[cluster_id].insert(i);
+  }
+
+  // Overlap.
+  for (int i = 0; i < num_blocks; ++i) {
+    const int* neighbors = schur_complement_graph->Neighbors(i);
+    for (int j = 0; j < schur_complement_graph->Degree(i); ++j) {
+      const int neighbor = neighbors[j];
+      if (cluster_membership[neighbor] != cluster_membership[i] &&
+          schur_complement_graph->NeighborWeight(i, j) >= kMinOverlapWeight) {
+        subdomain_blocks[cluster_membership[neighbor]].insert(i);
+      }
+    }
+  }
+
+  // Every pair of cameras in a subdomain contributes a cell to the
+  // preconditioner, so that the subdomain matrices are principal
+  // submatrices of the Schur complement.
+  set<pair<int, int> > block_pairs;
+  subdomains_.clear();
+  block_occurrences_.clear();
+  block_occurrences_.resize(num_blocks);
+  for (int i = 0; i < num_clusters; ++i) {
+    if (subdomain_blocks[i].empty()) {
+      continue;
+    }
+
+    const int subdomain_id = subdomains_.size();
+    subdomains_.push_back(Subdomain());
+    Subdomain& subdomain = subdomains_.back();
+    subdomain.blocks.assign(subdomain_blocks[i].begin(),
+                            subdomain_blocks[i].end());
+    for (int j = 0; j < subdomain.blocks.size(); ++j) {
+      const int block = subdomain.blocks[j];
+      subdomain.block_layout.push_back(subdomain.num_rows);
+      block_occurrences_[block].push_back(
+          make_pair(subdomain_id, subdomain.num_rows));
+      subdomain.num_rows += block_size_[block];
+      for (int k = j; k < subdomain.blocks.size(); ++k) {
+        block_pairs.insert(make_pair(block, subdomain.blocks[k]));
+      }
+    }
+  }
+
+  VLOG(2) << "Number of subdomains: " << subdomains_.size()
+          << " Number of block pairs: " << block_pairs.size();
+
+  subdomain_solutions_.resize(subdomains_.size());
+  for (int i = 0; i < subdomains_.size(); ++i) {
+    subdomain_solutions_[i].resize(subdomains_[i].num_rows);
+  }
+
+  m_.reset(new BlockRandomAccessSparseMatrix(block_size_, block_pairs));
+}
+
+// Initialize the SchurEliminator.
+void SchwarzPreconditioner::InitEliminator(
+    const CompressedRowBlockStructure& bs) {
+  if (options_.schur_structure_cache != NULL) {
+    eliminator_ =
+        options_.schur_structure_cache
+        ->FindOrCreate(bs, options_.elimination_groups[0])
+        ->Eliminator(bs, options_.num_threads);
+    return;
+  }
+
+  LinearSolver::Options eliminator_options;
+  eliminator_options.elimination_groups = options_.elimination_groups;
+  eliminator_options.num_threads = options_.num_threads;
+
+  DetectStructure(bs, options_.elimination_groups[0],
+                  &eliminator_options.row_block_size,
+                  &eliminator_options.e_block_size,
+                  &eliminator_options.f_block_size);
+
+  owned_eliminator_.reset(SchurEliminatorBase::Create(eliminator_options));
+  owned_eliminator_->Init(options_.elimination_groups[0], &bs);
+  eliminator_ = owned_eliminator_.get();
+}
+
+// Update the values of the preconditioner matrix and factorize the
+// subdomain matrices.
+bool SchwarzPreconditioner::Update(const BlockSparseMatrixBase& A,
+                                   const double* D) {
+  const time_t start_time = time(NULL);
+
+  // We need a dummy rhs vector and a dummy b vector since the Schur
+  // eliminator combines the computation of the reduced camera matrix
+  // with the computation of the right hand side of that linear
+  // system.
+  Vector rhs = Vector::Zero(m_->num_rows());
+  Vector b = Vector::Zero(A.num_rows());
+
+  // Compute a subset of the entries of the Schur complement.
+  eliminator_->Eliminate(&A, b.data(), D, m_.get(), rhs.data());
+
+  const int num_subdomains = subdomains_.size();
+  vector<int> factorization_succeeded(num_subdomains, 0);
+#pragma omp parallel for num_threads(options_.num_threads) schedule(dynamic)
+  for (int i = 0; i < num_subdomains; ++i) {
+    factorization_succeeded[i] = FactorizeSubdomain(&subdomains_[i]) ? 1 : 0;
+  }
+
+  VLOG(2) << "Compute time: " << time(NULL) - start_time;
+  for (int i = 0; i < num_subdomains; ++i) {
+    if (!factorization_succeeded[i]) {
+      LOG(WARNING) << "Cholesky factorization of subdomain " << i
+                   << " failed.";
+      return false;
+    }
+  }
+  return true;
+}
+
+// Copy the cells of the subdomain out of the preconditioner matrix
+// into a dense matrix and factorize it.
+bool SchwarzPreconditioner::FactorizeSubdomain(Subdomain* subdomain) {
+  const vector<int>& blocks = subdomain->blocks;
+  const vector<int>& block_layout = subdomain->block_layout;
+  Matrix& factor = subdomain->factor;
+  factor.resize(subdomain->num_rows, subdomain->num_rows);
+  factor.setZero();
+
+  for (int j = 0; j < blocks.size(); ++j) {
+    const int row_block_size = block_size_[blocks[j]];
+    for (int k = j; k < blocks.size(); ++k) {
+      const int col_block_size = block_size_[blocks[k]];
+      int r, c, row_stride, col_stride;
+      CellInfo* cell_info = CHECK_NOTNULL(
+          m_->GetCell(blocks[j], blocks[k], &r, &c, &row_stride, &col_stride));
+      MatrixRef cell(cell_info->values, row_stride, col_stride);
+      factor.block(block_layout[j], block_layout[k],
+                   row_block_size, col_block_size) =
+          cell.block(r, c, row_block_size, col_block_size);
+    }
+  }
+
+  DenseCholeskyOptions cholesky_options;
+  cholesky_options.block_layout = block_layout;
+  return BlockedCholeskyFactorize(cholesky_options,
+                                  subdomain->num_rows,
+                                  factor.data());
+}
+
+void SchwarzPreconditioner::RightMultiply(const double* x, double* y) const {
+  CHECK_NOTNULL(x);
+  CHECK_NOTNULL(y);
+
+  // Solve the subdomain systems independently.
+  const int num_subdomains = subdomains_.size();
+#pragma omp parallel for num_threads(options_.num_threads) schedule(dynamic)
+  for (int i = 0; i < num_subdomains; ++i) {
+    const Subdomain& subdomain = subdomains_[i];
+    Vector& z = subdomain_solutions_[i];
+    for (int j = 0; j < subdomain.blocks.size(); ++j) {
+      const int block = subdomain.blocks[j];
+      z.segment(subdomain.block_layout[j], block_size_[block]) =
+          ConstVectorRef(x + block_position_[block], block_size_[block]);
+    }
+    SolveUsingCholeskyFactor(subdomain.factor.data(),
+                             subdomain.num_rows,
+                             z.data());
+  }
+
+  // Sum the subdomain solutions.
+  const int num_blocks = block_size_.size();
+#pragma omp parallel for num_threads(options_.num_threads)
+  for (int i = 0; i < num_blocks; ++i) {
+    VectorRef y_block(y + block_position_[i], block_size_[i]);
+    y_block.setZero();
+    const vector<pair<int, int> >& occurrences = block_occurrences_[i];
+    for (int j = 0; j < occurrences.size(); ++j) {
+      y_block += subdomain_solutions_[occurrences[j].first].segment(
+          occurrences[j].second, block_size_[i]);
+    }
+  }
+}
+
+int SchwarzPreconditioner::num_rows() const {
+  return m_->num_rows();
+}
+
+}  // namespace internal
+}  // namespace ceres
@@ -0,0 +1,144 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Additive Schwarz preconditioner for the Schur complement.
+//
+// The cameras (f_blocks) are divided into overlapping subdomains
+// Omega_1, ..., Omega_k, and the preconditioner is
+//
+//   M^-1 = sum_i R_i' S_i^-1 R_i
+//
+// where R_i restricts a vector to the cameras in Omega_i, and S_i =
+// R_i S R_i' is the corresponding principal submatrix of the Schur
+// complement S. Since every S_i is a principal submatrix of a
+// positive definite matrix, M^-1 is symmetric positive definite and
+// can be used with the conjugate gradients solver.
+//
+// The subdomains are the clusters computed by the canonical views
+// clustering of the Schur complement graph (see visibility.h), each
+// extended by one layer of strongly connected cameras from the
+// neighbouring clusters. The overlap lets information propagate
+// between subdomains in a single application of the preconditioner.
+//
+// The subdomain matrices are factorized independently, and applied
+// independently in RightMultiply, so both parallelize over the
+// subdomains.
+
+#ifndef CERES_INTERNAL_SCHWARZ_PRECONDITIONER_H_
+#define CERES_INTERNAL_SCHWARZ_PRECONDITIONER_H_
+
+#include <utility>
+#include <vector>
+#include "ceres/internal/eigen.h"
+#include "ceres/internal/macros.h"
+#include "ceres/internal/scoped_ptr.h"
+#include "ceres/preconditioner.h"
+
+namespace ceres {
+namespace internal {
+
+class BlockRandomAccessSparseMatrix;
+class BlockSparseMatrixBase;
+struct CompressedRowBlockStructure;
+class SchurEliminatorBase;
+
+class SchwarzPreconditioner : public Preconditioner {
+ public:
+  // Initialize the symbolic structure of the preconditioner. bs is
+  // the block structure of the linear system to be solved. It is used
+  // to determine the subdomains and the sparsity structure of the
+  // preconditioner matrix.
+  //
+  // It has the same structural requirement as other Schur complement
+  // based solvers. Please see schur_eliminator.h for more details.
+  SchwarzPreconditioner(const CompressedRowBlockStructure& bs,
+                        const Preconditioner::Options& options);
+  virtual ~SchwarzPreconditioner();
+
+  // Preconditioner interface.
+  virtual bool Update(const BlockSparseMatrixBase& A, const double* D);
+  virtual void RightMultiply(const double* x, double* y) const;
+  virtual int num_rows() const;
+
+  int num_subdomains() const { return subdomains_.size(); }
+
+  // The f_blocks in the i^th subdomain, in increasing order.
+  const vector<int>& subdomain_blocks(int i) const {
+    return subdomains_[i].blocks;
+  }
+
+ private:
+  struct Subdomain {
+    Subdomain() : num_rows(0) {}
+
+    // Ids of the f_blocks in the subdomain, and their offsets in the
+    // subdomain matrix.
+    vector<int> blocks;
+    vector<int> block_layout;
+    int num_rows;
+
+    // Cholesky factor of the subdomain matrix.
+    Matrix factor;
+  };
+
+  void ComputeSubdomains(const CompressedRowBlockStructure& bs);
+  void InitEliminator(const CompressedRowBlockStructure& bs);
+  bool FactorizeSubdomain(Subdomain* subdomain);
+
+  Preconditioner::Options options_;
+
+  // Sizes and offsets of the f_blocks in the reduced linear system.
+  vector<int> block_size_;
+  vector<int> block_position_;
+
+  vector<Subdomain> subdomains_;
+
+  // For each f_block, the list of (subdomain, offset) pairs
+  // identifying where it occurs in the subdomain matrices. Used to
+  // sum the subdomain solutions without synchronization.
+  vector<vector<pair<int, int> > > block_occurrences_;
+
+  // If options_.schur_structure_cache is not NULL, the eliminator is
+  // shared with other users of the cache, otherwise it is owned by
+  // this object.
+  scoped_ptr<SchurEliminatorBase> owned_eliminator_;
+  SchurEliminatorBase* eliminator_;
+
+  // The blocks of the Schur complement needed by the subdomains.
+  scoped_ptr<BlockRandomAccessSparseMatrix> m_;
+
+  // Scratch space for the solutions of the subdomain systems.
+  mutable vector<Vector> subdomain_solutions_;
+
+  CERES_DISALLOW_COPY_AND_ASSIGN(SchwarzPreconditioner);
+};
+
+}  // namespace internal
+}  // namespace ceres
+
+#endif  // CERES_INTERNAL_SCHWARZ_PRECONDITIONER_H_
@@ -0,0 +1,234 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "ceres/schwarz_preconditioner.h"
+
+#include <set>
+#include <vector>
+#include "Eigen/Dense"
+#include "ceres/block_random_access_dense_matrix.h"
+#include "ceres/block_sparse_matrix.h"
+#include "ceres/block_structure.h"
+#include "ceres/casts.h"
+#include "ceres/internal/eigen.h"
+#include "ceres/internal/scoped_ptr.h"
+#include "ceres/linear_least_squares_problems.h"
+#include "ceres/linear_solver.h"
+#include "ceres/schur_eliminator.h"
+#include "ceres/types.h"
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+namespace ceres {
+namespace internal {
+
+// A bundle adjustment like problem with num_cameras cameras with 6
+// parameters each, and 3 dimensional points. The point p is observed
+// by the cameras p, p + 1 and p + 5 (modulo num_cameras), so the
+// cameras form a ring with some longer range connections.
+LinearLeastSquaresProblem* CreateRingProblem(const int num_cameras) {
+  const int kCameraSize = 6;
+  const int kPointSize = 3;
+  const int kResidualSize = 2;
+  const int kCameraOffsets[] = {0, 1, 5};
+  const int num_points = 2 * num_cameras;
+
+  CompressedRowBlockStructure* bs = new CompressedRowBlockStructure;
+  int position = 0;
+  for (int i = 0; i < num_points; ++i) {
+    bs->cols.push_back(Block());
+    bs->cols.back().size = kPointSize;
+    bs->cols.back().position = position;
+    position += kPointSize;
+  }
+  for (int i = 0; i < num_cameras; ++i) {
+    bs->cols.push_back(Block());
+    bs->cols.back().size = kCameraSize;
+    bs->cols.back().position = position;
+    position += kCameraSize;
+  }
+
+  int row_position = 0;
+  int value_position = 0;
+  for (int p = 0; p < num_points; ++p) {
+    for (int j = 0; j < 3; ++j) {
+      const int camera = (p / 2 + kCameraOffsets[j]) % num_cameras;
+      bs->rows.push_back(CompressedRow());
+      CompressedRow& row = bs->rows.back();
+      row.block.size = kResidualSize;
+      row.block.position = row_position;
+      row_position += kResidualSize;
+      row.cells.push_back(Cell(p, value_position));
+      value_position += kResidualSize * kPointSize;
+      row.cells.push_back(Cell(num_points + camera, value_position));
+      value_position += kResidualSize * kCameraSize;
+    }
+  }
+
+  LinearLeastSquaresProblem* problem = new LinearLeastSquaresProblem;
+  BlockSparseMatrix* A = new BlockSparseMatrix(bs);
+  srand(5);
+  VectorRef(A->mutable_values(), A->num_nonzeros()).setRandom();
+  problem->A.reset(A);
+  problem->D.reset(new double[A->num_cols()]);
+  VectorRef(problem->D.get(), A->num_cols()).setConstant(0.1);
+  problem->num_eliminate_blocks = num_points;
+  return problem;
+}
+
+class SchwarzPreconditionerTest : public ::testing::Test {
+ protected:
+  void SetUpFromProblem(LinearLeastSquaresProblem* problem) {
+    A_.reset(down_cast<BlockSparseMatrix*>(problem->A.release()));
+    D_.reset(problem->D.release());
+    num_eliminate_blocks_ = problem->num_eliminate_blocks;
+    const CompressedRowBlockStructure* bs = A_->block_structure();
+
+    options_.elimination_groups.push_back(num_eliminate_blocks_);
+    options_.elimination_groups.push_back(
+        bs->cols.size() - num_eliminate_blocks_);
+
+    // Compute the full Schur complement.
+    vector<int> blocks;
+    for (int i = num_eliminate_blocks_; i < bs->cols.size(); ++i) {
+      blocks.push_back(bs->cols[i].size);
+    }
+    BlockRandomAccessDenseMatrix lhs(blocks);
+    Vector rhs(lhs.num_rows());
+    Vector b = Vector::Zero(A_->num_rows());
+    LinearSolver::Options eliminator_options;
+    eliminator_options.elimination_groups = options_.elimination_groups;
+    scoped_ptr<SchurEliminatorBase> eliminator(
+        SchurEliminatorBase::Create(eliminator_options));
+    eliminator->Init(num_eliminate_blocks_, bs);
+    eliminator->Eliminate(A_.get(), b.data(), D_.get(), &lhs, rhs.data());
+    schur_complement_ =
+        ConstMatrixRef(lhs.values(), lhs.num_rows(), lhs.num_rows())
+        .selfadjointView<Eigen::Upper>();
+
+    block_position_.push_back(0);
+    for (int i = 0; i < blocks.size(); ++i) {
+      block_position_.push_back(block_position_.back() + blocks[i]);
+    }
+  }
+
+  // Apply the preconditioner to the columns of the identity matrix.
+  Matrix PreconditionerMatrix(const SchwarzPreconditioner& preconditioner) {
+    const int num_rows = preconditioner.num_rows();
+    Matrix m(num_rows, num_rows);
+    Vector x(num_rows);
+    Vector y(num_rows);
+    for (int i = 0; i < num_rows; ++i) {
+      x.setZero();
+      x[i] = 1.0;
+      preconditioner.RightMultiply(x.data(), y.data());
+      m.col(i) = y;
+    }
+    return m;
+  }
+
+  // sum_i R_i' S_i^-1 R_i computed from the full Schur complement.
+  Matrix ExpectedPreconditionerMatrix(
+      const SchwarzPreconditioner& preconditioner) {
+    const int num_rows = schur_complement_.rows();
+    Matrix expected = Matrix::Zero(num_rows, num_rows);
+    for (int i = 0; i < preconditioner.num_subdomains(); ++i) {
+      const vector<int>& blocks = preconditioner.subdomain_blocks(i);
+      vector<int> rows;
+      for (int j = 0; j < blocks.size(); ++j) {
+        for (int r = block_position_[blocks[j]];
+             r < block_position_[blocks[j] + 1];
+             ++r) {
+          rows.push_back(r);
+        }
+      }
+
+      Matrix s(rows.size(), rows.size());
+      for (int j = 0; j < rows.size(); ++j) {
+        for (int k = 0; k < rows.size(); ++k) {
+          s(j, k) = schur_complement_(rows[j], rows[k]);
+        }
+      }
+      const Matrix s_inverse = s.inverse();
+      for (int j = 0; j < rows.size(); ++j) {
+        for (int k = 0; k < rows.size(); ++k) {
+          expected(rows[j], rows[k]) += s_inverse(j, k);
+        }
+      }
+    }
+    return expected;
+  }
+
+  void TestPreconditioner(LinearLeastSquaresProblem* problem,
+                          int num_threads) {
+    SetUpFromProblem(problem);
+    options_.type = ADDITIVE_SCHWARZ;
+    options_.num_threads = num_threads;
+    SchwarzPreconditioner preconditioner(*A_->block_structure(), options_);
+
+    // Every camera belongs to a subdomain.
+    set<int> covered_blocks;
+    for (int i = 0; i < preconditioner.num_subdomains(); ++i) {
+      const vector<int>& blocks = preconditioner.subdomain_blocks(i);
+      covered_blocks.insert(blocks.begin(), blocks.end());
+    }
+    EXPECT_EQ(covered_blocks.size(), block_position_.size() - 1);
+
+    ASSERT_TRUE(preconditioner.Update(*A_, D_.get()));
+    const Matrix actual = PreconditionerMatrix(preconditioner);
+    const Matrix expected = ExpectedPreconditionerMatrix(preconditioner);
+    EXPECT_LT((actual - expected).norm(), 1e-10 * expected.norm());
+    EXPECT_LT((actual - actual.transpose()).norm(), 1e-10 * actual.norm());
+  }
+
+  int num_eliminate_blocks_;
+  scoped_ptr<BlockSparseMatrix> A_;
+  scoped_array<double> D_;
+  Matrix schur_complement_;
+  vector<int> block_position_;
+  Preconditioner::Options options_;
+};
+
+TEST_F(SchwarzPreconditionerTest, SmallProblem) {
+  scoped_ptr<LinearLeastSquaresProblem> problem(
+      CHECK_NOTNULL(CreateLinearLeastSquaresProblemFromId(2)));
+  TestPreconditioner(problem.get(), 1);
+}
+
+TEST_F(SchwarzPreconditionerTest, RingProblem) {
+  scoped_ptr<LinearLeastSquaresProblem> problem(CreateRingProblem(40));
+  TestPreconditioner(problem.get(), 1);
+}
+
+TEST_F(SchwarzPreconditionerTest, Multithreaded) {
+  scoped_ptr<LinearLeastSquaresProblem> problem(CreateRingProblem(40));
+  TestPreconditioner(problem.get(), 4);
+}
+
+}  // namespace internal
+}  // namespace ceres
@@ -30,46 +30,47 @@
 
 #include "ceres/scratch_evaluate_preparer.h"
 
-#include "ceres/parameter_block.h"
+#include "ceres/evaluation_plan.h"
 #include "ceres/program.h"
-#include "ceres/residual_block.h"
 
 namespace ceres {
 namespace internal {
 
 ScratchEvaluatePreparer* ScratchEvaluatePreparer::Create(
     const Program &program,
+    const EvaluationPlan* plan,
     int num_threads) {
   ScratchEvaluatePreparer* preparers = new ScratchEvaluatePreparer[num_threads];
   int max_derivatives_per_residual_block =
       program.MaxDerivativesPerResidualBlock();
   for (int i = 0; i < num_threads; i++) {
-    preparers[i].Init(max_derivatives_per_residual_block);
+    preparers[i].Init(plan, max_derivatives_per_residual_block);
   }
   return preparers;
 }
 
-void ScratchEvaluatePreparer::Init(int max_derivatives_per_residual_block) {
+void ScratchEvaluatePreparer::Init(const EvaluationPlan* plan,
+                                   int max_derivatives_per_residual_block) {
+  plan_ = plan;
   jacobian_scratch_.reset(
       new double[max_derivatives_per_residual_block]);
 }
 
 // Point the jacobian blocks into the scratch area of this evaluate preparer.
-void ScratchEvaluatePreparer::Prepare(const ResidualBlock* residual_block,
-                                      int /* residual_block_index */,
+void ScratchEvaluatePreparer::Prepare(int residual_block_index,
                                       SparseMatrix* /* jacobian */,
                                       double** jacobians) {
   double* jacobian_block_cursor = jacobian_scratch_.get();
-  int num_residuals = residual_block->NumResiduals();
-  int num_parameter_blocks = residual_block->NumParameterBlocks();
-  for (int j = 0; j < num_parameter_blocks; ++j) {
-    const ParameterBlock* parameter_block =
-        residual_block->parameter_blocks()[j];
-    if (parameter_block->IsConstant()) {
+  const EvaluationPlan::ResidualBlockEntry& entry =
+      plan_->residual_block(residual_block_index);
+  const EvaluationPlan::Argument* arguments =
+      plan_->arguments(residual_block_index);
+  for (int j = 0; j < entry.num_arguments; ++j) {
+    if (arguments[j].delta_offset < 0) {
       jacobians[j] = NULL;
     } else {
       jacobians[j] = jacobian_block_cursor;
-      jacobian_block_cursor += num_residuals * parameter_block->LocalSize();
+      jacobian_block_cursor += entry.num_residuals * arguments[j].local_size;
     }
   }
 }
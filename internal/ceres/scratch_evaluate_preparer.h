@@ -40,24 +40,27 @@
 namespace ceres {
 namespace internal {
 
+class EvaluationPlan;
 class Program;
-class ResidualBlock;
 class SparseMatrix;
 
 class ScratchEvaluatePreparer {
  public:
   // Create num_threads ScratchEvaluatePreparers.
   static ScratchEvaluatePreparer* Create(const Program &program,
+                                         const EvaluationPlan* plan,
                                          int num_threads);
 
   // EvaluatePreparer interface
-  void Init(int max_derivatives_per_residual_block);
-  void Prepare(const ResidualBlock* residual_block,
-               int residual_block_index,
+  void Init(const EvaluationPlan* plan,
+            int max_derivatives_per_residual_block);
+  void Prepare(int residual_block_index,
                SparseMatrix* jacobian,
                double** jacobians);
 
  private:
+  const EvaluationPlan* plan_;
+
   // Scratch space for the jacobians; each jacobian is packed one after another.
   // There is enough scratch to hold all the jacobians for the largest residual.
   scoped_array<double> jacobian_scratch_;
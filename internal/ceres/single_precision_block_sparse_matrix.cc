@@ -0,0 +1,124 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "ceres/single_precision_block_sparse_matrix.h"
+
+#include <vector>
+#include "ceres/blas.h"
+#include "ceres/block_sparse_matrix.h"
+#include "ceres/block_structure.h"
+#include "ceres/internal/eigen.h"
+#include "glog/logging.h"
+
+namespace ceres {
+namespace internal {
+
+SinglePrecisionBlockSparseMatrix::SinglePrecisionBlockSparseMatrix(
+    const BlockSparseMatrixBase& matrix)
+    : block_structure_(CHECK_NOTNULL(matrix.block_structure())),
+      num_rows_(matrix.num_rows()),
+      num_cols_(matrix.num_cols()),
+      num_nonzeros_(matrix.num_nonzeros()) {
+  VLOG(2) << "Allocating single precision values array with "
+          << num_nonzeros_ * sizeof(float) << " bytes.";  // NOLINT
+  values_.reset(new float[num_nonzeros_]);
+}
+
+SinglePrecisionBlockSparseMatrix::~SinglePrecisionBlockSparseMatrix() {
+}
+
+void SinglePrecisionBlockSparseMatrix::UpdateValues(
+    const BlockSparseMatrixBase& matrix,
+    int num_threads) {
+  CHECK_EQ(matrix.num_rows(), num_rows_);
+  CHECK_EQ(matrix.num_cols(), num_cols_);
+  CHECK_EQ(matrix.num_nonzeros(), num_nonzeros_);
+
+  const CompressedRowBlockStructure* bs = block_structure_;
+  const int num_row_blocks = bs->rows.size();
+#pragma omp parallel for num_threads(num_threads) schedule(static)
+  for (int r = 0; r < num_row_blocks; ++r) {
+    const double* row_values = matrix.RowBlockValues(r);
+    const int row_block_size = bs->rows[r].block.size;
+    const vector<Cell>& cells = bs->rows[r].cells;
+    for (int c = 0; c < cells.size(); ++c) {
+      const int cell_size = row_block_size * bs->cols[cells[c].block_id].size;
+      Eigen::Map<Eigen::VectorXf>(values_.get() + cells[c].position,
+                                  cell_size) =
+          ConstVectorRef(row_values + cells[c].position, cell_size)
+          .cast<float>();
+    }
+  }
+}
+
+void SinglePrecisionBlockSparseMatrix::RightMultiply(const double* x,
+                                                     double* y) const {
+  CHECK_NOTNULL(x);
+  CHECK_NOTNULL(y);
+
+  const CompressedRowBlockStructure* bs = block_structure_;
+  for (int i = 0; i < bs->rows.size(); ++i) {
+    const int row_block_pos = bs->rows[i].block.position;
+    const int row_block_size = bs->rows[i].block.size;
+    const vector<Cell>& cells = bs->rows[i].cells;
+    for (int j = 0; j < cells.size(); ++j) {
+      const int col_block_id = cells[j].block_id;
+      const int col_block_size = bs->cols[col_block_id].size;
+      const int col_block_pos = bs->cols[col_block_id].position;
+      MatrixVectorMultiply<Eigen::Dynamic, Eigen::Dynamic, 1>(
+          values_.get() + cells[j].position, row_block_size, col_block_size,
+          x + col_block_pos,
+          y + row_block_pos);
+    }
+  }
+}
+
+void SinglePrecisionBlockSparseMatrix::LeftMultiply(const double* x,
+                                                    double* y) const {
+  CHECK_NOTNULL(x);
+  CHECK_NOTNULL(y);
+
+  const CompressedRowBlockStructure* bs = block_structure_;
+  for (int i = 0; i < bs->rows.size(); ++i) {
+    const int row_block_pos = bs->rows[i].block.position;
+    const int row_block_size = bs->rows[i].block.size;
+    const vector<Cell>& cells = bs->rows[i].cells;
+    for (int j = 0; j < cells.size(); ++j) {
+      const int col_block_id = cells[j].block_id;
+      const int col_block_size = bs->cols[col_block_id].size;
+      const int col_block_pos = bs->cols[col_block_id].position;
+      MatrixTransposeVectorMultiply<Eigen::Dynamic, Eigen::Dynamic, 1>(
+          values_.get() + cells[j].position, row_block_size, col_block_size,
+          x + row_block_pos,
+          y + col_block_pos);
+    }
+  }
+}
+
+}  // namespace internal
+}  // namespace ceres
@@ -0,0 +1,97 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// A single precision copy of the values of a block sparse matrix.
+
+#ifndef CERES_INTERNAL_SINGLE_PRECISION_BLOCK_SPARSE_MATRIX_H_
+#define CERES_INTERNAL_SINGLE_PRECISION_BLOCK_SPARSE_MATRIX_H_
+
+#include "ceres/linear_operator.h"
+#include "ceres/internal/macros.h"
+#include "ceres/internal/scoped_ptr.h"
+
+namespace ceres {
+namespace internal {
+
+class BlockSparseMatrixBase;
+struct CompressedRowBlockStructure;
+
+// The iterative linear solvers spend most of their time in products
+// of the Jacobian with vectors, whose cost is dominated by reading
+// the values of the Jacobian from memory. Storing a copy of the
+// values in single precision halves this traffic.
+//
+// This class holds such a copy of a BlockSparseMatrixBase. It shares
+// the block structure of the matrix it was constructed with, and the
+// value of the cell (row_block, cell_block) is stored at offset
+//
+//   block_structure()->rows[row_block].cells[cell_block].position
+//
+// of values(), as in BlockSparseMatrix. The products with vectors are
+// accumulated in double precision, so the only loss of accuracy is
+// the rounding of the values of the matrix.
+class SinglePrecisionBlockSparseMatrix : public LinearOperator {
+ public:
+  // The block structure of matrix is not copied and must outlive this
+  // object. The values are not copied either, call UpdateValues to do
+  // so.
+  explicit SinglePrecisionBlockSparseMatrix(
+      const BlockSparseMatrixBase& matrix);
+  virtual ~SinglePrecisionBlockSparseMatrix();
+
+  // Copy the values of matrix, which must have the same block
+  // structure as the one this object was constructed with, rounding
+  // them to single precision.
+  void UpdateValues(const BlockSparseMatrixBase& matrix, int num_threads);
+
+  // LinearOperator interface.
+  virtual void RightMultiply(const double* x, double* y) const;
+  virtual void LeftMultiply(const double* x, double* y) const;
+  virtual int num_rows() const { return num_rows_; }
+  virtual int num_cols() const { return num_cols_; }
+
+  int num_nonzeros() const { return num_nonzeros_; }
+  const float* values() const { return values_.get(); }
+  const CompressedRowBlockStructure* block_structure() const {
+    return block_structure_;
+  }
+
+ private:
+  const CompressedRowBlockStructure* block_structure_;
+  int num_rows_;
+  int num_cols_;
+  int num_nonzeros_;
+  scoped_array<float> values_;
+
+  CERES_DISALLOW_COPY_AND_ASSIGN(SinglePrecisionBlockSparseMatrix);
+};
+
+}  // namespace internal
+}  // namespace ceres
+
+#endif  // CERES_INTERNAL_SINGLE_PRECISION_BLOCK_SPARSE_MATRIX_H_
@@ -0,0 +1,113 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2013 Google Inc. All rights reserved.
+// http://code.google.com/p/ceres-solver/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "ceres/single_precision_block_sparse_matrix.h"
+
+#include <cmath>
+#include "ceres/block_sparse_matrix.h"
+#include "ceres/casts.h"
+#include "ceres/internal/eigen.h"
+#include "ceres/internal/scoped_ptr.h"
+#include "ceres/linear_least_squares_problems.h"
+#include "ceres/random.h"
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+namespace ceres {
+namespace internal {
+
+class SinglePrecisionBlockSparseMatrixTest : public ::testing::Test {
+ protected :
+  virtual void SetUp() {
+    scoped_ptr<LinearLeastSquaresProblem> problem(
+        CreateLinearLeastSquaresProblemFromId(2));
+    CHECK_NOTNULL(problem.get());
+    A_.reset(down_cast<BlockSparseMatrix*>(problem->A.release()));
+  }
+
+  // Expect the products of A_ and its single precision copy with
+  // random vectors to agree up to tolerance.
+  void ExpectProductsAreNear(const SinglePrecisionBlockSparseMatrix& B,
+                             double tolerance) {
+    srand(5);
+    Vector x(A_->num_cols());
+    for (int i = 0; i < x.rows(); ++i) {
+      x(i) = RandDouble();
+    }
+    Vector y_a = Vector::Zero(A_->num_rows());
+    Vector y_b = Vector::Zero(A_->num_rows());
+    A_->RightMultiply(x.data(), y_a.data());
+    B.RightMultiply(x.data(), y_b.data());
+    EXPECT_LE((y_a - y_b).norm(), tolerance * y_a.norm());
+
+    Vector z(A_->num_rows());
+    for (int i = 0; i < z.rows(); ++i) {
+      z(i) = RandDouble();
+    }
+    Vector w_a = Vector::Zero(A_->num_cols());
+    Vector w_b = Vector::Zero(A_->num_cols());
+    A_->LeftMultiply(z.data(), w_a.data());
+    B.LeftMultiply(z.data(), w_b.data());
+    EXPECT_LE((w_a - w_b).norm(), tolerance * w_a.norm());
+  }
+
+  scoped_ptr<BlockSparseMatrix> A_;
+};
+
+TEST_F(SinglePrecisionBlockSparseMatrixTest, Dimensions) {
+  SinglePrecisionBlockSparseMatrix B(*A_);
+  EXPECT_EQ(B.num_rows(), A_->num_rows());
+  EXPECT_EQ(B.num_cols(), A_->num_cols());
+  EXPECT_EQ(B.num_nonzeros(), A_->num_nonzeros());
+  EXPECT_EQ(B.block_structure(), A_->block_structure());
+}
+
+TEST_F(SinglePrecisionBlockSparseMatrixTest, ValuesAreRounded) {
+  VectorRef(A_->mutable_values(), A_->num_nonzeros()) /= 3.0;
+  SinglePrecisionBlockSparseMatrix B(*A_);
+  B.UpdateValues(*A_, 1);
+  for (int i = 0; i < A_->num_nonzeros(); ++i) {
+    EXPECT_EQ(B.values()[i], static_cast<float>(A_->values()[i]));
+  }
+}
+
+TEST_F(SinglePrecisionBlockSparseMatrixTest, Products) {
+  SinglePrecisionBlockSparseMatrix B(*A_);
+  B.UpdateValues(*A_, 1);
+  // The entries of the test matrix are small integers, which are
+  // exactly representable in single precision.
+  ExpectProductsAreNear(B, 1e-15);
+
+  // Change the values of A_ and update the copy.
+  VectorRef(A_->mutable_values(), A_->num_nonzeros()) *= M_PI;
+  B.UpdateValues(*A_, 2);
+  ExpectProductsAreNear(B, 1e-6);
+}
+
+}  // namespace internal
+}  // namespace ceres
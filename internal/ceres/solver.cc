@@ -367,6 +367,10 @@ string Solver::Summary::FullReport() const {
                   SolverTerminationTypeToString(termination_type));
   }
 
+  if (!gradient_check_report.empty()) {
+    StringAppendF(&report, "\nGradient check:\n%s",
+                  gradient_check_report.c_str());
+  }
   return report;
 };
 
@@ -31,6 +31,7 @@
 #include "ceres/solver_impl.h"
 
 #include <cstdio>
+#include <cstring>
 #include <iostream>  // NOLINT
 #include <numeric>
 #include "ceres/coordinate_descent_minimizer.h"
@@ -59,22 +60,74 @@ namespace {
 
 // Callback for updating the user's parameter blocks. Updates are only
 // done if the step is successful.
+//
+// If all the user's callbacks declare the parameter blocks they
+// observe, only those parameter blocks are updated.
 class StateUpdatingCallback : public IterationCallback {
  public:
-  StateUpdatingCallback(Program* program, double* parameters)
-      : program_(program), parameters_(parameters) {}
+  StateUpdatingCallback(Program* program,
+                        double* parameters,
+                        const vector<IterationCallback*>& callbacks,
+                        int num_threads)
+      : parameters_(parameters),
+        num_threads_(num_threads) {
+    set<double*> observed_parameter_blocks;
+    bool all_callbacks_declare_observed_parameter_blocks = !callbacks.empty();
+    for (int i = 0; i < callbacks.size(); ++i) {
+      vector<double*> parameter_blocks;
+      if (!callbacks[i]->ObservedParameterBlocks(&parameter_blocks)) {
+        all_callbacks_declare_observed_parameter_blocks = false;
+        break;
+      }
+      observed_parameter_blocks.insert(parameter_blocks.begin(),
+                                       parameter_blocks.end());
+    }
+
+    // The parameter blocks are stored contiguously in parameters in
+    // the order of the program. Constant parameter blocks are never
+    // changed by the minimizer.
+    const vector<ParameterBlock*>& parameter_blocks =
+        program->parameter_blocks();
+    int offset = 0;
+    for (int i = 0; i < parameter_blocks.size(); ++i) {
+      ParameterBlock* parameter_block = parameter_blocks[i];
+      if (!parameter_block->IsConstant() &&
+          (!all_callbacks_declare_observed_parameter_blocks ||
+           observed_parameter_blocks.count(
+               parameter_block->mutable_user_state()) > 0)) {
+        parameter_blocks_.push_back(parameter_block);
+        offsets_.push_back(offset);
+      }
+      offset += parameter_block->Size();
+    }
+
+    VLOG(2) << "Updating " << parameter_blocks_.size() << " of "
+            << parameter_blocks.size()
+            << " parameter blocks every iteration.";
+  }
 
   CallbackReturnType operator()(const IterationSummary& summary) {
     if (summary.step_is_successful) {
-      program_->StateVectorToParameterBlocks(parameters_);
-      program_->CopyParameterBlockStateToUserState();
+      const int num_parameter_blocks = parameter_blocks_.size();
+#pragma omp parallel for num_threads(num_threads_) schedule(static)
+      for (int i = 0; i < num_parameter_blocks; ++i) {
+        ParameterBlock* parameter_block = parameter_blocks_[i];
+        memcpy(parameter_block->mutable_user_state(),
+               parameters_ + offsets_[i],
+               sizeof(*parameters_) * parameter_block->Size());
+      }
     }
     return SOLVER_CONTINUE;
   }
 
  private:
-  Program* program_;
   double* parameters_;
+  const int num_threads_;
+
+  // The parameter blocks updated every iteration, and their offsets
+  // in parameters_.
+  vector<ParameterBlock*> parameter_blocks_;
+  vector<int> offsets_;
 };
 
 void SetSummaryFinalCost(Solver::Summary* summary) {
@@ -233,12 +286,16 @@ void SolverImpl::TrustRegionMinimize(
                                        &logging_callback);
   }
 
-  StateUpdatingCallback updating_callback(program, parameters);
+  scoped_ptr<StateUpdatingCallback> updating_callback;
   if (options.update_state_every_iteration) {
+    updating_callback.reset(new StateUpdatingCallback(program,
+                                                      parameters,
+                                                      options.callbacks,
+                                                      options.num_threads));
     // This must get pushed to the front of the callbacks so that it is run
     // before any of the user callbacks.
     minimizer_options.callbacks.insert(minimizer_options.callbacks.begin(),
-                                       &updating_callback);
+                                       updating_callback.get());
   }
 
   minimizer_options.evaluator = evaluator;
@@ -257,6 +314,13 @@ void SolverImpl::TrustRegionMinimize(
   trust_region_strategy_options.trust_region_strategy_type =
       options.trust_region_strategy_type;
   trust_region_strategy_options.dogleg_type = options.dogleg_type;
+  if (IsSchurType(options.linear_solver_type) &&
+      options.linear_solver_ordering != NULL &&
+      options.linear_solver_ordering->NumGroups() > 0) {
+    trust_region_strategy_options.num_eliminate_blocks =
+        options.linear_solver_ordering->group_to_elements().begin()
+        ->second.size();
+  }
   scoped_ptr<TrustRegionStrategy> strategy(
       TrustRegionStrategy::Create(trust_region_strategy_options));
   minimizer_options.trust_region_strategy = strategy.get();
@@ -293,12 +357,16 @@ void SolverImpl::LineSearchMinimize(
                                        &logging_callback);
   }
 
-  StateUpdatingCallback updating_callback(program, parameters);
+  scoped_ptr<StateUpdatingCallback> updating_callback;
   if (options.update_state_every_iteration) {
+    updating_callback.reset(new StateUpdatingCallback(program,
+                                                      parameters,
+                                                      options.callbacks,
+                                                      options.num_threads));
     // This must get pushed to the front of the callbacks so that it is run
     // before any of the user callbacks.
     minimizer_options.callbacks.insert(minimizer_options.callbacks.begin(),
-                                       &updating_callback);
+                                       updating_callback.get());
   }
 
   minimizer_options.evaluator = evaluator;
@@ -388,11 +456,6 @@ void SolverImpl::TrustRegionSolve(const Solver::Options& original_options,
   summary->num_threads_given = original_options.num_threads;
   summary->num_threads_used = options.num_threads;
 
-  if (options.lsqp_iterations_to_dump.size() > 0) {
-    LOG(WARNING) << "Dumping linear least squares problems to disk is"
-        " currently broken. Ignoring Solver::Options::lsqp_iterations_to_dump";
-  }
-
   event_logger.AddEvent("Init");
 
   original_program->SetParameterBlockStatePtrsToUserStatePtrs();
@@ -403,7 +466,20 @@ void SolverImpl::TrustRegionSolve(const Solver::Options& original_options,
   // GradientCheckingCostFunction and replacing problem_impl with
   // gradient_checking_problem_impl.
   scoped_ptr<ProblemImpl> gradient_checking_problem_impl;
-  if (options.check_gradients) {
+  if (options.check_gradients &&
+      options.gradient_check_num_samples_per_type > 0) {
+    VLOG(1) << "Checking gradients of a sample of the residual blocks";
+    if (!CheckGradientsOfSampledResidualBlocks(
+            *original_program,
+            options.gradient_check_num_samples_per_type,
+            options.numeric_derivative_relative_step_size,
+            options.gradient_check_relative_precision,
+            options.num_threads,
+            &summary->gradient_check_report)) {
+      LOG(WARNING) << "Gradient check failed.\n"
+                   << summary->gradient_check_report;
+    }
+  } else if (options.check_gradients) {
     VLOG(1) << "Checking Gradients";
     gradient_checking_problem_impl.reset(
         CreateGradientCheckingProblemImpl(
@@ -484,7 +560,10 @@ void SolverImpl::TrustRegionSolve(const Solver::Options& original_options,
   }
 
   scoped_ptr<LinearSolver>
-      linear_solver(CreateLinearSolver(&options, &summary->error));
+      linear_solver(CreateLinearSolver(
+          &options,
+          original_problem_impl->mutable_schur_structure_cache(),
+          &summary->error));
   event_logger.AddEvent("CreateLinearSolver");
   if (linear_solver == NULL) {
     return;
@@ -512,6 +591,7 @@ void SolverImpl::TrustRegionSolve(const Solver::Options& original_options,
         ->group_to_elements().begin()
         ->second.size();
     if (!LexicographicallyOrderResidualBlocks(num_eliminate_blocks,
+                                              options.num_threads,
                                               reduced_program.get(),
                                               &summary->error)) {
       return;
@@ -698,7 +778,20 @@ void SolverImpl::LineSearchSolve(const Solver::Options& original_options,
   // GradientCheckingCostFunction and replacing problem_impl with
   // gradient_checking_problem_impl.
   scoped_ptr<ProblemImpl> gradient_checking_problem_impl;
-  if (options.check_gradients) {
+  if (options.check_gradients &&
+      options.gradient_check_num_samples_per_type > 0) {
+    VLOG(1) << "Checking gradients of a sample of the residual blocks";
+    if (!CheckGradientsOfSampledResidualBlocks(
+            *original_program,
+            options.gradient_check_num_samples_per_type,
+            options.numeric_derivative_relative_step_size,
+            options.gradient_check_relative_precision,
+            options.num_threads,
+            &summary->gradient_check_report)) {
+      LOG(WARNING) << "Gradient check failed.\n"
+                   << summary->gradient_check_report;
+    }
+  } else if (options.check_gradients) {
     VLOG(1) << "Checking Gradients";
     gradient_checking_problem_impl.reset(
         CreateGradientCheckingProblemImpl(
@@ -1010,6 +1103,7 @@ Program* SolverImpl::CreateReducedProgram(Solver::Options* options,
   if (original_num_groups == 1 && IsSchurType(options->linear_solver_type)) {
     vector<ParameterBlock*> schur_ordering;
     const int num_eliminate_blocks = ComputeSchurOrdering(*transformed_program,
+                                                          options->num_threads,
                                                           &schur_ordering);
     CHECK_EQ(schur_ordering.size(), transformed_program->NumParameterBlocks())
         << "Congratulations, you found a Ceres bug! Please report this error "
@@ -1025,6 +1119,7 @@ Program* SolverImpl::CreateReducedProgram(Solver::Options* options,
 
   if (!ApplyUserOrdering(problem_impl->parameter_map(),
                          linear_solver_ordering,
+                         options->num_threads,
                          transformed_program.get(),
                          error)) {
     return NULL;
@@ -1080,8 +1175,10 @@ Program* SolverImpl::CreateReducedProgram(Solver::Options* options,
   return transformed_program.release();
 }
 
-LinearSolver* SolverImpl::CreateLinearSolver(Solver::Options* options,
-                                             string* error) {
+LinearSolver* SolverImpl::CreateLinearSolver(
+    Solver::Options* options,
+    SchurStructureCache* schur_structure_cache,
+    string* error) {
   CHECK_NOTNULL(options);
   CHECK_NOTNULL(options->linear_solver_ordering);
   CHECK_NOTNULL(error);
@@ -1163,6 +1260,17 @@ LinearSolver* SolverImpl::CreateLinearSolver(Solver::Options* options,
   options->num_linear_solver_threads = linear_solver_options.num_threads;
 
   linear_solver_options.use_block_amd = options->use_block_amd;
+  linear_solver_options.use_nested_dissection_ordering =
+      options->use_nested_dissection_ordering;
+  linear_solver_options.use_mixed_precision_solves =
+      options->use_mixed_precision_solves;
+  linear_solver_options.max_num_refinement_iterations =
+      options->max_num_refinement_iterations;
+  linear_solver_options.max_schur_products_memory_in_mb =
+      options->max_schur_products_memory_in_mb;
+  linear_solver_options.use_single_precision_jacobian =
+      options->use_single_precision_jacobian;
+  linear_solver_options.schur_structure_cache = schur_structure_cache;
   const map<int, set<double*> >& groups =
       options->linear_solver_ordering->group_to_elements();
   for (map<int, set<double*> >::const_iterator it = groups.begin();
@@ -1185,6 +1293,7 @@ LinearSolver* SolverImpl::CreateLinearSolver(Solver::Options* options,
 bool SolverImpl::ApplyUserOrdering(
     const ProblemImpl::ParameterMap& parameter_map,
     const ParameterBlockOrdering* ordering,
+    const int num_threads,
     Program* program,
     string* error) {
   if (ordering->NumElements() != program->NumParameterBlocks()) {
@@ -1196,30 +1305,41 @@ bool SolverImpl::ApplyUserOrdering(
     return false;
   }
 
-  vector<ParameterBlock*>* parameter_blocks =
-      program->mutable_parameter_blocks();
-  parameter_blocks->clear();
-
+  // Flatten the ordering, so that the parameter blocks can be looked
+  // up in parallel.
+  vector<double*> parameter_block_ptrs;
+  parameter_block_ptrs.reserve(ordering->NumElements());
   const map<int, set<double*> >& groups =
       ordering->group_to_elements();
-
   for (map<int, set<double*> >::const_iterator group_it = groups.begin();
        group_it != groups.end();
        ++group_it) {
     const set<double*>& group = group_it->second;
-    for (set<double*>::const_iterator parameter_block_ptr_it = group.begin();
-         parameter_block_ptr_it != group.end();
-         ++parameter_block_ptr_it) {
-      ProblemImpl::ParameterMap::const_iterator parameter_block_it =
-          parameter_map.find(*parameter_block_ptr_it);
-      if (parameter_block_it == parameter_map.end()) {
-        *error = StringPrintf("User specified ordering contains a pointer "
-                              "to a double that is not a parameter block in "
-                              "the problem. The invalid double is in group: %d",
-                              group_it->first);
-        return false;
-      }
-      parameter_blocks->push_back(parameter_block_it->second);
+    parameter_block_ptrs.insert(parameter_block_ptrs.end(),
+                                group.begin(),
+                                group.end());
+  }
+
+  vector<ParameterBlock*>* parameter_blocks =
+      program->mutable_parameter_blocks();
+  const int num_parameter_blocks = parameter_block_ptrs.size();
+  parameter_blocks->resize(num_parameter_blocks);
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic, 1024)
+  for (int i = 0; i < num_parameter_blocks; ++i) {
+    ProblemImpl::ParameterMap::const_iterator parameter_block_it =
+        parameter_map.find(parameter_block_ptrs[i]);
+    (*parameter_blocks)[i] = (parameter_block_it == parameter_map.end())
+        ? NULL
+        : parameter_block_it->second;
+  }
+
+  for (int i = 0; i < num_parameter_blocks; ++i) {
+    if ((*parameter_blocks)[i] == NULL) {
+      *error = StringPrintf("User specified ordering contains a pointer "
+                            "to a double that is not a parameter block in "
+                            "the problem. The invalid double is in group: %d",
+                            ordering->GroupId(parameter_block_ptrs[i]));
+      return false;
     }
   }
   return true;
@@ -1249,26 +1369,51 @@ static int MinParameterBlock(const ResidualBlock* residual_block,
 // Schur eliminator, which works on these "row blocks" in the jacobian.
 bool SolverImpl::LexicographicallyOrderResidualBlocks(
     const int num_eliminate_blocks,
+    const int num_threads,
     Program* program,
     string* error) {
   CHECK_GE(num_eliminate_blocks, 1)
       << "Congratulations, you found a Ceres bug! Please report this error "
       << "to the developers.";
 
-  // Create a histogram of the number of residuals for each E block. There is an
-  // extra bucket at the end to catch all non-eliminated F blocks.
-  vector<int> residual_blocks_per_e_block(num_eliminate_blocks + 1);
   vector<ResidualBlock*>* residual_blocks = program->mutable_residual_blocks();
-  vector<int> min_position_per_residual(residual_blocks->size());
-  for (int i = 0; i < residual_blocks->size(); ++i) {
-    ResidualBlock* residual_block = (*residual_blocks)[i];
-    int position = MinParameterBlock(residual_block, num_eliminate_blocks);
-    min_position_per_residual[i] = position;
+  const int num_residual_blocks = residual_blocks->size();
+  vector<int> min_position_per_residual(num_residual_blocks);
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic, 1024)
+  for (int i = 0; i < num_residual_blocks; ++i) {
+    const int position = MinParameterBlock((*residual_blocks)[i],
+                                           num_eliminate_blocks);
     DCHECK_LE(position, num_eliminate_blocks);
-    residual_blocks_per_e_block[position]++;
+    min_position_per_residual[i] = position;
+  }
+
+  // The residual blocks are split into contiguous chunks, one per
+  // thread, and each chunk gets its own histogram of the number of
+  // residuals for each E block. There is an extra bucket at the end
+  // to catch all non-eliminated F blocks.
+  const int num_chunks = max(1, min(num_threads, num_residual_blocks));
+  const int chunk_size = (num_residual_blocks + num_chunks - 1) / num_chunks;
+  vector<vector<int> > chunk_histograms(num_chunks);
+#pragma omp parallel for num_threads(num_threads) schedule(static, 1)
+  for (int c = 0; c < num_chunks; ++c) {
+    vector<int>& histogram = chunk_histograms[c];
+    histogram.resize(num_eliminate_blocks + 1, 0);
+    const int chunk_end = min(num_residual_blocks, (c + 1) * chunk_size);
+    for (int i = c * chunk_size; i < chunk_end; ++i) {
+      histogram[min_position_per_residual[i]]++;
+    }
+  }
+
+  // Create a histogram of the number of residuals for each E block.
+  vector<int> residual_blocks_per_e_block(num_eliminate_blocks + 1, 0);
+  for (int c = 0; c < num_chunks; ++c) {
+    const vector<int>& histogram = chunk_histograms[c];
+    for (int i = 0; i <= num_eliminate_blocks; ++i) {
+      residual_blocks_per_e_block[i] += histogram[i];
+    }
   }
 
-  // Run a cumulative sum on the histogram, to obtain offsets to the start of
+  // Run a cumulative sum on the histogram, to obtain offsets to the end of
   // each histogram bucket (where each bucket is for the residuals for that
   // E-block).
   vector<int> offsets(num_eliminate_blocks + 1);
@@ -1289,29 +1434,49 @@ bool SolverImpl::LexicographicallyOrderResidualBlocks(
   // Each bucket is individually filled from the back of the bucket to the front
   // of the bucket. The filling order among the buckets is dictated by the
   // residual blocks. This loop uses the offsets as counters; subtracting one
-  // from each offset as a residual block is placed in the bucket. When the
-  // filling is finished, the offset pointerts should have shifted down one
-  // entry (this is verified below).
+  // from each offset as a residual block is placed in the bucket.
+  //
+  // Each chunk fills its own part of each bucket. The first chunk
+  // fills the back of the bucket, so the order of the residual blocks
+  // is the same as when the bucket is filled serially. Convert the
+  // chunk histograms into the offsets where each chunk starts filling
+  // each bucket.
+  for (int i = 0; i <= num_eliminate_blocks; ++i) {
+    int offset = offsets[i];
+    for (int c = 0; c < num_chunks; ++c) {
+      const int count = chunk_histograms[c][i];
+      chunk_histograms[c][i] = offset;
+      offset -= count;
+    }
+  }
+
   vector<ResidualBlock*> reordered_residual_blocks(
       (*residual_blocks).size(), static_cast<ResidualBlock*>(NULL));
-  for (int i = 0; i < residual_blocks->size(); ++i) {
-    int bucket = min_position_per_residual[i];
-
-    // Decrement the cursor, which should now point at the next empty position.
-    offsets[bucket]--;
-
-    // Sanity.
-    CHECK(reordered_residual_blocks[offsets[bucket]] == NULL)
-        << "Congratulations, you found a Ceres bug! Please report this error "
-        << "to the developers.";
-
-    reordered_residual_blocks[offsets[bucket]] = (*residual_blocks)[i];
+#pragma omp parallel for num_threads(num_threads) schedule(static, 1)
+  for (int c = 0; c < num_chunks; ++c) {
+    vector<int>& chunk_offsets = chunk_histograms[c];
+    const int chunk_end = min(num_residual_blocks, (c + 1) * chunk_size);
+    for (int i = c * chunk_size; i < chunk_end; ++i) {
+      int bucket = min_position_per_residual[i];
+
+      // Decrement the cursor, which should now point at the next empty
+      // position.
+      chunk_offsets[bucket]--;
+
+      // Sanity.
+      CHECK(reordered_residual_blocks[chunk_offsets[bucket]] == NULL)
+          << "Congratulations, you found a Ceres bug! Please report this "
+          << "error to the developers.";
+
+      reordered_residual_blocks[chunk_offsets[bucket]] = (*residual_blocks)[i];
+    }
   }
 
-  // Sanity check #1: The difference in bucket offsets should match the
-  // histogram sizes.
+  // Sanity check #1: When the filling is finished, the offsets of the
+  // last chunk should point at the start of each bucket.
   for (int i = 0; i < num_eliminate_blocks; ++i) {
-    CHECK_EQ(residual_blocks_per_e_block[i], offsets[i + 1] - offsets[i])
+    CHECK_EQ(chunk_histograms.back()[i],
+             offsets[i] - residual_blocks_per_e_block[i])
         << "Congratulations, you found a Ceres bug! Please report this error "
         << "to the developers.";
   }
@@ -1362,6 +1527,7 @@ CoordinateDescentMinimizer* SolverImpl::CreateInnerIterationMinimizer(
     // points.
     inner_iteration_ordering.reset(new ParameterBlockOrdering);
     ComputeRecursiveIndependentSetOrdering(program,
+                                           options.num_threads,
                                            inner_iteration_ordering.get());
     inner_iteration_ordering->Reverse();
     ordering_ptr = inner_iteration_ordering.get();
@@ -46,6 +46,7 @@ class CoordinateDescentMinimizer;
 class Evaluator;
 class LinearSolver;
 class Program;
+class SchurStructureCache;
 
 class SolverImpl {
  public:
@@ -99,14 +100,22 @@ class SolverImpl {
   // selected linear solver, which may be different from what the user
   // selected; consider the case that the remaining elimininated
   // blocks is zero after removing fixed blocks.
-  static LinearSolver* CreateLinearSolver(Solver::Options* options,
-                                          string* error);
+  //
+  // schur_structure_cache, if not NULL, is handed to the linear
+  // solver so that Schur type solvers can reuse symbolic state
+  // across calls to Solve.
+  static LinearSolver* CreateLinearSolver(
+      Solver::Options* options,
+      SchurStructureCache* schur_structure_cache,
+      string* error);
 
   // Reorder the parameter blocks in program using the ordering. A
   // return value of true indicates success and false indicates an
-  // error was encountered whose cause is logged to LOG(ERROR).
+  // error was encountered whose cause is logged to LOG(ERROR). The
+  // parameter blocks are looked up using num_threads threads.
   static bool ApplyUserOrdering(const ProblemImpl::ParameterMap& parameter_map,
                                 const ParameterBlockOrdering* ordering,
+                                int num_threads,
                                 Program* program,
                                 string* error);
 
@@ -114,9 +123,12 @@ class SolverImpl {
   // Reorder the residuals for program, if necessary, so that the
   // residuals involving e block (i.e., the first num_eliminate_block
   // parameter blocks) occur together. This is a necessary condition
-  // for the Schur eliminator.
+  // for the Schur eliminator. The bucket sort is done using
+  // num_threads threads; the resulting order does not depend on
+  // num_threads.
   static bool LexicographicallyOrderResidualBlocks(
       const int num_eliminate_blocks,
+      int num_threads,
       Program* program,
       string* error);
 
@@ -309,6 +309,7 @@ TEST(SolverImpl, ReorderResidualBlockNormalFunction) {
   string error;
   EXPECT_TRUE(SolverImpl::LexicographicallyOrderResidualBlocks(
                   2,
+                  1,
                   problem.mutable_program(),
                   &error));
   EXPECT_EQ(residual_blocks.size(), expected_residual_blocks.size());
@@ -317,6 +318,43 @@ TEST(SolverImpl, ReorderResidualBlockNormalFunction) {
   }
 }
 
+TEST(SolverImpl, ReorderResidualBlockMultiThreaded) {
+  const int kNumParameterBlocks = 20;
+  const int kNumEliminateBlocks = 10;
+  const int kNumResidualBlocks = 101;
+  ProblemImpl problem;
+  double x[kNumParameterBlocks];
+  for (int i = 0; i < kNumParameterBlocks; ++i) {
+    problem.AddParameterBlock(x + i, 1);
+  }
+  for (int i = 0; i < kNumResidualBlocks; ++i) {
+    problem.AddResidualBlock(new BinaryCostFunction(),
+                             NULL,
+                             x + (i * 7) % kNumParameterBlocks,
+                             x + (i * 7 + 3) % kNumParameterBlocks);
+  }
+  problem.mutable_program()->SetParameterOffsetsAndIndex();
+
+  // The order of the residual blocks does not depend on the number
+  // of threads.
+  Program expected_program(problem.program());
+  string error;
+  EXPECT_TRUE(SolverImpl::LexicographicallyOrderResidualBlocks(
+                  kNumEliminateBlocks,
+                  1,
+                  &expected_program,
+                  &error));
+  for (int num_threads = 2; num_threads <= 8; num_threads *= 2) {
+    Program program(problem.program());
+    EXPECT_TRUE(SolverImpl::LexicographicallyOrderResidualBlocks(
+                    kNumEliminateBlocks,
+                    num_threads,
+                    &program,
+                    &error));
+    EXPECT_EQ(program.residual_blocks(), expected_program.residual_blocks());
+  }
+}
+
 TEST(SolverImpl, ReorderResidualBlockNormalFunctionWithFixedBlocks) {
   ProblemImpl problem;
   double x;
@@ -380,6 +418,7 @@ TEST(SolverImpl, ReorderResidualBlockNormalFunctionWithFixedBlocks) {
 
   EXPECT_TRUE(SolverImpl::LexicographicallyOrderResidualBlocks(
                   2,
+                  1,
                   reduced_program.get(),
                   &error));
 
@@ -466,6 +505,7 @@ TEST(SolverImpl, ApplyUserOrderingOrderingTooSmall) {
   string error;
   EXPECT_FALSE(SolverImpl::ApplyUserOrdering(problem.parameter_map(),
                                              &ordering,
+                                             1,
                                              &program,
                                              &error));
 }
@@ -490,6 +530,7 @@ TEST(SolverImpl, ApplyUserOrderingNormal) {
 
   EXPECT_TRUE(SolverImpl::ApplyUserOrdering(problem.parameter_map(),
                                             &ordering,
+                                            4,
                                             program,
                                             &error));
   const vector<ParameterBlock*>& parameter_blocks = program->parameter_blocks();
@@ -507,7 +548,7 @@ TEST(SolverImpl, CreateLinearSolverNoSuiteSparse) {
   // CreateLinearSolver assumes a non-empty ordering.
   options.linear_solver_ordering = new ParameterBlockOrdering;
   string error;
-  EXPECT_FALSE(SolverImpl::CreateLinearSolver(&options, &error));
+  EXPECT_FALSE(SolverImpl::CreateLinearSolver(&options, NULL, &error));
 }
 #endif
 
@@ -518,7 +559,7 @@ TEST(SolverImpl, CreateLinearSolverNegativeMaxNumIterations) {
   // CreateLinearSolver assumes a non-empty ordering.
   options.linear_solver_ordering = new ParameterBlockOrdering;
   string error;
-  EXPECT_EQ(SolverImpl::CreateLinearSolver(&options, &error),
+  EXPECT_EQ(SolverImpl::CreateLinearSolver(&options, NULL, &error),
             static_cast<LinearSolver*>(NULL));
 }
 
@@ -529,7 +570,7 @@ TEST(SolverImpl, CreateLinearSolverNegativeMinNumIterations) {
   // CreateLinearSolver assumes a non-empty ordering.
   options.linear_solver_ordering = new ParameterBlockOrdering;
   string error;
-  EXPECT_EQ(SolverImpl::CreateLinearSolver(&options, &error),
+  EXPECT_EQ(SolverImpl::CreateLinearSolver(&options, NULL, &error),
             static_cast<LinearSolver*>(NULL));
 }
 
@@ -540,7 +581,7 @@ TEST(SolverImpl, CreateLinearSolverMaxLessThanMinIterations) {
   options.linear_solver_max_num_iterations = 5;
   options.linear_solver_ordering = new ParameterBlockOrdering;
   string error;
-  EXPECT_EQ(SolverImpl::CreateLinearSolver(&options, &error),
+  EXPECT_EQ(SolverImpl::CreateLinearSolver(&options, NULL, &error),
             static_cast<LinearSolver*>(NULL));
 }
 
@@ -558,7 +599,7 @@ TEST(SolverImpl, CreateLinearSolverDenseSchurMultipleThreads) {
 
   string error;
   scoped_ptr<LinearSolver> solver(
-      SolverImpl::CreateLinearSolver(&options, &error));
+      SolverImpl::CreateLinearSolver(&options, NULL, &error));
   EXPECT_TRUE(solver != NULL);
   EXPECT_EQ(options.linear_solver_type, DENSE_SCHUR);
   EXPECT_EQ(options.num_linear_solver_threads, 2);
@@ -571,11 +612,11 @@ TEST(SolverImpl, CreateIterativeLinearSolverForDogleg) {
   options.linear_solver_ordering = new ParameterBlockOrdering;
   string error;
   options.linear_solver_type = ITERATIVE_SCHUR;
-  EXPECT_EQ(SolverImpl::CreateLinearSolver(&options, &error),
+  EXPECT_EQ(SolverImpl::CreateLinearSolver(&options, NULL, &error),
             static_cast<LinearSolver*>(NULL));
 
   options.linear_solver_type = CGNR;
-  EXPECT_EQ(SolverImpl::CreateLinearSolver(&options, &error),
+  EXPECT_EQ(SolverImpl::CreateLinearSolver(&options, NULL, &error),
             static_cast<LinearSolver*>(NULL));
 }
 
@@ -586,19 +627,19 @@ TEST(SolverImpl, CreateLinearSolverNormalOperation) {
   // CreateLinearSolver assumes a non-empty ordering.
   options.linear_solver_ordering = new ParameterBlockOrdering;
   string error;
-  solver.reset(SolverImpl::CreateLinearSolver(&options, &error));
+  solver.reset(SolverImpl::CreateLinearSolver(&options, NULL, &error));
   EXPECT_EQ(options.linear_solver_type, DENSE_QR);
   EXPECT_TRUE(solver.get() != NULL);
 
   options.linear_solver_type = DENSE_NORMAL_CHOLESKY;
-  solver.reset(SolverImpl::CreateLinearSolver(&options, &error));
+  solver.reset(SolverImpl::CreateLinearSolver(&options, NULL, &error));
   EXPECT_EQ(options.linear_solver_type, DENSE_NORMAL_CHOLESKY);
   EXPECT_TRUE(solver.get() != NULL);
 
 #ifndef CERES_NO_SUITESPARSE
   options.linear_solver_type = SPARSE_NORMAL_CHOLESKY;
   options.sparse_linear_algebra_library = SUITE_SPARSE;
-  solver.reset(SolverImpl::CreateLinearSolver(&options, &error));
+  solver.reset(SolverImpl::CreateLinearSolver(&options, NULL, &error));
   EXPECT_EQ(options.linear_solver_type, SPARSE_NORMAL_CHOLESKY);
   EXPECT_TRUE(solver.get() != NULL);
 #endif
@@ -606,7 +647,7 @@ TEST(SolverImpl, CreateLinearSolverNormalOperation) {
 #ifndef CERES_NO_CXSPARSE
   options.linear_solver_type = SPARSE_NORMAL_CHOLESKY;
   options.sparse_linear_algebra_library = CX_SPARSE;
-  solver.reset(SolverImpl::CreateLinearSolver(&options, &error));
+  solver.reset(SolverImpl::CreateLinearSolver(&options, NULL, &error));
   EXPECT_EQ(options.linear_solver_type, SPARSE_NORMAL_CHOLESKY);
   EXPECT_TRUE(solver.get() != NULL);
 #endif
@@ -617,22 +658,22 @@ TEST(SolverImpl, CreateLinearSolverNormalOperation) {
   options.linear_solver_ordering->AddElementToGroup(&y, 0);
 
   options.linear_solver_type = DENSE_SCHUR;
-  solver.reset(SolverImpl::CreateLinearSolver(&options, &error));
+  solver.reset(SolverImpl::CreateLinearSolver(&options, NULL, &error));
   EXPECT_EQ(options.linear_solver_type, DENSE_SCHUR);
   EXPECT_TRUE(solver.get() != NULL);
 
   options.linear_solver_type = SPARSE_SCHUR;
-  solver.reset(SolverImpl::CreateLinearSolver(&options, &error));
+  solver.reset(SolverImpl::CreateLinearSolver(&options, NULL, &error));
 
 #if defined(CERES_NO_SUITESPARSE) && defined(CERES_NO_CXSPARSE)
-  EXPECT_TRUE(SolverImpl::CreateLinearSolver(&options, &error) == NULL);
+  EXPECT_TRUE(SolverImpl::CreateLinearSolver(&options, NULL, &error) == NULL);
 #else
   EXPECT_TRUE(solver.get() != NULL);
   EXPECT_EQ(options.linear_solver_type, SPARSE_SCHUR);
 #endif
 
   options.linear_solver_type = ITERATIVE_SCHUR;
-  solver.reset(SolverImpl::CreateLinearSolver(&options, &error));
+  solver.reset(SolverImpl::CreateLinearSolver(&options, NULL, &error));
   EXPECT_EQ(options.linear_solver_type, ITERATIVE_SCHUR);
   EXPECT_TRUE(solver.get() != NULL);
 }
@@ -701,6 +742,70 @@ TEST(SolverImpl, UpdateStateEveryIterationOption) {
   EXPECT_NE(original_x, callback.x_values[1]);
 }
 
+// Remembers the values of two parameter blocks, but declares that it
+// only observes the first one.
+struct ObservingCallback : public IterationCallback {
+  ObservingCallback(double* x, double* y) : x(x), y(y) {}
+  virtual ~ObservingCallback() {}
+  virtual CallbackReturnType operator()(const IterationSummary& summary) {
+    x_values.push_back(*x);
+    y_values.push_back(*y);
+    return SOLVER_CONTINUE;
+  }
+  virtual bool ObservedParameterBlocks(
+      vector<double*>* parameter_blocks) const {
+    parameter_blocks->push_back(x);
+    return true;
+  }
+  double* x;
+  double* y;
+  vector<double> x_values;
+  vector<double> y_values;
+};
+
+TEST(SolverImpl, UpdateStateEveryIterationOnlyUpdatesObservedBlocks) {
+  double x = 50.0;
+  double y = 50.0;
+
+  Problem::Options problem_options;
+  ProblemImpl problem(problem_options);
+  problem.AddResidualBlock(
+      new AutoDiffCostFunction<QuadraticCostFunction, 1, 1>(
+          new QuadraticCostFunction), NULL, &x);
+  problem.AddResidualBlock(
+      new AutoDiffCostFunction<QuadraticCostFunction, 1, 1>(
+          new QuadraticCostFunction), NULL, &y);
+
+  Solver::Options options;
+  options.linear_solver_type = DENSE_QR;
+  options.update_state_every_iteration = true;
+  options.num_threads = 2;
+  ObservingCallback observing_callback(&x, &y);
+  options.callbacks.push_back(&observing_callback);
+
+  Solver::Summary summary;
+  SolverImpl::Solve(options, &problem, &summary);
+  ASSERT_GT(observing_callback.x_values.size(), 1);
+  EXPECT_NE(50.0, observing_callback.x_values[1]);
+  for (int i = 0; i < observing_callback.y_values.size(); ++i) {
+    EXPECT_EQ(50.0, observing_callback.y_values[i]);
+  }
+
+  // All parameter blocks are updated at the end of the solve.
+  EXPECT_NEAR(5.0, x, 1e-6);
+  EXPECT_NEAR(5.0, y, 1e-6);
+
+  // A callback which does not declare the parameter blocks it
+  // observes forces all of them to be updated.
+  x = 50.0;
+  y = 50.0;
+  RememberingCallback remembering_callback(&y);
+  options.callbacks.push_back(&remembering_callback);
+  SolverImpl::Solve(options, &problem, &summary);
+  ASSERT_GT(remembering_callback.x_values.size(), 1);
+  EXPECT_NE(50.0, remembering_callback.x_values[1]);
+}
+
 // The parameters must be in separate blocks so that they can be individually
 // set constant or not.
 struct Quadratic4DCostFunction {
@@ -96,6 +96,12 @@ class SparseMatrix : public LinearOperator {
   // sparse matrix.
   virtual void ToTextFile(FILE* file) const = 0;
 
+  // Write out the matrix in the binary format described in
+  // lsqp_binary_file.h, i.e., a chunk describing the sparsity
+  // structure of the matrix followed by the chunks containing its
+  // values.
+  virtual void ToBinaryFile(FILE* file) const = 0;
+
   // Accessors for the values array that stores the entries of the
   // sparse matrix. The exact interpreptation of the values of this
   // array depends on the particular kind of SparseMatrix being
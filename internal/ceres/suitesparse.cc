@@ -33,17 +33,26 @@
 
 #include <vector>
 #include "cholmod.h"
+#include "ceres/compressed_column_scatter.h"
 #include "ceres/compressed_row_sparse_matrix.h"
 #include "ceres/triplet_sparse_matrix.h"
 
 namespace ceres {
 namespace internal {
 
-SuiteSparse::SuiteSparse() {
+SuiteSparse::SuiteSparse()
+    : solve_workspace_y_(NULL),
+      solve_workspace_e_(NULL) {
   cholmod_start(&cc_);
 }
 
 SuiteSparse::~SuiteSparse() {
+  if (solve_workspace_y_ != NULL) {
+    Free(solve_workspace_y_);
+  }
+  if (solve_workspace_e_ != NULL) {
+    Free(solve_workspace_e_);
+  }
   cholmod_finish(&cc_);
 }
 
@@ -108,6 +117,29 @@ cholmod_sparse* SuiteSparse::CreateSparseMatrixTransposeView(
   return m;
 }
 
+cholmod_sparse SuiteSparse::CreateSparseMatrixView(
+    CompressedColumnScatter* A) {
+  cholmod_sparse m;
+  m.nrow = A->num_rows();
+  m.ncol = A->num_cols();
+  m.nzmax = A->num_nonzeros();
+
+  m.p = reinterpret_cast<void*>(A->mutable_col_starts());
+  m.i = reinterpret_cast<void*>(A->mutable_rows());
+  m.x = reinterpret_cast<void*>(A->mutable_values());
+  m.nz = NULL;
+  m.z = NULL;
+
+  m.stype = 0;  // Matrix is not symmetric.
+  m.itype = CHOLMOD_INT;
+  m.xtype = CHOLMOD_REAL;
+  m.dtype = CHOLMOD_DOUBLE;
+  m.sorted = 1;
+  m.packed = 1;
+
+  return m;
+}
+
 cholmod_dense* SuiteSparse::CreateDenseVector(const double* x,
                                               int in_size,
                                               int out_size) {
@@ -366,6 +398,27 @@ cholmod_dense* SuiteSparse::Solve(cholmod_factor* L,
   return cholmod_solve(CHOLMOD_A, L, b, &cc_);
 }
 
+bool SuiteSparse::Solve(cholmod_factor* L,
+                        cholmod_dense* b,
+                        cholmod_dense** x) {
+  CHECK_NOTNULL(x);
+  if (cc_.status != CHOLMOD_OK) {
+    LOG(WARNING) << "CHOLMOD status NOT OK";
+    return false;
+  }
+
+#if CHOLMOD_VERSION >= CHOLMOD_VER_CODE(2, 0)
+  return cholmod_solve2(CHOLMOD_A, L, b, NULL, x, NULL,
+                        &solve_workspace_y_, &solve_workspace_e_, &cc_);
+#else
+  if (*x != NULL) {
+    Free(*x);
+  }
+  *x = cholmod_solve(CHOLMOD_A, L, b, &cc_);
+  return (*x != NULL);
+#endif
+}
+
 cholmod_dense* SuiteSparse::SolveCholesky(cholmod_sparse* A,
                                           cholmod_factor* L,
                                           cholmod_dense* b) {
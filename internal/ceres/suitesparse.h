@@ -46,6 +46,7 @@
 namespace ceres {
 namespace internal {
 
+class CompressedColumnScatter;
 class CompressedRowSparseMatrix;
 class TripletSparseMatrix;
 
@@ -75,6 +76,12 @@ class SuiteSparse {
   // the case for objects returned by CreateSparseMatrixTranspose.
   cholmod_sparse* CreateSparseMatrixTransposeView(CompressedRowSparseMatrix* A);
 
+  // Create a cholmod_sparse wrapper around the contents of A. Like
+  // the transpose view above, this is a shallow object that refers to
+  // the contents of A, but since it is returned by value there is
+  // nothing to free.
+  cholmod_sparse CreateSparseMatrixView(CompressedColumnScatter* A);
+
   // Given a vector x, build a cholmod_dense vector of size out_size
   // with the first in_size entries copied from x. If x is NULL, then
   // an all zeros vector is returned. Caller owns the result.
@@ -146,6 +153,16 @@ class SuiteSparse {
   // NULL is returned. Caller owns the result.
   cholmod_dense* Solve(cholmod_factor* L, cholmod_dense* b);
 
+  // Same as above, except that the solution is returned in *x. If *x
+  // is not NULL and has the right size, its storage is reused,
+  // otherwise it is (re)allocated. Caller owns *x. Returns false if
+  // the solve fails.
+  //
+  // With CHOLMOD 2.0 or later, repeated calls with the same x do not
+  // allocate any memory, since CHOLMOD's workspace is kept in this
+  // object between calls.
+  bool Solve(cholmod_factor* L, cholmod_dense* b, cholmod_dense** x);
+
   // Combine the calls to Cholesky and Solve into a single call. If
   // the cholesky factorization or the solve fails, return
   // NULL. Caller owns the result.
@@ -223,6 +240,10 @@ class SuiteSparse {
 
  private:
   cholmod_common cc_;
+
+  // Workspace for cholmod_solve2.
+  cholmod_dense* solve_workspace_y_;
+  cholmod_dense* solve_workspace_e_;
 };
 
 }  // namespace internal
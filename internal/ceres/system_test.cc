@@ -510,6 +510,7 @@ TEST(SystemTest, BundleAdjustmentProblem) {
   CONFIGURE(CGNR,                   SUITE_SPARSE, kAutomaticOrdering, JACOBI);
   CONFIGURE(ITERATIVE_SCHUR,        SUITE_SPARSE, kUserOrdering,      JACOBI);
   CONFIGURE(ITERATIVE_SCHUR,        SUITE_SPARSE, kUserOrdering,      SCHUR_JACOBI);
+  CONFIGURE(ITERATIVE_SCHUR,        SUITE_SPARSE, kUserOrdering,      ADDITIVE_SCHWARZ);
 
 #ifndef CERES_NO_SUITESPARSE
 
@@ -519,6 +520,7 @@ TEST(SystemTest, BundleAdjustmentProblem) {
 
   CONFIGURE(ITERATIVE_SCHUR,        SUITE_SPARSE, kAutomaticOrdering, JACOBI);
   CONFIGURE(ITERATIVE_SCHUR,        SUITE_SPARSE, kAutomaticOrdering, SCHUR_JACOBI);
+  CONFIGURE(ITERATIVE_SCHUR,        SUITE_SPARSE, kAutomaticOrdering, ADDITIVE_SCHWARZ);
 
 #ifndef CERES_NO_SUITESPARSE
 
@@ -35,6 +35,7 @@
 #include "ceres/internal/eigen.h"
 #include "ceres/internal/port.h"
 #include "ceres/internal/scoped_ptr.h"
+#include "ceres/lsqp_binary_file.h"
 #include "ceres/matrix_proto.h"
 #include "ceres/types.h"
 #include "glog/logging.h"
@@ -303,5 +304,18 @@ void TripletSparseMatrix::ToTextFile(FILE* file) const {
   }
 }
 
+void TripletSparseMatrix::ToBinaryFile(FILE* file) const {
+  CHECK_NOTNULL(file);
+  const int64 num_ints = 3 + 2 * static_cast<int64>(num_nonzeros_);
+  WriteLsqpChunkHeader(file,
+                       LSQP_TRIPLET_SPARSE_MATRIX,
+                       num_ints * sizeof(int));
+  const int header[3] = { num_rows_, num_cols_, num_nonzeros_ };
+  WriteLsqpInts(file, header, 3);
+  WriteLsqpInts(file, rows_.get(), num_nonzeros_);
+  WriteLsqpInts(file, cols_.get(), num_nonzeros_);
+  WriteLsqpDoubleChunks(file, LSQP_A_VALUES, values_.get(), num_nonzeros_);
+}
+
 }  // namespace internal
 }  // namespace ceres
@@ -69,6 +69,7 @@ class TripletSparseMatrix : public SparseMatrix {
   virtual void ToProto(SparseMatrixProto *proto) const;
 #endif
   virtual void ToTextFile(FILE* file) const;
+  virtual void ToBinaryFile(FILE* file) const;
   virtual int num_rows()        const { return num_rows_;     }
   virtual int num_cols()        const { return num_cols_;     }
   virtual int num_nonzeros()    const { return num_nonzeros_; }
@@ -43,7 +43,6 @@
 #include "ceres/evaluator.h"
 #include "ceres/internal/eigen.h"
 #include "ceres/internal/scoped_ptr.h"
-#include "ceres/linear_least_squares_problems.h"
 #include "ceres/sparse_matrix.h"
 #include "ceres/stringprintf.h"
 #include "ceres/trust_region_strategy.h"
@@ -74,23 +73,6 @@ void TrustRegionMinimizer::Init(const Minimizer::Options& options) {
        options_.lsqp_iterations_to_dump.end());
 }
 
-bool TrustRegionMinimizer::MaybeDumpLinearLeastSquaresProblem(
-    const int iteration,
-    const SparseMatrix* jacobian,
-    const double* residuals,
-    const double* step) const  {
-  // TODO(sameeragarwal): Since the use of trust_region_radius has
-  // moved inside TrustRegionStrategy, its not clear how we dump the
-  // regularization vector/matrix anymore.
-  //
-  // Also num_eliminate_blocks is not visible to the trust region
-  // minimizer either.
-  //
-  // Both of these indicate that this is the wrong place for this
-  // code, and going forward this should needs fixing/refactoring.
-  return true;
-}
-
 void TrustRegionMinimizer::Minimize(const Minimizer::Options& options,
                                     double* parameters,
                                     Solver::Summary* summary) {
@@ -122,6 +104,19 @@ void TrustRegionMinimizer::Minimize(const Minimizer::Options& options,
   Vector model_residuals(num_residuals);
   Vector scale(num_effective_parameters);
 
+  // When speculative Jacobian evaluation is enabled, the residuals
+  // and the Jacobian at the candidate point x_plus_delta are
+  // evaluated along with its cost into these buffers, and swapped
+  // with residuals and jacobian if the step is accepted.
+  scoped_ptr<SparseMatrix> candidate_jacobian_storage;
+  SparseMatrix* candidate_jacobian = NULL;
+  Vector candidate_residuals;
+  if (options_.use_speculative_jacobian_evaluation) {
+    candidate_jacobian_storage.reset(evaluator->CreateJacobian());
+    candidate_jacobian = candidate_jacobian_storage.get();
+    candidate_residuals.resize(num_residuals);
+  }
+
   IterationSummary iteration_summary;
   iteration_summary.iteration = 0;
   iteration_summary.step_is_valid = false;
@@ -219,6 +214,13 @@ void TrustRegionMinimizer::Minimize(const Minimizer::Options& options,
     const double strategy_start_time = WallTimeInSeconds();
     TrustRegionStrategy::PerSolveOptions per_solve_options;
     per_solve_options.eta = options_.eta;
+    if (binary_search(options_.lsqp_iterations_to_dump.begin(),
+                      options_.lsqp_iterations_to_dump.end(),
+                      iteration_summary.iteration)) {
+      per_solve_options.dump_directory = options_.lsqp_dump_directory;
+      per_solve_options.dump_iteration = iteration_summary.iteration;
+      per_solve_options.dump_format_type = options_.lsqp_dump_format_type;
+    }
     TrustRegionStrategy::Summary strategy_summary =
         strategy->ComputeStep(per_solve_options,
                               jacobian,
@@ -230,14 +232,6 @@ void TrustRegionMinimizer::Minimize(const Minimizer::Options& options,
     iteration_summary.linear_solver_iterations =
         strategy_summary.num_iterations;
 
-    if (!MaybeDumpLinearLeastSquaresProblem(iteration_summary.iteration,
-                                            jacobian,
-                                            residuals.data(),
-                                            trust_region_step.data())) {
-      LOG(FATAL) << "Tried writing linear least squares problem: "
-                 << options.lsqp_dump_directory << "but failed.";
-    }
-
     double model_cost_change = 0.0;
     if (strategy_summary.termination_type != FAILURE) {
       // new_model_cost
@@ -261,6 +255,8 @@ void TrustRegionMinimizer::Minimize(const Minimizer::Options& options,
       }
     }
 
+    double new_cost = numeric_limits<double>::max();
+    bool candidate_is_evaluated = false;
     if (!iteration_summary.step_is_valid) {
       // Invalid steps can happen due to a number of reasons, and we
       // allow a limited number of successive failures, and return with
@@ -305,8 +301,20 @@ void TrustRegionMinimizer::Minimize(const Minimizer::Options& options,
       }
 
       // Try this step.
-      double new_cost = numeric_limits<double>::max();
-      if (!evaluator->Evaluate(x_plus_delta.data(),
+      if (candidate_jacobian != NULL) {
+        candidate_is_evaluated =
+            evaluator->Evaluate(x_plus_delta.data(),
+                                &new_cost,
+                                candidate_residuals.data(),
+                                NULL,
+                                candidate_jacobian);
+        if (!candidate_is_evaluated) {
+          VLOG(2) << "Speculative Jacobian evaluation failed.";
+        }
+      }
+
+      if (!candidate_is_evaluated &&
+          !evaluator->Evaluate(x_plus_delta.data(),
                                &new_cost,
                                NULL, NULL, NULL)) {
         // If the evaluation of the new cost fails, treat it as a step
@@ -330,6 +338,9 @@ void TrustRegionMinimizer::Minimize(const Minimizer::Options& options,
             new_cost = x_plus_delta_cost;
           } else {
             x_plus_delta = inner_iteration_x;
+            // The speculatively evaluated residuals and Jacobian
+            // are for the point before the inner iteration.
+            candidate_is_evaluated = false;
             // Boost the model_cost_change, since the inner iteration
             // improvements are not accounted for by the trust region.
             model_cost_change +=  x_plus_delta_cost - new_cost;
@@ -415,12 +426,17 @@ void TrustRegionMinimizer::Minimize(const Minimizer::Options& options,
       x_norm = x.norm();
 
       // Step looks good, evaluate the residuals and Jacobian at this
-      // point.
-      if (!evaluator->Evaluate(x.data(),
-                               &cost,
-                               residuals.data(),
-                               NULL,
-                               jacobian)) {
+      // point, unless they were already evaluated along with the
+      // cost, in which case the buffers are swapped.
+      if (candidate_is_evaluated) {
+        cost = new_cost;
+        residuals.swap(candidate_residuals);
+        std::swap(jacobian, candidate_jacobian);
+      } else if (!evaluator->Evaluate(x.data(),
+                                      &cost,
+                                      residuals.data(),
+                                      NULL,
+                                      jacobian)) {
         summary->termination_type = NUMERICAL_FAILURE;
         summary->error =
             "Terminating: Residual and Jacobian evaluation failed.";
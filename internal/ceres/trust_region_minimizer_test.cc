@@ -34,6 +34,8 @@
 // Program and Problem machinery.
 
 #include <cmath>
+#include <vector>
+#include "ceres/autodiff_cost_function.h"
 #include "ceres/cost_function.h"
 #include "ceres/dense_qr_solver.h"
 #include "ceres/dense_sparse_matrix.h"
@@ -281,6 +283,170 @@ TEST(TrustRegionMinimizer, PowellsSingularFunctionUsingDogleg) {
   IsTrustRegionSolveSuccessful<false, false, false, true >(kStrategy);
 }
 
+void SolvePowellsFunction(bool use_speculative_jacobian_evaluation,
+                          double* parameters,
+                          Solver::Summary* summary) {
+  Solver::Options solver_options;
+  solver_options.use_speculative_jacobian_evaluation =
+      use_speculative_jacobian_evaluation;
+  LinearSolver::Options linear_solver_options;
+  DenseQRSolver linear_solver(linear_solver_options);
+
+  PowellEvaluator2<true, true, true, true> powell_evaluator;
+  scoped_ptr<SparseMatrix> jacobian(powell_evaluator.CreateJacobian());
+
+  Minimizer::Options minimizer_options(solver_options);
+  minimizer_options.gradient_tolerance = 1e-26;
+  minimizer_options.function_tolerance = 1e-26;
+  minimizer_options.parameter_tolerance = 1e-26;
+  minimizer_options.evaluator = &powell_evaluator;
+  minimizer_options.jacobian = jacobian.get();
+
+  TrustRegionStrategy::Options trust_region_strategy_options;
+  trust_region_strategy_options.linear_solver = &linear_solver;
+  scoped_ptr<TrustRegionStrategy> strategy(
+      TrustRegionStrategy::Create(trust_region_strategy_options));
+  minimizer_options.trust_region_strategy = strategy.get();
+
+  TrustRegionMinimizer minimizer;
+  minimizer.Minimize(minimizer_options, parameters, summary);
+}
+
+// Evaluating the Jacobian at the candidate point along with the cost
+// is an optimization, and should not change the iterates.
+TEST(TrustRegionMinimizer, SpeculativeJacobianEvaluation) {
+  double expected_parameters[4] = { 3, -1, 0, 1.0 };
+  Solver::Summary expected_summary;
+  SolvePowellsFunction(false, expected_parameters, &expected_summary);
+
+  double parameters[4] = { 3, -1, 0, 1.0 };
+  Solver::Summary summary;
+  SolvePowellsFunction(true, parameters, &summary);
+
+  EXPECT_EQ(expected_summary.termination_type, summary.termination_type);
+  EXPECT_EQ(expected_summary.num_successful_steps,
+            summary.num_successful_steps);
+  EXPECT_EQ(expected_summary.num_unsuccessful_steps,
+            summary.num_unsuccessful_steps);
+  ASSERT_EQ(expected_summary.iterations.size(), summary.iterations.size());
+  for (int i = 0; i < summary.iterations.size(); ++i) {
+    EXPECT_EQ(expected_summary.iterations[i].cost,
+              summary.iterations[i].cost);
+  }
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(expected_parameters[i], parameters[i]);
+  }
+}
+
+
+// Observation of a two dimensional point by a "camera" with a
+// quadratic response, i.e. residual = c0 * p + c1 * p^2 - observed.
+// Each residual depends on one point and one camera, which gives the
+// problem the structure needed by the Schur based solvers.
+struct QuadraticObservation {
+  QuadraticObservation(double observed_x, double observed_y)
+      : observed_x(observed_x), observed_y(observed_y) {}
+
+  template <typename T>
+  bool operator()(const T* camera, const T* point, T* residuals) const {
+    residuals[0] =
+        camera[0] * point[0] + camera[1] * point[0] * point[0] -
+        T(observed_x);
+    residuals[1] =
+        camera[0] * point[1] + camera[1] * point[1] * point[1] -
+        T(observed_y);
+    return true;
+  }
+
+  double observed_x;
+  double observed_y;
+};
+
+void SolveQuadraticObservationProblem(LinearSolverType linear_solver_type,
+                                      bool use_speculative_jacobian_evaluation,
+                                      vector<double>* parameters,
+                                      Solver::Summary* summary) {
+  const int kNumCameras = 3;
+  const int kNumPoints = 10;
+  parameters->resize(2 * (kNumCameras + kNumPoints));
+  double* cameras = &(*parameters)[0];
+  double* points = cameras + 2 * kNumCameras;
+
+  Problem problem;
+  for (int j = 0; j < kNumCameras; ++j) {
+    const double camera[2] = { 1.0 + 0.5 * j, 0.1 * j + 0.2 };
+    for (int i = 0; i < kNumPoints; ++i) {
+      const double point[2] = { 0.1 * i - 0.3, 0.5 - 0.07 * i };
+      double observed[2];
+      QuadraticObservation(0.0, 0.0)(camera, point, observed);
+      problem.AddResidualBlock(
+          new AutoDiffCostFunction<QuadraticObservation, 2, 2, 2>(
+              new QuadraticObservation(observed[0], observed[1])),
+          NULL,
+          cameras + 2 * j,
+          points + 2 * i);
+    }
+    // Perturb the cameras, except the first one which is held
+    // constant to fix the gauge.
+    cameras[2 * j] = camera[0] + ((j == 0) ? 0.0 : 0.2);
+    cameras[2 * j + 1] = camera[1] + ((j == 0) ? 0.0 : -0.1);
+  }
+  problem.SetParameterBlockConstant(cameras);
+
+  for (int i = 0; i < kNumPoints; ++i) {
+    points[2 * i] = 0.1 * i;
+    points[2 * i + 1] = 0.5;
+  }
+
+  Solver::Options options;
+  options.linear_solver_type = linear_solver_type;
+  options.use_speculative_jacobian_evaluation =
+      use_speculative_jacobian_evaluation;
+  options.max_num_iterations = 50;
+  options.function_tolerance = 1e-16;
+  options.gradient_tolerance = 1e-16;
+  options.parameter_tolerance = 1e-16;
+  Solve(options, &problem, summary);
+}
+
+// When a step is accepted, the minimizer swaps the current Jacobian
+// with the speculatively evaluated one, and the iterative Schur
+// complement solver must follow the swap instead of solving with the
+// Jacobian it was first invoked with. Its implicit Schur complement
+// rebuilds its view of the Jacobian when it is given a different
+// matrix, so the iterates are the same with and without speculative
+// evaluation.
+TEST(TrustRegionMinimizer, SpeculativeJacobianEvaluationWithIterativeSchur) {
+  vector<double> expected_parameters;
+  Solver::Summary expected_summary;
+  SolveQuadraticObservationProblem(ITERATIVE_SCHUR,
+                                   false,
+                                   &expected_parameters,
+                                   &expected_summary);
+  EXPECT_LE(expected_summary.final_cost, 1e-12);
+
+  vector<double> parameters;
+  Solver::Summary summary;
+  SolveQuadraticObservationProblem(ITERATIVE_SCHUR,
+                                   true,
+                                   &parameters,
+                                   &summary);
+
+  EXPECT_EQ(expected_summary.num_successful_steps,
+            summary.num_successful_steps);
+  EXPECT_EQ(expected_summary.num_unsuccessful_steps,
+            summary.num_unsuccessful_steps);
+  ASSERT_EQ(expected_summary.iterations.size(), summary.iterations.size());
+  for (int i = 0; i < summary.iterations.size(); ++i) {
+    EXPECT_EQ(expected_summary.iterations[i].cost,
+              summary.iterations[i].cost);
+  }
+  ASSERT_EQ(expected_parameters.size(), parameters.size());
+  for (int i = 0; i < parameters.size(); ++i) {
+    EXPECT_EQ(expected_parameters[i], parameters[i]);
+  }
+}
+
 
 class CurveCostFunction : public CostFunction {
  public:
@@ -31,6 +31,8 @@
 #ifndef CERES_INTERNAL_TRUST_REGION_STRATEGY_H_
 #define CERES_INTERNAL_TRUST_REGION_STRATEGY_H_
 
+#include <string>
+#include "ceres/internal/port.h"
 #include "ceres/types.h"
 
 namespace ceres {
@@ -60,7 +62,8 @@ class TrustRegionStrategy {
           max_radius(1e32),
           lm_min_diagonal(1e-6),
           lm_max_diagonal(1e32),
-          dogleg_type(TRADITIONAL_DOGLEG) {
+          dogleg_type(TRADITIONAL_DOGLEG),
+          num_eliminate_blocks(0) {
     }
 
     TrustRegionStrategyType trust_region_strategy_type;
@@ -78,12 +81,33 @@ class TrustRegionStrategy {
 
     // Further specify which dogleg method to use
     DoglegType dogleg_type;
+
+    // Number of e_blocks in the jacobian, if a Schur type linear
+    // solver is used. It is recorded in the linear least squares
+    // problems written to disk, so that they can be replayed with
+    // Schur type linear solvers.
+    int num_eliminate_blocks;
   };
 
   // Per solve options.
   struct PerSolveOptions {
+    PerSolveOptions()
+        : eta(0.0),
+          dump_iteration(-1),
+          dump_format_type(TEXTFILE) {
+    }
+
     // Forcing sequence for inexact solves.
     double eta;
+
+    // If dump_directory is not empty, the linear least squares
+    // problem solved to compute the step, i.e., the jacobian, the
+    // residuals, the regularizing diagonal and the solution of the
+    // linear solver, is written to dump_directory in the format
+    // dump_format_type. See DumpLinearLeastSquaresProblem.
+    string dump_directory;
+    int dump_iteration;
+    DumpFormatType dump_format_type;
   };
 
   struct Summary {
@@ -76,6 +76,7 @@ const char* PreconditionerTypeToString(PreconditionerType type) {
     CASESTR(SCHUR_JACOBI);
     CASESTR(CLUSTER_JACOBI);
     CASESTR(CLUSTER_TRIDIAGONAL);
+    CASESTR(ADDITIVE_SCHWARZ);
     default:
       return "UNKNOWN";
   }
@@ -88,6 +89,7 @@ bool StringToPreconditionerType(string value, PreconditionerType* type) {
   STRENUM(SCHUR_JACOBI);
   STRENUM(CLUSTER_JACOBI);
   STRENUM(CLUSTER_TRIDIAGONAL);
+  STRENUM(ADDITIVE_SCHWARZ);
   return false;
 }
 
@@ -182,6 +184,7 @@ bool StringToLineSearchDirectionType(string value,
 const char* LineSearchTypeToString(LineSearchType type) {
   switch (type) {
     CASESTR(ARMIJO);
+    CASESTR(WOLFE);
     default:
       return "UNKNOWN";
   }
@@ -190,6 +193,7 @@ const char* LineSearchTypeToString(LineSearchType type) {
 bool StringToLineSearchType(string value, LineSearchType* type) {
   UpperCase(&value);
   STRENUM(ARMIJO);
+  STRENUM(WOLFE);
   return false;
 }
 
@@ -88,8 +88,10 @@ class UnsymmetricLinearSolverTest : public ::testing::Test {
                       per_solve_options,
                       x_unregularized.data());
 
-    // Regularized solution
+    // Regularized solution. Since only D changes, solvers may reuse
+    // the products of A and b computed by the unregularized solve.
     per_solve_options.D = D_.get();
+    per_solve_options.A_and_b_are_unchanged = true;
     regularized_solve_summary =
         solver->Solve(transformed_A.get(),
                       b_.get(),
@@ -28,8 +28,6 @@
 //
 // Author: kushalav@google.com (Avanish Kushal)
 
-#ifndef CERES_NO_SUITESPARSE
-
 #include "ceres/visibility.h"
 
 #include <cmath>
@@ -39,8 +37,7 @@
 #include <vector>
 #include <utility>
 #include "ceres/block_structure.h"
-#include "ceres/collections_port.h"
-#include "ceres/graph.h"
+#include "ceres/compressed_graph.h"
 #include "glog/logging.h"
 
 namespace ceres {
@@ -73,84 +70,132 @@ void ComputeVisibility(const CompressedRowBlockStructure& block_structure,
   }
 }
 
-Graph<int>* CreateSchurComplementGraph(const vector<set<int> >& visibility) {
+CompressedGraph* CreateSchurComplementGraph(const vector<set<int> >& visibility,
+                                       const int num_threads) {
   const time_t start_time = time(NULL);
+  const int num_cameras = visibility.size();
+
   // Compute the number of e_blocks/point blocks. Since the visibility
   // set for each e_block/camera contains the set of e_blocks/points
   // visible to it, we find the maximum across all visibility sets.
   int num_points = 0;
-  for (int i = 0; i < visibility.size(); i++) {
+  for (int i = 0; i < num_cameras; i++) {
     if (visibility[i].size() > 0) {
       num_points = max(num_points, (*visibility[i].rbegin()) + 1);
     }
   }
 
+  // Store the camera->point mapping in compressed row form, so that
+  // the loops below walk contiguous arrays instead of set nodes.
+  vector<int> camera_offsets(num_cameras + 1, 0);
+  for (int i = 0; i < num_cameras; ++i) {
+    camera_offsets[i + 1] = camera_offsets[i] + visibility[i].size();
+  }
+  vector<int> camera_points(camera_offsets.back());
+  for (int i = 0; i < num_cameras; ++i) {
+    copy(visibility[i].begin(),
+         visibility[i].end(),
+         camera_points.begin() + camera_offsets[i]);
+  }
+
   // Invert the visibility. The input is a camera->point mapping,
   // which tells us which points are visible in which
   // cameras. However, to compute the sparsity structure of the Schur
   // Complement efficiently, its better to have the point->camera
-  // mapping.
-  vector<set<int> > inverse_visibility(num_points);
-  for (int i = 0; i < visibility.size(); i++) {
-    const set<int>& visibility_set = visibility[i];
-    for (set<int>::const_iterator it = visibility_set.begin();
-         it != visibility_set.end();
-         ++it) {
-      inverse_visibility[*it].insert(i);
+  // mapping. Since the cameras are visited in increasing order, each
+  // row of the inverse is sorted.
+  vector<int> point_offsets(num_points + 1, 0);
+  for (int i = 0; i < camera_points.size(); ++i) {
+    ++point_offsets[camera_points[i] + 1];
+  }
+  for (int i = 0; i < num_points; ++i) {
+    point_offsets[i + 1] += point_offsets[i];
+  }
+  vector<int> point_cameras(point_offsets.back());
+  {
+    vector<int> cursor(point_offsets.begin(), point_offsets.end() - 1);
+    for (int i = 0; i < num_cameras; ++i) {
+      for (int j = camera_offsets[i]; j < camera_offsets[i + 1]; ++j) {
+        point_cameras[cursor[camera_points[j]]++] = i;
+      }
     }
   }
 
-  // Map from camera pairs to number of points visible to both cameras
-  // in the pair.
-  HashMap<pair<int, int>, int > camera_pairs;
-
-  // Count the number of points visible to each camera/f_block pair.
-  for (vector<set<int> >::const_iterator it = inverse_visibility.begin();
-       it != inverse_visibility.end();
-       ++it) {
-    const set<int>& inverse_visibility_set = *it;
-    for (set<int>::const_iterator camera1 = inverse_visibility_set.begin();
-         camera1 != inverse_visibility_set.end();
-         ++camera1) {
-      set<int>::const_iterator camera2 = camera1;
-      for (++camera2; camera2 != inverse_visibility_set.end(); ++camera2) {
-        ++(camera_pairs[make_pair(*camera1, *camera2)]);
+  // For each camera, the list of (camera2, count) pairs, where
+  // camera2 > camera and count is the number of points visible to
+  // both cameras. Each camera is processed independently, so the rows
+  // can be computed in parallel. Every thread keeps a dense array of
+  // counts which is reset using the list of entries it touched.
+  vector<vector<pair<int, int> > > camera_pairs(num_cameras);
+
+#pragma omp parallel num_threads(num_threads)
+  {
+    vector<int> counts(num_cameras, 0);
+    vector<int> touched;
+
+#pragma omp for schedule(dynamic, 16)
+    for (int camera1 = 0; camera1 < num_cameras; ++camera1) {
+      for (int j = camera_offsets[camera1];
+           j < camera_offsets[camera1 + 1];
+           ++j) {
+        const int point = camera_points[j];
+        const int* row_begin = &point_cameras[0] + point_offsets[point];
+        const int* row_end = &point_cameras[0] + point_offsets[point + 1];
+        for (const int* camera2 = upper_bound(row_begin, row_end, camera1);
+             camera2 != row_end;
+             ++camera2) {
+          if (counts[*camera2]++ == 0) {
+            touched.push_back(*camera2);
+          }
+        }
+      }
+
+      sort(touched.begin(), touched.end());
+      vector<pair<int, int> >& row = camera_pairs[camera1];
+      row.reserve(touched.size());
+      for (int j = 0; j < touched.size(); ++j) {
+        row.push_back(make_pair(touched[j], counts[touched[j]]));
+        counts[touched[j]] = 0;
       }
+      touched.clear();
     }
   }
 
-  Graph<int>* graph = new Graph<int>();
-
-  // Add vertices and initialize the pairs for self edges so that self
-  // edges are guaranteed. This is needed for the Canonical views
-  // algorithm to work correctly.
+  // Add a self edge for each camera, so that self edges are
+  // guaranteed. This is needed for the Canonical views algorithm to
+  // work correctly.
   static const double kSelfEdgeWeight = 1.0;
-  for (int i = 0; i < visibility.size(); ++i) {
-    graph->AddVertex(i);
-    graph->AddEdge(i, i, kSelfEdgeWeight);
+  vector<pair<int, int> > edges;
+  vector<double> edge_weights;
+  for (int i = 0; i < num_cameras; ++i) {
+    edges.push_back(make_pair(i, i));
+    edge_weights.push_back(kSelfEdgeWeight);
   }
 
   // Add an edge for each camera pair.
-  for (HashMap<pair<int, int>, int>::const_iterator it = camera_pairs.begin();
-       it != camera_pairs.end();
-       ++it) {
-    const int camera1 = it->first.first;
-    const int camera2 = it->first.second;
-    CHECK_NE(camera1, camera2);
-
-    const int count = it->second;
-    // Static cast necessary for Windows.
-    const double weight = static_cast<double>(count) /
-        (sqrt(static_cast<double>(
-                  visibility[camera1].size() * visibility[camera2].size())));
-    graph->AddEdge(camera1, camera2, weight);
+  for (int camera1 = 0; camera1 < num_cameras; ++camera1) {
+    const vector<pair<int, int> >& row = camera_pairs[camera1];
+    for (int j = 0; j < row.size(); ++j) {
+      const int camera2 = row[j].first;
+      CHECK_NE(camera1, camera2);
+
+      const int count = row[j].second;
+      // Static cast necessary for Windows.
+      const double weight = static_cast<double>(count) /
+          (sqrt(static_cast<double>(
+                    visibility[camera1].size() * visibility[camera2].size())));
+      edges.push_back(make_pair(camera1, camera2));
+      edge_weights.push_back(weight);
+    }
   }
 
+  CompressedGraph* graph = new CompressedGraph(vector<double>(num_cameras, 1.0),
+                                               edges,
+                                               edge_weights,
+                                               num_threads);
   VLOG(2) << "Schur complement graph time: " << (time(NULL) - start_time);
   return graph;
 }
 
 }  // namespace internal
 }  // namespace ceres
-
-#endif
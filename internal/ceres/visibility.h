@@ -35,11 +35,9 @@
 #ifndef CERES_INTERNAL_VISIBILITY_H_
 #define CERES_INTERNAL_VISIBILITY_H_
 
-#ifndef CERES_NO_SUITESPARSE
-
 #include <set>
 #include <vector>
-#include "ceres/graph.h"
+#include "ceres/compressed_graph.h"
 
 namespace ceres {
 namespace internal {
@@ -69,12 +67,16 @@ void ComputeVisibility(const CompressedRowBlockStructure& block_structure,
 // matrix/Schur complement matrix obtained by eliminating the e_blocks
 // from the normal equations.
 //
-// Caller acquires ownership of the returned Graph pointer
+// The number of common e_blocks for each pair of f_blocks is counted
+// using num_threads threads.
+//
+// Caller acquires ownership of the returned CompressedGraph pointer
 // (heap-allocated).
-Graph<int>* CreateSchurComplementGraph(const vector<set<int> >& visibility);
+CompressedGraph* CreateSchurComplementGraph(
+    const vector<set<int> >& visibility,
+    int num_threads);
 
 }  // namespace internal
 }  // namespace ceres
 
-#endif  // CERES_NO_SUITESPARSE
 #endif  // CERES_INTERNAL_VISIBILITY_H_
@@ -43,12 +43,14 @@
 #include "ceres/block_sparse_matrix.h"
 #include "ceres/canonical_views_clustering.h"
 #include "ceres/collections_port.h"
+#include "ceres/compressed_column_scatter.h"
+#include "ceres/compressed_graph.h"
 #include "ceres/detect_structure.h"
-#include "ceres/graph.h"
 #include "ceres/graph_algorithms.h"
 #include "ceres/internal/scoped_ptr.h"
 #include "ceres/linear_solver.h"
 #include "ceres/schur_eliminator.h"
+#include "ceres/schur_structure_cache.h"
 #include "ceres/visibility.h"
 #include "glog/logging.h"
 
@@ -70,6 +72,7 @@ VisibilityBasedPreconditioner::VisibilityBasedPreconditioner(
     : options_(options),
       num_blocks_(0),
       num_clusters_(0),
+      eliminator_(NULL),
       factor_(NULL) {
   CHECK_GT(options_.elimination_groups.size(), 1);
   CHECK_GT(options_.elimination_groups[0], 0);
@@ -87,21 +90,50 @@ VisibilityBasedPreconditioner::VisibilityBasedPreconditioner(
     block_size_[i] = bs.cols[i + options_.elimination_groups[0]].size;
   }
 
+  // The clustering and the sparsity structure of the preconditioner
+  // only depend on bs, so if a previous preconditioner of the same
+  // type has seen it, reuse its work.
+  SchurStructure* schur_structure = NULL;
+  const VisibilityClustering* cached_clustering = NULL;
+  if (options_.schur_structure_cache != NULL) {
+    schur_structure = options_.schur_structure_cache->FindOrCreate(
+        bs, options_.elimination_groups[0]);
+    cached_clustering = schur_structure->FindClustering(options_.type);
+  }
+
   const time_t start_time = time(NULL);
-  switch (options_.type) {
-    case CLUSTER_JACOBI:
-      ComputeClusterJacobiSparsity(bs);
-      break;
-    case CLUSTER_TRIDIAGONAL:
-      ComputeClusterTridiagonalSparsity(bs);
-      break;
-    default:
-      LOG(FATAL) << "Unknown preconditioner type";
+  time_t structure_time = start_time;
+  if (cached_clustering != NULL) {
+    num_clusters_ = cached_clustering->num_clusters;
+    cluster_membership_ = cached_clustering->cluster_membership;
+    cluster_pairs_ = cached_clustering->cluster_pairs;
+    block_pairs_ = cached_clustering->block_pairs;
+    m_.reset(new BlockRandomAccessSparseMatrix(block_size_, block_pairs_));
+  } else {
+    switch (options_.type) {
+      case CLUSTER_JACOBI:
+        ComputeClusterJacobiSparsity(bs);
+        break;
+      case CLUSTER_TRIDIAGONAL:
+        ComputeClusterTridiagonalSparsity(bs);
+        break;
+      default:
+        LOG(FATAL) << "Unknown preconditioner type";
+    }
+    structure_time = time(NULL);
+    InitStorage(bs);
+
+    if (schur_structure != NULL) {
+      VisibilityClustering clustering;
+      clustering.num_clusters = num_clusters_;
+      clustering.cluster_membership = cluster_membership_;
+      clustering.cluster_pairs = cluster_pairs_;
+      clustering.block_pairs = block_pairs_;
+      schur_structure->InsertClustering(options_.type, clustering);
+    }
   }
-  const time_t structure_time = time(NULL);
-  InitStorage(bs);
   const time_t storage_time = time(NULL);
-  InitEliminator(bs);
+  InitEliminator(bs, schur_structure);
   const time_t eliminator_time = time(NULL);
 
   // Allocate temporary storage for a vector used during
@@ -163,9 +195,9 @@ void VisibilityBasedPreconditioner::ComputeClusterTridiagonalSparsity(
   // maximum spanning forest of this graph.
   vector<set<int> > cluster_visibility;
   ComputeClusterVisibility(visibility, &cluster_visibility);
-  scoped_ptr<Graph<int> > cluster_graph(
+  scoped_ptr<CompressedGraph> cluster_graph(
       CHECK_NOTNULL(CreateClusterGraph(cluster_visibility)));
-  scoped_ptr<Graph<int> > forest(
+  scoped_ptr<CompressedGraph> forest(
       CHECK_NOTNULL(Degree2MaximumSpanningForest(*cluster_graph)));
   ForestToClusterPairs(*forest, &cluster_pairs_);
 }
@@ -185,12 +217,14 @@ void VisibilityBasedPreconditioner::InitStorage(
 // memberships for each camera block.
 void VisibilityBasedPreconditioner::ClusterCameras(
     const vector<set<int> >& visibility) {
-  scoped_ptr<Graph<int> > schur_complement_graph(
-      CHECK_NOTNULL(CreateSchurComplementGraph(visibility)));
+  scoped_ptr<CompressedGraph> schur_complement_graph(
+      CHECK_NOTNULL(CreateSchurComplementGraph(visibility,
+                                               options_.num_threads)));
 
   CanonicalViewsClusteringOptions options;
   options.size_penalty_weight = kSizePenaltyWeight;
   options.similarity_penalty_weight = kSimilarityPenaltyWeight;
+  options.num_threads = options_.num_threads;
 
   vector<int> centers;
   HashMap<int, int> membership;
@@ -307,9 +341,16 @@ void VisibilityBasedPreconditioner::ComputeBlockPairsInPreconditioner(
   VLOG(1) << "Block pair stats: " << block_pairs_.size();
 }
 
-// Initialize the SchurEliminator.
+// Initialize the SchurEliminator. If a SchurStructure is available,
+// its eliminator is shared, otherwise a new one is created.
 void VisibilityBasedPreconditioner::InitEliminator(
-    const CompressedRowBlockStructure& bs) {
+    const CompressedRowBlockStructure& bs,
+    SchurStructure* schur_structure) {
+  if (schur_structure != NULL) {
+    eliminator_ = schur_structure->Eliminator(bs, options_.num_threads);
+    return;
+  }
+
   LinearSolver::Options eliminator_options;
   eliminator_options.elimination_groups = options_.elimination_groups;
   eliminator_options.num_threads = options_.num_threads;
@@ -319,8 +360,9 @@ void VisibilityBasedPreconditioner::InitEliminator(
                   &eliminator_options.e_block_size,
                   &eliminator_options.f_block_size);
 
-  eliminator_.reset(SchurEliminatorBase::Create(eliminator_options));
-  eliminator_->Init(options_.elimination_groups[0], &bs);
+  owned_eliminator_.reset(SchurEliminatorBase::Create(eliminator_options));
+  owned_eliminator_->Init(options_.elimination_groups[0], &bs);
+  eliminator_ = owned_eliminator_.get();
 }
 
 // Update the values of the preconditioner matrix and factorize it.
@@ -410,27 +452,31 @@ void VisibilityBasedPreconditioner::ScaleOffDiagonalCells() {
 // matrix.
 bool VisibilityBasedPreconditioner::Factorize() {
   // Extract the TripletSparseMatrix that is used for actually storing
-  // S and convert it into a cholmod_sparse object.
-  cholmod_sparse* lhs = ss_.CreateSparseMatrix(
-      down_cast<BlockRandomAccessSparseMatrix*>(
-          m_.get())->mutable_matrix());
+  // S and copy its values into compressed column storage. The
+  // sparsity pattern of S is fixed, so the conversion is only
+  // analyzed on the first call.
+  const TripletSparseMatrix* tsm =
+      down_cast<BlockRandomAccessSparseMatrix*>(m_.get())->matrix();
+  if (m_csc_.get() == NULL) {
+    m_csc_.reset(new CompressedColumnScatter(*tsm));
+  }
+  m_csc_->Scatter(*tsm, options_.num_threads);
+  cholmod_sparse lhs = ss_.CreateSparseMatrixView(m_csc_.get());
 
   // The matrix is symmetric, and the upper triangular part of the
   // matrix contains the values.
-  lhs->stype = 1;
+  lhs.stype = 1;
 
   // Symbolic factorization is computed if we don't already have one handy.
   if (factor_ == NULL) {
     if (options_.use_block_amd) {
-      factor_ = ss_.BlockAnalyzeCholesky(lhs, block_size_, block_size_);
+      factor_ = ss_.BlockAnalyzeCholesky(&lhs, block_size_, block_size_);
     } else {
-      factor_ = ss_.AnalyzeCholesky(lhs);
+      factor_ = ss_.AnalyzeCholesky(&lhs);
     }
   }
 
-  bool status = ss_.Cholesky(lhs, factor_);
-  ss_.Free(lhs);
-  return status;
+  return ss_.Cholesky(&lhs, factor_);
 }
 
 void VisibilityBasedPreconditioner::RightMultiply(const double* x,
@@ -473,24 +519,18 @@ bool VisibilityBasedPreconditioner::IsBlockPairOffDiagonal(
 // Convert a graph into a list of edges that includes self edges for
 // each vertex.
 void VisibilityBasedPreconditioner::ForestToClusterPairs(
-    const Graph<int>& forest,
+    const CompressedGraph& forest,
     HashSet<pair<int, int> >* cluster_pairs) const {
   CHECK_NOTNULL(cluster_pairs)->clear();
-  const HashSet<int>& vertices = forest.vertices();
-  CHECK_EQ(vertices.size(), num_clusters_);
+  CHECK_EQ(forest.num_vertices(), num_clusters_);
 
   // Add all the cluster pairs corresponding to the edges in the
   // forest.
-  for (HashSet<int>::const_iterator it1 = vertices.begin();
-       it1 != vertices.end();
-       ++it1) {
-    const int cluster1 = *it1;
+  for (int cluster1 = 0; cluster1 < num_clusters_; ++cluster1) {
     cluster_pairs->insert(make_pair(cluster1, cluster1));
-    const HashSet<int>& neighbors = forest.Neighbors(cluster1);
-    for (HashSet<int>::const_iterator it2 = neighbors.begin();
-         it2 != neighbors.end();
-         ++it2) {
-      const int cluster2 = *it2;
+    const int* neighbors = forest.Neighbors(cluster1);
+    for (int i = 0; i < forest.Degree(cluster1); ++i) {
+      const int cluster2 = neighbors[i];
       if (cluster1 < cluster2) {
         cluster_pairs->insert(make_pair(cluster1, cluster2));
       }
@@ -516,14 +556,10 @@ void VisibilityBasedPreconditioner::ComputeClusterVisibility(
 // Construct a graph whose vertices are the clusters, and the edge
 // weights are the number of 3D points visible to cameras in both the
 // vertices.
-Graph<int>* VisibilityBasedPreconditioner::CreateClusterGraph(
+CompressedGraph* VisibilityBasedPreconditioner::CreateClusterGraph(
     const vector<set<int> >& cluster_visibility) const {
-  Graph<int>* cluster_graph = new Graph<int>;
-
-  for (int i = 0; i < num_clusters_; ++i) {
-    cluster_graph->AddVertex(i);
-  }
-
+  vector<pair<int, int> > edges;
+  vector<double> edge_weights;
   for (int i = 0; i < num_clusters_; ++i) {
     const set<int>& cluster_i = cluster_visibility[i];
     for (int j = i+1; j < num_clusters_; ++j) {
@@ -539,11 +575,15 @@ Graph<int>* VisibilityBasedPreconditioner::CreateClusterGraph(
         // alorithm, iterates on the edges in decreasing order of
         // their weight, which is the number of points shared by the
         // two cameras that it connects.
-        cluster_graph->AddEdge(i, j, intersection.size());
+        edges.push_back(make_pair(i, j));
+        edge_weights.push_back(intersection.size());
       }
     }
   }
-  return cluster_graph;
+  return new CompressedGraph(vector<double>(num_clusters_, 1.0),
+                             edges,
+                             edge_weights,
+                             options_.num_threads);
 }
 
 // Canonical views clustering returns a HashMap from vertices to
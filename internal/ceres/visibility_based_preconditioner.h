@@ -52,7 +52,7 @@
 #include <vector>
 #include <utility>
 #include "ceres/collections_port.h"
-#include "ceres/graph.h"
+#include "ceres/compressed_graph.h"
 #include "ceres/internal/macros.h"
 #include "ceres/internal/scoped_ptr.h"
 #include "ceres/preconditioner.h"
@@ -63,8 +63,10 @@ namespace internal {
 
 class BlockRandomAccessSparseMatrix;
 class BlockSparseMatrixBase;
+class CompressedColumnScatter;
 struct CompressedRowBlockStructure;
 class SchurEliminatorBase;
+class SchurStructure;
 
 // This class implements visibility based preconditioners for
 // Structure from Motion/Bundle Adjustment problems. The name
@@ -145,7 +147,8 @@ class VisibilityBasedPreconditioner : public Preconditioner {
   void ComputeClusterJacobiSparsity(const CompressedRowBlockStructure& bs);
   void ComputeClusterTridiagonalSparsity(const CompressedRowBlockStructure& bs);
   void InitStorage(const CompressedRowBlockStructure& bs);
-  void InitEliminator(const CompressedRowBlockStructure& bs);
+  void InitEliminator(const CompressedRowBlockStructure& bs,
+                      SchurStructure* schur_structure);
   bool Factorize();
   void ScaleOffDiagonalCells();
 
@@ -154,8 +157,9 @@ class VisibilityBasedPreconditioner : public Preconditioner {
                             vector<int>* membership_vector) const;
   void ComputeClusterVisibility(const vector<set<int> >& visibility,
                                 vector<set<int> >* cluster_visibility) const;
-  Graph<int>* CreateClusterGraph(const vector<set<int> >& visibility) const;
-  void ForestToClusterPairs(const Graph<int>& forest,
+  CompressedGraph* CreateClusterGraph(
+      const vector<set<int> >& visibility) const;
+  void ForestToClusterPairs(const CompressedGraph& forest,
                             HashSet<pair<int, int> >* cluster_pairs) const;
   void ComputeBlockPairsInPreconditioner(const CompressedRowBlockStructure& bs);
   bool IsBlockPairInPreconditioner(int block1, int block2) const;
@@ -181,11 +185,20 @@ class VisibilityBasedPreconditioner : public Preconditioner {
   // Set of cluster pairs (including self pairs (i,i)) in the
   // preconditioner.
   HashSet<pair<int, int> > cluster_pairs_;
-  scoped_ptr<SchurEliminatorBase> eliminator_;
+
+  // If options_.schur_structure_cache is not NULL, the eliminator is
+  // shared with other users of the cache, otherwise it is owned by
+  // this object.
+  scoped_ptr<SchurEliminatorBase> owned_eliminator_;
+  SchurEliminatorBase* eliminator_;
 
   // Preconditioner matrix.
   scoped_ptr<BlockRandomAccessSparseMatrix> m_;
 
+  // Compressed column copy of m_, created by the first call to
+  // Factorize and updated in place afterwards.
+  scoped_ptr<CompressedColumnScatter> m_csc_;
+
   // RightMultiply is a const method for LinearOperators. It is
   // implemented using CHOLMOD's sparse triangular matrix solve
   // function. This however requires non-const access to the
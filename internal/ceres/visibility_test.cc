@@ -29,14 +29,13 @@
 // Author: kushalav@google.com (Avanish Kushal)
 //         sameeragarwal@google.com (Sameer Agarwal)
 
-#ifndef CERES_NO_SUITESPARSE
-
 #include "ceres/visibility.h"
 
+#include <algorithm>
 #include <set>
 #include <vector>
 #include "ceres/block_structure.h"
-#include "ceres/graph.h"
+#include "ceres/compressed_graph.h"
 #include "ceres/internal/scoped_ptr.h"
 #include "glog/logging.h"
 #include "gtest/gtest.h"
@@ -105,8 +104,8 @@ TEST(VisibilityTest, SimpleMatrix) {
     ASSERT_EQ(visibility[i].size(), 1);
   }
 
-  scoped_ptr<Graph<int> > graph(CreateSchurComplementGraph(visibility));
-  EXPECT_EQ(graph->vertices().size(), visibility.size());
+  scoped_ptr<CompressedGraph> graph(CreateSchurComplementGraph(visibility, 1));
+  EXPECT_EQ(graph->num_vertices(), visibility.size());
   for (int i = 0; i < visibility.size(); ++i) {
     EXPECT_EQ(graph->VertexWeight(i), 1.0);
   }
@@ -181,8 +180,8 @@ TEST(VisibilityTest, NoEBlocks) {
     ASSERT_EQ(visibility[i].size(), 0);
   }
 
-  scoped_ptr<Graph<int> > graph(CreateSchurComplementGraph(visibility));
-  EXPECT_EQ(graph->vertices().size(), visibility.size());
+  scoped_ptr<CompressedGraph> graph(CreateSchurComplementGraph(visibility, 1));
+  EXPECT_EQ(graph->num_vertices(), visibility.size());
   for (int i = 0; i < visibility.size(); ++i) {
     EXPECT_EQ(graph->VertexWeight(i), 1.0);
   }
@@ -201,7 +200,28 @@ TEST(VisibilityTest, NoEBlocks) {
   }
 }
 
+TEST(VisibilityTest, MultithreadedSchurComplementGraph) {
+  // Camera i sees the points i, ..., i + 4, so cameras which are
+  // less than five apart share 5 - |i - j| points.
+  const int kNumCameras = 50;
+  vector<set<int> > visibility(kNumCameras);
+  for (int i = 0; i < kNumCameras; ++i) {
+    for (int j = 0; j < 5; ++j) {
+      visibility[i].insert(i + j);
+    }
+  }
+
+  scoped_ptr<CompressedGraph> graph(CreateSchurComplementGraph(visibility, 4));
+  EXPECT_EQ(graph->num_vertices(), kNumCameras);
+  for (int i = 0; i < kNumCameras; ++i) {
+    for (int j = i; j < kNumCameras; ++j) {
+      const double expected_weight =
+          (i == j) ? 1.0 : max(0, 5 - (j - i)) / 5.0;
+      EXPECT_DOUBLE_EQ(graph->EdgeWeight(i, j), expected_weight)
+          << "Edge: " << i << " " << j;
+    }
+  }
+}
+
 }  // namespace internal
 }  // namespace ceres
-
-#endif  // CERES_NO_SUITESPARSE